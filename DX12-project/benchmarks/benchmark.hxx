@@ -0,0 +1,67 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <vector>
+
+#include <fmt/format.h>
+
+
+namespace benchmark
+{
+    using clock = std::chrono::steady_clock;
+
+    struct summary final {
+        double mean{0};
+        double median{0};
+        double p95{0};
+        double p99{0};
+    };
+
+    // Of samples in any unit.
+    inline summary summarize(std::vector<double> samples)
+    {
+        if (samples.empty())
+            return { };
+
+        std::sort(std::begin(samples), std::end(samples));
+
+        double total = 0;
+
+        for (auto sample : samples)
+            total += sample;
+
+        auto const percentile = [&samples] (double fraction)
+        {
+            return samples[(std::min)(static_cast<std::size_t>(fraction * static_cast<double>(std::size(samples))), std::size(samples) - 1)];
+        };
+
+        return summary{total / static_cast<double>(std::size(samples)), percentile(.5), percentile(.95), percentile(.99)};
+    }
+
+    template<class D>
+    double microseconds(D duration)
+    {
+        return std::chrono::duration<double, std::micro>(duration).count();
+    }
+
+    // Runs 'body' 'iterations' times and returns the mean time of one run in nanoseconds.
+    template<class F>
+    double time_per_iteration(std::size_t iterations, F &&body)
+    {
+        auto const start = clock::now();
+
+        for (auto index = std::size_t{0}; index < iterations; ++index)
+            body(index);
+
+        return std::chrono::duration<double, std::nano>(clock::now() - start).count() / static_cast<double>(iterations);
+    }
+
+    // Keeps the compiler from optimizing a computed value away.
+    template<class T>
+    void keep(T const &value)
+    {
+        asm volatile("" : : "g"(&value) : "memory");
+    }
+}
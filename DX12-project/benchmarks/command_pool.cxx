@@ -0,0 +1,112 @@
+#include "benchmark.hxx"
+
+#include "main.hxx"
+#include "graphics/command_pool.hxx"
+#include "graphics/queue.hxx"
+
+
+namespace
+{
+    auto constexpr kFRAMES_IN_FLIGHT = 3u;
+    auto constexpr kLISTS_PER_FRAME = 4u;
+
+    struct result final {
+        double ns_per_frame{0};
+        double objects_per_frame{0};
+    };
+
+    // Records and submits 'frame_number' frames of 'kLISTS_PER_FRAME' lists, getting every pair from 'acquire'
+    // and handing it to 'retire' with the fence value of its submission once the frame is submitted.
+    template<class A, class R>
+    result run(std::size_t frame_number, A &&acquire, R &&retire)
+    {
+        auto device = stand_in::create_device();
+        graphics::queue_scheduler queues{device.get()};
+
+        auto &&timeline = queues.timeline(graphics::queue_type::graphics);
+
+        std::array<UINT64, kFRAMES_IN_FLIGHT> frame_fences{};
+
+        auto const ns_per_frame = benchmark::time_per_iteration(frame_number, [&] (std::size_t frame_index)
+        {
+            auto const slot = frame_index % kFRAMES_IN_FLIGHT;
+
+            timeline.wait(frame_fences[slot]);
+
+            std::array<graphics::command_context, kLISTS_PER_FRAME> contexts;
+            std::array<ID3D12CommandList *, kLISTS_PER_FRAME> command_lists;
+
+            for (auto index = 0u; index < kLISTS_PER_FRAME; ++index) {
+                contexts[index] = acquire(device.get(), slot);
+
+                contexts[index].command_list->DrawIndexedInstanced(3, 1, 0, 0, 0);
+                contexts[index].command_list->Close();
+
+                command_lists[index] = contexts[index].command_list.get();
+            }
+
+            frame_fences[slot] = queues.submit(graphics::queue_type::graphics, command_lists).value;
+
+            for (auto &&context : contexts)
+                retire(std::move(context), timeline, frame_fences[slot], slot);
+        });
+
+        queues.flush();
+
+        auto &&statistics = device->statistics();
+
+        return result{ns_per_frame, static_cast<double>(statistics.command_allocators + statistics.command_lists) / static_cast<double>(frame_number)};
+    }
+}
+
+// CPU time of getting the command lists of a frame from the pool against creating a fresh allocator and list
+// for each of them, as init_D3D used to. The stand-in device creates objects far more cheaply than a driver does,
+// so the gap on real hardware is larger; the objects created per frame are what the pool removes.
+int main()
+{
+    auto constexpr kFRAME_NUMBER = 20'000u;
+
+    fmt::print("{} frames of {} lists, {} frames in flight\n", kFRAME_NUMBER, kLISTS_PER_FRAME, kFRAMES_IN_FLIGHT);
+    fmt::print("source | ns per frame | objects created per frame\n");
+
+    {
+        std::unique_ptr<graphics::command_pool> command_pool;
+
+        auto const pooled = run(kFRAME_NUMBER, [&command_pool] (ID3D12Device6 *const device, std::size_t)
+        {
+            if (command_pool == nullptr)
+                command_pool = std::make_unique<graphics::command_pool>(device);
+
+            return command_pool->acquire(D3D12_COMMAND_LIST_TYPE_DIRECT);
+        },
+        [&command_pool] (graphics::command_context &&context, graphics::fence_timeline &timeline, UINT64 fence_value, std::size_t)
+        {
+            command_pool->release(std::move(context), timeline, fence_value);
+        });
+
+        fmt::print("pool   | {:12.0f} | {:.4f}\n", pooled.ns_per_frame, pooled.objects_per_frame);
+    }
+
+    {
+        // Fresh pairs are kept alive until the slot's fence is waited for again.
+        std::array<std::vector<graphics::command_context>, kFRAMES_IN_FLIGHT> in_flight;
+
+        auto const fresh = run(kFRAME_NUMBER, [&in_flight] (ID3D12Device6 *const device, std::size_t slot)
+        {
+            // The slot still holds the pairs of its previous frame, which the GPU is done with.
+            if (std::size(in_flight[slot]) == kLISTS_PER_FRAME)
+                in_flight[slot].clear();
+
+            auto command_allocator = create_command_allocator(device, D3D12_COMMAND_LIST_TYPE_DIRECT);
+            auto command_list = create_command_list(device, command_allocator.get(), D3D12_COMMAND_LIST_TYPE_DIRECT);
+
+            return graphics::command_context{command_allocator, command_list, D3D12_COMMAND_LIST_TYPE_DIRECT};
+        },
+        [&in_flight] (graphics::command_context &&context, graphics::fence_timeline &, UINT64, std::size_t slot)
+        {
+            in_flight[slot].push_back(std::move(context));
+        });
+
+        fmt::print("fresh  | {:12.0f} | {:.4f}\n", fresh.ns_per_frame, fresh.objects_per_frame);
+    }
+}
@@ -0,0 +1,63 @@
+#include "benchmark.hxx"
+
+#include "main.hxx"
+#include "graphics/descriptor.hxx"
+
+
+// Allocate and free throughput of the descriptor allocator as the number of threads grows. Every thread
+// allocates a batch of descriptors and frees them again, as a thread recording a pass would.
+int main()
+{
+    auto constexpr kBATCH_SIZE = 48;
+    auto constexpr kROUND_NUMBER = 20'000;
+
+    // Past the number of cores the threads contend for the free lists while they are preempted, which is the worst case.
+    auto const max_thread_number = (std::max)(std::thread::hardware_concurrency(), 8u);
+
+    fmt::print("threads | allocations + frees per second | ns per pair per thread\n");
+
+    for (auto thread_number = 1u; thread_number <= max_thread_number; thread_number *= 2) {
+        auto device = stand_in::create_device();
+        graphics::descriptor_allocator allocator{device.get()};
+
+        std::atomic<unsigned> ready{0};
+        std::atomic<bool> go{false};
+
+        std::vector<std::thread> threads;
+
+        for (auto thread = 0u; thread < thread_number; ++thread) {
+            threads.emplace_back([&]
+            {
+                std::array<graphics::descriptor, kBATCH_SIZE> descriptors;
+
+                ++ready;
+
+                while (!go.load())
+                    std::this_thread::yield();
+
+                for (auto round = 0; round < kROUND_NUMBER; ++round) {
+                    for (auto &&descriptor : descriptors)
+                        descriptor = allocator.allocate(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+                    for (auto &&descriptor : descriptors)
+                        allocator.free(descriptor);
+                }
+            });
+        }
+
+        while (ready.load() != thread_number)
+            std::this_thread::yield();
+
+        auto const start = benchmark::clock::now();
+
+        go.store(true);
+
+        for (auto &&thread : threads)
+            thread.join();
+
+        auto const seconds = std::chrono::duration<double>(benchmark::clock::now() - start).count();
+        auto const pairs = static_cast<double>(thread_number) * kROUND_NUMBER * kBATCH_SIZE;
+
+        fmt::print("{:7} | {:30.3e} | {:8.1f}\n", thread_number, pairs / seconds, seconds * 1e9 / (pairs / thread_number));
+    }
+}
@@ -0,0 +1,219 @@
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <boost/signals2.hpp>
+
+#include "benchmark.hxx"
+
+#include "platform/window.hxx"
+
+
+namespace
+{
+    using namespace std::chrono_literals;
+
+    auto constexpr kEVENT_RATE = 10'000u;
+    auto constexpr kEVENT_NUMBER = 20'000u;
+
+    auto constexpr kEVENT_PERIOD = std::chrono::nanoseconds{std::chrono::seconds{1}} / kEVENT_RATE;
+
+    // Of the render thread's wait for events, as in the frame loop when there is nothing to render.
+    auto constexpr kWAIT_TIMEOUT = 100ms;
+
+    // Cursor events carry the time they were pushed at as their x, so the handler can tell how long they took.
+    double timestamp() noexcept
+    {
+        return static_cast<double>(benchmark::clock::now().time_since_epoch().count());
+    }
+
+    struct latency_handler final : platform::event_handler_interface {
+        std::vector<double> latencies;
+
+        latency_handler() { latencies.reserve(kEVENT_NUMBER); }
+
+        void on_resize(std::int32_t, std::int32_t) override { }
+
+        void on_cursor(platform::cursor_event const &event) override
+        {
+            latencies.push_back((timestamp() - event.x) / 1'000.);
+        }
+    };
+
+    struct dispatch_result final {
+        double rate{0};
+
+        std::vector<double> push_times;
+        std::vector<double> latencies;
+
+        std::uint64_t wake_ups{0};
+        std::uint64_t dropped{0};
+    };
+
+    // The platform thread: moves the cursor of the stand-in window at kEVENT_RATE and times each callback.
+    void produce(GLFWwindow *window, dispatch_result &result)
+    {
+        result.push_times.reserve(kEVENT_NUMBER);
+
+        auto const start = benchmark::clock::now();
+
+        for (auto index = 0u; index < kEVENT_NUMBER; ++index) {
+            std::this_thread::sleep_until(start + index * kEVENT_PERIOD);
+
+            auto const push_start = benchmark::clock::now();
+
+            stand_in::move_cursor(window, timestamp(), 0.);
+
+            result.push_times.push_back(std::chrono::duration<double, std::nano>(benchmark::clock::now() - push_start).count());
+        }
+
+        result.rate = kEVENT_NUMBER / std::chrono::duration<double>(benchmark::clock::now() - start).count();
+    }
+
+    // How the window reported events before the queue: a signal emitted from the window callback, whose slot hands
+    // the events to the render thread under a mutex and wakes it with a condition variable, the least the old design
+    // needed to render on another thread.
+    dispatch_result signals2_dispatch()
+    {
+        struct hand_off final {
+            boost::signals2::signal<void(double, double)> signal;
+
+            std::mutex mutex;
+            std::condition_variable posted;
+
+            std::vector<platform::cursor_event> events;
+            bool done{false};
+        };
+
+        hand_off state;
+
+        state.signal.connect([&state] (double x, double y)
+        {
+            {
+                std::lock_guard lock{state.mutex};
+                state.events.push_back({x, y});
+            }
+
+            state.posted.notify_one();
+        });
+
+        auto const window = glfwCreateWindow(800, 600, "signals2", nullptr, nullptr);
+
+        glfwSetWindowUserPointer(window, &state);
+
+        glfwSetCursorPosCallback(window, [] (auto handle, auto x, auto y)
+        {
+            static_cast<hand_off *>(glfwGetWindowUserPointer(handle))->signal(x, y);
+        });
+
+        dispatch_result result;
+        latency_handler handler;
+
+        std::thread render_thread{[&state, &handler, &result]
+        {
+            std::vector<platform::cursor_event> batch;
+
+            while (true) {
+                {
+                    std::unique_lock lock{state.mutex};
+
+                    state.posted.wait_for(lock, kWAIT_TIMEOUT, [&state] { return !state.events.empty() || state.done; });
+
+                    if (state.events.empty() && state.done)
+                        return;
+
+                    batch.swap(state.events);
+                }
+
+                if (batch.empty())
+                    continue;
+
+                ++result.wake_ups;
+
+                for (auto &&event : batch)
+                    handler.on_cursor(event);
+
+                batch.clear();
+            }
+        }};
+
+        produce(window, result);
+
+        {
+            std::lock_guard lock{state.mutex};
+            state.done = true;
+        }
+
+        state.posted.notify_one();
+
+        render_thread.join();
+
+        glfwDestroyWindow(window);
+
+        result.latencies = std::move(handler.latencies);
+
+        return result;
+    }
+
+    // The window's callbacks push into its event queue; the render thread sleeps in wait_events() until woken.
+    dispatch_result event_queue_dispatch()
+    {
+        platform::window window{"event_queue", 800, 600};
+
+        auto const handler = std::make_shared<latency_handler>();
+
+        window.connect_event_handler(handler);
+
+        dispatch_result result;
+
+        std::thread render_thread{[&window]
+        {
+            auto &&events = window.events();
+
+            while (!events.should_close())
+                events.wait_events(kWAIT_TIMEOUT);
+
+            events.poll_events();
+        }};
+
+        produce(stand_in::window_of(window.handle()), result);
+
+        window.close();
+
+        render_thread.join();
+
+        auto const statistics = window.events().statistics();
+
+        result.wake_ups = statistics.batches;
+        result.dropped = statistics.dropped;
+        result.latencies = std::move(handler->latencies);
+
+        return result;
+    }
+
+    void print(std::string_view name, dispatch_result result)
+    {
+        auto const push_time = benchmark::summarize(std::move(result.push_times));
+        auto const latency = benchmark::summarize(result.latencies);
+
+        fmt::print("{:11} | {:8.0f} | {:9.0f} | {:9.0f} | {:9.1f} | {:9.1f} | {:9} | {:8} | {:7}\n", name, result.rate, push_time.median, push_time.p99,
+                   latency.median, latency.p99, std::size(result.latencies), result.wake_ups, result.dropped);
+    }
+}
+
+// Mouse input at 10k events per second through a stand-in window, from the platform thread to a render thread that
+// sleeps until events come: a boost::signals2 signal handing the events over under a mutex against the window's event
+// queue, whose render thread blocks in wait_events(). The push time is what the message loop pays per event; the
+// latency is from the callback to the handler and includes waking the render thread.
+int main()
+{
+    fmt::print("{} events at {} per second, {} cores\n", kEVENT_NUMBER, kEVENT_RATE, std::thread::hardware_concurrency());
+    fmt::print("{:11} | {:>8} | {:>9} | {:>9} | {:>9} | {:>9} | {:>9} | {:>8} | {:>7}\n", "dispatch", "events/s", "push p50",
+               "push p99", "latency", "latency", "delivered", "wake-ups", "dropped");
+    fmt::print("{:11} | {:8} | {:>9} | {:>9} | {:>9} | {:>9} | {:9} | {:8} | {:7}\n", "", "", "ns", "ns", "p50, us", "p99, us", "", "", "");
+
+    print("signals2", signals2_dispatch());
+    print("event_queue", event_queue_dispatch());
+}
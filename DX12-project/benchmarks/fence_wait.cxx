@@ -0,0 +1,40 @@
+#include "benchmark.hxx"
+
+#include "main.hxx"
+#include "graphics/command.hxx"
+#include "graphics/fence.hxx"
+
+
+// The cost of a blocking fence wait with the timeline's pooled event and with a fresh event per wait,
+// the way flush_command_queue() used to do it. The GPU runs on the waiting thread when the wait blocks,
+// so the numbers are the CPU-side cost of a wait without any scheduling noise.
+int main()
+{
+    auto constexpr kWAIT_NUMBER = 20'000;
+
+    auto device = stand_in::create_device();
+    auto queue = create_command_queue(device.get(), D3D12_COMMAND_LIST_TYPE_DIRECT);
+
+    graphics::fence_timeline timeline{device.get()};
+
+    auto const pooled = benchmark::time_per_iteration(kWAIT_NUMBER, [&] (auto)
+    {
+        timeline.wait(timeline.signal(queue.get()));
+    });
+
+    auto const fresh = benchmark::time_per_iteration(kWAIT_NUMBER, [&] (auto)
+    {
+        auto const value = timeline.signal(queue.get());
+
+        auto event_handle = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
+
+        timeline.get()->SetEventOnCompletion(value, event_handle);
+        WaitForSingleObject(event_handle, INFINITE);
+
+        CloseHandle(event_handle);
+    });
+
+    fmt::print("signal and wait with the pooled event: {:8.0f} ns\n", pooled);
+    fmt::print("signal and wait with a fresh event:    {:8.0f} ns\n", fresh);
+    fmt::print("events created: {}\n", stand_in::win32().events_created.load());
+}
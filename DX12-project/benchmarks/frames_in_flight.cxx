@@ -0,0 +1,61 @@
+#include "benchmark.hxx"
+
+#include "main.hxx"
+#include "graphics/command_pool.hxx"
+#include "graphics/frame.hxx"
+#include "graphics/queue.hxx"
+
+
+// CPU frame time with one, two and three frames in flight when the GPU takes as long per frame as the CPU.
+// With one frame the CPU waits for every frame it submits; with more it only waits when it gets a full ring ahead.
+int main()
+{
+    auto constexpr kFRAME_COUNT = 200;
+
+    auto constexpr kCPU_TIME = std::chrono::microseconds{1000};
+    auto constexpr kGPU_TIME = std::chrono::microseconds{1000};
+
+    stand_in::gpu_thread gpu{kGPU_TIME};
+
+    fmt::print("frames in flight | CPU frame time (mean / median / p99, us) | time blocked on the fence (mean, us)\n");
+
+    for (auto frames_in_flight = 1u; frames_in_flight <= 3; ++frames_in_flight) {
+        auto device = stand_in::create_device();
+
+        graphics::resource_state_registry resource_states;
+        graphics::queue_scheduler queues{device.get()};
+        graphics::command_pool command_pool{device.get()};
+
+        auto frame_contexts = create_frame_contexts(frames_in_flight, resource_states);
+
+        std::vector<double> frame_times;
+        std::vector<double> wait_times;
+
+        for (auto index = 0; index < kFRAME_COUNT; ++index) {
+            auto const start = benchmark::clock::now();
+
+            auto &frame = frame_contexts[index % frames_in_flight];
+
+            queues.timeline(graphics::queue_type::graphics).wait(frame.fence_value);
+
+            auto const waited = benchmark::clock::now();
+
+            begin_command_lists(frame, command_pool, D3D12_COMMAND_LIST_TYPE_DIRECT);
+
+            // Recording.
+            while (benchmark::clock::now() - waited < kCPU_TIME);
+
+            frame.fence_value = submit_command_lists(frame, command_pool, queues, graphics::queue_type::graphics);
+
+            frame_times.push_back(benchmark::microseconds(benchmark::clock::now() - start));
+            wait_times.push_back(benchmark::microseconds(waited - start));
+        }
+
+        queues.flush();
+
+        auto const frame_time = benchmark::summarize(frame_times);
+
+        fmt::print("{:16} | {:8.0f} / {:8.0f} / {:8.0f}{:17}| {:8.0f}\n", frames_in_flight,
+                   frame_time.mean, frame_time.median, frame_time.p99, "", benchmark::summarize(wait_times).mean);
+    }
+}
@@ -0,0 +1,161 @@
+#include <random>
+
+#include "benchmark.hxx"
+
+#include "graphics/draw_commands.hxx"
+#include "graphics/instance_store.hxx"
+
+
+namespace
+{
+    // Same as the upload merge gap of indirect_draws.
+    auto constexpr kMERGE_GAP = 16u;
+
+    graphics::gpu_instance random_instance(std::mt19937 &generator, std::uint32_t mesh_count)
+    {
+        std::uniform_real_distribution<float> position{-2.f, 2.f};
+
+        graphics::gpu_instance instance;
+
+        instance.transform[3] = position(generator);
+        instance.transform[7] = position(generator);
+        instance.transform[11] = std::uniform_real_distribution<float>{0.f, 1.f}(generator);
+
+        instance.bounds = {0.f, 0.f, 0.f, .05f};
+        instance.mesh = std::uniform_int_distribution<std::uint32_t>{0, mesh_count - 1}(generator);
+
+        return instance;
+    }
+
+    struct upload final {
+        std::uint64_t bytes{0};
+        std::uint64_t copies{0};
+    };
+
+    upload collect_upload(graphics::instance_store<graphics::gpu_instance> &store)
+    {
+        upload result;
+
+        store.for_each_dirty_range(kMERGE_GAP, [&result] (graphics::dirty_range range)
+        {
+            result.bytes += static_cast<std::uint64_t>(range.count) * sizeof(graphics::gpu_instance);
+            ++result.copies;
+        });
+
+        store.clear_dirty();
+
+        return result;
+    }
+
+    void run(std::uint32_t instance_count)
+    {
+        auto constexpr kMESH_COUNT = 256u;
+        auto constexpr kFRAME_NUMBER = 100;
+
+        std::mt19937 generator{20};
+
+        std::vector<graphics::mesh_draw> meshes(kMESH_COUNT);
+
+        for (auto index = 0u; index < kMESH_COUNT; ++index)
+            meshes[index] = graphics::mesh_draw{36 + index * 3, index * 1024, 0, 0};
+
+        graphics::instance_store<graphics::gpu_instance> store{instance_count};
+
+        std::vector<graphics::instance_handle> handles;
+        handles.reserve(instance_count);
+
+        std::vector<graphics::gpu_instance> instances(instance_count);
+
+        for (auto &&instance : instances)
+            instance = random_instance(generator, kMESH_COUNT);
+
+        auto const insert_ns = benchmark::time_per_iteration(instance_count, [&] (std::size_t index)
+        {
+            handles.push_back(store.insert(instances[index]));
+        });
+
+        auto const initial = collect_upload(store);
+
+        fmt::print("{} instances\n", instance_count);
+        fmt::print("  insert                       {:8.1f} ns per instance, first upload {} MiB in {} copy\n",
+                   insert_ns, initial.bytes >> 20, initial.copies);
+
+        // Frames that move 1% of the instances, and frames that replace 1% of them.
+        for (auto churn : {false, true}) {
+            std::vector<double> samples;
+            upload total;
+
+            auto const changes = instance_count / 100;
+
+            std::vector<std::size_t> positions(changes);
+            std::vector<graphics::gpu_instance> replacements(changes);
+
+            for (auto frame = 0; frame < kFRAME_NUMBER; ++frame) {
+                // The changes come from the scene; only applying them is timed.
+                for (auto change = 0u; change < changes; ++change) {
+                    positions[change] = std::uniform_int_distribution<std::size_t>{0, std::size(handles) - 1}(generator);
+                    replacements[change] = random_instance(generator, kMESH_COUNT);
+                }
+
+                auto const start = benchmark::clock::now();
+
+                for (auto change = 0u; change < changes; ++change) {
+                    auto &&handle = handles[positions[change]];
+
+                    if (churn) {
+                        store.erase(handle);
+                        handle = store.insert(replacements[change]);
+                    }
+
+                    else store.update(handle, replacements[change]);
+                }
+
+                auto const frame_upload = collect_upload(store);
+
+                samples.push_back(benchmark::microseconds(benchmark::clock::now() - start));
+
+                total.bytes += frame_upload.bytes;
+                total.copies += frame_upload.copies;
+            }
+
+            auto const summary = benchmark::summarize(std::move(samples));
+
+            fmt::print("  {} 1% per frame   {:8.1f} us median, {:8.1f} us p99; {:6.2f} MiB in {:6} copies per frame, "
+                       "{:5.1f}% of a full upload\n",
+                       churn ? "replace" : "update ", summary.median, summary.p99,
+                       static_cast<double>(total.bytes) / kFRAME_NUMBER / (1 << 20), total.copies / kFRAME_NUMBER,
+                       100. * static_cast<double>(total.bytes) / kFRAME_NUMBER / static_cast<double>(initial.bytes));
+        }
+
+        // The CPU reference of the culling pass: the work the GPU takes over from per-object draw calls.
+        auto const view_frustum = graphics::frustum_of({1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f});
+
+        std::vector<graphics::indirect_draw_command> commands(instance_count);
+        std::uint32_t visible = 0;
+
+        std::vector<double> samples;
+
+        for (auto sample = 0; sample < 10; ++sample) {
+            auto const start = benchmark::clock::now();
+
+            visible = graphics::pack_draw_commands(store.instances(), meshes, view_frustum, commands);
+
+            samples.push_back(benchmark::microseconds(benchmark::clock::now() - start));
+        }
+
+        benchmark::keep(commands);
+
+        auto const summary = benchmark::summarize(std::move(samples));
+
+        fmt::print("  pack draw commands           {:8.1f} us median, {:5.2f} ns per instance; {} visible\n",
+                   summary.median, summary.median * 1000. / instance_count, visible);
+    }
+}
+
+// Per-frame CPU cost of the GPU-driven instance store at 100k and 1M instances: updating or replacing 1% of
+// the instances and collecting the dirty ranges to upload, and packing the draw commands on the CPU for comparison.
+int main()
+{
+    run(100'000);
+    run(1'000'000);
+}
@@ -0,0 +1,126 @@
+#include "benchmark.hxx"
+
+#include "main.hxx"
+#include "platform/job_system.hxx"
+
+
+namespace
+{
+    // About half a microsecond of arithmetic that the compiler can't fold away.
+    std::uint64_t leaf_work(std::uint64_t seed)
+    {
+        auto value = seed;
+
+        for (auto step = 0; step < 400; ++step)
+            value = value * 6364136223846793005ull + 1442695040888963407ull;
+
+        return value;
+    }
+
+    // Every index of a flat range, like the draw batches of a pass.
+    void flat_graph(platform::job_system &jobs, std::vector<std::uint64_t> &results)
+    {
+        jobs.parallel_for(static_cast<std::uint32_t>(std::size(results)), 16, [&results] (auto begin, auto end)
+        {
+            for (auto index = begin; index < end; ++index)
+                results[index] = leaf_work(index);
+        });
+    }
+
+    // Recursive fork-join: every job splits its range in two and waits for the halves.
+    void split(platform::job_system &jobs, std::vector<std::uint64_t> &results, std::uint32_t begin, std::uint32_t end)
+    {
+        if (end - begin <= 16) {
+            for (auto index = begin; index < end; ++index)
+                results[index] = leaf_work(index);
+
+            return;
+        }
+
+        auto const middle = begin + (end - begin) / 2;
+
+        platform::job_counter counter;
+
+        jobs.run(counter, [&jobs, &results, begin, middle] { split(jobs, results, begin, middle); });
+        split(jobs, results, middle, end);
+
+        jobs.wait(counter);
+    }
+
+    void fork_join_graph(platform::job_system &jobs, std::vector<std::uint64_t> &results)
+    {
+        split(jobs, results, 0, static_cast<std::uint32_t>(std::size(results)));
+    }
+
+    // Stages that depend on each other, like the passes of a frame: each one starts after the previous one is done.
+    void staged_graph(platform::job_system &jobs, std::vector<std::uint64_t> &results)
+    {
+        auto constexpr kSTAGE_NUMBER = 8u;
+
+        auto const stage_size = static_cast<std::uint32_t>(std::size(results)) / kSTAGE_NUMBER;
+
+        for (auto stage = 0u; stage < kSTAGE_NUMBER; ++stage) {
+            jobs.parallel_for(stage_size, 8, [&results, stage, stage_size] (auto begin, auto end)
+            {
+                for (auto index = stage * stage_size + begin; index < stage * stage_size + end; ++index)
+                    results[index] = leaf_work(stage == 0 ? index : results[index - stage_size]);
+            });
+        }
+    }
+}
+
+// Time of synthetic task graphs on the job system from one thread up to every core. The thread count includes the
+// calling thread, which takes part in the work while it waits.
+int main()
+{
+    auto constexpr kJOB_NUMBER = 8192u;
+    auto constexpr kSAMPLE_NUMBER = 30;
+
+    auto const max_thread_number = (std::max)(std::thread::hardware_concurrency(), 4u);
+
+    struct graph final {
+        std::string_view name;
+        void (*run)(platform::job_system &, std::vector<std::uint64_t> &);
+    };
+
+    auto const graphs = std::array{
+        graph{"flat"sv, flat_graph},
+        graph{"fork-join"sv, fork_join_graph},
+        graph{"staged"sv, staged_graph}
+    };
+
+    fmt::print("{} cores; {} leaf jobs of about half a microsecond per graph\n", std::thread::hardware_concurrency(), kJOB_NUMBER);
+    fmt::print("graph     | threads | median us | p99 us    | speedup\n");
+
+    for (auto &&[name, run] : graphs) {
+        double single_thread_median = 0;
+
+        for (auto thread_number = 1u; thread_number <= max_thread_number; thread_number *= 2) {
+            platform::job_system jobs{thread_number - 1};
+
+            std::vector<std::uint64_t> results(kJOB_NUMBER);
+            std::vector<double> samples;
+
+            // Warms the workers up.
+            run(jobs, results);
+
+            for (auto sample = 0; sample < kSAMPLE_NUMBER; ++sample) {
+                auto const start = benchmark::clock::now();
+
+                run(jobs, results);
+
+                samples.push_back(benchmark::microseconds(benchmark::clock::now() - start));
+            }
+
+            benchmark::keep(results);
+
+            auto const summary = benchmark::summarize(std::move(samples));
+
+            if (thread_number == 1)
+                single_thread_median = summary.median;
+
+            fmt::print("{:9} | {:7} | {:9.1f} | {:9.1f} | {:7.2f}\n", name, thread_number, summary.median, summary.p99,
+                       single_thread_median / summary.median);
+        }
+    }
+}
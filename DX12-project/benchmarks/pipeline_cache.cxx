@@ -0,0 +1,131 @@
+#include <random>
+#include <sstream>
+#include <thread>
+
+#include "benchmark.hxx"
+
+#include "utility/deduplicating_map.hxx"
+#include "graphics/pipeline_cache_file.hxx"
+
+
+namespace
+{
+    auto constexpr kENTRY_NUMBER = 50'000u;
+    auto constexpr kLOOKUP_NUMBER = 2'000'000u;
+
+    // About the size of the cached blob of a simple graphics pipeline.
+    auto constexpr kBLOB_SIZE = 2048u;
+}
+
+// Lookups in a pipeline cache file of 50k entries, each of which verifies the blob's checksum, and in the in-memory
+// deduplicating map the cache keeps its pipelines in, from one thread and from several at once. Half of the lookups
+// are for hashes that aren't there.
+int main()
+{
+    std::mt19937_64 generator{9};
+
+    std::vector<std::uint64_t> hashes(kENTRY_NUMBER);
+
+    for (auto &&hash : hashes)
+        hash = generator() | 1;
+
+    std::vector<std::byte> blobs(static_cast<std::size_t>(kENTRY_NUMBER) * kBLOB_SIZE);
+
+    for (auto &&value : blobs)
+        value = static_cast<std::byte>(generator());
+
+    std::vector<graphics::pipeline_cache_entry> entries;
+
+    for (auto index = 0u; index < kENTRY_NUMBER; ++index)
+        entries.push_back(graphics::pipeline_cache_entry{hashes[index], std::span{blobs}.subspan(index * kBLOB_SIZE, kBLOB_SIZE)});
+
+    auto const key = graphics::pipeline_cache_key{0x10de, 0x2484, 1};
+
+    std::ostringstream stream;
+
+    auto const write_start = benchmark::clock::now();
+
+    graphics::write_pipeline_cache(stream, key, entries);
+
+    auto const write_ms = benchmark::microseconds(benchmark::clock::now() - write_start) / 1'000.;
+
+    auto const text = stream.str();
+    auto const file = std::as_bytes(std::span{text});
+
+    auto const open_start = benchmark::clock::now();
+
+    auto const view = graphics::pipeline_cache_view::open(file, key);
+
+    auto const open_us = benchmark::microseconds(benchmark::clock::now() - open_start);
+
+    if (!view || view->size() != kENTRY_NUMBER) {
+        fmt::print("the cache file didn't open\n");
+        return 1;
+    }
+
+    // Even lookups hit, odd ones miss: the stored hashes are all odd.
+    std::vector<std::uint64_t> lookups(kLOOKUP_NUMBER);
+
+    for (auto index = 0u; index < kLOOKUP_NUMBER; ++index)
+        lookups[index] = index % 2 == 0 ? hashes[generator() % kENTRY_NUMBER] : generator() & ~1ull;
+
+    std::size_t found = 0;
+
+    auto const find_ns = benchmark::time_per_iteration(kLOOKUP_NUMBER, [&] (auto index)
+    {
+        found += view->find(lookups[index]).empty() ? 0 : 1;
+    });
+
+    fmt::print("{} entries of {} bytes, {:.1f} MiB file: written in {:.1f} ms, opened in {:.1f} us\n", kENTRY_NUMBER, kBLOB_SIZE,
+               static_cast<double>(std::size(file)) / (1 << 20), write_ms, open_us);
+    fmt::print("pipeline_cache_view::find       {:8.1f} ns per lookup ({} found)\n", find_ns, found);
+
+    utility::deduplicating_map<std::uint64_t> map;
+
+    for (auto hash : hashes)
+        map.get_or_create(hash, [hash] { return hash; });
+
+    // Only hits: a miss would create the value.
+    for (auto index = 1u; index < kLOOKUP_NUMBER; index += 2)
+        lookups[index] = hashes[generator() % kENTRY_NUMBER];
+
+    std::uint64_t sum = 0;
+
+    auto const map_ns = benchmark::time_per_iteration(kLOOKUP_NUMBER, [&] (auto index)
+    {
+        sum += map.get_or_create(lookups[index], [] { return std::uint64_t{0}; });
+    });
+
+    benchmark::keep(sum);
+
+    fmt::print("deduplicating_map::get_or_create {:7.1f} ns per lookup, 1 thread\n", map_ns);
+
+    for (auto thread_number : {2u, 4u, 8u}) {
+        std::vector<std::thread> threads;
+
+        auto const start = benchmark::clock::now();
+
+        for (auto thread = 0u; thread < thread_number; ++thread) {
+            threads.emplace_back([&map, &lookups, thread, thread_number]
+            {
+                std::uint64_t local_sum = 0;
+
+                for (auto index = thread; index < kLOOKUP_NUMBER; index += thread_number)
+                    local_sum += map.get_or_create(lookups[index], [] { return std::uint64_t{0}; });
+
+                benchmark::keep(local_sum);
+            });
+        }
+
+        for (auto &&thread : threads)
+            thread.join();
+
+        auto const ns = std::chrono::duration<double, std::nano>(benchmark::clock::now() - start).count() / kLOOKUP_NUMBER;
+
+        fmt::print("deduplicating_map::get_or_create {:7.1f} ns per lookup, {} threads\n", ns, thread_number);
+    }
+
+    auto const counters = map.counters();
+
+    fmt::print("{} created, {} reused\n", counters.created, counters.reused);
+}
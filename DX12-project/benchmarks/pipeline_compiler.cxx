@@ -0,0 +1,149 @@
+#include <thread>
+
+#include "benchmark.hxx"
+
+#include "graphics/pipeline_compiler.hxx"
+
+
+namespace
+{
+    using namespace std::chrono_literals;
+
+    using compiler = graphics::basic_pipeline_compiler<int>;
+
+    auto constexpr kPIPELINE_NUMBER = 1000u;
+
+    // New pipelines the scene needs each frame until it has asked for all of them, like a level streaming in.
+    auto constexpr kNEW_PER_FRAME = 50u;
+
+    // Half of the pipelines are known up front and prewarmed at low priority.
+    auto constexpr kPREWARMED_NUMBER = kPIPELINE_NUMBER / 2;
+
+    auto constexpr kCOMPILE_TIME = 2ms;
+    auto constexpr kRECORD_TIME = 2ms;
+
+    void compile()
+    {
+        std::this_thread::sleep_for(kCOMPILE_TIME);
+    }
+
+    void record()
+    {
+        auto const start = benchmark::clock::now();
+
+        while (benchmark::clock::now() - start < kRECORD_TIME);
+    }
+
+    struct frame_statistics final {
+        benchmark::summary frame_time;
+        std::size_t frames{0};
+        std::size_t skipped_draws{0};
+        std::size_t fallback_draws{0};
+    };
+
+    void print(std::string_view name, frame_statistics const &statistics)
+    {
+        fmt::print("{:22} | {:6} | {:8.1f} | {:8.1f} | {:8.1f} | {:13} | {:14}\n", name, statistics.frames, statistics.frame_time.median,
+                   statistics.frame_time.p95, statistics.frame_time.p99, statistics.skipped_draws, statistics.fallback_draws);
+    }
+
+    // The render thread compiles each pipeline the first time a draw needs it.
+    frame_statistics compile_on_first_use()
+    {
+        std::vector<bool> compiled(kPIPELINE_NUMBER, false);
+        std::vector<double> frame_times;
+
+        for (auto needed = 0u; needed < kPIPELINE_NUMBER; ) {
+            auto const start = benchmark::clock::now();
+
+            needed = (std::min)(needed + kNEW_PER_FRAME, kPIPELINE_NUMBER);
+
+            for (auto index = 0u; index < needed; ++index) {
+                if (!compiled[index]) {
+                    compile();
+                    compiled[index] = true;
+                }
+            }
+
+            record();
+
+            frame_times.push_back(benchmark::microseconds(benchmark::clock::now() - start) / 1'000.);
+        }
+
+        auto const frames = std::size(frame_times);
+
+        return frame_statistics{benchmark::summarize(std::move(frame_times)), frames, 0, 0};
+    }
+
+    // Draws request their pipeline at high priority, raise prewarmed ones, and use the fallback or skip until it is ready.
+    // Frames keep coming until every pipeline is ready.
+    frame_statistics compile_in_background(std::uint32_t worker_count)
+    {
+        compiler pipelines{worker_count};
+
+        auto const fallback = compiler::handle::make_ready(0);
+
+        std::vector<compiler::handle> handles(kPIPELINE_NUMBER);
+
+        for (auto index = 0u; index < kPREWARMED_NUMBER; ++index)
+            handles[index * 2] = pipelines.request([] { compile(); return 1; }, graphics::pipeline_priority::low, fallback);
+
+        frame_statistics statistics;
+        std::vector<double> frame_times;
+
+        auto ready = 0u;
+
+        for (auto needed = 0u; ready < kPIPELINE_NUMBER; ) {
+            auto const start = benchmark::clock::now();
+
+            needed = (std::min)(needed + kNEW_PER_FRAME, kPIPELINE_NUMBER);
+            ready = 0;
+
+            for (auto index = 0u; index < needed; ++index) {
+                auto &&pipeline = handles[index];
+
+                if (!pipeline) {
+                    // Half of these have no fallback, e.g. because there is no cheaper variant.
+                    pipeline = pipelines.request([] { compile(); return 1; }, graphics::pipeline_priority::high,
+                                                 index % 4 == 1 ? compiler::handle{ } : fallback);
+                }
+
+                else if (pipeline.status() == graphics::pipeline_status::pending)
+                    pipelines.prioritize(pipeline, graphics::pipeline_priority::high);
+
+                if (pipeline.get() != nullptr)
+                    ++ready;
+
+                else if (pipeline.current() != nullptr)
+                    ++statistics.fallback_draws;
+
+                else
+                    ++statistics.skipped_draws;
+            }
+
+            record();
+
+            frame_times.push_back(benchmark::microseconds(benchmark::clock::now() - start) / 1'000.);
+        }
+
+        statistics.frames = std::size(frame_times);
+        statistics.frame_time = benchmark::summarize(std::move(frame_times));
+
+        return statistics;
+    }
+}
+
+// Frame times while 1000 pipeline requests of 2 ms each drain, with 2 ms of recording per frame. The scene asks for 50
+// new pipelines a frame; half of them were prewarmed at low priority and get raised once a draw needs them. Compiling
+// on the render thread stalls the frames that need new pipelines; the background compiler keeps the frame time at the
+// recording time and trades the stalls for draws that use a fallback or are skipped for a few frames.
+int main()
+{
+    fmt::print("{:22} | {:6} | {:>8} | {:>8} | {:>8} | {:13} | {:14}\n", "", "frames", "p50, ms", "p95, ms", "p99, ms", "skipped draws",
+               "fallback draws");
+
+    print("on first use", compile_on_first_use());
+
+    for (auto worker_count : {1u, 2u, 4u})
+        print(fmt::format("background, {} worker{}", worker_count, worker_count > 1 ? "s" : ""), compile_in_background(worker_count));
+}
@@ -0,0 +1,122 @@
+#include <array>
+#include <random>
+
+#include "benchmark.hxx"
+
+#include "graphics/render_graph.hxx"
+
+
+namespace
+{
+    using graphics::queue_type;
+    using graphics::resource_access;
+
+    auto constexpr kPASS_NUMBER = 500u;
+    auto constexpr kSAMPLE_NUMBER = 2'000;
+
+    // Every pass reads a few of the targets written by the recent passes and writes one of its own, a few of them
+    // on the compute and copy queues; every 50th pass also writes one of the imported resources. 'variant' changes
+    // one access, so two variants have different topologies.
+    void build_graph(graphics::render_graph &graph, std::uint32_t variant)
+    {
+        graph.clear();
+
+        std::mt19937 generator{11};
+
+        std::array<std::uint32_t, 4> imported;
+
+        for (auto &&resource : imported)
+            resource = graph.import_resource("imported", resource_access::shader_read, resource_access::shader_read);
+
+        std::vector<std::uint32_t> targets;
+
+        for (auto index = 0u; index < kPASS_NUMBER; ++index) {
+            auto const queue = index % 10 == 3 ? queue_type::compute : index % 25 == 7 ? queue_type::copy : queue_type::graphics;
+            auto const pass = graph.add_pass("pass", queue);
+
+            for (auto read = std::min<std::size_t>(generator() % 3 + 1, std::size(targets)); read > 0; --read) {
+                auto const window = std::min<std::size_t>(std::size(targets), 16);
+                auto const access = index == variant ? resource_access::shader_read | resource_access::copy_source : resource_access::shader_read;
+
+                graph.read(pass, targets[std::size(targets) - 1 - generator() % window], access);
+            }
+
+            targets.push_back(graph.create_resource("target"));
+
+            graph.write(pass, targets.back(), queue == queue_type::graphics ? resource_access::render_target : resource_access::unordered_access);
+
+            if (index % 50 == 49)
+                graph.write(pass, imported[index / 50 % std::size(imported)], resource_access::render_target);
+        }
+    }
+
+    void report(char const *name, std::vector<double> samples)
+    {
+        auto const summary = benchmark::summarize(std::move(samples));
+
+        fmt::print("{:28} | {:9.1f} | {:9.1f} | {:9.1f}\n", name, summary.mean, summary.median, summary.p99);
+    }
+}
+
+// Compilation of a synthetic 500-pass graph. Cold compilations run on a new compiler, recompilations alternate two
+// topologies on the same one so that its scratch storage is reused, and cached ones only build and compare the
+// topology key. Graphs are rebuilt before every compilation, but only the compilation is timed.
+int main()
+{
+    graphics::render_graph graph;
+
+    std::vector<double> cold, recompiled, cached, building;
+
+    for (auto sample = 0; sample < kSAMPLE_NUMBER; ++sample) {
+        build_graph(graph, 0);
+
+        graphics::render_graph_compiler compiler;
+
+        auto const start = benchmark::clock::now();
+
+        benchmark::keep(compiler.compile(graph).order.back());
+
+        cold.push_back(benchmark::microseconds(benchmark::clock::now() - start));
+    }
+
+    graphics::render_graph_compiler compiler;
+
+    for (auto sample = 0; sample < kSAMPLE_NUMBER; ++sample) {
+        auto const start = benchmark::clock::now();
+
+        build_graph(graph, static_cast<std::uint32_t>(sample % 2) + 100);
+
+        building.push_back(benchmark::microseconds(benchmark::clock::now() - start));
+
+        auto const compile_start = benchmark::clock::now();
+
+        benchmark::keep(compiler.compile(graph).order.back());
+
+        recompiled.push_back(benchmark::microseconds(benchmark::clock::now() - compile_start));
+    }
+
+    for (auto sample = 0; sample < kSAMPLE_NUMBER; ++sample) {
+        build_graph(graph, 100);
+
+        auto const start = benchmark::clock::now();
+
+        benchmark::keep(compiler.compile(graph).order.back());
+
+        cached.push_back(benchmark::microseconds(benchmark::clock::now() - start));
+    }
+
+    auto &&compiled = compiler.compile(graph);
+
+    fmt::print("{} passes, {} resources: {} culled, {} barriers, {} batches\n", kPASS_NUMBER, std::size(graph.resources()),
+               compiled.culled_pass_count, std::size(compiled.barriers), std::size(compiled.batches));
+
+    fmt::print("                             | mean us   | median us | p99 us\n");
+
+    report("building the graph", std::move(building));
+    report("cold compilation", std::move(cold));
+    report("recompilation", std::move(recompiled));
+    report("cached", std::move(cached));
+
+    // The first cached sample compiles once more, to switch back to the topology it keeps.
+    fmt::print("{} compilations of {} graphs on the shared compiler\n", compiler.compilation_count(), 2 * kSAMPLE_NUMBER + 1);
+}
@@ -0,0 +1,58 @@
+#include <random>
+
+#include "benchmark.hxx"
+
+#include "graphics/tlsf.hxx"
+
+
+// Allocate and free throughput of the TLSF allocator on a 256MB range with 64KB granularity, the way the
+// memory allocator uses it, with about 200 live allocations of a random mix of sizes. An operation is an
+// allocation followed by the free of a random live allocation.
+int main()
+{
+    auto constexpr kOPERATION_NUMBER = 2'000'000;
+    auto constexpr kLIVE_TARGET = 200;
+
+    graphics::tlsf_allocator allocator{256ull << 20, 64ull << 10};
+
+    std::mt19937_64 generator{3};
+
+    // Precomputed so that the generator stays out of the timing.
+    std::vector<std::uint64_t> sizes(kOPERATION_NUMBER);
+
+    for (auto &&size : sizes)
+        size = (generator() % 4 == 0 ? generator() % (4ull << 20) : generator() % (256ull << 10)) + 1;
+
+    std::vector<graphics::tlsf_allocator::allocation> live;
+    live.reserve(kLIVE_TARGET * 2);
+
+    std::size_t failed = 0;
+    std::size_t frees = 0;
+
+    auto const nanoseconds = benchmark::time_per_iteration(kOPERATION_NUMBER, [&] (auto index)
+    {
+        if (std::size(live) < kLIVE_TARGET || (sizes[index] & 1) != 0) {
+            if (auto allocation = allocator.allocate(sizes[index], 64ull << 10); allocation.valid())
+                live.push_back(allocation);
+
+            else ++failed;
+        }
+
+        if (std::size(live) >= kLIVE_TARGET) {
+            auto const victim = sizes[index] % std::size(live);
+
+            allocator.free(live[victim]);
+
+            live[victim] = live.back();
+            live.pop_back();
+
+            ++frees;
+        }
+    });
+
+    auto const statistics = allocator.statistics();
+
+    fmt::print("{:.1f} ns per operation ({} frees, {} failed allocations)\n", nanoseconds, frees, failed);
+    fmt::print("used {:.0f}%, {} free blocks, fragmentation {:.2f}\n", 100. * static_cast<double>(statistics.used) / static_cast<double>(statistics.size),
+               statistics.free_block_count, statistics.fragmentation());
+}
@@ -0,0 +1,54 @@
+#include "benchmark.hxx"
+
+#include "main.hxx"
+#include "graphics/command_pool.hxx"
+#include "graphics/queue.hxx"
+#include "graphics/streaming.hxx"
+
+
+// Throughput of the upload service in MB/s as the batch size grows, for small and large requests. Each run
+// enqueues the requests from the calling thread and flushes; the worker stages them and the stand-in copy queue
+// executes the copies when the worker runs out of pages or the flush waits.
+int main()
+{
+    auto constexpr kTOTAL_SIZE = 256ull << 20;
+    auto constexpr kDESTINATION_SIZE = 32ull << 20;
+
+    auto device = stand_in::create_device();
+
+    graphics::queue_scheduler queues{device.get()};
+    graphics::command_pool command_pool{device.get()};
+
+    winrt::com_ptr<ID3D12Resource> destination;
+    destination.attach(new ID3D12Resource{CD3DX12_RESOURCE_DESC::Buffer(kDESTINATION_SIZE), D3D12_HEAP_TYPE_DEFAULT});
+
+    fmt::print("{} MiB per run through a ring of 4 pages of 4 MiB\n", kTOTAL_SIZE >> 20);
+    fmt::print("request KiB | batch KiB | MB/s    | batches | requests per batch\n");
+
+    for (auto request_size : {4ull << 10, 64ull << 10, 1ull << 20}) {
+        std::vector<std::byte> const data(request_size, std::byte{1});
+
+        for (auto batch_size : {16ull << 10, 64ull << 10, 256ull << 10, 1ull << 20, 4ull << 20}) {
+            if (batch_size < request_size)
+                continue;
+
+            graphics::upload_service uploads{device.get(), command_pool, queues, 4ull << 20, 4, batch_size};
+
+            auto const request_number = kTOTAL_SIZE / request_size;
+
+            auto const start = benchmark::clock::now();
+
+            for (auto index = 0ull; index < request_number; ++index)
+                (void)uploads.upload_buffer(destination.get(), index * request_size % kDESTINATION_SIZE, data);
+
+            uploads.flush();
+
+            auto const seconds = std::chrono::duration<double>(benchmark::clock::now() - start).count();
+            auto const statistics = uploads.statistics();
+
+            fmt::print("{:11} | {:9} | {:7.0f} | {:7} | {:.1f}\n", request_size >> 10, batch_size >> 10,
+                       static_cast<double>(statistics.bytes) / seconds / 1e6, statistics.batches,
+                       static_cast<double>(statistics.requests) / static_cast<double>(statistics.batches));
+        }
+    }
+}
@@ -0,0 +1,77 @@
+#include "indirect.hlsli"
+
+// Mirrors graphics::pack_draw_commands.
+
+struct culling_bindings
+{
+    uint instances;
+    uint meshes;
+    uint commands;
+    uint command_count;
+};
+
+ConstantBuffer<culling_bindings> bindings : register(b0);
+ConstantBuffer<culling_constants> constants : register(b1);
+
+bool visible(instance_data instance)
+{
+    float3 const center = float3(
+        dot(instance.transform[0], float4(instance.bounds.xyz, 1)),
+        dot(instance.transform[1], float4(instance.bounds.xyz, 1)),
+        dot(instance.transform[2], float4(instance.bounds.xyz, 1))
+    );
+
+    float3 const x = float3(instance.transform[0].x, instance.transform[1].x, instance.transform[2].x);
+    float3 const y = float3(instance.transform[0].y, instance.transform[1].y, instance.transform[2].y);
+    float3 const z = float3(instance.transform[0].z, instance.transform[1].z, instance.transform[2].z);
+
+    float const radius = instance.bounds.w * sqrt(max(dot(x, x), max(dot(y, y), dot(z, z))));
+
+    [unroll]
+    for (uint plane = 0; plane < 6; ++plane) {
+        if (dot(constants.planes[plane].xyz, center) + constants.planes[plane].w < -radius)
+            return false;
+    }
+
+    return true;
+}
+
+[numthreads(64, 1, 1)]
+void main(uint3 thread_id : SV_DispatchThreadID)
+{
+    uint const index = thread_id.x;
+
+    instance_data instance = (instance_data)0;
+    bool draw = false;
+
+    if (index < constants.instance_count) {
+        instance = buffers[bindings.instances].Load<instance_data>(index * kINSTANCE_STRIDE);
+        draw = instance.mesh < constants.mesh_count && visible(instance);
+    }
+
+    // One atomic per wave: the lanes that draw take consecutive commands after the wave's first one.
+    uint const wave_count = WaveActiveCountBits(draw);
+
+    uint first = 0;
+
+    if (wave_count != 0 && WaveIsFirstLane())
+        rw_buffers[bindings.command_count].InterlockedAdd(0, wave_count, first);
+
+    first = WaveReadLaneFirst(first);
+
+    if (!draw)
+        return;
+
+    mesh_data const mesh = buffers[bindings.meshes].Load<mesh_data>(instance.mesh * kMESH_STRIDE);
+
+    draw_command command;
+
+    command.instance_index = index;
+    command.index_count_per_instance = mesh.index_count;
+    command.instance_count = 1;
+    command.start_index_location = mesh.first_index;
+    command.base_vertex_location = mesh.base_vertex;
+    command.start_instance_location = 0;
+
+    rw_buffers[bindings.commands].Store<draw_command>((first + WavePrefixCountBits(draw)) * kDRAW_COMMAND_STRIDE, command);
+}
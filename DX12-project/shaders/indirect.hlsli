@@ -0,0 +1,59 @@
+#ifndef INDIRECT_HLSLI
+#define INDIRECT_HLSLI
+
+// Structures shared with src/graphics/draw_commands.hxx; the layouts have to match.
+
+struct instance_data
+{
+    // Rows of the object-to-world matrix.
+    float4 transform[3];
+
+    // Object-space bounding sphere: center and radius.
+    float4 bounds;
+
+    uint mesh;
+    uint material;
+
+    uint2 padding;
+};
+
+struct mesh_data
+{
+    uint index_count;
+    uint first_index;
+    int base_vertex;
+
+    uint padding;
+};
+
+// The root constant with the instance index, then D3D12_DRAW_INDEXED_ARGUMENTS.
+struct draw_command
+{
+    uint instance_index;
+
+    uint index_count_per_instance;
+    uint instance_count;
+    uint start_index_location;
+    int base_vertex_location;
+    uint start_instance_location;
+};
+
+struct culling_constants
+{
+    float4 planes[6];
+
+    uint instance_count;
+    uint mesh_count;
+
+    uint2 padding;
+};
+
+static const uint kINSTANCE_STRIDE = 80;
+static const uint kMESH_STRIDE = 16;
+static const uint kDRAW_COMMAND_STRIDE = 24;
+
+// The bindless tables; buffers are raw views addressed in bytes.
+ByteAddressBuffer buffers[] : register(t0, space1);
+RWByteAddressBuffer rw_buffers[] : register(u0, space1);
+
+#endif
@@ -0,0 +1,222 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <istream>
+#include <limits>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <string>
+#include <tuple>
+#include <vector>
+
+
+namespace graphics
+{
+    auto constexpr kNO_ADAPTER = std::numeric_limits<std::size_t>::max();
+
+    // Adapters with less dedicated memory than this are treated as integrated ones sharing system memory.
+    auto constexpr kINTEGRATED_VIDEO_MEMORY_THRESHOLD = 512ull << 20;
+
+    // The bindless root signature has unbounded UAV tables, which need resource binding tier 3.
+    auto constexpr kREQUIRED_RESOURCE_BINDING_TIER = 3u;
+
+    // API-neutral copy of what is known about an adapter, fetched once per enumeration.
+    struct adapter_description final {
+        std::wstring name;
+
+        std::uint32_t vendor_id{0}, device_id{0}, subsystem_id{0}, revision{0};
+        std::uint64_t luid{0};
+
+        std::uint64_t driver_version{0};
+
+        std::uint64_t dedicated_video_memory{0};
+        std::uint64_t dedicated_system_memory{0};
+        std::uint64_t shared_system_memory{0};
+
+        bool software{false};
+
+        // Whether a device with the required feature level can be created, and the resource binding tier of that device.
+        bool supported{false};
+        std::uint32_t resource_binding_tier{0};
+
+        bool integrated() const noexcept { return dedicated_video_memory < kINTEGRATED_VIDEO_MEMORY_THRESHOLD; }
+    };
+
+    enum class adapter_preference : std::uint8_t {
+        discrete, integrated, any
+    };
+
+    struct adapter_policy final {
+        adapter_preference preference{adapter_preference::discrete};
+
+        // Wins over every other criterion if such a supported adapter is present.
+        std::optional<std::uint64_t> pinned_luid;
+
+        std::uint64_t minimum_video_memory{0};
+
+        bool allow_software{false};
+    };
+
+    // Compared lexicographically: pinned LUID, preferred kind, dedicated video memory,
+    // dedicated system memory, shared system memory.
+    using adapter_score = std::tuple<bool, bool, std::uint64_t, std::uint64_t, std::uint64_t>;
+
+    // Adapters the policy excludes, and the ones the renderer can't run on, have no score.
+    std::optional<adapter_score> score_adapter(adapter_description const &adapter, adapter_policy const &policy) noexcept
+    {
+        if (!adapter.supported || adapter.resource_binding_tier < kREQUIRED_RESOURCE_BINDING_TIER)
+            return std::nullopt;
+
+        if (adapter.software && !policy.allow_software)
+            return std::nullopt;
+
+        if (adapter.dedicated_video_memory < policy.minimum_video_memory)
+            return std::nullopt;
+
+        auto const pinned = policy.pinned_luid && *policy.pinned_luid == adapter.luid;
+
+        auto preferred = true;
+
+        if (policy.preference == adapter_preference::discrete)
+            preferred = !adapter.integrated();
+
+        else if (policy.preference == adapter_preference::integrated)
+            preferred = adapter.integrated();
+
+        return adapter_score{pinned, preferred, adapter.dedicated_video_memory, adapter.dedicated_system_memory, adapter.shared_system_memory};
+    }
+
+    // Returns the index of the best adapter, or kNO_ADAPTER if the policy excludes all of them.
+    std::size_t pick_adapter(std::span<adapter_description const> adapters, adapter_policy const &policy) noexcept
+    {
+        auto best = kNO_ADAPTER;
+        std::optional<adapter_score> best_score;
+
+        for (auto index = 0u; index < std::size(adapters); ++index) {
+            auto score = score_adapter(adapters[index], policy);
+
+            if (score && (!best_score || *score > *best_score)) {
+                best = index;
+                best_score = score;
+            }
+        }
+
+        return best;
+    }
+
+    // Probe results of earlier runs. An entry is only valid for the same hardware and driver version,
+    // a driver update invalidates it.
+    class adapter_cache final {
+    public:
+
+        std::optional<bool> supported(adapter_description const &adapter) const noexcept
+        {
+            if (auto const value = find(adapter); value != nullptr)
+                return value->supported;
+
+            return std::nullopt;
+        }
+
+        std::optional<std::uint32_t> resource_binding_tier(adapter_description const &adapter) const noexcept
+        {
+            if (auto const value = find(adapter); value != nullptr)
+                return value->resource_binding_tier;
+
+            return std::nullopt;
+        }
+
+        void store(adapter_description const &adapter)
+        {
+            auto it = std::find_if(std::begin(entries_), std::end(entries_), [&adapter] (auto &&entry)
+            {
+                return same_hardware(entry, adapter);
+            });
+
+            auto const value = entry{
+                adapter.vendor_id, adapter.device_id, adapter.subsystem_id, adapter.revision, adapter.driver_version, adapter.supported,
+                adapter.resource_binding_tier
+            };
+
+            if (it == std::end(entries_))
+                entries_.push_back(value);
+
+            else *it = value;
+
+            dirty_ = true;
+        }
+
+        bool dirty() const noexcept { return dirty_; }
+
+        std::size_t size() const noexcept { return std::size(entries_); }
+
+        // One line per adapter: version tag, vendor, device, subsystem, revision, driver version, probe result and
+        // resource binding tier.
+        // Entries of other format versions are skipped, reading stops at the first malformed line.
+        void load(std::istream &stream)
+        {
+            entries_.clear();
+
+            std::string tag;
+            entry value;
+
+            while (stream >> tag >> value.vendor_id >> value.device_id >> value.subsystem_id >> value.revision >> value.driver_version >> value.supported
+                          >> value.resource_binding_tier) {
+                if (tag == kFORMAT_TAG)
+                    entries_.push_back(value);
+            }
+
+            dirty_ = false;
+        }
+
+        void save(std::ostream &stream)
+        {
+            for (auto &&value : entries_) {
+                stream << kFORMAT_TAG << ' ' << value.vendor_id << ' ' << value.device_id << ' ' << value.subsystem_id << ' '
+                       << value.revision << ' ' << value.driver_version << ' ' << value.supported << ' ' << value.resource_binding_tier << '\n';
+            }
+
+            dirty_ = false;
+        }
+
+    private:
+
+        // Version 1 lines predate the resource binding tier and are a field shorter, so a file of them loads empty and
+        // the adapters are probed again.
+        static auto constexpr kFORMAT_TAG = "adapter-v2";
+
+        struct entry final {
+            std::uint32_t vendor_id{0}, device_id{0}, subsystem_id{0}, revision{0};
+            std::uint64_t driver_version{0};
+
+            bool supported{false};
+            std::uint32_t resource_binding_tier{0};
+        };
+
+        std::vector<entry> entries_;
+
+        bool dirty_{false};
+
+        // The entry of the adapter if it was probed with the same driver.
+        entry const *find(adapter_description const &adapter) const noexcept
+        {
+            auto it = std::find_if(std::begin(entries_), std::end(entries_), [&adapter] (auto &&entry)
+            {
+                return same_hardware(entry, adapter);
+            });
+
+            if (it == std::end(entries_) || it->driver_version != adapter.driver_version)
+                return nullptr;
+
+            return &*it;
+        }
+
+        // LUIDs change between reboots, so entries are keyed by the PCI identity of the adapter.
+        static bool same_hardware(entry const &value, adapter_description const &adapter) noexcept
+        {
+            return value.vendor_id == adapter.vendor_id && value.device_id == adapter.device_id &&
+                   value.subsystem_id == adapter.subsystem_id && value.revision == adapter.revision;
+        }
+    };
+}
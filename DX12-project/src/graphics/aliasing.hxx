@@ -0,0 +1,147 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdint>
+#include <limits>
+#include <numeric>
+#include <span>
+#include <vector>
+
+
+namespace graphics
+{
+    auto constexpr kNO_ALIASED_PREDECESSOR = std::numeric_limits<std::uint32_t>::max();
+
+    // Memory needs of a resource that only lives within the passes [first_pass, last_pass] of a frame.
+    struct aliasing_request final {
+        std::uint64_t size{0};
+        std::uint64_t alignment{1};
+
+        std::uint32_t first_pass{0};
+        std::uint32_t last_pass{0};
+    };
+
+    struct aliasing_placement final {
+        std::uint64_t offset{0};
+
+        // The most recently used resource that occupied overlapping memory before this one, if any: earlier in
+        // the frame or, failing that, late in the previous frame. Its memory has to be handed over with an aliasing
+        // barrier before the first use.
+        std::uint32_t predecessor{kNO_ALIASED_PREDECESSOR};
+    };
+
+    struct aliasing_layout final {
+        std::vector<aliasing_placement> placements;
+
+        std::uint64_t size{0};
+
+        // Memory needed if every resource had its own range.
+        std::uint64_t unaliased_size{0};
+
+        std::uint64_t bytes_saved() const noexcept { return unaliased_size - size; }
+    };
+
+    // Assigns offsets so that resources with intersecting lifetimes never overlap in memory, while resources
+    // with disjoint lifetimes may share it. Resources are placed largest first at the lowest offset that is free
+    // for their whole lifetime, which is the usual greedy approximation of the interval packing problem.
+    aliasing_layout pack_aliased_resources(std::span<aliasing_request const> requests)
+    {
+        auto constexpr align_up = [] (std::uint64_t value, std::uint64_t alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        };
+
+        auto constexpr lifetimes_intersect = [] (aliasing_request const &lhs, aliasing_request const &rhs)
+        {
+            return lhs.first_pass <= rhs.last_pass && rhs.first_pass <= lhs.last_pass;
+        };
+
+        aliasing_layout layout;
+        layout.placements.resize(std::size(requests));
+
+        std::vector<std::uint32_t> order(std::size(requests));
+        std::iota(std::begin(order), std::end(order), 0u);
+
+        std::stable_sort(std::begin(order), std::end(order), [requests] (auto lhs, auto rhs)
+        {
+            return requests[lhs].size > requests[rhs].size;
+        });
+
+        std::vector<std::uint32_t> placed;
+        placed.reserve(std::size(requests));
+
+        std::vector<std::uint64_t> candidates;
+
+        for (auto index : order) {
+            auto const &request = requests[index];
+
+            layout.unaliased_size = align_up(layout.unaliased_size, request.alignment) + request.size;
+
+            // The lowest free offset is either zero or right past the end of a conflicting resource.
+            candidates.assign(1, 0);
+
+            for (auto other : placed) {
+                if (lifetimes_intersect(request, requests[other]))
+                    candidates.push_back(layout.placements[other].offset + requests[other].size);
+            }
+
+            std::sort(std::begin(candidates), std::end(candidates));
+
+            auto offset = std::numeric_limits<std::uint64_t>::max();
+
+            for (auto candidate : candidates) {
+                candidate = align_up(candidate, request.alignment);
+
+                auto const fits = std::none_of(std::begin(placed), std::end(placed), [&] (auto other)
+                {
+                    auto const other_offset = layout.placements[other].offset;
+
+                    return lifetimes_intersect(request, requests[other])
+                        && candidate < other_offset + requests[other].size && other_offset < candidate + request.size;
+                });
+
+                if (fits) {
+                    offset = candidate;
+                    break;
+                }
+            }
+
+            layout.placements[index].offset = offset;
+            layout.size = (std::max)(layout.size, offset + request.size);
+
+            placed.push_back(index);
+        }
+
+        // Memory that overlaps in placement belongs to resources with disjoint lifetimes, each of which is before or after
+        // the resource within the frame. The same placed resources are reused every frame, so a resource without
+        // a predecessor earlier in the frame takes its memory over from the last user at the end of the previous frame.
+        for (auto index = 0u; index < std::size(requests); ++index) {
+            auto const &request = requests[index];
+            auto &placement = layout.placements[index];
+
+            auto wrapped_predecessor = kNO_ALIASED_PREDECESSOR;
+
+            for (auto other = 0u; other < std::size(requests); ++other) {
+                auto const &previous = requests[other];
+
+                if (other == index)
+                    continue;
+
+                auto const other_offset = layout.placements[other].offset;
+
+                if (placement.offset >= other_offset + previous.size || other_offset >= placement.offset + request.size)
+                    continue;
+
+                auto &predecessor = previous.last_pass < request.first_pass ? placement.predecessor : wrapped_predecessor;
+
+                if (predecessor == kNO_ALIASED_PREDECESSOR || requests[predecessor].last_pass < previous.last_pass)
+                    predecessor = other;
+            }
+
+            if (placement.predecessor == kNO_ALIASED_PREDECESSOR)
+                placement.predecessor = wrapped_predecessor;
+        }
+
+        return layout;
+    }
+}
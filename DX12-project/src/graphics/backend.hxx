@@ -0,0 +1,160 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+#include <memory>
+#include <span>
+
+#include "graphics/render_graph.hxx"
+
+
+// The calls the renderer makes to create resources and descriptor heaps, record barriers and work, and submit
+// it with fences, behind interfaces with one implementation over D3D12 (graphics/d3d12_backend.hxx) and a null one
+// that records into a binary stream with virtual GPU timing (graphics/null_backend.hxx). Nothing here includes
+// a platform header, so the CPU side of submitting a frame builds and can be profiled without a GPU.
+namespace graphics::backend
+{
+    auto constexpr kALL_SUBRESOURCES = std::numeric_limits<std::uint32_t>::max();
+
+    enum class heap_type : std::uint8_t {
+        // GPU memory.
+        gpu,
+        // CPU-written, GPU-read.
+        upload,
+        // GPU-written, CPU-read.
+        readback
+    };
+
+    enum class resource_dimension : std::uint8_t {
+        buffer, texture_2d
+    };
+
+    enum class resource_flags : std::uint8_t {
+        none                = 0,
+        render_target       = 1u << 0,
+        depth_stencil       = 1u << 1,
+        unordered_access    = 1u << 2
+    };
+
+    constexpr resource_flags operator| (resource_flags lhs, resource_flags rhs) noexcept
+    {
+        return static_cast<resource_flags>(static_cast<std::uint8_t>(lhs) | static_cast<std::uint8_t>(rhs));
+    }
+
+    constexpr resource_flags operator& (resource_flags lhs, resource_flags rhs) noexcept
+    {
+        return static_cast<resource_flags>(static_cast<std::uint8_t>(lhs) & static_cast<std::uint8_t>(rhs));
+    }
+
+    struct resource_description final {
+        resource_dimension dimension{resource_dimension::buffer};
+
+        // In bytes for buffers.
+        std::uint64_t width{0};
+        std::uint32_t height{1};
+        std::uint16_t array_size{1};
+        std::uint16_t mip_levels{1};
+
+        // A DXGI_FORMAT value; unknown (0) for buffers.
+        std::uint32_t format{0};
+
+        resource_flags flags{resource_flags::none};
+    };
+
+    enum class descriptor_heap_type : std::uint8_t {
+        // Constant buffer, shader resource and unordered access views.
+        view, sampler, render_target, depth_stencil
+    };
+
+    struct descriptor_heap_description final {
+        descriptor_heap_type type{descriptor_heap_type::view};
+        std::uint32_t count{0};
+        bool shader_visible{false};
+    };
+
+    struct resource_interface {
+        virtual ~resource_interface() = default;
+
+        virtual resource_description const &description() const noexcept = 0;
+    };
+
+    struct descriptor_heap_interface {
+        virtual ~descriptor_heap_interface() = default;
+
+        virtual descriptor_heap_description const &description() const noexcept = 0;
+    };
+
+    enum class barrier_type : std::uint8_t {
+        transition, aliasing, unordered_access
+    };
+
+    // States are render graph accesses; a backend maps them to its own.
+    struct resource_barrier final {
+        barrier_type type{barrier_type::transition};
+
+        resource_interface *resource{nullptr};
+
+        // The resource that starts to use the memory, for an aliasing barrier.
+        resource_interface *resource_after{nullptr};
+
+        std::uint32_t subresource{kALL_SUBRESOURCES};
+
+        resource_access before{resource_access::undefined};
+        resource_access after{resource_access::undefined};
+    };
+
+    struct command_list_interface {
+        virtual ~command_list_interface() = default;
+
+        // The list's allocator has to be done executing.
+        virtual void reset() = 0;
+        virtual void close() = 0;
+
+        virtual void resource_barriers(std::span<resource_barrier const> barriers) = 0;
+
+        virtual void set_descriptor_heaps(std::span<descriptor_heap_interface *const> heaps) = 0;
+
+        virtual void copy_buffer_region(resource_interface &destination, std::uint64_t destination_offset,
+                                        resource_interface &source, std::uint64_t source_offset, std::uint64_t size) = 0;
+
+        virtual void draw_indexed(std::uint32_t index_count, std::uint32_t instance_count, std::uint32_t first_index,
+                                  std::int32_t base_vertex, std::uint32_t first_instance) = 0;
+
+        virtual void dispatch(std::uint32_t x, std::uint32_t y, std::uint32_t z) = 0;
+    };
+
+    struct fence_interface {
+        virtual ~fence_interface() = default;
+
+        virtual std::uint64_t completed_value() const = 0;
+
+        // Blocks the calling thread until the fence has reached the value.
+        virtual void wait(std::uint64_t value) = 0;
+    };
+
+    struct queue_interface {
+        virtual ~queue_interface() = default;
+
+        virtual void execute(std::span<command_list_interface *const> command_lists) = 0;
+
+        virtual void signal(fence_interface &fence, std::uint64_t value) = 0;
+
+        // Makes the queue wait for the fence before the work submitted next.
+        virtual void wait(fence_interface &fence, std::uint64_t value) = 0;
+    };
+
+    struct device_interface {
+        virtual ~device_interface() = default;
+
+        virtual std::unique_ptr<resource_interface>
+        create_committed_resource(resource_description const &description, heap_type heap, resource_access initial_access) = 0;
+
+        virtual std::unique_ptr<descriptor_heap_interface> create_descriptor_heap(descriptor_heap_description const &description) = 0;
+
+        virtual std::unique_ptr<fence_interface> create_fence(std::uint64_t initial_value = 0) = 0;
+
+        virtual std::unique_ptr<queue_interface> create_queue(queue_type type) = 0;
+
+        virtual std::unique_ptr<command_list_interface> create_command_list(queue_type type) = 0;
+    };
+}
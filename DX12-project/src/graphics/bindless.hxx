@@ -0,0 +1,212 @@
+#pragma once
+
+#include <array>
+#include <span>
+
+#include "main.hxx"
+#include "utility/exception.hxx"
+#include "utility/hash.hxx"
+#include "graphics/adapter.hxx"
+#include "graphics/bindless_layout.hxx"
+#include "graphics/descriptor.hxx"
+#include "graphics/descriptor_ring.hxx"
+#include "graphics/fence.hxx"
+
+
+namespace graphics
+{
+    struct root_signature final {
+        winrt::com_ptr<ID3D12RootSignature> signature;
+
+        // Hash of the serialized description; pipeline states are cached by it.
+        std::uint64_t hash{0};
+    };
+
+    constexpr UINT root_parameter_index(bindless_root_parameter parameter) noexcept
+    {
+        return static_cast<UINT>(parameter);
+    }
+
+    std::uint32_t resource_binding_tier(ID3D12Device6 *const device)
+    {
+        D3D12_FEATURE_DATA_D3D12_OPTIONS options{ };
+
+        if (auto result = device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options)); FAILED(result))
+            throw dx::device_error(fmt::format("failed to check resource binding tier support: {0:#x}"s, result));
+
+        return static_cast<std::uint32_t>(options.ResourceBindingTier);
+    }
+
+    // The root signature shared by all pipelines. Shaders declare the tables as unbounded arrays in space1,
+    // e.g. 'Texture2D textures[] : register(t0, space1)', and index them with the bindless indices passed in
+    // the root constants (b0); the frame constants are at b1.
+    root_signature create_bindless_root_signature(ID3D12Device6 *const device)
+    {
+        // Adapters below the tier aren't picked (see score_adapter), so this only fails for a device made elsewhere.
+        if (auto const tier = resource_binding_tier(device); tier < kREQUIRED_RESOURCE_BINDING_TIER)
+            throw dx::device_error(fmt::format("resource binding tier {} is lower than the required tier {}"s, tier, kREQUIRED_RESOURCE_BINDING_TIER));
+
+        // Indices that aren't in use are never initialized, and the descriptors change while frames are in flight.
+        auto constexpr view_flags = D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE | D3D12_DESCRIPTOR_RANGE_FLAG_DATA_VOLATILE;
+
+        auto const ranges = std::array{
+            CD3DX12_DESCRIPTOR_RANGE1{D3D12_DESCRIPTOR_RANGE_TYPE_SRV, UINT_MAX, 0, 1, view_flags, 0},
+            CD3DX12_DESCRIPTOR_RANGE1{D3D12_DESCRIPTOR_RANGE_TYPE_UAV, UINT_MAX, 0, 1, view_flags, 0},
+            CD3DX12_DESCRIPTOR_RANGE1{D3D12_DESCRIPTOR_RANGE_TYPE_SAMPLER, UINT_MAX, 0, 1, D3D12_DESCRIPTOR_RANGE_FLAG_DESCRIPTORS_VOLATILE, 0}
+        };
+
+        std::array<CD3DX12_ROOT_PARAMETER1, kBINDLESS_ROOT_PARAMETER_NUMBER> parameters;
+
+        parameters[root_parameter_index(bindless_root_parameter::constants)].InitAsConstants(kROOT_CONSTANT_COUNT, 0);
+        parameters[root_parameter_index(bindless_root_parameter::frame_constants)].InitAsConstantBufferView(1);
+        parameters[root_parameter_index(bindless_root_parameter::shader_resource_views)].InitAsDescriptorTable(1, &ranges[0]);
+        parameters[root_parameter_index(bindless_root_parameter::unordered_access_views)].InitAsDescriptorTable(1, &ranges[1]);
+        parameters[root_parameter_index(bindless_root_parameter::samplers)].InitAsDescriptorTable(1, &ranges[2]);
+
+        CD3DX12_VERSIONED_ROOT_SIGNATURE_DESC description;
+
+        description.Init_1_1(static_cast<UINT>(std::size(parameters)), std::data(parameters), 0, nullptr,
+                             D3D12_ROOT_SIGNATURE_FLAG_ALLOW_INPUT_ASSEMBLER_INPUT_LAYOUT);
+
+        winrt::com_ptr<ID3DBlob> blob, errors;
+
+        if (auto result = D3DX12SerializeVersionedRootSignature(&description, D3D_ROOT_SIGNATURE_VERSION_1_1, blob.put(), errors.put()); FAILED(result)) {
+            auto const message = errors != nullptr ? std::string{static_cast<char const *>(errors->GetBufferPointer()), errors->GetBufferSize()} : std::string{ };
+
+            throw dx::device_error(fmt::format("failed to serialize the root signature: {0:#x} {1}"s, result, message));
+        }
+
+        root_signature signature;
+
+        if (auto result = device->CreateRootSignature(0, blob->GetBufferPointer(), blob->GetBufferSize(), winrt::guid_of<ID3D12RootSignature>(), signature.signature.put_void()); FAILED(result))
+            throw dx::device_error(fmt::format("failed to create the root signature: {0:#x}"s, result));
+
+        signature.hash = utility::hash_bytes(std::span{static_cast<std::byte const *>(blob->GetBufferPointer()), blob->GetBufferSize()});
+
+        return signature;
+    }
+
+    // Descriptors addressed by bindless indices. Views live in the persistent region of the descriptor ring's heap,
+    // SRVs and UAVs sharing one index space; samplers have a shader-visible heap of their own.
+    class bindless_descriptors final {
+    public:
+
+        bindless_descriptors(ID3D12Device6 *const device, descriptor_ring &ring, fence_timeline &timeline, std::uint32_t sampler_capacity)
+            : device_{device}, ring_{ring}, timeline_{timeline}, views_{ring.persistent_capacity()}, samplers_{sampler_capacity}
+        {
+            sampler_heap_ = create_descriptor_heaps(device, D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, sampler_capacity, D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE);
+
+            sampler_increment_size_ = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER);
+        }
+
+        bindless_descriptors(bindless_descriptors const &) = delete;
+        bindless_descriptors &operator=(bindless_descriptors const &) = delete;
+
+        [[nodiscard]] bindless_index
+        create_shader_resource_view(ID3D12Resource *const resource, D3D12_SHADER_RESOURCE_VIEW_DESC const *const description)
+        {
+            auto const index = allocate(views_);
+
+            device_->CreateShaderResourceView(resource, description, ring_.persistent_cpu_handle(index.value));
+
+            return index;
+        }
+
+        [[nodiscard]] bindless_index
+        create_unordered_access_view(ID3D12Resource *const resource, ID3D12Resource *const counter, D3D12_UNORDERED_ACCESS_VIEW_DESC const *const description)
+        {
+            auto const index = allocate(views_);
+
+            device_->CreateUnorderedAccessView(resource, counter, description, ring_.persistent_cpu_handle(index.value));
+
+            return index;
+        }
+
+        [[nodiscard]] bindless_index create_sampler(D3D12_SAMPLER_DESC const &description)
+        {
+            auto const index = allocate(samplers_);
+
+            auto const cpu_handle = D3D12_CPU_DESCRIPTOR_HANDLE{
+                sampler_heap_->GetCPUDescriptorHandleForHeapStart().ptr + static_cast<SIZE_T>(index.value) * sampler_increment_size_
+            };
+
+            device_->CreateSampler(&description, cpu_handle);
+
+            return index;
+        }
+
+        // The index stays valid for the frames already recorded; it is reused once the current frame has finished.
+        void release_view(bindless_index index) { views_.free(index); }
+        void release_sampler(bindless_index index) { samplers_.free(index); }
+
+        void end_frame(UINT64 fence_value)
+        {
+            views_.end_frame(fence_value);
+            samplers_.end_frame(fence_value);
+        }
+
+        std::array<ID3D12DescriptorHeap *, 2> heaps() const noexcept
+        {
+            return {ring_.heap(), sampler_heap_.get()};
+        }
+
+        // Expects the heaps to be set on the command list.
+        void bind_graphics(ID3D12GraphicsCommandList *const command_list, root_signature const &signature) const
+        {
+            command_list->SetGraphicsRootSignature(signature.signature.get());
+
+            command_list->SetGraphicsRootDescriptorTable(root_parameter_index(bindless_root_parameter::shader_resource_views), ring_.persistent_gpu_handle(0));
+            command_list->SetGraphicsRootDescriptorTable(root_parameter_index(bindless_root_parameter::unordered_access_views), ring_.persistent_gpu_handle(0));
+            command_list->SetGraphicsRootDescriptorTable(root_parameter_index(bindless_root_parameter::samplers), sampler_heap_->GetGPUDescriptorHandleForHeapStart());
+        }
+
+        void bind_compute(ID3D12GraphicsCommandList *const command_list, root_signature const &signature) const
+        {
+            command_list->SetComputeRootSignature(signature.signature.get());
+
+            command_list->SetComputeRootDescriptorTable(root_parameter_index(bindless_root_parameter::shader_resource_views), ring_.persistent_gpu_handle(0));
+            command_list->SetComputeRootDescriptorTable(root_parameter_index(bindless_root_parameter::unordered_access_views), ring_.persistent_gpu_handle(0));
+            command_list->SetComputeRootDescriptorTable(root_parameter_index(bindless_root_parameter::samplers), sampler_heap_->GetGPUDescriptorHandleForHeapStart());
+        }
+
+    private:
+
+        ID3D12Device6 *device_;
+
+        descriptor_ring &ring_;
+        fence_timeline &timeline_;
+
+        descriptor_index_allocator views_;
+        descriptor_index_allocator samplers_;
+
+        winrt::com_ptr<ID3D12DescriptorHeap> sampler_heap_;
+        std::uint32_t sampler_increment_size_{0};
+
+        bindless_index allocate(descriptor_index_allocator &allocator)
+        {
+            allocator.reclaim(timeline_.completed_value());
+
+            try {
+                return allocator.allocate();
+
+            } catch (std::length_error const &exception) {
+                throw dx::device_error(exception.what());
+            }
+        }
+    };
+
+    // Writes one binding block of a root_constant_layout with a single call.
+    template<class Layout, class Block>
+    void set_graphics_root_constants(ID3D12GraphicsCommandList *const command_list, Block const &block)
+    {
+        command_list->SetGraphicsRoot32BitConstants(root_parameter_index(bindless_root_parameter::constants),
+                                                    Layout::template size_of<Block>(), &block, Layout::template offset_of<Block>());
+    }
+
+    template<class Layout, class Block>
+    void set_compute_root_constants(ID3D12GraphicsCommandList *const command_list, Block const &block)
+    {
+        command_list->SetComputeRoot32BitConstants(root_parameter_index(bindless_root_parameter::constants),
+                                                   Layout::template size_of<Block>(), &block, Layout::template offset_of<Block>());
+    }
+}
@@ -0,0 +1,239 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+
+namespace graphics
+{
+    // Position of a descriptor in a bindless table; shaders receive it through root constants.
+    struct bindless_index final {
+        static auto constexpr kINVALID = std::numeric_limits<std::uint32_t>::max();
+
+        std::uint32_t value{kINVALID};
+
+        constexpr bool valid() const noexcept { return value != kINVALID; }
+
+        constexpr bool operator== (bindless_index const &) const = default;
+    };
+
+    // Hands out indices of a bindless table. A freed index may still be read by frames in flight, so it becomes
+    // reusable only after the fence value of the frame it was freed in has been reached.
+    class descriptor_index_allocator final {
+    public:
+
+        explicit descriptor_index_allocator(std::uint32_t capacity) : capacity_{capacity} { }
+
+        descriptor_index_allocator(descriptor_index_allocator const &) = delete;
+        descriptor_index_allocator &operator=(descriptor_index_allocator const &) = delete;
+
+        [[nodiscard]] bindless_index allocate()
+        {
+            std::unique_lock lock{mutex_};
+
+            if (!free_.empty()) {
+                auto const index = free_.back();
+                free_.pop_back();
+
+                return bindless_index{index};
+            }
+
+            if (next_ == capacity_)
+                throw std::length_error("bindless descriptor table is exhausted");
+
+            return bindless_index{next_++};
+        }
+
+        void free(bindless_index index)
+        {
+            if (!index.valid())
+                return;
+
+            std::unique_lock lock{mutex_};
+
+            freed_.push_back(index.value);
+        }
+
+        // Indices freed since the previous call are reusable once the fence reaches the value.
+        void end_frame(std::uint64_t fence_value)
+        {
+            std::unique_lock lock{mutex_};
+
+            if (freed_.empty())
+                return;
+
+            retired_.push_back(retired_indices{fence_value, std::move(freed_)});
+
+            freed_.clear();
+        }
+
+        void reclaim(std::uint64_t completed_value)
+        {
+            std::unique_lock lock{mutex_};
+
+            while (!retired_.empty() && retired_.front().fence_value <= completed_value) {
+                auto &&indices = retired_.front().indices;
+
+                free_.insert(std::end(free_), std::begin(indices), std::end(indices));
+
+                retired_.pop_front();
+            }
+        }
+
+        std::uint32_t capacity() const noexcept { return capacity_; }
+
+        // Indices that are allocated or not reusable yet.
+        std::uint32_t size() const
+        {
+            std::unique_lock lock{mutex_};
+
+            return next_ - static_cast<std::uint32_t>(std::size(free_));
+        }
+
+    private:
+
+        struct retired_indices final {
+            std::uint64_t fence_value{0};
+            std::vector<std::uint32_t> indices;
+        };
+
+        std::uint32_t capacity_{0};
+
+        mutable std::mutex mutex_;
+
+        // Indices past 'next_' have never been handed out.
+        std::uint32_t next_{0};
+
+        std::vector<std::uint32_t> free_;
+        std::vector<std::uint32_t> freed_;
+        std::deque<retired_indices> retired_;
+    };
+
+    // Root parameters of the bindless root signature, in order.
+    enum class bindless_root_parameter : std::uint32_t {
+        // Per-draw binding blocks, see root_constant_layout.
+        constants = 0,
+        // Root CBV of the per-frame constants.
+        frame_constants,
+        // Unbounded tables over the bindless part of the shader-visible heaps.
+        shader_resource_views,
+        unordered_access_views,
+        samplers
+    };
+
+    auto constexpr kBINDLESS_ROOT_PARAMETER_NUMBER = 5u;
+
+    // 32-bit values of the root constants parameter.
+    auto constexpr kROOT_CONSTANT_COUNT = 16u;
+
+    // Root signature size in DWORDs: a root constant costs one, a root descriptor two, a descriptor table one.
+    auto constexpr kBINDLESS_ROOT_SIGNATURE_COST = kROOT_CONSTANT_COUNT + 2u + 3u;
+
+    static_assert(kBINDLESS_ROOT_SIGNATURE_COST <= 64, "a root signature is limited to 64 DWORDs");
+
+    // A block of root constants: copied verbatim into the root constants, so it must be made of 32-bit values.
+    template<class T>
+    concept root_constant_block = std::is_trivially_copyable_v<T> && std::is_standard_layout_v<T> &&
+                                  alignof(T) <= 4 && sizeof(T) % 4 == 0;
+
+    template<class T, class... Blocks>
+    auto constexpr kBLOCK_OCCURRENCES = (0u + ... + static_cast<std::uint32_t>(std::is_same_v<T, Blocks>));
+
+    template<class... Blocks>
+    concept fits_root_constants = (0u + ... + static_cast<std::uint32_t>(sizeof(Blocks) / 4)) <= kROOT_CONSTANT_COUNT;
+
+    template<class... Blocks>
+    concept distinct_blocks = ((kBLOCK_OCCURRENCES<Blocks, Blocks...> == 1) && ...);
+
+    // Places binding blocks back to back in the root constants. Offsets and sizes are compile-time constants, and
+    // a layout that doesn't fit, or names a block twice, doesn't compile:
+    //
+    //     struct view_bindings final { bindless_index camera; };
+    //     struct draw_bindings final { bindless_index transforms, material; std::uint32_t instance_offset; };
+    //
+    //     using main_pass_layout = root_constant_layout<view_bindings, draw_bindings>;
+    //
+    //     main_pass_layout::offset_of<draw_bindings>() == 1, main_pass_layout::size_of<draw_bindings>() == 3
+    template<root_constant_block... Blocks> requires fits_root_constants<Blocks...> && distinct_blocks<Blocks...>
+    class root_constant_layout final {
+    public:
+
+        static auto constexpr kBLOCK_NUMBER = sizeof...(Blocks);
+
+        static std::array<std::uint32_t, kBLOCK_NUMBER> constexpr kSIZES{static_cast<std::uint32_t>(sizeof(Blocks) / 4)...};
+
+        static std::array<std::uint32_t, kBLOCK_NUMBER> constexpr kOFFSETS = []
+        {
+            std::array<std::uint32_t, kBLOCK_NUMBER> offsets{};
+
+            for (std::size_t index = 1; index < kBLOCK_NUMBER; ++index)
+                offsets[index] = offsets[index - 1] + kSIZES[index - 1];
+
+            return offsets;
+        }();
+
+        // 32-bit values used by all blocks together.
+        static auto constexpr kSIZE = (0u + ... + static_cast<std::uint32_t>(sizeof(Blocks) / 4));
+
+        template<class T>
+        static constexpr std::uint32_t offset_of() noexcept { return kOFFSETS[index_of<T>()]; }
+
+        template<class T>
+        static constexpr std::uint32_t size_of() noexcept { return kSIZES[index_of<T>()]; }
+
+    private:
+
+        template<class T>
+        static constexpr std::size_t index_of() noexcept
+        {
+            static_assert(kBLOCK_OCCURRENCES<T, Blocks...> == 1, "the block isn't part of the layout");
+
+            std::array<bool, kBLOCK_NUMBER> constexpr matches{std::is_same_v<T, Blocks>...};
+
+            std::size_t index = 0;
+
+            while (!matches[index])
+                ++index;
+
+            return index;
+        }
+    };
+
+    // Compile-time checks of the layout generator.
+    namespace root_constant_layout_checks
+    {
+        struct view final { bindless_index camera; };
+        struct draw final { bindless_index transforms, material; std::uint32_t instance_offset; };
+        struct material final { float roughness, metallic; bindless_index albedo, normal; };
+
+        using layout = root_constant_layout<view, draw, material>;
+
+        static_assert(layout::offset_of<view>() == 0 && layout::size_of<view>() == 1);
+        static_assert(layout::offset_of<draw>() == 1 && layout::size_of<draw>() == 3);
+        static_assert(layout::offset_of<material>() == 4 && layout::size_of<material>() == 4);
+        static_assert(layout::kSIZE == 8);
+
+        static_assert(root_constant_layout<>::kSIZE == 0);
+
+        template<class... Blocks>
+        concept valid_layout = requires { typename root_constant_layout<Blocks...>; };
+
+        struct full final { std::uint32_t values[kROOT_CONSTANT_COUNT]; };
+        struct too_large final { std::uint32_t values[kROOT_CONSTANT_COUNT + 1]; };
+
+        static_assert(valid_layout<full> && !valid_layout<too_large> && !valid_layout<full, view>);
+        static_assert(!valid_layout<view, draw, view>);
+
+        struct with_double final { double value; };
+        struct with_short final { std::uint16_t value; };
+        struct with_pointer final { std::uint32_t *value; };
+
+        static_assert(!root_constant_block<with_double> && !root_constant_block<with_short> && !root_constant_block<with_pointer>);
+    }
+}
@@ -0,0 +1,137 @@
+#pragma once
+
+#include <deque>
+#include <mutex>
+#include <optional>
+
+#include "main.hxx"
+#include "utility/exception.hxx"
+#include "graphics/command.hxx"
+#include "graphics/fence.hxx"
+
+
+namespace graphics
+{
+    // An allocator with the list that records into it; the list is handed out open.
+    struct command_context final {
+        winrt::com_ptr<ID3D12CommandAllocator> command_allocator;
+        winrt::com_ptr<ID3D12GraphicsCommandList5> command_list;
+
+        D3D12_COMMAND_LIST_TYPE type{D3D12_COMMAND_LIST_TYPE_DIRECT};
+    };
+
+    struct command_pool_statistics final {
+        std::size_t created{0};
+        std::size_t in_use{0};
+        std::size_t retired{0};
+
+        // The most contexts of the type that were out of the pool at the same time.
+        std::size_t high_water_mark{0};
+    };
+
+    // Allocator and list pairs per command list type. A pair comes back with the fence value of the submission
+    // that used it and is recycled once the fence reaches the value; the pool grows only when no retired pair
+    // is complete, so a steady frame rate creates no objects.
+    class command_pool final {
+    public:
+
+        explicit command_pool(ID3D12Device6 *const device) : device_{device} { }
+
+        command_pool(command_pool const &) = delete;
+        command_pool &operator=(command_pool const &) = delete;
+
+        [[nodiscard]] command_context acquire(D3D12_COMMAND_LIST_TYPE type)
+        {
+            auto &&pool = pool_of(type);
+
+            std::optional<command_context> recycled;
+
+            {
+                std::unique_lock lock{mutex_};
+
+                // Pairs retire in submission order, so only the oldest one has to be checked.
+                if (!pool.retired.empty() && pool.retired.front().timeline->is_complete(pool.retired.front().fence_value)) {
+                    recycled = std::move(pool.retired.front().context);
+                    pool.retired.pop_front();
+                }
+
+                else ++pool.created;
+
+                pool.high_water_mark = (std::max)(pool.high_water_mark, ++pool.in_use);
+            }
+
+            if (!recycled) {
+                auto command_allocator = create_command_allocator(device_, type);
+                auto command_list = create_command_list(device_, command_allocator.get(), type);
+
+                return command_context{command_allocator, command_list, type};
+            }
+
+            if (auto result = recycled->command_allocator->Reset(); FAILED(result))
+                throw dx::device_error(fmt::format("failed to reset a command allocator: {0:#x}"s, result));
+
+            if (auto result = recycled->command_list->Reset(recycled->command_allocator.get(), nullptr); FAILED(result))
+                throw dx::device_error(fmt::format("failed to reset a command list: {0:#x}"s, result));
+
+            return *std::move(recycled);
+        }
+
+        // The list has to be closed and submitted to the queue that 'timeline' signals.
+        void release(command_context &&context, fence_timeline &timeline, UINT64 fence_value)
+        {
+            auto &&pool = pool_of(context.type);
+
+            std::unique_lock lock{mutex_};
+
+            pool.retired.push_back(retired_context{std::move(context), &timeline, fence_value});
+
+            --pool.in_use;
+        }
+
+        command_pool_statistics statistics(D3D12_COMMAND_LIST_TYPE type) const
+        {
+            auto &&pool = pool_of(type);
+
+            std::unique_lock lock{mutex_};
+
+            return command_pool_statistics{pool.created, pool.in_use, std::size(pool.retired), pool.high_water_mark};
+        }
+
+    private:
+
+        struct retired_context final {
+            command_context context;
+
+            fence_timeline *timeline{nullptr};
+            UINT64 fence_value{0};
+        };
+
+        struct type_pool final {
+            std::deque<retired_context> retired;
+
+            std::size_t created{0};
+            std::size_t in_use{0};
+            std::size_t high_water_mark{0};
+        };
+
+        ID3D12Device6 *device_;
+
+        mutable std::mutex mutex_;
+
+        // Direct, bundle, compute and copy lists.
+        std::array<type_pool, 4> pools_;
+
+        type_pool &pool_of(D3D12_COMMAND_LIST_TYPE type)
+        {
+            if (static_cast<std::size_t>(type) >= std::size(pools_))
+                throw dx::device_error(fmt::format("unsupported command list type: {0}"s, static_cast<int>(type)));
+
+            return pools_[static_cast<std::size_t>(type)];
+        }
+
+        type_pool const &pool_of(D3D12_COMMAND_LIST_TYPE type) const
+        {
+            return const_cast<command_pool *>(this)->pool_of(type);
+        }
+    };
+}
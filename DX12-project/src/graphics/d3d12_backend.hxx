@@ -0,0 +1,324 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <span>
+#include <vector>
+
+#include "main.hxx"
+#include "utility/exception.hxx"
+#include "graphics/backend.hxx"
+#include "graphics/command.hxx"
+#include "graphics/descriptor.hxx"
+#include "graphics/queue.hxx"
+#include "graphics/render_graph_executor.hxx"
+
+
+namespace graphics::backend
+{
+    class d3d12_resource final : public resource_interface {
+    public:
+
+        d3d12_resource(winrt::com_ptr<ID3D12Resource> resource, resource_description const &description) noexcept
+            : resource_{std::move(resource)}, description_{description} { }
+
+        resource_description const &description() const noexcept override { return description_; }
+
+        ID3D12Resource *get() const noexcept { return resource_.get(); }
+
+    private:
+
+        winrt::com_ptr<ID3D12Resource> resource_;
+        resource_description description_;
+    };
+
+    class d3d12_descriptor_heap final : public descriptor_heap_interface {
+    public:
+
+        d3d12_descriptor_heap(winrt::com_ptr<ID3D12DescriptorHeap> heap, descriptor_heap_description const &description) noexcept
+            : heap_{std::move(heap)}, description_{description} { }
+
+        descriptor_heap_description const &description() const noexcept override { return description_; }
+
+        ID3D12DescriptorHeap *get() const noexcept { return heap_.get(); }
+
+    private:
+
+        winrt::com_ptr<ID3D12DescriptorHeap> heap_;
+        descriptor_heap_description description_;
+    };
+
+    // A command list with its own allocator; reset() requires the previous recording to have finished executing.
+    class d3d12_command_list final : public command_list_interface {
+    public:
+
+        d3d12_command_list(ID3D12Device6 *const device, queue_type type)
+        {
+            allocator_ = create_command_allocator(device, command_list_type_of(type));
+            command_list_ = ::create_command_list(device, allocator_.get(), command_list_type_of(type));
+        }
+
+        void reset() override
+        {
+            if (auto result = allocator_->Reset(); FAILED(result))
+                throw dx::device_error(fmt::format("failed to reset a command allocator: {0:#x}"s, result));
+
+            if (auto result = command_list_->Reset(allocator_.get(), nullptr); FAILED(result))
+                throw dx::device_error(fmt::format("failed to reset a command list: {0:#x}"s, result));
+        }
+
+        void close() override
+        {
+            if (auto result = command_list_->Close(); FAILED(result))
+                throw dx::device_error(fmt::format("failed to close a command list: {0:#x}"s, result));
+        }
+
+        void resource_barriers(std::span<resource_barrier const> barriers) override
+        {
+            // Reused, so a steady frame doesn't allocate.
+            barriers_.clear();
+
+            for (auto &&barrier : barriers) {
+                auto const resource = resource_of(barrier.resource);
+
+                switch (barrier.type) {
+                    case barrier_type::aliasing:
+                        barriers_.push_back(CD3DX12_RESOURCE_BARRIER::Aliasing(resource, resource_of(barrier.resource_after)));
+                        break;
+
+                    case barrier_type::unordered_access:
+                        barriers_.push_back(CD3DX12_RESOURCE_BARRIER::UAV(resource));
+                        break;
+
+                    default:
+                        barriers_.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource, resource_state_of(barrier.before),
+                                                                                 resource_state_of(barrier.after), barrier.subresource));
+                        break;
+                }
+            }
+
+            if (!barriers_.empty())
+                command_list_->ResourceBarrier(static_cast<UINT>(std::size(barriers_)), std::data(barriers_));
+        }
+
+        void set_descriptor_heaps(std::span<descriptor_heap_interface *const> heaps) override
+        {
+            std::array<ID3D12DescriptorHeap *, 2> d3d12_heaps{nullptr, nullptr};
+
+            if (std::size(heaps) > std::size(d3d12_heaps))
+                throw dx::device_error("at most a view and a sampler heap can be bound"s);
+
+            for (std::size_t index = 0; index < std::size(heaps); ++index)
+                d3d12_heaps[index] = static_cast<d3d12_descriptor_heap *>(heaps[index])->get();
+
+            command_list_->SetDescriptorHeaps(static_cast<UINT>(std::size(heaps)), std::data(d3d12_heaps));
+        }
+
+        void copy_buffer_region(resource_interface &destination, std::uint64_t destination_offset,
+                                resource_interface &source, std::uint64_t source_offset, std::uint64_t size) override
+        {
+            command_list_->CopyBufferRegion(resource_of(&destination), destination_offset, resource_of(&source), source_offset, size);
+        }
+
+        void draw_indexed(std::uint32_t index_count, std::uint32_t instance_count, std::uint32_t first_index,
+                          std::int32_t base_vertex, std::uint32_t first_instance) override
+        {
+            command_list_->DrawIndexedInstanced(index_count, instance_count, first_index, base_vertex, first_instance);
+        }
+
+        void dispatch(std::uint32_t x, std::uint32_t y, std::uint32_t z) override
+        {
+            command_list_->Dispatch(x, y, z);
+        }
+
+        ID3D12GraphicsCommandList5 *get() const noexcept { return command_list_.get(); }
+
+    private:
+
+        winrt::com_ptr<ID3D12CommandAllocator> allocator_;
+        winrt::com_ptr<ID3D12GraphicsCommandList5> command_list_;
+
+        std::vector<D3D12_RESOURCE_BARRIER> barriers_;
+
+        static ID3D12Resource *resource_of(resource_interface const *resource) noexcept
+        {
+            return resource != nullptr ? static_cast<d3d12_resource const *>(resource)->get() : nullptr;
+        }
+    };
+
+    class d3d12_fence final : public fence_interface {
+    public:
+
+        d3d12_fence(ID3D12Device6 *const device, std::uint64_t initial_value)
+        {
+            if (auto result = device->CreateFence(initial_value, D3D12_FENCE_FLAG_NONE, winrt::guid_of<ID3D12Fence1>(), fence_.put_void()); FAILED(result))
+                throw dx::fence_error(fmt::format("failed to create a fence: {0:#x}"s, result));
+        }
+
+        std::uint64_t completed_value() const override { return fence_->GetCompletedValue(); }
+
+        void wait(std::uint64_t value) override
+        {
+            if (fence_->GetCompletedValue() >= value)
+                return;
+
+            // Without an event the call blocks until the fence reaches the value.
+            if (auto result = fence_->SetEventOnCompletion(value, nullptr); FAILED(result))
+                throw dx::fence_error(fmt::format("failed to wait for a fence: {0:#x}"s, result));
+        }
+
+        ID3D12Fence1 *get() const noexcept { return fence_.get(); }
+
+    private:
+
+        winrt::com_ptr<ID3D12Fence1> fence_;
+    };
+
+    class d3d12_queue final : public queue_interface {
+    public:
+
+        d3d12_queue(ID3D12Device6 *const device, queue_type type) : queue_{create_command_queue(device, command_list_type_of(type))} { }
+
+        void execute(std::span<command_list_interface *const> command_lists) override
+        {
+            command_lists_.clear();
+
+            for (auto command_list : command_lists)
+                command_lists_.push_back(static_cast<d3d12_command_list *>(command_list)->get());
+
+            if (!command_lists_.empty())
+                queue_->ExecuteCommandLists(static_cast<UINT>(std::size(command_lists_)), std::data(command_lists_));
+        }
+
+        void signal(fence_interface &fence, std::uint64_t value) override
+        {
+            if (auto result = queue_->Signal(static_cast<d3d12_fence &>(fence).get(), value); FAILED(result))
+                throw dx::fence_error(fmt::format("failed to signal a fence: {0:#x}"s, result));
+        }
+
+        void wait(fence_interface &fence, std::uint64_t value) override
+        {
+            if (auto result = queue_->Wait(static_cast<d3d12_fence &>(fence).get(), value); FAILED(result))
+                throw dx::fence_error(fmt::format("failed to wait for a fence on a queue: {0:#x}"s, result));
+        }
+
+        ID3D12CommandQueue *get() const noexcept { return queue_.get(); }
+
+    private:
+
+        winrt::com_ptr<ID3D12CommandQueue> queue_;
+
+        std::vector<ID3D12CommandList *> command_lists_;
+    };
+
+    class d3d12_device final : public device_interface {
+    public:
+
+        explicit d3d12_device(winrt::com_ptr<ID3D12Device6> device) noexcept : device_{std::move(device)} { }
+
+        std::unique_ptr<resource_interface>
+        create_committed_resource(resource_description const &description, heap_type heap, resource_access initial_access) override
+        {
+            CD3DX12_HEAP_PROPERTIES const heap_properties{heap_type_of(heap)};
+
+            auto const d3d12_description = description.dimension == resource_dimension::buffer
+                ? CD3DX12_RESOURCE_DESC::Buffer(description.width, resource_flags_of(description.flags))
+                : CD3DX12_RESOURCE_DESC::Tex2D(static_cast<DXGI_FORMAT>(description.format), description.width, description.height,
+                                               description.array_size, description.mip_levels, 1, 0, resource_flags_of(description.flags));
+
+            // Upload and readback heaps only allow a single state.
+            auto initial_state = resource_state_of(initial_access);
+
+            if (heap == heap_type::upload)
+                initial_state = D3D12_RESOURCE_STATE_GENERIC_READ;
+
+            else if (heap == heap_type::readback)
+                initial_state = D3D12_RESOURCE_STATE_COPY_DEST;
+
+            winrt::com_ptr<ID3D12Resource> resource;
+
+            if (auto result = device_->CreateCommittedResource(&heap_properties, D3D12_HEAP_FLAG_NONE, &d3d12_description, initial_state, nullptr,
+                                                               winrt::guid_of<ID3D12Resource>(), resource.put_void()); FAILED(result))
+                throw dx::device_error(fmt::format("failed to create a committed resource: {0:#x}"s, result));
+
+            return std::make_unique<d3d12_resource>(std::move(resource), description);
+        }
+
+        std::unique_ptr<descriptor_heap_interface> create_descriptor_heap(descriptor_heap_description const &description) override
+        {
+            auto const flags = description.shader_visible ? D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE : D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
+
+            auto heap = create_descriptor_heaps(device_.get(), descriptor_heap_type_of(description.type), description.count, flags);
+
+            return std::make_unique<d3d12_descriptor_heap>(std::move(heap), description);
+        }
+
+        std::unique_ptr<fence_interface> create_fence(std::uint64_t initial_value) override
+        {
+            return std::make_unique<d3d12_fence>(device_.get(), initial_value);
+        }
+
+        std::unique_ptr<queue_interface> create_queue(queue_type type) override
+        {
+            return std::make_unique<d3d12_queue>(device_.get(), type);
+        }
+
+        std::unique_ptr<command_list_interface> create_command_list(queue_type type) override
+        {
+            return std::make_unique<d3d12_command_list>(device_.get(), type);
+        }
+
+        ID3D12Device6 *get() const noexcept { return device_.get(); }
+
+    private:
+
+        winrt::com_ptr<ID3D12Device6> device_;
+
+        static D3D12_HEAP_TYPE heap_type_of(heap_type heap) noexcept
+        {
+            switch (heap) {
+                case heap_type::upload:
+                    return D3D12_HEAP_TYPE_UPLOAD;
+
+                case heap_type::readback:
+                    return D3D12_HEAP_TYPE_READBACK;
+
+                default:
+                    return D3D12_HEAP_TYPE_DEFAULT;
+            }
+        }
+
+        static D3D12_RESOURCE_FLAGS resource_flags_of(resource_flags flags) noexcept
+        {
+            auto d3d12_flags = D3D12_RESOURCE_FLAG_NONE;
+
+            if ((flags & resource_flags::render_target) != resource_flags::none)
+                d3d12_flags |= D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET;
+
+            if ((flags & resource_flags::depth_stencil) != resource_flags::none)
+                d3d12_flags |= D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL;
+
+            if ((flags & resource_flags::unordered_access) != resource_flags::none)
+                d3d12_flags |= D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS;
+
+            return d3d12_flags;
+        }
+
+        static D3D12_DESCRIPTOR_HEAP_TYPE descriptor_heap_type_of(descriptor_heap_type type) noexcept
+        {
+            switch (type) {
+                case descriptor_heap_type::sampler:
+                    return D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER;
+
+                case descriptor_heap_type::render_target:
+                    return D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
+
+                case descriptor_heap_type::depth_stencil:
+                    return D3D12_DESCRIPTOR_HEAP_TYPE_DSV;
+
+                default:
+                    return D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+            }
+        }
+    };
+}
@@ -1,16 +1,24 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <numeric>
+
 #include "main.hxx"
 #include "utility/exception.hxx"
 
 
 winrt::com_ptr<ID3D12DescriptorHeap>
-create_descriptor_heaps(ID3D12Device6 *const device, D3D12_DESCRIPTOR_HEAP_TYPE type, std::uint32_t number)
+create_descriptor_heaps(ID3D12Device6 *const device, D3D12_DESCRIPTOR_HEAP_TYPE type, std::uint32_t number,
+                        D3D12_DESCRIPTOR_HEAP_FLAGS flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE)
 {
     D3D12_DESCRIPTOR_HEAP_DESC description{
         type,
         number,
-        D3D12_DESCRIPTOR_HEAP_FLAG_NONE,
+        flags,
         0
     };
 
@@ -21,3 +29,247 @@ create_descriptor_heaps(ID3D12Device6 *const device, D3D12_DESCRIPTOR_HEAP_TYPE
 
     return heap;
 }
+
+namespace graphics
+{
+    auto constexpr kINVALID_DESCRIPTOR_INDEX = std::numeric_limits<std::uint32_t>::max();
+
+    struct descriptor final {
+        D3D12_CPU_DESCRIPTOR_HANDLE cpu_handle{0};
+
+        D3D12_DESCRIPTOR_HEAP_TYPE type{D3D12_DESCRIPTOR_HEAP_TYPE_RTV};
+        std::uint32_t index{kINVALID_DESCRIPTOR_INDEX};
+
+        bool valid() const noexcept { return index != kINVALID_DESCRIPTOR_INDEX; }
+    };
+
+    // Hands out single CPU-only descriptors of every heap type.
+    // Each heap type keeps a lock-free free list that spans a chain of equally sized heaps, and every thread keeps
+    // a small cache in front of it, so that most allocations and frees touch no shared state at all.
+    // Heaps are only added, never released, while the allocator is alive, and are released with it even if other threads
+    // still cache descriptors of them; threads return their cached descriptors on exit.
+    class descriptor_allocator final {
+    public:
+
+        explicit descriptor_allocator(ID3D12Device6 *const device) : state_{std::make_shared<state>()}
+        {
+            auto constexpr heap_capacities = std::array{
+                1024u,  // CBV_SRV_UAV
+                256u,   // Sampler
+                64u,    // RTV
+                16u     // DSV
+            };
+
+            for (auto type = 0u; type < kHEAP_TYPE_NUMBER; ++type) {
+                auto &pool = state_->pools[type];
+
+                pool.device = device;
+                pool.type = static_cast<D3D12_DESCRIPTOR_HEAP_TYPE>(type);
+                pool.heap_capacity = heap_capacities[type];
+                pool.increment_size = device->GetDescriptorHandleIncrementSize(pool.type);
+            }
+        }
+
+        descriptor_allocator(descriptor_allocator const &) = delete;
+        descriptor_allocator &operator=(descriptor_allocator const &) = delete;
+
+        [[nodiscard]] descriptor allocate(D3D12_DESCRIPTOR_HEAP_TYPE type)
+        {
+            auto &pool = state_->pools.at(type);
+            auto &bin = local_cache().bins[type];
+
+            if (bin.count == 0)
+                bin.count = pool.pop_batch(std::data(bin.indices), kCACHE_REFILL_SIZE);
+
+            auto const index = bin.indices[--bin.count];
+
+            return descriptor{pool.cpu_handle(index), type, index};
+        }
+
+        void free(descriptor const &allocation)
+        {
+            if (!allocation.valid())
+                return;
+
+            auto &bin = local_cache().bins[allocation.type];
+
+            if (bin.count == kCACHE_SIZE) {
+                bin.count -= kCACHE_REFILL_SIZE;
+
+                state_->pools[allocation.type].push_batch(std::data(bin.indices) + bin.count, kCACHE_REFILL_SIZE);
+            }
+
+            bin.indices[bin.count++] = allocation.index;
+        }
+
+        std::uint32_t heap_number(D3D12_DESCRIPTOR_HEAP_TYPE type) const noexcept
+        {
+            return state_->pools.at(type).page_count.load(std::memory_order_acquire);
+        }
+
+    private:
+
+        static auto constexpr kHEAP_TYPE_NUMBER = static_cast<std::uint32_t>(D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES);
+        static auto constexpr kMAX_HEAP_NUMBER = 64u;
+
+        static auto constexpr kCACHE_SIZE = 64u;
+        static auto constexpr kCACHE_REFILL_SIZE = kCACHE_SIZE / 2;
+
+        struct heap_page final {
+            winrt::com_ptr<ID3D12DescriptorHeap> heap;
+            SIZE_T cpu_start{0};
+        };
+
+        struct heap_pool final {
+            ID3D12Device6 *device{nullptr};
+
+            D3D12_DESCRIPTOR_HEAP_TYPE type{D3D12_DESCRIPTOR_HEAP_TYPE_RTV};
+            std::uint32_t heap_capacity{0};
+            std::uint32_t increment_size{0};
+
+            std::array<heap_page, kMAX_HEAP_NUMBER> pages;
+            std::atomic<std::uint32_t> page_count{0};
+
+            // Free list links indexed by the global descriptor index.
+            std::unique_ptr<std::atomic<std::uint32_t>[]> links;
+
+            // The low half is the index of the first free descriptor, the high half is a tag that changes with
+            // every update and makes a successful exchange prove that the list was not touched in between.
+            std::atomic<std::uint64_t> head{kINVALID_DESCRIPTOR_INDEX};
+
+            std::mutex grow_mutex;
+
+            static std::uint64_t pack(std::uint64_t tag, std::uint32_t index) noexcept { return (tag << 32) | index; }
+            static std::uint32_t index_of(std::uint64_t head) noexcept { return static_cast<std::uint32_t>(head); }
+            static std::uint64_t tag_of(std::uint64_t head) noexcept { return head >> 32; }
+
+            D3D12_CPU_DESCRIPTOR_HANDLE cpu_handle(std::uint32_t index) const noexcept
+            {
+                auto const &page = pages[index / heap_capacity];
+
+                return D3D12_CPU_DESCRIPTOR_HANDLE{page.cpu_start + static_cast<SIZE_T>(index % heap_capacity) * increment_size};
+            }
+
+            std::uint32_t pop_batch(std::uint32_t *indices, std::uint32_t number)
+            {
+                while (true) {
+                    auto current = head.load(std::memory_order_acquire);
+
+                    if (index_of(current) == kINVALID_DESCRIPTOR_INDEX) {
+                        grow();
+                        continue;
+                    }
+
+                    auto count = 0u;
+                    auto next = index_of(current);
+
+                    while (count < number && next != kINVALID_DESCRIPTOR_INDEX) {
+                        indices[count++] = next;
+                        next = links[next].load(std::memory_order_relaxed);
+                    }
+
+                    if (head.compare_exchange_weak(current, pack(tag_of(current) + 1, next), std::memory_order_acq_rel, std::memory_order_acquire))
+                        return count;
+                }
+            }
+
+            void push_batch(std::uint32_t const *indices, std::uint32_t number)
+            {
+                if (number == 0)
+                    return;
+
+                for (auto i = 0u; i + 1 < number; ++i)
+                    links[indices[i]].store(indices[i + 1], std::memory_order_relaxed);
+
+                auto current = head.load(std::memory_order_relaxed);
+
+                do {
+                    links[indices[number - 1]].store(index_of(current), std::memory_order_relaxed);
+                } while (!head.compare_exchange_weak(current, pack(tag_of(current) + 1, indices[0]), std::memory_order_release, std::memory_order_relaxed));
+            }
+
+            void grow()
+            {
+                std::lock_guard lock{grow_mutex};
+
+                // Another thread may have grown the pool or returned descriptors while this one was waiting.
+                if (index_of(head.load(std::memory_order_acquire)) != kINVALID_DESCRIPTOR_INDEX)
+                    return;
+
+                auto const page_index = page_count.load(std::memory_order_relaxed);
+
+                if (page_index == kMAX_HEAP_NUMBER)
+                    throw dx::device_error(fmt::format("exceeded the maximum number of descriptor heaps of type {}"s, static_cast<std::int32_t>(type)));
+
+                if (links == nullptr)
+                    links = std::make_unique<std::atomic<std::uint32_t>[]>(static_cast<std::size_t>(heap_capacity) * kMAX_HEAP_NUMBER);
+
+                auto &page = pages[page_index];
+
+                page.heap = create_descriptor_heaps(device, type, heap_capacity);
+                page.cpu_start = page.heap->GetCPUDescriptorHandleForHeapStart().ptr;
+
+                page_count.store(page_index + 1, std::memory_order_release);
+
+                auto const first = page_index * heap_capacity;
+
+                std::vector<std::uint32_t> indices(heap_capacity);
+                std::iota(std::begin(indices), std::end(indices), first);
+
+                push_batch(std::data(indices), heap_capacity);
+            }
+        };
+
+        struct state final {
+            std::array<heap_pool, kHEAP_TYPE_NUMBER> pools;
+        };
+
+        struct thread_cache final {
+            struct bin final {
+                std::array<std::uint32_t, kCACHE_SIZE> indices;
+                std::uint32_t count{0};
+            };
+
+            // Doesn't keep the owner's heaps alive: they die with the allocator, and the descriptors cached for an
+            // allocator that is gone are dropped with them.
+            std::weak_ptr<state> owner;
+
+            std::array<bin, kHEAP_TYPE_NUMBER> bins;
+
+            ~thread_cache() { flush(); }
+
+            bool owned_by(std::shared_ptr<state> const &value) const noexcept
+            {
+                return !owner.owner_before(value) && !value.owner_before(owner);
+            }
+
+            void flush()
+            {
+                if (auto const current = owner.lock(); current != nullptr) {
+                    for (auto type = 0u; type < kHEAP_TYPE_NUMBER; ++type)
+                        current->pools[type].push_batch(std::data(bins[type].indices), bins[type].count);
+                }
+
+                for (auto &&bin : bins)
+                    bin.count = 0;
+
+                owner.reset();
+            }
+        };
+
+        std::shared_ptr<state> state_;
+
+        thread_cache &local_cache()
+        {
+            thread_local thread_cache cache;
+
+            // Compares the control blocks, so a new allocator never takes over the cache of an expired one.
+            if (!cache.owned_by(state_)) {
+                cache.flush();
+                cache.owner = state_;
+            }
+
+            return cache;
+        }
+    };
+}
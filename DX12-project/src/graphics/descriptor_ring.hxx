@@ -0,0 +1,172 @@
+#pragma once
+
+#include <deque>
+#include <span>
+
+#include "main.hxx"
+#include "utility/exception.hxx"
+#include "graphics/descriptor.hxx"
+#include "graphics/fence.hxx"
+
+
+namespace graphics
+{
+    struct descriptor_table final {
+        D3D12_CPU_DESCRIPTOR_HANDLE cpu_handle{0};
+        D3D12_GPU_DESCRIPTOR_HANDLE gpu_handle{0};
+
+        std::uint32_t offset{0};
+        std::uint32_t size{0};
+    };
+
+    struct descriptor_ring_statistics final {
+        std::uint32_t capacity{0};
+
+        std::uint64_t occupancy{0};
+        std::uint64_t peak_occupancy{0};
+
+        std::uint64_t wrap_stalls{0};
+        std::uint64_t copy_calls{0};
+    };
+
+    // Shader-visible CBV_SRV_UAV heap suballocated as a ring.
+    // Tables are allocated contiguously from the head, each frame's allocations are retired together with the frame's
+    // fence value, and the tail only moves once that value has been reached.
+    // The heap may start with a persistent region the ring never touches; only one heap of the type can be bound
+    // at a time, so bindless descriptors have to live in the same heap as the transient tables.
+    class descriptor_ring final {
+    public:
+
+        descriptor_ring(ID3D12Device6 *const device, fence_timeline &timeline, std::uint32_t capacity, std::uint32_t persistent_capacity = 0)
+            : device_{device}, timeline_{timeline}, capacity_{capacity}, persistent_capacity_{persistent_capacity}
+        {
+            heap_ = create_descriptor_heaps(device, D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, persistent_capacity + capacity,
+                                            D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE);
+
+            increment_size_ = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+            cpu_start_ = heap_->GetCPUDescriptorHandleForHeapStart();
+            gpu_start_ = heap_->GetGPUDescriptorHandleForHeapStart();
+
+            statistics_.capacity = capacity;
+        }
+
+        descriptor_ring(descriptor_ring const &) = delete;
+        descriptor_ring &operator=(descriptor_ring const &) = delete;
+
+        ID3D12DescriptorHeap *heap() const noexcept { return heap_.get(); }
+
+        descriptor_ring_statistics const &statistics() const noexcept { return statistics_; }
+
+        std::uint32_t persistent_capacity() const noexcept { return persistent_capacity_; }
+
+        D3D12_CPU_DESCRIPTOR_HANDLE persistent_cpu_handle(std::uint32_t index) const noexcept
+        {
+            return D3D12_CPU_DESCRIPTOR_HANDLE{cpu_start_.ptr + static_cast<SIZE_T>(index) * increment_size_};
+        }
+
+        D3D12_GPU_DESCRIPTOR_HANDLE persistent_gpu_handle(std::uint32_t index) const noexcept
+        {
+            return D3D12_GPU_DESCRIPTOR_HANDLE{gpu_start_.ptr + static_cast<UINT64>(index) * increment_size_};
+        }
+
+        [[nodiscard]] descriptor_table allocate(std::uint32_t size)
+        {
+            if (size == 0 || size > capacity_)
+                throw dx::device_error(fmt::format("descriptor table of {} descriptors doesn't fit the ring of {}"s, size, capacity_));
+
+            reclaim();
+
+            auto offset = static_cast<std::uint32_t>(head_ % capacity_);
+
+            // A table can't straddle the end of the heap, so the tail end is skipped and released with the frame.
+            auto const padding = offset + size > capacity_ ? capacity_ - offset : 0u;
+
+            while (head_ + padding + size - tail_ > capacity_) {
+                if (retired_frames_.empty())
+                    throw dx::device_error("descriptor ring is exhausted by a single frame"s);
+
+                ++statistics_.wrap_stalls;
+
+                timeline_.wait(retired_frames_.front().fence_value);
+
+                reclaim();
+            }
+
+            head_ += padding;
+            offset = static_cast<std::uint32_t>(head_ % capacity_);
+
+            head_ += size;
+
+            // Position in the heap, behind the persistent region.
+            offset += persistent_capacity_;
+
+            statistics_.occupancy = head_ - tail_;
+            statistics_.peak_occupancy = (std::max)(statistics_.peak_occupancy, statistics_.occupancy);
+
+            return descriptor_table{
+                D3D12_CPU_DESCRIPTOR_HANDLE{cpu_start_.ptr + static_cast<SIZE_T>(offset) * increment_size_},
+                D3D12_GPU_DESCRIPTOR_HANDLE{gpu_start_.ptr + static_cast<UINT64>(offset) * increment_size_},
+                offset, size
+            };
+        }
+
+        // Gathers the CPU-only source descriptors into one contiguous table with a single CopyDescriptors call.
+        [[nodiscard]] descriptor_table copy_table(std::span<D3D12_CPU_DESCRIPTOR_HANDLE const> descriptors)
+        {
+            auto table = allocate(static_cast<std::uint32_t>(std::size(descriptors)));
+
+            UINT const destination_size = table.size;
+
+            device_->CopyDescriptors(1, &table.cpu_handle, &destination_size,
+                                     static_cast<UINT>(std::size(descriptors)), std::data(descriptors), nullptr,
+                                     D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+
+            ++statistics_.copy_calls;
+
+            return table;
+        }
+
+        // Everything allocated since the previous call is released once the fence reaches the value.
+        void end_frame(UINT64 fence_value)
+        {
+            retired_frames_.push_back(retired_frame{fence_value, head_});
+        }
+
+    private:
+
+        struct retired_frame final {
+            UINT64 fence_value{0};
+            std::uint64_t head{0};
+        };
+
+        ID3D12Device6 *device_;
+        fence_timeline &timeline_;
+
+        winrt::com_ptr<ID3D12DescriptorHeap> heap_;
+
+        std::uint32_t capacity_{0};
+        std::uint32_t persistent_capacity_{0};
+        std::uint32_t increment_size_{0};
+
+        D3D12_CPU_DESCRIPTOR_HANDLE cpu_start_{0};
+        D3D12_GPU_DESCRIPTOR_HANDLE gpu_start_{0};
+
+        // Monotonic positions; the offset in the ring is the position modulo the capacity.
+        std::uint64_t head_{0}, tail_{0};
+
+        std::deque<retired_frame> retired_frames_;
+
+        descriptor_ring_statistics statistics_;
+
+        void reclaim()
+        {
+            while (!retired_frames_.empty() && timeline_.is_complete(retired_frames_.front().fence_value)) {
+                tail_ = retired_frames_.front().head;
+                retired_frames_.pop_front();
+            }
+
+            statistics_.occupancy = head_ - tail_;
+        }
+    };
+}
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <span>
+
+#include "graphics/bindless_layout.hxx"
+
+
+namespace graphics
+{
+    // Per-instance data read by the culling pass and the vertex shaders; matches 'instance_data' in shaders/indirect.hlsli.
+    struct gpu_instance final {
+        // Object to world: the first three rows of a 4x4 matrix that transforms column vectors.
+        std::array<float, 12> transform{1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f};
+
+        // Object-space bounding sphere: center and radius.
+        std::array<float, 4> bounds{0.f, 0.f, 0.f, 0.f};
+
+        // Index into the mesh table.
+        std::uint32_t mesh{0};
+        bindless_index material;
+
+        std::array<std::uint32_t, 2> padding{0, 0};
+    };
+
+    static_assert(sizeof(gpu_instance) == 80, "has to match the shader structure");
+
+    // The part of a mesh's index buffer a draw uses; matches 'mesh_data' in shaders/indirect.hlsli.
+    struct mesh_draw final {
+        std::uint32_t index_count{0};
+        std::uint32_t first_index{0};
+        std::int32_t base_vertex{0};
+
+        std::uint32_t padding{0};
+    };
+
+    static_assert(sizeof(mesh_draw) == 16, "has to match the shader structure");
+
+    // Same layout as D3D12_DRAW_INDEXED_ARGUMENTS.
+    struct draw_indexed_arguments final {
+        std::uint32_t index_count_per_instance{0};
+        std::uint32_t instance_count{0};
+        std::uint32_t start_index_location{0};
+        std::int32_t base_vertex_location{0};
+        std::uint32_t start_instance_location{0};
+    };
+
+    // One command of the indirect draw command signature: the root constant with the instance index, then the draw.
+    struct indirect_draw_command final {
+        std::uint32_t instance_index{0};
+        draw_indexed_arguments arguments;
+    };
+
+    static_assert(sizeof(indirect_draw_command) == 24, "has to match the command signature stride");
+
+    // Set by the command signature for every indirect draw.
+    struct indirect_draw_bindings final {
+        std::uint32_t instance_index{0};
+    };
+
+    // Set once before the indirect draws.
+    struct scene_bindings final {
+        bindless_index instances;
+        bindless_index meshes;
+    };
+
+    using indirect_draw_layout = root_constant_layout<indirect_draw_bindings, scene_bindings>;
+
+    struct culling_bindings final {
+        bindless_index instances;
+        bindless_index meshes;
+        bindless_index commands;
+        bindless_index command_count;
+    };
+
+    using culling_layout = root_constant_layout<culling_bindings>;
+
+    // Planes (a, b, c, d) with normalized normals pointing inside: a point is inside if a x + b y + c z + d >= 0 for all.
+    struct frustum final {
+        std::array<std::array<float, 4>, 6> planes;
+    };
+
+    // Constants of the culling pass, bound as the frame constants; matches 'culling_constants' in shaders/indirect.hlsli.
+    struct culling_constants final {
+        frustum view_frustum;
+
+        std::uint32_t instance_count{0};
+        std::uint32_t mesh_count{0};
+
+        std::array<std::uint32_t, 2> padding{0, 0};
+    };
+
+    static_assert(sizeof(culling_constants) % 16 == 0, "constant buffer structures are made of 16-byte registers");
+
+    // Extracts the planes from a row-major view-projection matrix that transforms column vectors into
+    // the D3D clip space, where 0 <= z <= w.
+    frustum frustum_of(std::array<float, 16> const &view_projection) noexcept
+    {
+        auto const row = [&view_projection] (std::size_t index)
+        {
+            return std::array{
+                view_projection[index * 4 + 0], view_projection[index * 4 + 1], view_projection[index * 4 + 2], view_projection[index * 4 + 3]
+            };
+        };
+
+        auto const combine = [] (std::array<float, 4> const &lhs, std::array<float, 4> const &rhs, float sign)
+        {
+            return std::array{lhs[0] + sign * rhs[0], lhs[1] + sign * rhs[1], lhs[2] + sign * rhs[2], lhs[3] + sign * rhs[3]};
+        };
+
+        auto const r0 = row(0), r1 = row(1), r2 = row(2), r3 = row(3);
+
+        frustum result{{
+            combine(r3, r0, 1.f), combine(r3, r0, -1.f),
+            combine(r3, r1, 1.f), combine(r3, r1, -1.f),
+            r2, combine(r3, r2, -1.f)
+        }};
+
+        for (auto &&plane : result.planes) {
+            auto const length = std::sqrt(plane[0] * plane[0] + plane[1] * plane[1] + plane[2] * plane[2]);
+
+            if (length > 0.f) {
+                for (auto &&value : plane)
+                    value /= length;
+            }
+        }
+
+        return result;
+    }
+
+    // The bounding sphere is moved by the transform and scaled by its largest axis scale.
+    bool instance_visible(frustum const &view_frustum, gpu_instance const &instance) noexcept
+    {
+        auto &&m = instance.transform;
+        auto &&b = instance.bounds;
+
+        std::array const center{
+            m[0] * b[0] + m[1] * b[1] + m[2] * b[2] + m[3],
+            m[4] * b[0] + m[5] * b[1] + m[6] * b[2] + m[7],
+            m[8] * b[0] + m[9] * b[1] + m[10] * b[2] + m[11]
+        };
+
+        auto const scale_squared = (std::max)({
+            m[0] * m[0] + m[4] * m[4] + m[8] * m[8],
+            m[1] * m[1] + m[5] * m[5] + m[9] * m[9],
+            m[2] * m[2] + m[6] * m[6] + m[10] * m[10]
+        });
+
+        auto const radius = b[3] * std::sqrt(scale_squared);
+
+        for (auto &&plane : view_frustum.planes) {
+            if (plane[0] * center[0] + plane[1] * center[1] + plane[2] * center[2] + plane[3] < -radius)
+                return false;
+        }
+
+        return true;
+    }
+
+    // What the culling pass writes, for one instance.
+    constexpr indirect_draw_command draw_command_of(std::uint32_t instance_index, mesh_draw const &mesh) noexcept
+    {
+        return indirect_draw_command{
+            instance_index,
+            draw_indexed_arguments{mesh.index_count, 1, mesh.first_index, mesh.base_vertex, 0}
+        };
+    }
+
+    // CPU version of the culling pass in shaders/cull_instances.hlsl: packs a command for every visible instance
+    // with a valid mesh and returns their number. 'commands' needs room for all instances. The GPU appends
+    // the commands in no particular order.
+    std::uint32_t pack_draw_commands(std::span<gpu_instance const> instances, std::span<mesh_draw const> meshes,
+                                     frustum const &view_frustum, std::span<indirect_draw_command> commands) noexcept
+    {
+        std::uint32_t count = 0;
+
+        for (std::uint32_t index = 0; index < std::size(instances); ++index) {
+            auto &&instance = instances[index];
+
+            if (instance.mesh >= std::size(meshes) || !instance_visible(view_frustum, instance))
+                continue;
+
+            commands[count++] = draw_command_of(index, meshes[instance.mesh]);
+        }
+
+        return count;
+    }
+}
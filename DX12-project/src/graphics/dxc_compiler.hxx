@@ -0,0 +1,203 @@
+#pragma once
+
+#include <algorithm>
+#include <filesystem>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include "main.hxx"
+#include "utility/exception.hxx"
+#include "graphics/shader_build.hxx"
+
+
+namespace graphics
+{
+    // dxcompiler.dll isn't part of Windows, so it is loaded on first use rather than imported: on a machine without it
+    // creating a compiler throws, instead of the executable failing to start.
+    DxcCreateInstanceProc dxc_create_instance()
+    {
+        static auto const function = [] () -> DxcCreateInstanceProc
+        {
+            auto const module = LoadLibraryW(L"dxcompiler.dll");
+
+            if (module == nullptr)
+                return nullptr;
+
+            return reinterpret_cast<DxcCreateInstanceProc>(GetProcAddress(module, "DxcCreateInstance"));
+        }();
+
+        if (function == nullptr)
+            throw dx::com_exception("failed to load DxcCreateInstance from dxcompiler.dll"s);
+
+        return function;
+    }
+
+    // Serves includes from the scanned sources. DXC asks for every candidate path in turn; the ones that aren't
+    // part of the sources don't exist as far as it is concerned.
+    class dxc_include_handler final : public winrt::implements<dxc_include_handler, IDxcIncludeHandler> {
+    public:
+
+        dxc_include_handler(IDxcUtils *const utils, shader_sources const &sources) noexcept : utils_{utils}, sources_{sources} { }
+
+        HRESULT STDMETHODCALLTYPE LoadSource(LPCWSTR filename, IDxcBlob **include) noexcept override
+        {
+            *include = nullptr;
+
+            auto const file = sources_.find(std::filesystem::path{filename});
+
+            if (file == nullptr)
+                return HRESULT_FROM_WIN32(ERROR_FILE_NOT_FOUND);
+
+            winrt::com_ptr<IDxcBlobEncoding> blob;
+
+            if (auto result = utils_->CreateBlob(std::data(file->text), static_cast<UINT32>(std::size(file->text)), DXC_CP_UTF8, blob.put()); FAILED(result))
+                return result;
+
+            *include = blob.detach();
+
+            return S_OK;
+        }
+
+    private:
+
+        IDxcUtils *utils_;
+        shader_sources const &sources_;
+    };
+
+    // DirectX Shader Compiler. Reflection is stripped from the bytecode and returned separately.
+    class dxc_compiler final : public shader_compiler_interface {
+    public:
+
+        explicit dxc_compiler(std::vector<std::filesystem::path> include_directories = { }, std::vector<std::wstring> options = {L"-O3"s})
+            : options_{std::move(options)}
+        {
+            for (auto &&directory : include_directories)
+                include_directories_.push_back(normalize_shader_path(directory));
+
+            auto compiler = create_compiler();
+
+            auto version_info = compiler.as<IDxcVersionInfo>();
+
+            UINT32 major = 0, minor = 0;
+
+            if (auto result = version_info->GetVersion(&major, &minor); FAILED(result))
+                throw dx::com_exception(fmt::format("failed to get the DXC version: {0:#x}"s, result));
+
+            identity_ = fmt::format("dxc {0}.{1}"s, major, minor);
+
+            if (auto commit_info = compiler.try_as<IDxcVersionInfo2>(); commit_info != nullptr) {
+                UINT32 commit_count = 0;
+                char *commit_hash = nullptr;
+
+                if (SUCCEEDED(commit_info->GetCommitInfo(&commit_count, &commit_hash))) {
+                    identity_ += fmt::format(" {0} {1}"s, commit_count, commit_hash);
+                    CoTaskMemFree(commit_hash);
+                }
+            }
+
+            for (auto &&option : options_)
+                identity_ += ' ' + winrt::to_string(option);
+        }
+
+        std::string identity() const override { return identity_; }
+
+        shader_binary compile(shader_request const &request, shader_sources const &sources) override
+        {
+            // Compiler instances aren't meant to be shared between threads.
+            auto compiler = create_compiler();
+
+            winrt::com_ptr<IDxcUtils> utils;
+
+            if (auto result = dxc_create_instance()(CLSID_DxcUtils, winrt::guid_of<IDxcUtils>(), utils.put_void()); FAILED(result))
+                throw dx::com_exception(fmt::format("failed to create DXC utilities: {0:#x}"s, result));
+
+            std::vector<std::wstring> arguments{
+                sources.main().path.wstring(),
+                L"-E"s, std::wstring{winrt::to_hstring(request.entry_point)},
+                L"-T"s, std::wstring{winrt::to_hstring(request.target)},
+                L"-Qstrip_reflection"s,
+                L"-Qstrip_debug"s
+            };
+
+            for (auto &&define : request.defines) {
+                arguments.push_back(L"-D"s);
+                arguments.push_back(std::wstring{winrt::to_hstring(define.name + '=' + define.value)});
+            }
+
+            for (auto &&directory : include_directories_) {
+                arguments.push_back(L"-I"s);
+                arguments.push_back(directory.wstring());
+            }
+
+            arguments.insert(std::end(arguments), std::begin(options_), std::end(options_));
+
+            std::vector<LPCWSTR> argument_pointers;
+
+            std::transform(std::cbegin(arguments), std::cend(arguments), std::back_inserter(argument_pointers), [] (auto &&argument)
+            {
+                return argument.c_str();
+            });
+
+            auto &&text = sources.main().text;
+
+            DxcBuffer const source{std::data(text), std::size(text), DXC_CP_UTF8};
+
+            auto include_handler = winrt::make<dxc_include_handler>(utils.get(), sources);
+
+            winrt::com_ptr<IDxcResult> output;
+
+            if (auto result = compiler->Compile(&source, std::data(argument_pointers), static_cast<UINT32>(std::size(argument_pointers)),
+                                                include_handler.get(), winrt::guid_of<IDxcResult>(), output.put_void()); FAILED(result))
+                throw dx::com_exception(fmt::format("failed to run DXC: {0:#x}"s, result));
+
+            HRESULT status = S_OK;
+            output->GetStatus(&status);
+
+            if (FAILED(status)) {
+                winrt::com_ptr<IDxcBlobUtf8> errors;
+                output->GetOutput(DXC_OUT_ERRORS, winrt::guid_of<IDxcBlobUtf8>(), errors.put_void(), nullptr);
+
+                auto const message = errors != nullptr ? std::string{errors->GetStringPointer(), errors->GetStringLength()} : std::string{ };
+
+                throw shader_error(fmt::format("failed to compile {0} ({1}, {2}): {3}"s, request.source.string(), request.entry_point, request.target, message));
+            }
+
+            shader_binary binary;
+
+            auto const copy = [&output] (DXC_OUT_KIND kind, std::vector<std::byte> &bytes)
+            {
+                winrt::com_ptr<IDxcBlob> blob;
+
+                if (!output->HasOutput(kind) || FAILED(output->GetOutput(kind, winrt::guid_of<IDxcBlob>(), blob.put_void(), nullptr)))
+                    return;
+
+                auto const data = static_cast<std::byte const *>(blob->GetBufferPointer());
+
+                bytes.assign(data, data + blob->GetBufferSize());
+            };
+
+            copy(DXC_OUT_OBJECT, binary.bytecode);
+            copy(DXC_OUT_REFLECTION, binary.reflection);
+
+            return binary;
+        }
+
+    private:
+
+        std::vector<std::filesystem::path> include_directories_;
+        std::vector<std::wstring> options_;
+
+        std::string identity_;
+
+        static winrt::com_ptr<IDxcCompiler3> create_compiler()
+        {
+            winrt::com_ptr<IDxcCompiler3> compiler;
+
+            if (auto result = dxc_create_instance()(CLSID_DxcCompiler, winrt::guid_of<IDxcCompiler3>(), compiler.put_void()); FAILED(result))
+                throw dx::com_exception(fmt::format("failed to create a DXC instance: {0:#x}"s, result));
+
+            return compiler;
+        }
+    };
+}
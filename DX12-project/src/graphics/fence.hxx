@@ -0,0 +1,175 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <span>
+
+#include "main.hxx"
+#include "utility/exception.hxx"
+
+
+namespace graphics
+{
+    auto constexpr kINFINITE_WAIT = (std::chrono::milliseconds::max)();
+
+    // Monotonically increasing fence values of a single command queue.
+    // Signaling has to be serialized with the queue submissions; querying and waiting may happen from any thread.
+    class fence_timeline final {
+    public:
+
+        explicit fence_timeline(ID3D12Device6 *const device)
+        {
+            if (auto result = device->CreateFence(0, D3D12_FENCE_FLAG_NONE, winrt::guid_of<ID3D12Fence1>(), fence_.put_void()); FAILED(result))
+                throw dx::fence_error(fmt::format("failed to create a fence: {0:#x}"s, result));
+        }
+
+        ~fence_timeline()
+        {
+            for (auto event_handle : event_pool_)
+                CloseHandle(event_handle);
+        }
+
+        fence_timeline(fence_timeline const &) = delete;
+        fence_timeline &operator=(fence_timeline const &) = delete;
+
+        ID3D12Fence1 *get() const noexcept { return fence_.get(); }
+
+        UINT64 last_signaled_value() const noexcept { return last_signaled_.load(std::memory_order_acquire); }
+
+        UINT64 signal(ID3D12CommandQueue *const queue)
+        {
+            auto const value = last_signaled_.load(std::memory_order_relaxed) + 1;
+
+            if (auto result = queue->Signal(fence_.get(), value); FAILED(result))
+                throw dx::fence_error(fmt::format("failed to update a fence: {0:#x}"s, result));
+
+            last_signaled_.store(value, std::memory_order_release);
+
+            return value;
+        }
+
+        UINT64 completed_value() noexcept
+        {
+            auto const value = fence_->GetCompletedValue();
+
+            // Keep the cached value monotonic even if several threads refresh it concurrently.
+            auto cached = last_completed_.load(std::memory_order_relaxed);
+
+            while (cached < value && !last_completed_.compare_exchange_weak(cached, value, std::memory_order_release, std::memory_order_relaxed));
+
+            return (std::max)(cached, value);
+        }
+
+        bool is_complete(UINT64 value) noexcept
+        {
+            if (value <= last_completed_.load(std::memory_order_acquire))
+                return true;
+
+            return value <= completed_value();
+        }
+
+        // Returns false if the timeout elapsed before the fence reached the value.
+        bool wait(UINT64 value, std::chrono::milliseconds timeout = kINFINITE_WAIT)
+        {
+            if (is_complete(value))
+                return true;
+
+            auto const deadline = timeout == kINFINITE_WAIT ? (std::chrono::steady_clock::time_point::max)()
+                                                            : std::chrono::steady_clock::now() + timeout;
+
+            auto event_handle = acquire_event();
+
+            // An event that timed out earlier can still be signaled by its stale registration, so the wait
+            // is repeated until the fence has really been reached.
+            while (!is_complete(value)) {
+                if (auto result = fence_->SetEventOnCompletion(value, event_handle); FAILED(result)) {
+                    release_event(event_handle);
+
+                    throw dx::fence_error(fmt::format("failed to specify a fence signaled event: {0:#x}"s, result));
+                }
+
+                DWORD wait_ms = INFINITE;
+
+                if (timeout != kINFINITE_WAIT) {
+                    auto const remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - std::chrono::steady_clock::now());
+
+                    // INFINITE is a valid DWORD too, so a long finite timeout must stop short of it.
+                    wait_ms = static_cast<DWORD>(std::clamp(remaining.count(), std::chrono::milliseconds::rep{0},
+                                                            static_cast<std::chrono::milliseconds::rep>(INFINITE - 1)));
+                }
+
+                auto const wait_result = WaitForSingleObject(event_handle, wait_ms);
+
+                if (wait_result == WAIT_FAILED) {
+                    auto const error = GetLastError();
+
+                    // The event is no use to the next waiter.
+                    CloseHandle(event_handle);
+
+                    throw dx::fence_error(fmt::format("failed to wait for a fence event: {0:#x}"s, error));
+                }
+
+                if (wait_result == WAIT_TIMEOUT) {
+                    release_event(event_handle);
+
+                    return is_complete(value);
+                }
+            }
+
+            release_event(event_handle);
+
+            return true;
+        }
+
+        // Waits once for the largest of the values instead of waiting for each of them in turn.
+        bool wait_all(std::span<UINT64 const> values, std::chrono::milliseconds timeout = kINFINITE_WAIT)
+        {
+            if (values.empty())
+                return true;
+
+            return wait(*std::max_element(std::begin(values), std::end(values)), timeout);
+        }
+
+        void flush(ID3D12CommandQueue *const queue)
+        {
+            wait(signal(queue));
+        }
+
+    private:
+
+        winrt::com_ptr<ID3D12Fence1> fence_;
+
+        std::atomic<UINT64> last_signaled_{0};
+        std::atomic<UINT64> last_completed_{0};
+
+        std::mutex event_pool_mutex_;
+        std::vector<HANDLE> event_pool_;
+
+        HANDLE acquire_event()
+        {
+            {
+                std::lock_guard lock{event_pool_mutex_};
+
+                if (!event_pool_.empty()) {
+                    auto event_handle = event_pool_.back();
+                    event_pool_.pop_back();
+
+                    return event_handle;
+                }
+            }
+
+            if (auto event_handle = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS); event_handle != nullptr)
+                return event_handle;
+
+            throw dx::fence_error(fmt::format("failed to create a fence event: {0:#x}"s, GetLastError()));
+        }
+
+        void release_event(HANDLE event_handle)
+        {
+            std::lock_guard lock{event_pool_mutex_};
+
+            event_pool_.push_back(event_handle);
+        }
+    };
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include "main.hxx"
+#include "utility/exception.hxx"
+#include "graphics/command_pool.hxx"
+#include "graphics/fence.hxx"
+#include "graphics/queue.hxx"
+#include "graphics/resource_state.hxx"
+
+
+namespace graphics
+{
+    // Per-frame recording state. A slot is recycled only after the GPU has reached its fence value,
+    // so the CPU is free to record up to 'frames in flight' frames ahead of the GPU.
+    struct frame_context final {
+        // Pairs acquired for the frame; they go back to the pool with the fence value of the submission.
+        std::vector<command_context> command_contexts;
+
+        // The list the render thread records into and the closed lists that precede it in submission order.
+        ID3D12GraphicsCommandList5 *current_command_list{nullptr};
+        std::vector<ID3D12CommandList *> command_lists;
+
+        resource_state_tracker state_tracker;
+
+        UINT64 fence_value{0};
+    };
+}
+
+std::vector<graphics::frame_context>
+create_frame_contexts(std::uint32_t frames_in_flight, graphics::resource_state_registry &resource_states)
+{
+    std::vector<graphics::frame_context> frame_contexts(frames_in_flight);
+
+    for (auto &&frame : frame_contexts)
+        frame.state_tracker = graphics::resource_state_tracker{resource_states};
+
+    return frame_contexts;
+}
+
+// Starts the frame's recording on a list from the pool.
+void begin_command_lists(graphics::frame_context &frame, graphics::command_pool &command_pool, D3D12_COMMAND_LIST_TYPE type)
+{
+    frame.command_contexts.push_back(command_pool.acquire(type));
+
+    frame.current_command_list = frame.command_contexts.back().command_list.get();
+    frame.command_lists.clear();
+
+    frame.state_tracker.reset();
+}
+
+// Executes the frame's lists, preceded by the barriers that the first resource uses within them turned out to need,
+// and hands the lists back to the pool. The queue first waits for the fences of other queues the frame depends on.
+// Returns the fence value of the submission.
+UINT64 submit_command_lists(graphics::frame_context &frame, graphics::command_pool &command_pool, graphics::queue_scheduler &queues,
+                            graphics::queue_type type, std::span<graphics::queue_fence const> waits = { })
+{
+    if (auto result = frame.current_command_list->Close(); FAILED(result))
+        throw dx::device_error(fmt::format("failed to close a command list: {0:#x}"s, result));
+
+    frame.command_lists.push_back(frame.current_command_list);
+    frame.current_command_list = nullptr;
+
+    if (auto const barriers = frame.state_tracker.resolve(); !barriers.empty()) {
+        auto fixup = command_pool.acquire(frame.command_contexts.front().type);
+
+        fixup.command_list->ResourceBarrier(static_cast<UINT>(std::size(barriers)), std::data(barriers));
+
+        if (auto result = fixup.command_list->Close(); FAILED(result))
+            throw dx::device_error(fmt::format("failed to close a command list: {0:#x}"s, result));
+
+        frame.command_lists.insert(std::begin(frame.command_lists), fixup.command_list.get());
+        frame.command_contexts.push_back(std::move(fixup));
+    }
+
+    auto const fence_value = queues.submit(type, frame.command_lists, waits).value;
+
+    for (auto &&context : frame.command_contexts)
+        command_pool.release(std::move(context), queues.timeline(type), fence_value);
+
+    frame.command_contexts.clear();
+    frame.command_lists.clear();
+
+    return fence_value;
+}
+
+// Blocks until the GPU is done with every frame in flight, e.g. before the buffers they render to are resized.
+// Frames are submitted in order on one queue, so only the latest frame's fence is waited for; the other queues keep running.
+void wait_for_frames_in_flight(std::span<graphics::frame_context const> frame_contexts, graphics::queue_scheduler &queues,
+                               graphics::queue_type type = graphics::queue_type::graphics)
+{
+    auto const last_frame = std::max_element(std::cbegin(frame_contexts), std::cend(frame_contexts), [] (auto &&lhs, auto &&rhs)
+    {
+        return lhs.fence_value < rhs.fence_value;
+    });
+
+    if (last_frame != std::cend(frame_contexts))
+        queues.timeline(type).wait(last_frame->fence_value);
+}
@@ -0,0 +1,124 @@
+#pragma once
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <utility>
+
+#include "main.hxx"
+#include "graphics/fence.hxx"
+
+
+namespace graphics
+{
+    // Timestamps the moments the GPU reaches the fence values of the frames, for the frame pacer: the CPU time after
+    // Present leaves the GPU's share of a frame out. A thread waits for the values in submission order, so a time is
+    // late by no more than the thread's wake-up.
+    class frame_completion_timer final {
+    public:
+
+        using clock = std::chrono::steady_clock;
+        using time_point = std::chrono::time_point<clock, std::chrono::nanoseconds>;
+
+        explicit frame_completion_timer(fence_timeline &timeline) : timeline_{timeline}, thread_{[this] { run(); }} { }
+
+        // The timeline has to outlive the timer; a value the GPU doesn't reach is given up on here.
+        ~frame_completion_timer()
+        {
+            {
+                std::lock_guard lock{mutex_};
+                stop_ = true;
+            }
+
+            pending_condition_.notify_all();
+
+            thread_.join();
+        }
+
+        frame_completion_timer(frame_completion_timer const &) = delete;
+        frame_completion_timer &operator=(frame_completion_timer const &) = delete;
+
+        // After the frame's last submission; values have to come in increasing order.
+        void submitted(UINT64 value)
+        {
+            {
+                std::lock_guard lock{mutex_};
+                pending_.push_back(value);
+            }
+
+            pending_condition_.notify_one();
+        }
+
+        // Blocks until the GPU has reached the submitted 'value' and returns when it did. Times of earlier values
+        // are forgotten.
+        time_point completion_time(UINT64 value)
+        {
+            std::unique_lock lock{mutex_};
+
+            completed_condition_.wait(lock, [this, value] { return last_completed_ >= value; });
+
+            while (completed_.front().first < value)
+                completed_.pop_front();
+
+            return completed_.front().second;
+        }
+
+    private:
+
+        fence_timeline &timeline_;
+
+        std::mutex mutex_;
+
+        std::condition_variable pending_condition_;
+        std::condition_variable completed_condition_;
+
+        std::deque<UINT64> pending_;
+        std::deque<std::pair<UINT64, time_point>> completed_;
+
+        UINT64 last_completed_{0};
+        bool stop_{false};
+
+        std::thread thread_;
+
+        void run()
+        {
+            while (true) {
+                UINT64 value = 0;
+
+                {
+                    std::unique_lock lock{mutex_};
+
+                    pending_condition_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+
+                    if (stop_)
+                        return;
+
+                    value = pending_.front();
+                }
+
+                // Bounded, so that stopping doesn't depend on the GPU.
+                while (!timeline_.wait(value, std::chrono::milliseconds{100})) {
+                    std::lock_guard lock{mutex_};
+
+                    if (stop_)
+                        return;
+                }
+
+                auto const time = clock::now();
+
+                {
+                    std::lock_guard lock{mutex_};
+
+                    pending_.pop_front();
+                    completed_.emplace_back(value, time);
+
+                    last_completed_ = value;
+                }
+
+                completed_condition_.notify_all();
+            }
+        }
+    };
+}
@@ -0,0 +1,179 @@
+#pragma once
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <optional>
+#include <thread>
+#include <vector>
+
+
+namespace graphics
+{
+    struct frame_pacer_settings final {
+        // Of the display, until the actual one is known.
+        std::chrono::nanoseconds refresh_period{16'666'667};
+
+        // Time kept free before the deadline on top of the predicted work.
+        std::chrono::nanoseconds margin{std::chrono::milliseconds{1}};
+
+        // The predicted work is this percentile of the recent frames.
+        double percentile{0.99};
+
+        std::uint32_t history_size{120};
+
+        // Frames whose latency is kept for the statistics.
+        std::uint32_t latency_history_size{1024};
+
+        // Without pacing, input is sampled as soon as the swapchain can take a frame.
+        bool enabled{true};
+    };
+
+    struct frame_pacer_statistics final {
+        std::uint64_t frames{0};
+        std::uint64_t missed{0};
+
+        std::chrono::nanoseconds period{0};
+        std::chrono::nanoseconds predicted_work{0};
+        std::chrono::nanoseconds margin{0};
+        std::chrono::nanoseconds delay{0};
+    };
+
+    // Delays the start of a frame after the frame latency wait, so that input is sampled as late as the frame's
+    // work allows and the frame still makes the next vsync. The work of the recent frames predicts the next one;
+    // a missed vsync, seen as a wake-up that comes a period late, widens the margin, which then decays back.
+    // The refresh period has to come from the display: the intervals between wake-ups include the delay itself.
+    //
+    // With a maximum frame latency of one, the wait returns about when the previous frame is displayed, so the time
+    // from sampling input to the next wake-up is the input-to-display latency of the frame.
+    class frame_pacer final {
+    public:
+
+        using clock = std::chrono::steady_clock;
+        using duration = std::chrono::nanoseconds;
+        using time_point = std::chrono::time_point<clock, duration>;
+
+        explicit frame_pacer(frame_pacer_settings settings = { })
+            : settings_{settings}, period_{settings.refresh_period}, margin_{settings.margin}
+        {
+            work_.reserve(settings_.history_size);
+            latencies_.reserve(settings_.latency_history_size);
+        }
+
+        // The frame latency wait returned at 'wake_time'. Returns when to sample input and start the frame.
+        time_point begin_frame(time_point wake_time)
+        {
+            if (last_wake_) {
+                auto const interval = wake_time - *last_wake_;
+
+                record(latencies_, latency_position_, settings_.latency_history_size, wake_time - sample_time_);
+
+                if (interval > period_ * 3 / 2) {
+                    ++statistics_.missed;
+
+                    margin_ = (std::min)(margin_ * 2, period_ / 2);
+                }
+
+                else margin_ -= (margin_ - settings_.margin) / 64;
+            }
+
+            last_wake_ = wake_time;
+
+            auto delay = duration{0};
+
+            if (settings_.enabled)
+                delay = (std::max)(duration{0}, period_ - predicted_work_ - margin_);
+
+            sample_time_ = wake_time + delay;
+
+            ++statistics_.frames;
+            statistics_.delay = delay;
+
+            return sample_time_;
+        }
+
+        void set_refresh_period(duration period) noexcept { period_ = period; }
+
+        // The GPU finished the frame at 'ready_time', e.g. when it reached the frame's fence. The CPU time after
+        // Present would leave the GPU's share out, and GPU-bound frames would then start too late and miss every vsync.
+        void end_frame(time_point ready_time)
+        {
+            record(work_, work_position_, settings_.history_size, ready_time - sample_time_);
+
+            predicted_work_ = percentile_of(work_, settings_.percentile);
+        }
+
+        // Input-to-display latency of the recent frames.
+        duration latency_percentile(double percentile) const
+        {
+            return percentile_of(latencies_, percentile);
+        }
+
+        frame_pacer_statistics statistics() const noexcept
+        {
+            auto statistics = statistics_;
+
+            statistics.period = period_;
+            statistics.predicted_work = predicted_work_;
+            statistics.margin = margin_;
+
+            return statistics;
+        }
+
+    private:
+
+        frame_pacer_settings settings_;
+
+        duration period_;
+        duration margin_;
+        duration predicted_work_{0};
+
+        std::optional<time_point> last_wake_;
+        time_point sample_time_;
+
+        // Ring buffers, oldest entry at the position once full.
+        std::vector<duration> work_;
+        std::size_t work_position_{0};
+
+        std::vector<duration> latencies_;
+        std::size_t latency_position_{0};
+
+        frame_pacer_statistics statistics_;
+
+        static void record(std::vector<duration> &history, std::size_t &position, std::size_t capacity, duration value)
+        {
+            if (capacity == 0)
+                return;
+
+            if (std::size(history) < capacity)
+                history.push_back(value);
+
+            else history[position] = value;
+
+            position = (position + 1) % capacity;
+        }
+
+        static duration percentile_of(std::vector<duration> values, double percentile)
+        {
+            if (values.empty())
+                return duration{0};
+
+            auto const index = static_cast<std::size_t>(percentile * static_cast<double>(std::size(values) - 1) + .5);
+            auto const nth = std::begin(values) + static_cast<std::ptrdiff_t>((std::min)(index, std::size(values) - 1));
+
+            std::nth_element(std::begin(values), nth, std::end(values));
+
+            return *nth;
+        }
+    };
+
+    // The OS sleep may overshoot by a scheduler tick, so the last 'spin' before the deadline is spent yielding.
+    void sleep_until_precise(frame_pacer::time_point deadline, frame_pacer::duration spin = std::chrono::milliseconds{2})
+    {
+        if (auto const coarse = deadline - spin; frame_pacer::clock::now() < coarse)
+            std::this_thread::sleep_until(coarse);
+
+        while (frame_pacer::clock::now() < deadline)
+            std::this_thread::yield();
+    }
+}
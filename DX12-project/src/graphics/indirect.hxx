@@ -0,0 +1,281 @@
+#pragma once
+
+#include <array>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "main.hxx"
+#include "utility/exception.hxx"
+#include "graphics/bindless.hxx"
+#include "graphics/draw_commands.hxx"
+#include "graphics/instance_store.hxx"
+#include "graphics/memory.hxx"
+#include "graphics/pipeline.hxx"
+#include "graphics/resource_state.hxx"
+#include "graphics/shader_build.hxx"
+#include "graphics/upload.hxx"
+
+
+namespace graphics
+{
+    static_assert(sizeof(draw_indexed_arguments) == sizeof(D3D12_DRAW_INDEXED_ARGUMENTS));
+
+    // Thread group size of shaders/cull_instances.hlsl.
+    auto constexpr kCULLING_GROUP_SIZE = 64u;
+
+    // Clean instances between two dirty ones that are uploaded anyway rather than starting another copy.
+    auto constexpr kINSTANCE_UPLOAD_MERGE_GAP = 16u;
+
+    // Every indirect draw sets the instance index root constant and draws one instance of its mesh.
+    winrt::com_ptr<ID3D12CommandSignature> create_draw_command_signature(ID3D12Device6 *const device, root_signature const &signature)
+    {
+        std::array<D3D12_INDIRECT_ARGUMENT_DESC, 2> arguments{ };
+
+        arguments[0].Type = D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT;
+        arguments[0].Constant.RootParameterIndex = root_parameter_index(bindless_root_parameter::constants);
+        arguments[0].Constant.DestOffsetIn32BitValues = indirect_draw_layout::offset_of<indirect_draw_bindings>();
+        arguments[0].Constant.Num32BitValuesToSet = indirect_draw_layout::size_of<indirect_draw_bindings>();
+
+        arguments[1].Type = D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED;
+
+        D3D12_COMMAND_SIGNATURE_DESC const description{
+            sizeof(indirect_draw_command),
+            static_cast<UINT>(std::size(arguments)), std::data(arguments),
+            0
+        };
+
+        winrt::com_ptr<ID3D12CommandSignature> command_signature;
+
+        if (auto result = device->CreateCommandSignature(&description, signature.signature.get(), winrt::guid_of<ID3D12CommandSignature>(),
+                                                         command_signature.put_void()); FAILED(result))
+            throw dx::device_error(fmt::format("failed to create the draw command signature: {0:#x}"s, result));
+
+        return command_signature;
+    }
+
+    // The compute pipeline of shaders/cull_instances.hlsl. The request owns the bytecode until it has been compiled.
+    pipeline_compiler::handle
+    request_culling_pipeline(pipeline_compiler &compiler, pipeline_cache &cache, root_signature const &signature,
+                             std::shared_ptr<shader_binary const> shader, pipeline_priority priority = pipeline_priority::high)
+    {
+        return compiler.request([&cache, root_signature = signature.signature.get(), hash = signature.hash, shader = std::move(shader)]
+        {
+            D3D12_COMPUTE_PIPELINE_STATE_DESC description{ };
+
+            description.pRootSignature = root_signature;
+            description.CS = D3D12_SHADER_BYTECODE{std::data(shader->bytecode), std::size(shader->bytecode)};
+
+            return cache.compute_pipeline(description, hash);
+        }, priority);
+    }
+
+    // GPU-driven draws: instances live in a GPU buffer that is updated by dirty ranges, a compute pass culls them
+    // and appends a command per visible instance, and one ExecuteIndirect draws them all, so the CPU cost doesn't
+    // grow with the number of draws. All buffers are raw views in the bindless tables.
+    class indirect_draws final {
+    public:
+
+        indirect_draws(ID3D12Device6 *const device, memory_allocator &memory_allocator, resource_state_registry &resource_states,
+                       bindless_descriptors &descriptors, root_signature const &signature, std::uint32_t instance_capacity, std::uint32_t mesh_capacity)
+            : memory_allocator_{memory_allocator}, resource_states_{resource_states}, descriptors_{descriptors},
+              instances_{instance_capacity}, mesh_capacity_{mesh_capacity}
+        {
+            instance_buffer_ = create_buffer(static_cast<UINT64>(instance_capacity) * sizeof(gpu_instance), D3D12_RESOURCE_FLAG_NONE);
+            mesh_buffer_ = create_buffer(static_cast<UINT64>(mesh_capacity) * sizeof(mesh_draw), D3D12_RESOURCE_FLAG_NONE);
+            command_buffer_ = create_buffer(static_cast<UINT64>(instance_capacity) * sizeof(indirect_draw_command), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+            count_buffer_ = create_buffer(sizeof(std::uint32_t), D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS);
+
+            instance_view_ = create_view(instance_buffer_.get());
+            mesh_view_ = create_view(mesh_buffer_.get());
+            command_view_ = create_unordered_view(command_buffer_.get());
+            count_view_ = create_unordered_view(count_buffer_.get());
+
+            command_signature_ = create_draw_command_signature(device, signature);
+
+            mesh_dirty_.resize(mesh_capacity);
+        }
+
+        ~indirect_draws()
+        {
+            for (auto index : {instance_view_, mesh_view_, command_view_, count_view_})
+                descriptors_.release_view(index);
+
+            for (auto buffer : {&instance_buffer_, &mesh_buffer_, &command_buffer_, &count_buffer_}) {
+                resource_states_.unregister_resource(buffer->get());
+                memory_allocator_.release(*buffer);
+            }
+        }
+
+        indirect_draws(indirect_draws const &) = delete;
+        indirect_draws &operator=(indirect_draws const &) = delete;
+
+        instance_store<gpu_instance> &instances() noexcept { return instances_; }
+        instance_store<gpu_instance> const &instances() const noexcept { return instances_; }
+
+        [[nodiscard]] std::uint32_t add_mesh(mesh_draw const &mesh)
+        {
+            if (std::size(meshes_) == mesh_capacity_)
+                throw dx::device_error("the mesh table is full"s);
+
+            auto const index = static_cast<std::uint32_t>(std::size(meshes_));
+
+            meshes_.push_back(mesh);
+            mesh_dirty_.mark(index);
+
+            return index;
+        }
+
+        void set_culling_pipeline(pipeline_compiler::handle pipeline) { culling_pipeline_ = std::move(pipeline); }
+
+        // The pipeline the commands are drawn with; until it is ready nothing is drawn.
+        void set_draw_pipeline(pipeline_compiler::handle pipeline) { draw_pipeline_ = std::move(pipeline); }
+
+        ID3D12Resource *instance_buffer() const noexcept { return instance_buffer_.get(); }
+        ID3D12Resource *mesh_buffer() const noexcept { return mesh_buffer_.get(); }
+        ID3D12Resource *command_buffer() const noexcept { return command_buffer_.get(); }
+        ID3D12Resource *count_buffer() const noexcept { return count_buffer_.get(); }
+
+        // Copies the changed instances and meshes and resets the command count.
+        // Expects the instance, mesh and count buffers in the copy destination state.
+        void upload(ID3D12GraphicsCommandList *const command_list, upload_ring &ring)
+        {
+            instances_.for_each_dirty_range(kINSTANCE_UPLOAD_MERGE_GAP, [&] (dirty_range range)
+            {
+                copy_range(command_list, ring, range, instances_.instances(), instance_buffer_.get());
+            });
+
+            instances_.clear_dirty();
+
+            mesh_dirty_.for_each_range(static_cast<std::uint32_t>(std::size(meshes_)), 0, [&] (dirty_range range)
+            {
+                copy_range(command_list, ring, range, std::span<mesh_draw const>{meshes_}, mesh_buffer_.get());
+            });
+
+            mesh_dirty_.clear();
+
+            auto const zero = ring.allocate(sizeof(std::uint32_t), sizeof(std::uint32_t));
+
+            std::memset(zero.cpu_address, 0, sizeof(std::uint32_t));
+
+            command_list->CopyBufferRegion(count_buffer_.get(), 0, zero.resource, zero.offset, sizeof(std::uint32_t));
+        }
+
+        // Appends the commands of the visible instances. Expects the heaps of 'descriptors' to be set, the instance
+        // and mesh buffers in a shader resource state, and the command and count buffers in the unordered access state.
+        void cull(ID3D12GraphicsCommandList *const command_list, root_signature const &signature, upload_ring &ring, frustum const &view_frustum)
+        {
+            auto const pipeline = culling_pipeline_.current();
+
+            if (pipeline == nullptr || instances_.size() == 0)
+                return;
+
+            culling_constants const constants{view_frustum, instances_.size(), static_cast<std::uint32_t>(std::size(meshes_))};
+
+            auto const allocation = ring.allocate(sizeof(constants));
+
+            std::memcpy(allocation.cpu_address, &constants, sizeof(constants));
+
+            descriptors_.bind_compute(command_list, signature);
+
+            command_list->SetPipelineState(pipeline->get());
+            command_list->SetComputeRootConstantBufferView(root_parameter_index(bindless_root_parameter::frame_constants), allocation.gpu_address);
+
+            set_compute_root_constants<culling_layout>(command_list, culling_bindings{instance_view_, mesh_view_, command_view_, count_view_});
+
+            command_list->Dispatch((instances_.size() + kCULLING_GROUP_SIZE - 1) / kCULLING_GROUP_SIZE, 1, 1);
+        }
+
+        // Draws the culled instances with one ExecuteIndirect. Expects the graphics bindings to be set and
+        // the command and count buffers in the indirect argument state.
+        void execute(ID3D12GraphicsCommandList *const command_list) const
+        {
+            auto const pipeline = draw_pipeline_.current();
+
+            if (pipeline == nullptr || culling_pipeline_.current() == nullptr || instances_.size() == 0)
+                return;
+
+            command_list->SetPipelineState(pipeline->get());
+
+            set_graphics_root_constants<indirect_draw_layout>(command_list, scene_bindings{instance_view_, mesh_view_});
+
+            command_list->ExecuteIndirect(command_signature_.get(), instances_.size(), command_buffer_.get(), 0, count_buffer_.get(), 0);
+        }
+
+    private:
+
+        memory_allocator &memory_allocator_;
+        resource_state_registry &resource_states_;
+        bindless_descriptors &descriptors_;
+
+        instance_store<gpu_instance> instances_;
+
+        std::vector<mesh_draw> meshes_;
+        std::uint32_t mesh_capacity_{0};
+        dirty_range_tracker mesh_dirty_;
+
+        placed_resource instance_buffer_;
+        placed_resource mesh_buffer_;
+        placed_resource command_buffer_;
+        placed_resource count_buffer_;
+
+        bindless_index instance_view_;
+        bindless_index mesh_view_;
+        bindless_index command_view_;
+        bindless_index count_view_;
+
+        winrt::com_ptr<ID3D12CommandSignature> command_signature_;
+
+        pipeline_compiler::handle culling_pipeline_;
+        pipeline_compiler::handle draw_pipeline_;
+
+        placed_resource create_buffer(UINT64 size, D3D12_RESOURCE_FLAGS flags)
+        {
+            auto const description = CD3DX12_RESOURCE_DESC::Buffer(size, flags);
+
+            auto buffer = memory_allocator_.create_placed_resource(D3D12_HEAP_TYPE_DEFAULT, description, D3D12_RESOURCE_STATE_COMMON);
+
+            resource_states_.register_resource(buffer.get(), 1, D3D12_RESOURCE_STATE_COMMON);
+
+            return buffer;
+        }
+
+        bindless_index create_view(ID3D12Resource *const buffer)
+        {
+            D3D12_SHADER_RESOURCE_VIEW_DESC description{ };
+
+            description.Format = DXGI_FORMAT_R32_TYPELESS;
+            description.ViewDimension = D3D12_SRV_DIMENSION_BUFFER;
+            description.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+            description.Buffer.NumElements = static_cast<UINT>(buffer->GetDesc().Width / 4);
+            description.Buffer.Flags = D3D12_BUFFER_SRV_FLAG_RAW;
+
+            return descriptors_.create_shader_resource_view(buffer, &description);
+        }
+
+        bindless_index create_unordered_view(ID3D12Resource *const buffer)
+        {
+            D3D12_UNORDERED_ACCESS_VIEW_DESC description{ };
+
+            description.Format = DXGI_FORMAT_R32_TYPELESS;
+            description.ViewDimension = D3D12_UAV_DIMENSION_BUFFER;
+            description.Buffer.NumElements = static_cast<UINT>(buffer->GetDesc().Width / 4);
+            description.Buffer.Flags = D3D12_BUFFER_UAV_FLAG_RAW;
+
+            return descriptors_.create_unordered_access_view(buffer, nullptr, &description);
+        }
+
+        template<class T>
+        static void copy_range(ID3D12GraphicsCommandList *const command_list, upload_ring &ring, dirty_range range,
+                               std::span<T const> elements, ID3D12Resource *const buffer)
+        {
+            auto const size = static_cast<UINT64>(range.count) * sizeof(T);
+
+            auto const allocation = ring.allocate(size, 16);
+
+            std::memcpy(allocation.cpu_address, std::data(elements) + range.first, size);
+
+            command_list->CopyBufferRegion(buffer, static_cast<UINT64>(range.first) * sizeof(T), allocation.resource, allocation.offset, size);
+        }
+    };
+}
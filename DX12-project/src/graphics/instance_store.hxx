@@ -0,0 +1,288 @@
+#pragma once
+
+#include <algorithm>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+
+namespace graphics
+{
+    // Refers to an instance for as long as it exists; a handle of an erased instance never refers to another one.
+    struct instance_handle final {
+        static auto constexpr kINVALID = std::numeric_limits<std::uint32_t>::max();
+
+        std::uint32_t slot{kINVALID};
+        std::uint32_t generation{0};
+
+        constexpr bool valid() const noexcept { return slot != kINVALID; }
+
+        constexpr bool operator== (instance_handle const &) const = default;
+    };
+
+    // Elements [first, first + count).
+    struct dirty_range final {
+        std::uint32_t first{0};
+        std::uint32_t count{0};
+
+        constexpr bool operator== (dirty_range const &) const = default;
+    };
+
+    // Elements changed since the last upload, one bit per element. Only the words between the lowest and
+    // the highest marked element are visited when the ranges are collected or cleared.
+    class dirty_range_tracker final {
+    public:
+
+        void resize(std::uint32_t size)
+        {
+            words_.resize((static_cast<std::size_t>(size) + 63) / 64, 0);
+        }
+
+        void mark(std::uint32_t index)
+        {
+            words_[index / 64] |= 1ull << (index % 64);
+
+            first_ = (std::min)(first_, index);
+            end_ = (std::max)(end_, index + 1);
+        }
+
+        void mark(std::uint32_t first, std::uint32_t count)
+        {
+            for (auto index = first; index < first + count; ++index)
+                mark(index);
+        }
+
+        bool empty() const noexcept { return first_ >= end_; }
+
+        // Runs of marked elements below 'size'. Runs separated by at most 'merge_gap' clean elements are merged,
+        // trading a few redundant bytes for fewer copies.
+        template<class F>
+        void for_each_range(std::uint32_t size, std::uint32_t merge_gap, F &&callback) const
+        {
+            auto const end = (std::min)(end_, size);
+
+            if (first_ >= end)
+                return;
+
+            dirty_range current;
+
+            for (auto word_index = first_ / 64; word_index <= (end - 1) / 64; ++word_index) {
+                auto bits = words_[word_index];
+
+                while (bits != 0) {
+                    auto const start = static_cast<std::uint32_t>(std::countr_zero(bits));
+                    auto const length = static_cast<std::uint32_t>(std::countr_one(bits >> start));
+
+                    bits = start + length == 64 ? 0 : bits & (~0ull << (start + length));
+
+                    auto const first = word_index * 64 + start;
+
+                    if (first >= end)
+                        break;
+
+                    auto const count = (std::min)(length, end - first);
+
+                    if (current.count != 0 && first - (current.first + current.count) <= merge_gap)
+                        current.count = first + count - current.first;
+
+                    else {
+                        if (current.count != 0)
+                            callback(current);
+
+                        current = dirty_range{first, count};
+                    }
+                }
+            }
+
+            if (current.count != 0)
+                callback(current);
+        }
+
+        std::vector<dirty_range> ranges(std::uint32_t size, std::uint32_t merge_gap = 0) const
+        {
+            std::vector<dirty_range> ranges;
+
+            for_each_range(size, merge_gap, [&ranges] (dirty_range range) { ranges.push_back(range); });
+
+            return ranges;
+        }
+
+        void clear()
+        {
+            if (empty())
+                return;
+
+            std::fill(std::begin(words_) + first_ / 64, std::begin(words_) + (end_ - 1) / 64 + 1, 0);
+
+            first_ = std::numeric_limits<std::uint32_t>::max();
+            end_ = 0;
+        }
+
+    private:
+
+        std::vector<std::uint64_t> words_;
+
+        std::uint32_t first_{std::numeric_limits<std::uint32_t>::max()};
+        std::uint32_t end_{0};
+    };
+
+    // Instances packed densely in insertion order, as the GPU reads them: erasing one moves the last instance
+    // into its place. Handles go through a slot table, so they stay valid when instances move. Every changed
+    // or moved element is marked dirty; the ranges are uploaded once per frame.
+    template<class T>
+    class instance_store final {
+    public:
+
+        explicit instance_store(std::uint32_t capacity) : capacity_{capacity}
+        {
+            instances_.reserve(capacity);
+            dense_slots_.reserve(capacity);
+
+            dirty_.resize(capacity);
+        }
+
+        [[nodiscard]] instance_handle insert(T const &instance)
+        {
+            if (size() == capacity_)
+                throw std::length_error("instance store is full");
+
+            std::uint32_t slot = 0;
+
+            if (!free_slots_.empty()) {
+                slot = free_slots_.back();
+                free_slots_.pop_back();
+            }
+
+            else {
+                slot = static_cast<std::uint32_t>(std::size(slots_));
+                slots_.push_back(slot_entry{ });
+            }
+
+            auto const index = size();
+
+            instances_.push_back(instance);
+            dense_slots_.push_back(slot);
+
+            slots_[slot].index = index;
+
+            dirty_.mark(index);
+
+            return instance_handle{slot, slots_[slot].generation};
+        }
+
+        bool erase(instance_handle handle)
+        {
+            auto const index = index_of(handle);
+
+            if (index == kINVALID_INDEX)
+                return false;
+
+            auto const last = size() - 1;
+
+            if (index != last) {
+                instances_[index] = std::move(instances_[last]);
+                dense_slots_[index] = dense_slots_[last];
+
+                slots_[dense_slots_[index]].index = index;
+
+                dirty_.mark(index);
+            }
+
+            instances_.pop_back();
+            dense_slots_.pop_back();
+
+            auto &&slot = slots_[handle.slot];
+
+            slot.index = kINVALID_INDEX;
+            ++slot.generation;
+
+            free_slots_.push_back(handle.slot);
+
+            return true;
+        }
+
+        bool update(instance_handle handle, T const &instance)
+        {
+            auto const index = index_of(handle);
+
+            if (index == kINVALID_INDEX)
+                return false;
+
+            instances_[index] = instance;
+
+            dirty_.mark(index);
+
+            return true;
+        }
+
+        bool contains(instance_handle handle) const noexcept { return index_of(handle) != kINVALID_INDEX; }
+
+        T const *find(instance_handle handle) const noexcept
+        {
+            auto const index = index_of(handle);
+
+            return index != kINVALID_INDEX ? &instances_[index] : nullptr;
+        }
+
+        // Position of the instance in 'instances()'; changes when other instances are erased.
+        std::uint32_t index_of(instance_handle handle) const noexcept
+        {
+            if (handle.slot >= std::size(slots_))
+                return kINVALID_INDEX;
+
+            auto &&slot = slots_[handle.slot];
+
+            return slot.generation == handle.generation ? slot.index : kINVALID_INDEX;
+        }
+
+        instance_handle handle_of(std::uint32_t index) const noexcept
+        {
+            auto const slot = dense_slots_[index];
+
+            return instance_handle{slot, slots_[slot].generation};
+        }
+
+        std::span<T const> instances() const noexcept { return instances_; }
+
+        std::uint32_t size() const noexcept { return static_cast<std::uint32_t>(std::size(instances_)); }
+        std::uint32_t capacity() const noexcept { return capacity_; }
+
+        // Changed elements of 'instances()'; elements past the end after erasing don't need to be uploaded.
+        template<class F>
+        void for_each_dirty_range(std::uint32_t merge_gap, F &&callback) const
+        {
+            dirty_.for_each_range(size(), merge_gap, std::forward<F>(callback));
+        }
+
+        std::vector<dirty_range> dirty_ranges(std::uint32_t merge_gap = 0) const { return dirty_.ranges(size(), merge_gap); }
+
+        bool dirty() const noexcept { return !dirty_.empty(); }
+
+        void clear_dirty() { dirty_.clear(); }
+
+    private:
+
+        static auto constexpr kINVALID_INDEX = std::numeric_limits<std::uint32_t>::max();
+
+        struct slot_entry final {
+            std::uint32_t index{kINVALID_INDEX};
+            std::uint32_t generation{0};
+        };
+
+        std::uint32_t capacity_{0};
+
+        std::vector<T> instances_;
+
+        // Slot of every instance, to fix up the slot of the instance moved by an erase.
+        std::vector<std::uint32_t> dense_slots_;
+
+        std::vector<slot_entry> slots_;
+        std::vector<std::uint32_t> free_slots_;
+
+        dirty_range_tracker dirty_;
+    };
+}
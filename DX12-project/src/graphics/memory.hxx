@@ -0,0 +1,336 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <mutex>
+
+#include "main.hxx"
+#include "utility/exception.hxx"
+#include "graphics/tlsf.hxx"
+
+
+namespace graphics
+{
+    constexpr UINT64 align_up(UINT64 value, UINT64 alignment) noexcept
+    {
+        return (value + alignment - 1) & ~(alignment - 1);
+    }
+
+    // Resource heap tier 1 hardware can't mix buffers, render target/depth-stencil textures and other textures in a heap.
+    enum class resource_category : std::uint32_t {
+        buffer = 0,
+        render_target_texture,
+        texture,
+        any,
+        count
+    };
+
+    enum class alignment_class : std::uint32_t {
+        standard = 0,   // 64KB
+        msaa,           // 4MB
+        count
+    };
+
+    struct memory_allocation final {
+        ID3D12Heap *heap{nullptr};
+
+        UINT64 offset{0};
+        UINT64 size{0};
+
+        std::uint32_t pool{0};
+        std::uint32_t block{0};
+
+        tlsf_allocator::allocation range;
+
+        bool valid() const noexcept { return heap != nullptr; }
+    };
+
+    struct placed_resource final {
+        winrt::com_ptr<ID3D12Resource> resource;
+        memory_allocation allocation;
+
+        ID3D12Resource *get() const noexcept { return resource.get(); }
+    };
+
+    struct memory_pool_statistics final {
+        D3D12_HEAP_TYPE heap_type{D3D12_HEAP_TYPE_DEFAULT};
+        resource_category category{resource_category::any};
+        UINT64 alignment{0};
+
+        std::uint32_t block_count{0};
+
+        // Summed over the blocks; the largest free block is the largest one of any block.
+        tlsf_statistics usage;
+    };
+
+    // Suballocates placed resources out of large ID3D12Heap blocks.
+    // Blocks are grouped into pools by heap type, resource category (tier 1 only) and alignment class, and every
+    // block hands out ranges with a TLSF allocator. Resources larger than a block get a dedicated block of their own.
+    class memory_allocator final {
+    public:
+
+        static UINT64 constexpr kDEFAULT_BLOCK_SIZE = 64ull << 20;
+
+        explicit memory_allocator(ID3D12Device6 *const device, UINT64 block_size = kDEFAULT_BLOCK_SIZE) : device_{device}, block_size_{block_size}
+        {
+            D3D12_FEATURE_DATA_D3D12_OPTIONS options{};
+
+            if (auto result = device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options)); FAILED(result))
+                throw dx::device_error(fmt::format("failed to check device D3D12 options: {0:#x}"s, result));
+
+            heap_tier_ = options.ResourceHeapTier;
+
+            for (auto heap_type_index = 0u; heap_type_index < kHEAP_TYPE_COUNT; ++heap_type_index) {
+                for (auto category = 0u; category < kCATEGORY_COUNT; ++category) {
+                    for (auto alignment = 0u; alignment < kALIGNMENT_CLASS_COUNT; ++alignment) {
+                        auto &pool = pools_[(heap_type_index * kCATEGORY_COUNT + category) * kALIGNMENT_CLASS_COUNT + alignment];
+
+                        pool.heap_type = kHEAP_TYPES[heap_type_index];
+                        pool.category = static_cast<resource_category>(category);
+                        pool.alignment = static_cast<alignment_class>(alignment) == alignment_class::msaa ? D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT
+                                                                                                          : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+                    }
+                }
+            }
+        }
+
+        memory_allocator(memory_allocator const &) = delete;
+        memory_allocator &operator=(memory_allocator const &) = delete;
+
+        resource_category category_of(D3D12_RESOURCE_DESC const &description) const noexcept
+        {
+            if (heap_tier_ != D3D12_RESOURCE_HEAP_TIER_1)
+                return resource_category::any;
+
+            if (description.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+                return resource_category::buffer;
+
+            if ((description.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) != 0)
+                return resource_category::render_target_texture;
+
+            return resource_category::texture;
+        }
+
+        [[nodiscard]] memory_allocation allocate(D3D12_HEAP_TYPE heap_type, D3D12_RESOURCE_DESC const &description)
+        {
+            auto const info = device_->GetResourceAllocationInfo(0, 1, &description);
+
+            if (info.SizeInBytes == UINT64_MAX)
+                throw dx::memory_error("invalid resource description for a placed resource"s);
+
+            return allocate(heap_type, category_of(description), info);
+        }
+
+        // Allocates a raw range, e.g. to place several aliasing resources of the same category in it.
+        [[nodiscard]] memory_allocation allocate(D3D12_HEAP_TYPE heap_type, resource_category category, D3D12_RESOURCE_ALLOCATION_INFO const &info)
+        {
+            auto const alignment = info.Alignment > D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT ? alignment_class::msaa : alignment_class::standard;
+
+            auto const pool_index = pool_index_of(heap_type, category, alignment);
+
+            std::lock_guard lock{mutex_};
+
+            auto &pool = pools_[pool_index];
+
+            for (auto block_index = 0u; block_index < std::size(pool.blocks); ++block_index) {
+                auto &block = pool.blocks[block_index];
+
+                if (block.heap == nullptr)
+                    continue;
+
+                if (auto range = block.allocator.allocate(info.SizeInBytes, info.Alignment); range.valid())
+                    return memory_allocation{block.heap.get(), range.offset, range.size, pool_index, block_index, range};
+            }
+
+            auto const block_index = create_block(pool_index, (std::max)(block_size_, info.SizeInBytes));
+            auto &block = pool.blocks[block_index];
+
+            auto range = block.allocator.allocate(info.SizeInBytes, info.Alignment);
+
+            return memory_allocation{block.heap.get(), range.offset, range.size, pool_index, block_index, range};
+        }
+
+        void free(memory_allocation const &allocation)
+        {
+            if (!allocation.valid())
+                return;
+
+            std::lock_guard lock{mutex_};
+
+            auto &block = pools_[allocation.pool].blocks[allocation.block];
+
+            block.allocator.free(allocation.range);
+
+            // Regular blocks are kept for reuse, dedicated ones go away with their resource.
+            if (block.allocator.empty() && block.allocator.size() > block_size_)
+                block = memory_block{nullptr, tlsf_allocator{0, 1}};
+        }
+
+        [[nodiscard]] placed_resource
+        create_placed_resource(D3D12_HEAP_TYPE heap_type, D3D12_RESOURCE_DESC const &description, D3D12_RESOURCE_STATES initial_state,
+                               D3D12_CLEAR_VALUE const *const clear_value = nullptr)
+        {
+            placed_resource placed{nullptr, allocate(heap_type, description)};
+
+            if (auto result = device_->CreatePlacedResource(placed.allocation.heap, placed.allocation.offset, &description, initial_state, clear_value,
+                                                            winrt::guid_of<ID3D12Resource>(), placed.resource.put_void()); FAILED(result)) {
+                free(placed.allocation);
+
+                throw dx::memory_error(fmt::format("failed to create a placed resource: {0:#x}"s, result));
+            }
+
+            return placed;
+        }
+
+        // The resource has to be no longer in use by the GPU.
+        void release(placed_resource &placed)
+        {
+            placed.resource = nullptr;
+
+            free(placed.allocation);
+
+            placed.allocation = memory_allocation{ };
+        }
+
+        // Releases regular blocks that have no allocations left.
+        void trim()
+        {
+            std::lock_guard lock{mutex_};
+
+            for (auto &&pool : pools_) {
+                for (auto &&block : pool.blocks) {
+                    if (block.heap != nullptr && block.allocator.empty())
+                        block = memory_block{nullptr, tlsf_allocator{0, 1}};
+                }
+            }
+        }
+
+        std::vector<memory_pool_statistics> statistics() const
+        {
+            std::lock_guard lock{mutex_};
+
+            std::vector<memory_pool_statistics> result;
+
+            for (auto pool_index = 0u; pool_index < kPOOL_COUNT; ++pool_index) {
+                auto const &pool = pools_[pool_index];
+
+                memory_pool_statistics pool_statistics{pool.heap_type, pool.category, pool.alignment, 0, { }};
+
+                for (auto &&block : pool.blocks) {
+                    if (block.heap == nullptr)
+                        continue;
+
+                    auto const usage = block.allocator.statistics();
+
+                    ++pool_statistics.block_count;
+
+                    pool_statistics.usage.size += usage.size;
+                    pool_statistics.usage.used += usage.used;
+                    pool_statistics.usage.free_block_count += usage.free_block_count;
+                    pool_statistics.usage.allocation_count += usage.allocation_count;
+                    pool_statistics.usage.largest_free_block = (std::max)(pool_statistics.usage.largest_free_block, usage.largest_free_block);
+                }
+
+                if (pool_statistics.block_count != 0)
+                    result.push_back(pool_statistics);
+            }
+
+            return result;
+        }
+
+    private:
+
+        static auto constexpr kHEAP_TYPES = std::array{D3D12_HEAP_TYPE_DEFAULT, D3D12_HEAP_TYPE_UPLOAD, D3D12_HEAP_TYPE_READBACK};
+        static auto constexpr kHEAP_TYPE_COUNT = static_cast<std::uint32_t>(std::size(kHEAP_TYPES));
+        static auto constexpr kCATEGORY_COUNT = static_cast<std::uint32_t>(resource_category::count);
+        static auto constexpr kALIGNMENT_CLASS_COUNT = static_cast<std::uint32_t>(alignment_class::count);
+
+        static auto constexpr kPOOL_COUNT = kHEAP_TYPE_COUNT * kCATEGORY_COUNT * kALIGNMENT_CLASS_COUNT;
+
+        struct memory_block final {
+            winrt::com_ptr<ID3D12Heap> heap;
+            tlsf_allocator allocator;
+        };
+
+        struct memory_pool final {
+            D3D12_HEAP_TYPE heap_type{D3D12_HEAP_TYPE_DEFAULT};
+            resource_category category{resource_category::any};
+            UINT64 alignment{D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT};
+
+            std::vector<memory_block> blocks;
+        };
+
+        ID3D12Device6 *device_;
+
+        UINT64 block_size_;
+        D3D12_RESOURCE_HEAP_TIER heap_tier_{D3D12_RESOURCE_HEAP_TIER_1};
+
+        mutable std::mutex mutex_;
+
+        std::array<memory_pool, kPOOL_COUNT> pools_;
+
+        static std::uint32_t pool_index_of(D3D12_HEAP_TYPE heap_type, resource_category category, alignment_class alignment)
+        {
+            auto const it = std::find(std::begin(kHEAP_TYPES), std::end(kHEAP_TYPES), heap_type);
+
+            if (it == std::end(kHEAP_TYPES))
+                throw dx::memory_error(fmt::format("unsupported heap type for suballocation: {}"s, static_cast<std::int32_t>(heap_type)));
+
+            auto const heap_type_index = static_cast<std::uint32_t>(std::distance(std::begin(kHEAP_TYPES), it));
+
+            return (heap_type_index * kCATEGORY_COUNT + static_cast<std::uint32_t>(category)) * kALIGNMENT_CLASS_COUNT
+                 + static_cast<std::uint32_t>(alignment);
+        }
+
+        static D3D12_HEAP_FLAGS heap_flags_of(resource_category category) noexcept
+        {
+            switch (category) {
+                case resource_category::buffer:
+                    return D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+
+                case resource_category::render_target_texture:
+                    return D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+
+                case resource_category::texture:
+                    return D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+
+                default:
+                    return D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES;
+            }
+        }
+
+        std::uint32_t create_block(std::uint32_t pool_index, UINT64 size)
+        {
+            auto &pool = pools_[pool_index];
+
+            size = align_up(size, pool.alignment);
+
+            D3D12_HEAP_DESC const description{
+                size,
+                CD3DX12_HEAP_PROPERTIES{pool.heap_type},
+                pool.alignment,
+                heap_flags_of(pool.category)
+            };
+
+            winrt::com_ptr<ID3D12Heap> heap;
+
+            if (auto result = device_->CreateHeap(&description, winrt::guid_of<ID3D12Heap>(), heap.put_void()); FAILED(result))
+                throw dx::memory_error(fmt::format("failed to create a memory heap of {0} bytes: {1:#x}"s, size, result));
+
+            memory_block block{heap, tlsf_allocator{size, pool.alignment}};
+
+            // Slots of released blocks are reused so that the indices of live allocations stay valid.
+            auto it = std::find_if(std::begin(pool.blocks), std::end(pool.blocks), [] (auto &&block) { return block.heap == nullptr; });
+
+            if (it != std::end(pool.blocks)) {
+                *it = std::move(block);
+
+                return static_cast<std::uint32_t>(std::distance(std::begin(pool.blocks), it));
+            }
+
+            pool.blocks.push_back(std::move(block));
+
+            return static_cast<std::uint32_t>(std::size(pool.blocks) - 1);
+        }
+    };
+}
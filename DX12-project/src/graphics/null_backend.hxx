@@ -0,0 +1,458 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+#include "graphics/backend.hxx"
+
+
+namespace graphics::backend
+{
+    // Costs of the virtual GPU, in nanoseconds.
+    struct null_timing final {
+        double command_list{2'000.};
+        double barrier{250.};
+
+        double draw{800.};
+        double index{.02};
+
+        double dispatch{1'500.};
+        double thread_group{40.};
+
+        double copy{1'000.};
+        double byte{.0001};
+    };
+
+    enum class null_command : std::uint8_t {
+        barrier, set_descriptor_heaps, copy_buffer_region, draw_indexed, dispatch
+    };
+
+    // A command is its opcode, the size of its payload and the payload, with the fields packed without padding.
+    // Resources and heaps are referred to by the ids the device gave them.
+    template<class F>
+    void for_each_null_command(std::span<std::byte const> stream, F &&function)
+    {
+        for (std::size_t offset = 0; offset + 2 <= std::size(stream); ) {
+            auto const command = static_cast<null_command>(stream[offset]);
+            auto const size = static_cast<std::size_t>(stream[offset + 1]);
+
+            if (offset + 2 + size > std::size(stream))
+                throw std::out_of_range("truncated command stream");
+
+            function(command, stream.subspan(offset + 2, size));
+
+            offset += 2 + size;
+        }
+    }
+
+    // Reads the packed fields of a payload in order.
+    class null_payload_reader final {
+    public:
+
+        explicit null_payload_reader(std::span<std::byte const> payload) noexcept : payload_{payload} { }
+
+        template<class T>
+        T read()
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+
+            if (offset_ + sizeof(T) > std::size(payload_))
+                throw std::out_of_range("truncated command payload");
+
+            T value;
+            std::memcpy(&value, std::data(payload_) + offset_, sizeof(T));
+
+            offset_ += sizeof(T);
+
+            return value;
+        }
+
+    private:
+
+        std::span<std::byte const> payload_;
+        std::size_t offset_{0};
+    };
+
+    // Virtual time of the null device: the host's elapsed time plus the time the host would have spent blocked on
+    // fences. Waits never sleep, they move the clock to the point the virtual GPU would have got to.
+    class null_clock final {
+    public:
+
+        using duration = std::chrono::duration<double, std::nano>;
+
+        duration now() const noexcept { return std::chrono::steady_clock::now() - start_ + skipped_; }
+
+        void advance_to(duration time) noexcept
+        {
+            if (auto const current = now(); time > current)
+                skipped_ += time - current;
+        }
+
+        duration skipped() const noexcept { return skipped_; }
+
+    private:
+
+        std::chrono::steady_clock::time_point start_{std::chrono::steady_clock::now()};
+        duration skipped_{0};
+    };
+
+    struct null_device_statistics final {
+        std::uint64_t resources{0};
+        std::uint64_t descriptor_heaps{0};
+
+        std::uint64_t executed_command_lists{0};
+        std::uint64_t commands{0};
+        std::uint64_t stream_bytes{0};
+
+        std::uint64_t host_waits{0};
+
+        // Time the virtual queues were busy, by queue type.
+        std::array<null_clock::duration, static_cast<std::size_t>(queue_type::count)> busy{ };
+    };
+
+    class null_resource final : public resource_interface {
+    public:
+
+        null_resource(std::uint32_t id, resource_description const &description) noexcept : id_{id}, description_{description} { }
+
+        resource_description const &description() const noexcept override { return description_; }
+
+        std::uint32_t id() const noexcept { return id_; }
+
+    private:
+
+        std::uint32_t id_;
+        resource_description description_;
+    };
+
+    class null_descriptor_heap final : public descriptor_heap_interface {
+    public:
+
+        null_descriptor_heap(std::uint32_t id, descriptor_heap_description const &description) noexcept : id_{id}, description_{description} { }
+
+        descriptor_heap_description const &description() const noexcept override { return description_; }
+
+        std::uint32_t id() const noexcept { return id_; }
+
+    private:
+
+        std::uint32_t id_;
+        descriptor_heap_description description_;
+    };
+
+    class null_command_list final : public command_list_interface {
+    public:
+
+        null_command_list(queue_type type, null_timing const &timing) : type_{type}, timing_{timing} { }
+
+        void reset() override
+        {
+            stream_.clear();
+
+            command_count_ = 0;
+            cost_ = timing_.command_list;
+
+            closed_ = false;
+        }
+
+        void close() override
+        {
+            if (closed_)
+                throw std::logic_error("the command list is already closed");
+
+            closed_ = true;
+        }
+
+        void resource_barriers(std::span<resource_barrier const> barriers) override
+        {
+            for (auto &&barrier : barriers) {
+                write(null_command::barrier, static_cast<std::uint8_t>(barrier.type), id_of(barrier.resource), id_of(barrier.resource_after),
+                      barrier.subresource, static_cast<std::uint32_t>(barrier.before), static_cast<std::uint32_t>(barrier.after));
+            }
+
+            cost_ += timing_.barrier * static_cast<double>(std::size(barriers));
+        }
+
+        void set_descriptor_heaps(std::span<descriptor_heap_interface *const> heaps) override
+        {
+            std::array<std::uint32_t, 2> ids{0, 0};
+
+            if (std::size(heaps) > std::size(ids))
+                throw std::invalid_argument("at most a view and a sampler heap can be bound");
+
+            for (std::size_t index = 0; index < std::size(heaps); ++index)
+                ids[index] = static_cast<null_descriptor_heap *>(heaps[index])->id();
+
+            write(null_command::set_descriptor_heaps, static_cast<std::uint8_t>(std::size(heaps)), ids[0], ids[1]);
+        }
+
+        void copy_buffer_region(resource_interface &destination, std::uint64_t destination_offset,
+                                resource_interface &source, std::uint64_t source_offset, std::uint64_t size) override
+        {
+            write(null_command::copy_buffer_region, id_of(&destination), destination_offset, id_of(&source), source_offset, size);
+
+            cost_ += timing_.copy + timing_.byte * static_cast<double>(size);
+        }
+
+        void draw_indexed(std::uint32_t index_count, std::uint32_t instance_count, std::uint32_t first_index,
+                          std::int32_t base_vertex, std::uint32_t first_instance) override
+        {
+            write(null_command::draw_indexed, index_count, instance_count, first_index, base_vertex, first_instance);
+
+            cost_ += timing_.draw + timing_.index * static_cast<double>(index_count) * static_cast<double>(instance_count);
+        }
+
+        void dispatch(std::uint32_t x, std::uint32_t y, std::uint32_t z) override
+        {
+            write(null_command::dispatch, x, y, z);
+
+            cost_ += timing_.dispatch + timing_.thread_group * static_cast<double>(x) * static_cast<double>(y) * static_cast<double>(z);
+        }
+
+        queue_type type() const noexcept { return type_; }
+
+        bool closed() const noexcept { return closed_; }
+
+        std::span<std::byte const> stream() const noexcept { return stream_; }
+
+        std::uint64_t command_count() const noexcept { return command_count_; }
+
+        // Of executing the list on the virtual GPU.
+        null_clock::duration cost() const noexcept { return null_clock::duration{cost_}; }
+
+    private:
+
+        queue_type type_;
+        null_timing const &timing_;
+
+        // The allocated capacity is kept across resets, like a command allocator's memory.
+        std::vector<std::byte> stream_;
+
+        std::uint64_t command_count_{0};
+        double cost_{timing_.command_list};
+
+        bool closed_{false};
+
+        static std::uint32_t id_of(resource_interface const *resource) noexcept
+        {
+            return resource != nullptr ? static_cast<null_resource const *>(resource)->id() : 0;
+        }
+
+        template<class... Ts>
+        void write(null_command command, Ts... values)
+        {
+            if (closed_)
+                throw std::logic_error("the command list is closed");
+
+            auto constexpr kSIZE = (sizeof(Ts) + ... + 0);
+            static_assert(kSIZE <= 255, "the payload size has to fit a byte");
+
+            auto const offset = std::size(stream_);
+            stream_.resize(offset + 2 + kSIZE);
+
+            auto data = std::data(stream_) + offset;
+
+            *data++ = static_cast<std::byte>(command);
+            *data++ = static_cast<std::byte>(kSIZE);
+
+            ((std::memcpy(data, &values, sizeof(Ts)), data += sizeof(Ts)), ...);
+
+            ++command_count_;
+        }
+    };
+
+    class null_fence final : public fence_interface {
+    public:
+
+        null_fence(null_device_statistics &statistics, null_clock &clock, std::uint64_t initial_value)
+            : statistics_{statistics}, clock_{clock}, initial_value_{initial_value} { }
+
+        std::uint64_t completed_value() const override
+        {
+            auto const now = clock_.now();
+            auto value = initial_value_;
+
+            for (auto &&signal : signals_) {
+                if (signal.time > now)
+                    break;
+
+                value = signal.value;
+            }
+
+            return value;
+        }
+
+        void wait(std::uint64_t value) override
+        {
+            ++statistics_.host_waits;
+
+            clock_.advance_to(completion_time(value));
+        }
+
+        // On the virtual GPU timeline. Values are signaled in increasing order.
+        void signal(std::uint64_t value, null_clock::duration time)
+        {
+            // With no points left, the initial value is the last one signaled.
+            if (value <= (signals_.empty() ? initial_value_ : signals_.back().value))
+                throw std::logic_error("fence values have to increase");
+
+            signals_.push_back(signal_point{value, (std::max)(time, signals_.empty() ? time : signals_.back().time)});
+
+            // Points the clock has passed are folded into the initial value.
+            auto const now = clock_.now();
+            auto const passed = std::find_if(std::begin(signals_), std::end(signals_), [now] (auto &&point) { return point.time > now; });
+
+            if (passed != std::begin(signals_)) {
+                initial_value_ = std::prev(passed)->value;
+                signals_.erase(std::begin(signals_), passed);
+            }
+        }
+
+        null_clock::duration completion_time(std::uint64_t value) const
+        {
+            if (value <= initial_value_)
+                return null_clock::duration{0};
+
+            auto const it = std::find_if(std::begin(signals_), std::end(signals_), [value] (auto &&point) { return point.value >= value; });
+
+            // Nothing is left that could signal it.
+            if (it == std::end(signals_))
+                throw std::logic_error("waiting for a fence value that hasn't been signaled would never return");
+
+            return it->time;
+        }
+
+    private:
+
+        struct signal_point final {
+            std::uint64_t value{0};
+            null_clock::duration time{0};
+        };
+
+        null_device_statistics &statistics_;
+        null_clock &clock_;
+
+        std::uint64_t initial_value_;
+        std::vector<signal_point> signals_;
+    };
+
+    // Executes command lists in submission order; a list starts once the queue is idle, and not before it is submitted.
+    class null_queue final : public queue_interface {
+    public:
+
+        null_queue(queue_type type, null_device_statistics &statistics, null_clock &clock) noexcept
+            : type_{type}, statistics_{statistics}, clock_{clock} { }
+
+        void execute(std::span<command_list_interface *const> command_lists) override
+        {
+            for (auto command_list : command_lists) {
+                auto &&list = *static_cast<null_command_list *>(command_list);
+
+                if (!list.closed())
+                    throw std::logic_error("only closed command lists can be executed");
+
+                if (list.type() != type_)
+                    throw std::invalid_argument("the command list type doesn't match the queue");
+
+                auto const start = (std::max)(busy_until_, clock_.now());
+
+                busy_until_ = start + list.cost();
+
+                ++statistics_.executed_command_lists;
+                statistics_.commands += list.command_count();
+                statistics_.stream_bytes += std::size(list.stream());
+                statistics_.busy[static_cast<std::size_t>(type_)] += list.cost();
+            }
+        }
+
+        void signal(fence_interface &fence, std::uint64_t value) override
+        {
+            static_cast<null_fence &>(fence).signal(value, (std::max)(busy_until_, clock_.now()));
+        }
+
+        void wait(fence_interface &fence, std::uint64_t value) override
+        {
+            busy_until_ = (std::max)(busy_until_, static_cast<null_fence &>(fence).completion_time(value));
+        }
+
+        null_clock::duration busy_until() const noexcept { return busy_until_; }
+
+    private:
+
+        queue_type type_;
+
+        null_device_statistics &statistics_;
+        null_clock &clock_;
+
+        null_clock::duration busy_until_{0};
+    };
+
+    // A device without a GPU. Commands are validated and recorded into each list's stream, execution only advances
+    // the virtual queues' timelines by the costs of the lists. The objects it creates refer to it, so it has to
+    // outlive them.
+    class null_device final : public device_interface {
+    public:
+
+        explicit null_device(null_timing timing = { }) noexcept : timing_{timing} { }
+
+        null_device(null_device const &) = delete;
+        null_device &operator=(null_device const &) = delete;
+
+        std::unique_ptr<resource_interface>
+        create_committed_resource(resource_description const &description, heap_type, resource_access) override
+        {
+            if (description.width == 0)
+                throw std::invalid_argument("a resource can't be empty");
+
+            ++statistics_.resources;
+
+            return std::make_unique<null_resource>(next_id_++, description);
+        }
+
+        std::unique_ptr<descriptor_heap_interface> create_descriptor_heap(descriptor_heap_description const &description) override
+        {
+            ++statistics_.descriptor_heaps;
+
+            return std::make_unique<null_descriptor_heap>(next_id_++, description);
+        }
+
+        std::unique_ptr<fence_interface> create_fence(std::uint64_t initial_value) override
+        {
+            return std::make_unique<null_fence>(statistics_, clock_, initial_value);
+        }
+
+        std::unique_ptr<queue_interface> create_queue(queue_type type) override
+        {
+            return std::make_unique<null_queue>(type, statistics_, clock_);
+        }
+
+        std::unique_ptr<command_list_interface> create_command_list(queue_type type) override
+        {
+            return std::make_unique<null_command_list>(type, timing_);
+        }
+
+        null_clock const &clock() const noexcept { return clock_; }
+
+        null_device_statistics const &statistics() const noexcept { return statistics_; }
+
+    private:
+
+        null_timing timing_;
+        null_clock clock_;
+
+        null_device_statistics statistics_;
+
+        // Zero stands for no resource in the streams.
+        std::uint32_t next_id_{1};
+    };
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include "main.hxx"
+#include "utility/exception.hxx"
+#include "platform/job_system.hxx"
+#include "graphics/command_pool.hxx"
+#include "graphics/frame.hxx"
+
+
+// Records 'batch_count' lists in parallel in between what the render thread recorded so far and what it records next.
+// Every job records into its own pair from the pool, so recording needs no locks beyond the pool's; the lists are
+// appended in batch order, so the submission order doesn't depend on the scheduling. Pending barriers go ahead
+// of the parallel lists, which don't transition resources themselves.
+template<class F>
+void record_parallel(graphics::frame_context &frame, graphics::command_pool &command_pool, platform::job_system &job_system,
+                     std::uint32_t batch_count, std::span<ID3D12DescriptorHeap *const> descriptor_heaps, F &&record)
+{
+    auto const type = frame.command_contexts.back().type;
+
+    frame.state_tracker.flush(frame.current_command_list);
+
+    if (auto result = frame.current_command_list->Close(); FAILED(result))
+        throw dx::device_error(fmt::format("failed to close a command list: {0:#x}"s, result));
+
+    frame.command_lists.push_back(frame.current_command_list);
+
+    std::vector<graphics::command_context> contexts(batch_count);
+
+    platform::job_counter counter;
+
+    for (auto batch = 0u; batch < batch_count; ++batch) {
+        job_system.run(counter, [&, batch]
+        {
+            auto &&context = contexts[batch];
+
+            context = command_pool.acquire(type);
+
+            auto command_list = context.command_list.get();
+
+            // Bound state doesn't carry over between command lists.
+            if (!descriptor_heaps.empty())
+                command_list->SetDescriptorHeaps(static_cast<UINT>(std::size(descriptor_heaps)), std::data(descriptor_heaps));
+
+            record(batch, command_list);
+
+            if (auto result = command_list->Close(); FAILED(result))
+                throw dx::device_error(fmt::format("failed to close a command list: {0:#x}"s, result));
+        });
+    }
+
+    job_system.wait(counter);
+
+    for (auto &&context : contexts) {
+        frame.command_lists.push_back(context.command_list.get());
+        frame.command_contexts.push_back(std::move(context));
+    }
+
+    frame.command_contexts.push_back(command_pool.acquire(type));
+    frame.current_command_list = frame.command_contexts.back().command_list.get();
+
+    if (!descriptor_heaps.empty())
+        frame.current_command_list->SetDescriptorHeaps(static_cast<UINT>(std::size(descriptor_heaps)), std::data(descriptor_heaps));
+}
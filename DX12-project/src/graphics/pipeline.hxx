@@ -0,0 +1,295 @@
+#pragma once
+
+#include <filesystem>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <vector>
+
+#include "main.hxx"
+#include "utility/exception.hxx"
+#include "utility/deduplicating_map.hxx"
+#include "utility/hash.hxx"
+#include "platform/mapped_file.hxx"
+#include "graphics/pipeline_cache_file.hxx"
+#include "graphics/pipeline_description.hxx"
+#include "graphics/pipeline_compiler.hxx"
+
+
+namespace graphics
+{
+    pipeline_cache_key pipeline_cache_key_of(IDXGIAdapter4 *const adapter)
+    {
+        DXGI_ADAPTER_DESC1 description;
+
+        if (auto result = adapter->GetDesc1(&description); FAILED(result))
+            throw dx::dxgi_factory(fmt::format("failed to get an adapter description: {0:#x}"s, result));
+
+        LARGE_INTEGER driver_version{};
+        adapter->CheckInterfaceSupport(winrt::guid_of<IDXGIDevice>(), &driver_version);
+
+        return pipeline_cache_key{description.VendorId, description.DeviceId, static_cast<std::uint64_t>(driver_version.QuadPart)};
+    }
+
+    struct pipeline_cache_statistics final {
+        // Pipelines created from the cache file, compiled from scratch, and requests served by a pipeline
+        // that had been requested before.
+        std::uint64_t loaded{0};
+        std::uint64_t compiled{0};
+        std::uint64_t deduplicated{0};
+
+        // Cached blobs the driver refused, e.g. after a change the cache key doesn't capture.
+        std::uint64_t rejected{0};
+    };
+
+    // Pipeline state objects keyed by a hash of their full description. Identical requests, also concurrent ones,
+    // share a single pipeline. Compiled pipelines persist in a memory-mapped cache file that is keyed by the adapter
+    // and driver: through ID3D12PipelineLibrary where the device supports it, as individual cached blobs otherwise.
+    // save() writes the next version of the file beside the mapped one; it replaces the old file once the cache is destroyed.
+    class pipeline_cache final {
+    public:
+
+        pipeline_cache(ID3D12Device6 *const device, pipeline_cache_key const &key, std::filesystem::path path)
+            : device_{device}, key_{key}, path_{std::move(path)}
+        {
+            file_ = std::make_unique<platform::mapped_file>(path_);
+            view_ = pipeline_cache_view::open(file_->bytes(), key_);
+
+            D3D12_FEATURE_DATA_SHADER_CACHE shader_cache{ };
+
+            if (auto result = device->CheckFeatureSupport(D3D12_FEATURE_SHADER_CACHE, &shader_cache, sizeof(shader_cache)); FAILED(result))
+                return;
+
+            if ((shader_cache.SupportFlags & D3D12_SHADER_CACHE_SUPPORT_LIBRARY) == 0)
+                return;
+
+            auto library = view_ ? view_->library() : std::span<std::byte const>{ };
+
+            // The library keeps referencing the serialized bytes, so they stay mapped as long as it lives.
+            if (FAILED(device->CreatePipelineLibrary(std::data(library), std::size(library), winrt::guid_of<ID3D12PipelineLibrary>(), library_.put_void()))) {
+                // A stale or corrupted library; the driver compiles everything again.
+                if (FAILED(device->CreatePipelineLibrary(nullptr, 0, winrt::guid_of<ID3D12PipelineLibrary>(), library_.put_void())))
+                    library_ = nullptr;
+            }
+        }
+
+        ~pipeline_cache()
+        {
+            library_ = nullptr;
+            file_.reset();
+
+            if (std::error_code error; std::filesystem::exists(next_path(), error))
+                std::filesystem::rename(next_path(), path_, error);
+        }
+
+        pipeline_cache(pipeline_cache const &) = delete;
+        pipeline_cache &operator=(pipeline_cache const &) = delete;
+
+        [[nodiscard]] winrt::com_ptr<ID3D12PipelineState>
+        graphics_pipeline(D3D12_GRAPHICS_PIPELINE_STATE_DESC description, std::uint64_t root_signature_hash)
+        {
+            auto const hash = hash_pipeline_description(description, root_signature_hash);
+
+            return pipelines_.get_or_create(hash, [&]
+            {
+                return create(hash, description, [this] (auto &&description, auto &&pipeline)
+                {
+                    return device_->CreateGraphicsPipelineState(&description, winrt::guid_of<ID3D12PipelineState>(), pipeline.put_void());
+
+                }, [this] (auto name, auto &&description, auto &&pipeline)
+                {
+                    return library_->LoadGraphicsPipeline(name, &description, winrt::guid_of<ID3D12PipelineState>(), pipeline.put_void());
+                });
+            });
+        }
+
+        [[nodiscard]] winrt::com_ptr<ID3D12PipelineState>
+        compute_pipeline(D3D12_COMPUTE_PIPELINE_STATE_DESC description, std::uint64_t root_signature_hash)
+        {
+            auto const hash = hash_pipeline_description(description, root_signature_hash);
+
+            return pipelines_.get_or_create(hash, [&]
+            {
+                return create(hash, description, [this] (auto &&description, auto &&pipeline)
+                {
+                    return device_->CreateComputePipelineState(&description, winrt::guid_of<ID3D12PipelineState>(), pipeline.put_void());
+
+                }, [this] (auto name, auto &&description, auto &&pipeline)
+                {
+                    return library_->LoadComputePipeline(name, &description, winrt::guid_of<ID3D12PipelineState>(), pipeline.put_void());
+                });
+            });
+        }
+
+        // Pipelines of the previous file that weren't requested in this run are carried over.
+        void save()
+        {
+            std::vector<winrt::com_ptr<ID3DBlob>> blobs;
+            std::vector<pipeline_cache_entry> entries;
+
+            std::vector<std::byte> library;
+
+            if (library_ != nullptr) {
+                std::unique_lock lock{library_mutex_};
+
+                library.resize(library_->GetSerializedSize());
+
+                if (auto result = library_->Serialize(std::data(library), std::size(library)); FAILED(result))
+                    throw dx::device_error(fmt::format("failed to serialize a pipeline library: {0:#x}"s, result));
+            }
+
+            else {
+                pipelines_.for_each([&] (std::uint64_t hash, winrt::com_ptr<ID3D12PipelineState> const &pipeline)
+                {
+                    winrt::com_ptr<ID3DBlob> blob;
+
+                    if (SUCCEEDED(pipeline->GetCachedBlob(blob.put())))
+                        entries.push_back(pipeline_cache_entry{hash, std::span{static_cast<std::byte const *>(blob->GetBufferPointer()), blob->GetBufferSize()}});
+
+                    blobs.push_back(std::move(blob));
+                });
+
+                if (view_) {
+                    view_->for_each([&] (std::uint64_t hash, std::span<std::byte const> blob)
+                    {
+                        if (!pipelines_.contains(hash))
+                            entries.push_back(pipeline_cache_entry{hash, blob});
+                    });
+                }
+            }
+
+            std::ofstream file{next_path(), std::ios::binary | std::ios::trunc};
+
+            if (!file)
+                throw dx::device_error("failed to open the pipeline cache file for writing"s);
+
+            write_pipeline_cache(file, key_, std::move(entries), library);
+        }
+
+        pipeline_cache_statistics statistics() const
+        {
+            std::unique_lock lock{statistics_mutex_};
+
+            auto statistics = statistics_;
+
+            statistics.deduplicated = pipelines_.counters().reused;
+
+            return statistics;
+        }
+
+    private:
+
+        ID3D12Device6 *device_;
+
+        pipeline_cache_key key_;
+        std::filesystem::path path_;
+
+        std::unique_ptr<platform::mapped_file> file_;
+        std::optional<pipeline_cache_view> view_;
+
+        // The library isn't documented to be free-threaded.
+        winrt::com_ptr<ID3D12PipelineLibrary> library_;
+        std::mutex library_mutex_;
+
+        utility::deduplicating_map<winrt::com_ptr<ID3D12PipelineState>> pipelines_;
+
+        mutable std::mutex statistics_mutex_;
+        pipeline_cache_statistics statistics_;
+
+        std::filesystem::path next_path() const
+        {
+            auto path = path_;
+            return path.concat(L".next");
+        }
+
+        void count(std::uint64_t pipeline_cache_statistics::*counter)
+        {
+            std::unique_lock lock{statistics_mutex_};
+
+            ++(statistics_.*counter);
+        }
+
+        template<class D, class C, class L>
+        winrt::com_ptr<ID3D12PipelineState> create(std::uint64_t hash, D description, C &&compile, L &&load)
+        {
+            winrt::com_ptr<ID3D12PipelineState> pipeline;
+
+            auto const hex = fmt::format("{0:016x}"s, hash);
+            auto const name = std::wstring{std::begin(hex), std::end(hex)};
+
+            if (library_ != nullptr) {
+                {
+                    std::unique_lock lock{library_mutex_};
+
+                    // Fails with E_INVALIDARG if the library doesn't have the pipeline.
+                    if (SUCCEEDED(load(name.c_str(), description, pipeline))) {
+                        count(&pipeline_cache_statistics::loaded);
+                        return pipeline;
+                    }
+                }
+
+                if (auto result = compile(description, pipeline); FAILED(result))
+                    throw dx::device_error(fmt::format("failed to create a pipeline state: {0:#x}"s, result));
+
+                count(&pipeline_cache_statistics::compiled);
+
+                std::unique_lock lock{library_mutex_};
+
+                // Fails if a concurrent creation of the same name won the race, which is harmless.
+                library_->StorePipeline(name.c_str(), pipeline.get());
+
+                return pipeline;
+            }
+
+            if (auto blob = view_ ? view_->find(hash) : std::span<std::byte const>{ }; !blob.empty()) {
+                description.CachedPSO = D3D12_CACHED_PIPELINE_STATE{std::data(blob), std::size(blob)};
+
+                if (SUCCEEDED(compile(description, pipeline))) {
+                    count(&pipeline_cache_statistics::loaded);
+                    return pipeline;
+                }
+
+                // D3D12_ERROR_ADAPTER_NOT_FOUND, D3D12_ERROR_DRIVER_VERSION_MISMATCH or a blob the driver can't use.
+                count(&pipeline_cache_statistics::rejected);
+
+                description.CachedPSO = D3D12_CACHED_PIPELINE_STATE{nullptr, 0};
+            }
+
+            if (auto result = compile(description, pipeline); FAILED(result))
+                throw dx::device_error(fmt::format("failed to create a pipeline state: {0:#x}"s, result));
+
+            count(&pipeline_cache_statistics::compiled);
+
+            return pipeline;
+        }
+    };
+
+    using pipeline_compiler = basic_pipeline_compiler<winrt::com_ptr<ID3D12PipelineState>>;
+
+    // Creates the pipeline through the cache on a compiler thread. The shaders, input layout and stream output
+    // the description points to have to stay alive until the handle isn't pending any more.
+    pipeline_compiler::handle
+    request_graphics_pipeline(pipeline_compiler &compiler, pipeline_cache &cache, D3D12_GRAPHICS_PIPELINE_STATE_DESC const &description,
+                              std::uint64_t root_signature_hash, pipeline_priority priority = pipeline_priority::normal,
+                              pipeline_compiler::handle fallback = { })
+    {
+        return compiler.request([&cache, description, root_signature_hash]
+        {
+            return cache.graphics_pipeline(description, root_signature_hash);
+        }, priority, std::move(fallback));
+    }
+
+    pipeline_compiler::handle
+    request_compute_pipeline(pipeline_compiler &compiler, pipeline_cache &cache, D3D12_COMPUTE_PIPELINE_STATE_DESC const &description,
+                             std::uint64_t root_signature_hash, pipeline_priority priority = pipeline_priority::normal,
+                             pipeline_compiler::handle fallback = { })
+    {
+        return compiler.request([&cache, description, root_signature_hash]
+        {
+            return cache.compute_pipeline(description, root_signature_hash);
+        }, priority, std::move(fallback));
+    }
+}
@@ -0,0 +1,264 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <optional>
+#include <ostream>
+#include <span>
+#include <vector>
+
+#include "utility/hash.hxx"
+
+
+namespace graphics
+{
+    // Compiled pipelines are only valid for the adapter and driver that produced them.
+    struct pipeline_cache_key final {
+        std::uint32_t vendor_id{0};
+        std::uint32_t device_id{0};
+        std::uint64_t driver_version{0};
+
+        bool operator== (pipeline_cache_key const &) const = default;
+    };
+
+    struct pipeline_cache_entry final {
+        std::uint64_t hash{0};
+        std::span<std::byte const> blob;
+    };
+
+    // Layout of a pipeline cache file, all fields little-endian:
+    //   header         magic, format version, cache key, entry count, library section, index checksum, header checksum
+    //   index          entry count of {description hash, blob offset, blob size, blob checksum}, sorted by hash
+    //   blobs          cached pipeline blobs (ID3D12PipelineState::GetCachedBlob), 8-byte aligned
+    //   library        serialized ID3D12PipelineLibrary, if the device supports it
+    // A file with a different magic, version or key, or whose header or index fails its checksum, is ignored as a whole;
+    // a blob that fails its checksum is treated as missing.
+    namespace pipeline_cache_file
+    {
+        auto constexpr kMAGIC = 0x31435350u; // "PSC1"
+        auto constexpr kVERSION = 1u;
+
+        struct header final {
+            std::uint32_t magic{kMAGIC};
+            std::uint32_t version{kVERSION};
+
+            pipeline_cache_key key;
+
+            std::uint64_t entry_count{0};
+
+            std::uint64_t library_offset{0};
+            std::uint64_t library_size{0};
+            std::uint64_t library_checksum{0};
+
+            std::uint64_t index_checksum{0};
+            std::uint64_t header_checksum{0};
+        };
+
+        struct index_entry final {
+            std::uint64_t hash{0};
+            std::uint64_t offset{0};
+            std::uint64_t size{0};
+            std::uint64_t checksum{0};
+        };
+
+        static_assert(sizeof(header) == 72 && sizeof(index_entry) == 32, "the file layout must not contain padding");
+
+        // Everything in front of the checksum itself.
+        std::uint64_t header_checksum(header const &value) noexcept
+        {
+            return utility::hash_bytes(std::as_bytes(std::span{&value, 1}).first(offsetof(header, header_checksum)));
+        }
+    }
+
+    // Read-only view of a cache file, usually a mapping of it. The view doesn't own the bytes.
+    class pipeline_cache_view final {
+    public:
+
+        static std::optional<pipeline_cache_view> open(std::span<std::byte const> file, pipeline_cache_key const &key) noexcept
+        {
+            using namespace pipeline_cache_file;
+
+            header value;
+
+            if (std::size(file) < sizeof(value))
+                return std::nullopt;
+
+            std::memcpy(&value, std::data(file), sizeof(value));
+
+            if (value.magic != kMAGIC || value.version != kVERSION || value.key != key)
+                return std::nullopt;
+
+            if (value.header_checksum != header_checksum(value))
+                return std::nullopt;
+
+            auto const index_size = value.entry_count * sizeof(index_entry);
+
+            if (value.entry_count > (std::size(file) - sizeof(header)) / sizeof(index_entry))
+                return std::nullopt;
+
+            auto const index = file.subspan(sizeof(header), static_cast<std::size_t>(index_size));
+
+            if (utility::hash_bytes(index) != value.index_checksum)
+                return std::nullopt;
+
+            pipeline_cache_view view;
+
+            view.file_ = file;
+            view.index_ = index;
+            view.entry_count_ = static_cast<std::size_t>(value.entry_count);
+
+            if (value.library_size != 0 && value.library_offset <= std::size(file) && value.library_size <= std::size(file) - value.library_offset) {
+                auto const library = file.subspan(static_cast<std::size_t>(value.library_offset), static_cast<std::size_t>(value.library_size));
+
+                if (utility::hash_bytes(library) == value.library_checksum)
+                    view.library_ = library;
+            }
+
+            return view;
+        }
+
+        // The blob of the description hash, empty if it is missing or corrupted.
+        std::span<std::byte const> find(std::uint64_t hash) const noexcept
+        {
+            std::size_t first = 0, count = entry_count_;
+
+            // Binary search over the unaligned index.
+            while (count > 0) {
+                auto const step = count / 2;
+
+                if (entry(first + step).hash < hash) {
+                    first += step + 1;
+                    count -= step + 1;
+                }
+
+                else count = step;
+            }
+
+            if (first == entry_count_)
+                return { };
+
+            auto const value = entry(first);
+
+            if (value.hash != hash || value.offset > std::size(file_) || value.size > std::size(file_) - value.offset)
+                return { };
+
+            auto const blob = file_.subspan(static_cast<std::size_t>(value.offset), static_cast<std::size_t>(value.size));
+
+            if (utility::hash_bytes(blob) != value.checksum)
+                return { };
+
+            return blob;
+        }
+
+        // The serialized pipeline library, empty if there is none or it is corrupted.
+        std::span<std::byte const> library() const noexcept { return library_; }
+
+        std::size_t size() const noexcept { return entry_count_; }
+
+        // Entries in hash order; the blobs are not verified.
+        template<class F>
+        void for_each(F &&function) const
+        {
+            for (auto index = 0u; index < entry_count_; ++index) {
+                auto const value = entry(index);
+
+                if (value.offset <= std::size(file_) && value.size <= std::size(file_) - value.offset)
+                    function(value.hash, file_.subspan(static_cast<std::size_t>(value.offset), static_cast<std::size_t>(value.size)));
+            }
+        }
+
+    private:
+
+        std::span<std::byte const> file_;
+        std::span<std::byte const> index_;
+        std::span<std::byte const> library_;
+
+        std::size_t entry_count_{0};
+
+        pipeline_cache_view() = default;
+
+        pipeline_cache_file::index_entry entry(std::size_t index) const noexcept
+        {
+            pipeline_cache_file::index_entry value;
+
+            std::memcpy(&value, std::data(index_) + index * sizeof(value), sizeof(value));
+
+            return value;
+        }
+    };
+
+    // Entries with the same hash are written once.
+    void write_pipeline_cache(std::ostream &stream, pipeline_cache_key const &key,
+                              std::vector<pipeline_cache_entry> entries, std::span<std::byte const> library = { })
+    {
+        using namespace pipeline_cache_file;
+
+        std::sort(std::begin(entries), std::end(entries), [] (auto &&lhs, auto &&rhs) { return lhs.hash < rhs.hash; });
+
+        auto it = std::unique(std::begin(entries), std::end(entries), [] (auto &&lhs, auto &&rhs) { return lhs.hash == rhs.hash; });
+
+        entries.erase(it, std::end(entries));
+
+        auto const align = [] (std::uint64_t offset) { return (offset + 7) & ~std::uint64_t{7}; };
+
+        std::vector<index_entry> index;
+        index.reserve(std::size(entries));
+
+        auto offset = sizeof(header) + std::size(entries) * sizeof(index_entry);
+
+        for (auto &&entry : entries) {
+            offset = align(offset);
+
+            index.push_back(index_entry{entry.hash, offset, std::size(entry.blob), utility::hash_bytes(entry.blob)});
+
+            offset += std::size(entry.blob);
+        }
+
+        header value;
+
+        value.key = key;
+        value.entry_count = std::size(entries);
+
+        if (!library.empty()) {
+            value.library_offset = align(offset);
+            value.library_size = std::size(library);
+            value.library_checksum = utility::hash_bytes(library);
+        }
+
+        value.index_checksum = utility::hash_bytes(std::as_bytes(std::span{index}));
+        value.header_checksum = header_checksum(value);
+
+        auto const write = [&stream] (std::span<std::byte const> bytes)
+        {
+            stream.write(reinterpret_cast<char const *>(std::data(bytes)), static_cast<std::streamsize>(std::size(bytes)));
+        };
+
+        auto const pad = [&stream, &align] (std::uint64_t position)
+        {
+            auto constexpr zeros = std::array<char, 8>{ };
+
+            stream.write(std::data(zeros), static_cast<std::streamsize>(align(position) - position));
+        };
+
+        write(std::as_bytes(std::span{&value, 1}));
+        write(std::as_bytes(std::span{index}));
+
+        auto position = sizeof(header) + std::size(index) * sizeof(index_entry);
+
+        for (auto &&entry : entries) {
+            pad(position);
+            position = align(position);
+
+            write(entry.blob);
+            position += std::size(entry.blob);
+        }
+
+        if (!library.empty()) {
+            pad(position);
+            write(library);
+        }
+    }
+}
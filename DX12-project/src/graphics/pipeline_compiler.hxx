@@ -0,0 +1,336 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+namespace graphics
+{
+    enum class pipeline_priority : std::uint8_t {
+        // Pipelines needed by draws that are currently skipped or drawn with a fallback.
+        high = 0,
+        normal,
+        // Prewarming of pipelines that may be needed later.
+        low
+    };
+
+    auto constexpr kPIPELINE_PRIORITY_NUMBER = 3u;
+
+    enum class pipeline_status : std::uint32_t {
+        pending = 0, ready, failed
+    };
+
+    template<class T>
+    class basic_pipeline_compiler;
+
+    // Shared by the render thread and the compiler. The status only ever goes from pending to ready or failed,
+    // and the pipeline is written before the status is published, so reading it needs no lock.
+    template<class T>
+    class pipeline_handle final {
+    public:
+
+        pipeline_handle() = default;
+
+        // A handle that is ready from the start, e.g. for a fallback compiled during startup.
+        static pipeline_handle make_ready(T pipeline)
+        {
+            pipeline_handle handle{std::make_shared<state>()};
+
+            handle.state_->pipeline.emplace(std::move(pipeline));
+            handle.state_->status.store(pipeline_status::ready, std::memory_order_release);
+
+            return handle;
+        }
+
+        explicit operator bool() const noexcept { return state_ != nullptr; }
+
+        pipeline_status status() const noexcept
+        {
+            return state_ != nullptr ? state_->status.load(std::memory_order_acquire) : pipeline_status::failed;
+        }
+
+        // The pipeline once it is ready, nullptr before.
+        T const *get() const noexcept
+        {
+            if (status() != pipeline_status::ready)
+                return nullptr;
+
+            return &*state_->pipeline;
+        }
+
+        // The pipeline to draw with this frame: the requested one once it is ready, its fallback until then.
+        // nullptr means the draw has to be skipped.
+        T const *current() const noexcept
+        {
+            if (auto pipeline = get(); pipeline != nullptr)
+                return pipeline;
+
+            if (state_ == nullptr || state_->fallback == nullptr)
+                return nullptr;
+
+            return pipeline_handle{state_->fallback}.get();
+        }
+
+        // Why the compilation failed; nullptr if it was cancelled or hasn't failed.
+        std::exception_ptr error() const noexcept
+        {
+            return status() == pipeline_status::failed && state_ != nullptr ? state_->error : nullptr;
+        }
+
+    private:
+
+        friend class basic_pipeline_compiler<T>;
+
+        struct state final {
+            std::atomic<pipeline_status> status{pipeline_status::pending};
+
+            std::optional<T> pipeline;
+            std::exception_ptr error;
+
+            std::shared_ptr<state> fallback;
+        };
+
+        std::shared_ptr<state> state_;
+
+        explicit pipeline_handle(std::shared_ptr<state> state) noexcept : state_{std::move(state)} { }
+    };
+
+    struct pipeline_compiler_statistics final {
+        std::uint64_t requested{0};
+        std::uint64_t compiled{0};
+        std::uint64_t failed{0};
+        std::uint64_t cancelled{0};
+
+        // Requests waiting for a worker right now.
+        std::uint64_t queued{0};
+    };
+
+    // Compiles pipelines on background threads so the render thread never blocks on the driver's compiler.
+    // Workers take the oldest request of the highest priority. Raising the priority of a pending request is allowed
+    // at any time, e.g. once a draw actually needs it. Requests still queued when the compiler is destroyed are cancelled.
+    // T is the pipeline type and the compile functions are opaque, so the scheduling is independent of D3D.
+    template<class T>
+    class basic_pipeline_compiler final {
+    public:
+
+        using handle = pipeline_handle<T>;
+
+        // 'on_thread_start' runs first on every worker, e.g. to lower the OS priority of the thread.
+        explicit basic_pipeline_compiler(std::uint32_t worker_count = default_worker_count(), std::function<void()> on_thread_start = { })
+        {
+            worker_count = (std::max)(worker_count, 1u);
+
+            workers_.reserve(worker_count);
+
+            for (auto index = 0u; index < worker_count; ++index) {
+                workers_.emplace_back([this, on_thread_start]
+                {
+                    if (on_thread_start)
+                        on_thread_start();
+
+                    work();
+                });
+            }
+        }
+
+        ~basic_pipeline_compiler()
+        {
+            std::vector<std::shared_ptr<queued_request>> cancelled;
+
+            {
+                std::unique_lock lock{mutex_};
+
+                stop_ = true;
+
+                for (auto &&queue : queues_) {
+                    std::move(std::begin(queue), std::end(queue), std::back_inserter(cancelled));
+                    queue.clear();
+                }
+            }
+
+            pending_condition_.notify_all();
+
+            for (auto &&worker : workers_)
+                worker.join();
+
+            for (auto &&value : cancelled)
+                value->state->status.store(pipeline_status::failed, std::memory_order_release);
+
+            statistics_.cancelled += std::size(cancelled);
+            statistics_.queued = 0;
+        }
+
+        basic_pipeline_compiler(basic_pipeline_compiler const &) = delete;
+        basic_pipeline_compiler &operator=(basic_pipeline_compiler const &) = delete;
+
+        // 'compile' runs on a worker and returns the pipeline or throws. Draws use 'fallback' until the pipeline is ready.
+        template<class F>
+        handle request(F &&compile, pipeline_priority priority = pipeline_priority::normal, handle fallback = { })
+        {
+            auto state = std::make_shared<typename handle::state>();
+
+            state->fallback = std::move(fallback.state_);
+
+            {
+                std::unique_lock lock{mutex_};
+
+                auto value = std::make_shared<queued_request>(queued_request{std::function<T()>{std::forward<F>(compile)}, state, priority});
+
+                queues_[static_cast<std::size_t>(priority)].push_back(value);
+
+                ++statistics_.requested;
+                ++statistics_.queued;
+            }
+
+            pending_condition_.notify_one();
+
+            return handle{std::move(state)};
+        }
+
+        // Moves a request that is still queued up to 'priority'; does nothing for requests already being compiled
+        // or requested with a higher priority.
+        void prioritize(handle const &pipeline, pipeline_priority priority)
+        {
+            if (pipeline.status() != pipeline_status::pending)
+                return;
+
+            std::unique_lock lock{mutex_};
+
+            for (auto index = static_cast<std::size_t>(priority) + 1; index < kPIPELINE_PRIORITY_NUMBER; ++index) {
+                auto &&queue = queues_[index];
+
+                auto it = std::find_if(std::begin(queue), std::end(queue), [&pipeline] (auto &&value)
+                {
+                    return value->state == pipeline.state_;
+                });
+
+                if (it == std::end(queue))
+                    continue;
+
+                (*it)->priority = priority;
+
+                queues_[static_cast<std::size_t>(priority)].push_back(std::move(*it));
+                queue.erase(it);
+
+                return;
+            }
+        }
+
+        // Blocks until every queued request has been compiled; meant for loading screens and shutdown.
+        void wait_idle()
+        {
+            std::unique_lock lock{mutex_};
+
+            idle_condition_.wait(lock, [this] { return statistics_.queued == 0 && active_ == 0; });
+        }
+
+        pipeline_compiler_statistics statistics() const
+        {
+            std::unique_lock lock{mutex_};
+
+            return statistics_;
+        }
+
+        static std::uint32_t default_worker_count() noexcept
+        {
+            // Leaves most of the cores to the frame's own jobs.
+            return (std::max)(std::thread::hardware_concurrency() / 4, 1u);
+        }
+
+    private:
+
+        struct queued_request final {
+            std::function<T()> compile;
+            std::shared_ptr<typename handle::state> state;
+
+            pipeline_priority priority;
+        };
+
+        mutable std::mutex mutex_;
+
+        std::condition_variable pending_condition_;
+        std::condition_variable idle_condition_;
+
+        std::array<std::deque<std::shared_ptr<queued_request>>, kPIPELINE_PRIORITY_NUMBER> queues_;
+
+        std::uint32_t active_{0};
+        bool stop_{false};
+
+        pipeline_compiler_statistics statistics_;
+
+        std::vector<std::thread> workers_;
+
+        std::shared_ptr<queued_request> pop()
+        {
+            for (auto &&queue : queues_) {
+                if (!queue.empty()) {
+                    auto value = std::move(queue.front());
+                    queue.pop_front();
+
+                    return value;
+                }
+            }
+
+            return nullptr;
+        }
+
+        void work()
+        {
+            while (true) {
+                std::shared_ptr<queued_request> value;
+
+                {
+                    std::unique_lock lock{mutex_};
+
+                    pending_condition_.wait(lock, [this] { return stop_ || statistics_.queued != 0; });
+
+                    if (stop_)
+                        return;
+
+                    value = pop();
+
+                    --statistics_.queued;
+                    ++active_;
+                }
+
+                auto &&state = *value->state;
+                auto status = pipeline_status::ready;
+
+                try {
+                    state.pipeline.emplace(value->compile());
+
+                } catch (...) {
+                    state.error = std::current_exception();
+                    status = pipeline_status::failed;
+                }
+
+                // Publishes the pipeline or the error.
+                state.status.store(status, std::memory_order_release);
+
+                {
+                    std::unique_lock lock{mutex_};
+
+                    ++(status == pipeline_status::ready ? statistics_.compiled : statistics_.failed);
+
+                    --active_;
+
+                    if (statistics_.queued == 0 && active_ == 0)
+                        idle_condition_.notify_all();
+                }
+            }
+        }
+    };
+}
@@ -0,0 +1,99 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+#include "main.hxx"
+#include "utility/hash.hxx"
+
+
+namespace graphics
+{
+    std::span<std::byte const> bytes_of(D3D12_SHADER_BYTECODE const &bytecode) noexcept
+    {
+        return {static_cast<std::byte const *>(bytecode.pShaderBytecode), bytecode.BytecodeLength};
+    }
+
+    // Hashes every field that affects the compiled pipeline, following the pointers; the cached blob is left out.
+    // Root signatures can't be read back from the interface, so the caller passes a hash of the serialized one.
+    std::uint64_t hash_pipeline_description(D3D12_GRAPHICS_PIPELINE_STATE_DESC const &description, std::uint64_t root_signature_hash) noexcept
+    {
+        utility::hasher hasher;
+
+        hasher.add(root_signature_hash);
+
+        for (auto &&shader : {description.VS, description.PS, description.DS, description.HS, description.GS})
+            hasher.add(bytes_of(shader));
+
+        auto &&stream_output = description.StreamOutput;
+
+        hasher.add(stream_output.NumEntries).add(stream_output.NumStrides).add(stream_output.RasterizedStream);
+
+        for (auto &&entry : std::span{stream_output.pSODeclaration, stream_output.NumEntries}) {
+            hasher.add(entry.Stream).add(std::string_view{entry.SemanticName != nullptr ? entry.SemanticName : ""}).add(entry.SemanticIndex);
+            hasher.add(entry.StartComponent).add(entry.ComponentCount).add(entry.OutputSlot);
+        }
+
+        for (auto stride : std::span{stream_output.pBufferStrides, stream_output.NumStrides})
+            hasher.add(stride);
+
+        auto &&blend = description.BlendState;
+
+        hasher.add(blend.AlphaToCoverageEnable).add(blend.IndependentBlendEnable);
+
+        for (auto &&target : blend.RenderTarget) {
+            hasher.add(target.BlendEnable).add(target.LogicOpEnable);
+            hasher.add(target.SrcBlend).add(target.DestBlend).add(target.BlendOp);
+            hasher.add(target.SrcBlendAlpha).add(target.DestBlendAlpha).add(target.BlendOpAlpha);
+            hasher.add(target.LogicOp).add(target.RenderTargetWriteMask);
+        }
+
+        hasher.add(description.SampleMask);
+
+        auto &&rasterizer = description.RasterizerState;
+
+        hasher.add(rasterizer.FillMode).add(rasterizer.CullMode).add(rasterizer.FrontCounterClockwise);
+        hasher.add(rasterizer.DepthBias).add(rasterizer.DepthBiasClamp).add(rasterizer.SlopeScaledDepthBias);
+        hasher.add(rasterizer.DepthClipEnable).add(rasterizer.MultisampleEnable).add(rasterizer.AntialiasedLineEnable);
+        hasher.add(rasterizer.ForcedSampleCount).add(rasterizer.ConservativeRaster);
+
+        auto &&depth_stencil = description.DepthStencilState;
+
+        hasher.add(depth_stencil.DepthEnable).add(depth_stencil.DepthWriteMask).add(depth_stencil.DepthFunc);
+        hasher.add(depth_stencil.StencilEnable).add(depth_stencil.StencilReadMask).add(depth_stencil.StencilWriteMask);
+
+        for (auto &&face : {depth_stencil.FrontFace, depth_stencil.BackFace})
+            hasher.add(face.StencilFailOp).add(face.StencilDepthFailOp).add(face.StencilPassOp).add(face.StencilFunc);
+
+        hasher.add(description.InputLayout.NumElements);
+
+        for (auto &&element : std::span{description.InputLayout.pInputElementDescs, description.InputLayout.NumElements}) {
+            hasher.add(std::string_view{element.SemanticName != nullptr ? element.SemanticName : ""}).add(element.SemanticIndex);
+            hasher.add(element.Format).add(element.InputSlot).add(element.AlignedByteOffset);
+            hasher.add(element.InputSlotClass).add(element.InstanceDataStepRate);
+        }
+
+        hasher.add(description.IBStripCutValue).add(description.PrimitiveTopologyType);
+
+        hasher.add(description.NumRenderTargets);
+
+        for (auto format : description.RTVFormats)
+            hasher.add(format);
+
+        hasher.add(description.DSVFormat).add(description.SampleDesc.Count).add(description.SampleDesc.Quality);
+        hasher.add(description.NodeMask).add(description.Flags);
+
+        return hasher.value();
+    }
+
+    std::uint64_t hash_pipeline_description(D3D12_COMPUTE_PIPELINE_STATE_DESC const &description, std::uint64_t root_signature_hash) noexcept
+    {
+        utility::hasher hasher;
+
+        hasher.add(root_signature_hash).add(bytes_of(description.CS)).add(description.NodeMask).add(description.Flags);
+
+        return hasher.value();
+    }
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <memory>
+#include <span>
+
+#include "main.hxx"
+#include "utility/exception.hxx"
+#include "graphics/command.hxx"
+#include "graphics/fence.hxx"
+#include "graphics/render_graph.hxx"
+
+
+namespace graphics
+{
+    auto constexpr kQUEUE_TYPE_NUMBER = static_cast<std::size_t>(queue_type::count);
+
+    // A point on the timeline of one of the queues.
+    struct queue_fence final {
+        queue_type queue{queue_type::graphics};
+        UINT64 value{0};
+    };
+
+    constexpr D3D12_COMMAND_LIST_TYPE command_list_type_of(queue_type type) noexcept
+    {
+        switch (type) {
+            case queue_type::compute:
+                return D3D12_COMMAND_LIST_TYPE_COMPUTE;
+
+            case queue_type::copy:
+                return D3D12_COMMAND_LIST_TYPE_COPY;
+
+            default:
+                return D3D12_COMMAND_LIST_TYPE_DIRECT;
+        }
+    }
+
+    // Direct, compute and copy queues, each with its own fence timeline. A submission lists the fences of other
+    // queues it depends on and the matching GPU-side waits are inserted ahead of it, so independent work of
+    // different queues overlaps. Only fence values that have already been signaled can be waited for: every wait
+    // then points backwards in the submission order, which keeps the wait graph acyclic and the queues deadlock-free.
+    // Submissions to a queue have to be serialized by the caller; different queues may be fed from different threads.
+    class queue_scheduler final {
+    public:
+
+        explicit queue_scheduler(ID3D12Device6 *const device)
+        {
+            for (auto index = 0u; index < kQUEUE_TYPE_NUMBER; ++index) {
+                queues_[index] = create_command_queue(device, command_list_type_of(static_cast<queue_type>(index)));
+                timelines_[index] = std::make_unique<fence_timeline>(device);
+            }
+        }
+
+        queue_scheduler(queue_scheduler const &) = delete;
+        queue_scheduler &operator=(queue_scheduler const &) = delete;
+
+        ID3D12CommandQueue *queue(queue_type type) const noexcept { return queues_[index_of(type)].get(); }
+
+        fence_timeline &timeline(queue_type type) const noexcept { return *timelines_[index_of(type)]; }
+
+        // Makes the queue wait for the fences before whatever is submitted to it next.
+        void wait(queue_type type, std::span<queue_fence const> fences)
+        {
+            auto const target = index_of(type);
+
+            for (auto &&fence : fences) {
+                auto const source = index_of(fence.queue);
+
+                // Work of a single queue is already executed in order.
+                if (source == target)
+                    continue;
+
+                auto &&source_timeline = *timelines_[source];
+
+                if (fence.value > source_timeline.last_signaled_value())
+                    throw dx::fence_error(fmt::format("a queue can't wait for a fence value that hasn't been signaled yet: {0}"s, fence.value));
+
+                // A wait for an earlier or equal value of the same queue is implied by the previous one.
+                if (fence.value <= waited_values_[target][source] || source_timeline.is_complete(fence.value))
+                    continue;
+
+                if (auto result = queues_[target]->Wait(source_timeline.get(), fence.value); FAILED(result))
+                    throw dx::fence_error(fmt::format("failed to wait for a fence on a queue: {0:#x}"s, result));
+
+                waited_values_[target][source] = fence.value;
+            }
+        }
+
+        queue_fence signal(queue_type type)
+        {
+            auto const index = index_of(type);
+
+            return queue_fence{type, timelines_[index]->signal(queues_[index].get())};
+        }
+
+        queue_fence submit(queue_type type, std::span<ID3D12CommandList *const> command_lists, std::span<queue_fence const> waits = { })
+        {
+            wait(type, waits);
+
+            if (!command_lists.empty())
+                queues_[index_of(type)]->ExecuteCommandLists(static_cast<UINT>(std::size(command_lists)), std::data(command_lists));
+
+            return signal(type);
+        }
+
+        // Blocks until every queue has finished the work submitted so far.
+        void flush()
+        {
+            for (auto index = 0u; index < kQUEUE_TYPE_NUMBER; ++index)
+                timelines_[index]->flush(queues_[index].get());
+        }
+
+    private:
+
+        std::array<winrt::com_ptr<ID3D12CommandQueue>, kQUEUE_TYPE_NUMBER> queues_;
+        std::array<std::unique_ptr<fence_timeline>, kQUEUE_TYPE_NUMBER> timelines_;
+
+        // The largest value of each source queue that a target queue has been made to wait for.
+        std::array<std::array<UINT64, kQUEUE_TYPE_NUMBER>, kQUEUE_TYPE_NUMBER> waited_values_{ };
+
+        static std::size_t index_of(queue_type type) noexcept { return static_cast<std::size_t>(type); }
+    };
+}
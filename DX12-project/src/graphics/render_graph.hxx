@@ -0,0 +1,559 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <span>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+
+namespace graphics
+{
+    auto constexpr kINVALID_RENDER_GRAPH_INDEX = std::numeric_limits<std::uint32_t>::max();
+
+    enum class queue_type : std::uint8_t {
+        graphics, compute, copy, count
+    };
+
+    // API-neutral resource usage; read usages can be combined.
+    enum class resource_access : std::uint32_t {
+        undefined           = 0,
+        vertex_buffer       = 1u << 0,
+        index_buffer        = 1u << 1,
+        constant_buffer     = 1u << 2,
+        indirect_argument   = 1u << 3,
+        shader_read         = 1u << 4,
+        depth_read          = 1u << 5,
+        copy_source         = 1u << 6,
+        present             = 1u << 7,
+        render_target       = 1u << 8,
+        depth_write         = 1u << 9,
+        unordered_access    = 1u << 10,
+        copy_dest           = 1u << 11
+    };
+
+    constexpr resource_access operator| (resource_access lhs, resource_access rhs) noexcept
+    {
+        return static_cast<resource_access>(static_cast<std::uint32_t>(lhs) | static_cast<std::uint32_t>(rhs));
+    }
+
+    constexpr resource_access operator& (resource_access lhs, resource_access rhs) noexcept
+    {
+        return static_cast<resource_access>(static_cast<std::uint32_t>(lhs) & static_cast<std::uint32_t>(rhs));
+    }
+
+    auto constexpr kWRITE_RESOURCE_ACCESS = resource_access::render_target | resource_access::depth_write |
+                                            resource_access::unordered_access | resource_access::copy_dest;
+
+    // Declarative description of a frame: passes declare the resources they read and write, the order
+    // and the barriers between them are derived by render_graph_compiler. The graph is meant to be rebuilt
+    // every frame; its compilation is reused as long as the topology stays the same.
+    class render_graph final {
+    public:
+
+        struct resource_use final {
+            std::uint32_t resource{kINVALID_RENDER_GRAPH_INDEX};
+            resource_access access{resource_access::undefined};
+        };
+
+        struct resource final {
+            std::string_view name;
+
+            // Imported resources are owned outside of the graph and are observable after it, so passes
+            // writing them are never culled. Transient ones only live between their first and last use.
+            bool imported{false};
+
+            resource_access initial_access{resource_access::undefined};
+            resource_access final_access{resource_access::undefined};
+        };
+
+        struct pass final {
+            std::string_view name;
+            queue_type queue{queue_type::graphics};
+
+            // A pass with side effects (e.g. a readback) is kept even if nothing reads what it writes.
+            bool side_effects{false};
+
+            std::vector<resource_use> uses;
+
+            std::function<void()> execute;
+        };
+
+        std::uint32_t create_resource(std::string_view name)
+        {
+            resources_.push_back(resource{name});
+
+            return static_cast<std::uint32_t>(std::size(resources_) - 1);
+        }
+
+        std::uint32_t import_resource(std::string_view name, resource_access initial_access, resource_access final_access)
+        {
+            resources_.push_back(resource{name, true, initial_access, final_access});
+
+            return static_cast<std::uint32_t>(std::size(resources_) - 1);
+        }
+
+        std::uint32_t add_pass(std::string_view name, queue_type queue, std::function<void()> execute = { })
+        {
+            passes_.push_back(pass{name, queue, false, { }, std::move(execute)});
+
+            return static_cast<std::uint32_t>(std::size(passes_) - 1);
+        }
+
+        void read(std::uint32_t pass, std::uint32_t resource, resource_access access)
+        {
+            if ((access & kWRITE_RESOURCE_ACCESS) != resource_access::undefined)
+                throw std::invalid_argument("render graph read with a write access");
+
+            use(pass, resource, access);
+        }
+
+        void write(std::uint32_t pass, std::uint32_t resource, resource_access access)
+        {
+            if ((access & kWRITE_RESOURCE_ACCESS) == resource_access::undefined)
+                throw std::invalid_argument("render graph write without a write access");
+
+            use(pass, resource, access);
+        }
+
+        void set_side_effects(std::uint32_t pass) { passes_.at(pass).side_effects = true; }
+
+        void clear()
+        {
+            resources_.clear();
+            passes_.clear();
+        }
+
+        std::span<resource const> resources() const noexcept { return resources_; }
+
+        std::span<pass const> passes() const noexcept { return passes_; }
+
+    private:
+
+        std::vector<resource> resources_;
+        std::vector<pass> passes_;
+
+        void use(std::uint32_t pass, std::uint32_t resource, resource_access access)
+        {
+            if (resource >= std::size(resources_))
+                throw std::out_of_range("invalid render graph resource");
+
+            auto &&uses = passes_.at(pass).uses;
+
+            // Several uses of a resource within a pass are merged into one combined access.
+            auto it = std::find_if(std::begin(uses), std::end(uses), [resource] (auto &&use) { return use.resource == resource; });
+
+            if (it != std::end(uses))
+                it->access = it->access | access;
+
+            else uses.push_back(resource_use{resource, access});
+        }
+    };
+
+    struct render_graph_barrier final {
+        std::uint32_t resource{kINVALID_RENDER_GRAPH_INDEX};
+
+        // Equal accesses stand for an unordered access barrier between two passes writing the resource.
+        resource_access before{resource_access::undefined};
+        resource_access after{resource_access::undefined};
+    };
+
+    // Positions within the execution order of the first and the last pass that use a transient resource.
+    struct render_graph_lifetime final {
+        std::uint32_t first{kINVALID_RENDER_GRAPH_INDEX};
+        std::uint32_t last{kINVALID_RENDER_GRAPH_INDEX};
+
+        constexpr bool operator== (render_graph_lifetime const &) const = default;
+    };
+
+    // Consecutive passes of the execution order that go to the same queue.
+    struct render_graph_batch final {
+        queue_type queue{queue_type::graphics};
+
+        std::uint32_t first{0}, last{0};
+
+        // For every queue, the latest batch of it this one has to wait for.
+        std::array<std::uint32_t, static_cast<std::size_t>(queue_type::count)> waits;
+    };
+
+    struct compiled_render_graph final {
+        // Indices of the passes that survived culling, in execution order.
+        std::vector<std::uint32_t> order;
+
+        // The barriers of the pass at position 'i' are [barrier_offsets[i], barrier_offsets[i + 1]),
+        // the remaining ones bring imported resources into their final access.
+        std::vector<std::uint32_t> barrier_offsets;
+        std::vector<render_graph_barrier> barriers;
+
+        std::vector<render_graph_lifetime> lifetimes;
+        std::vector<render_graph_batch> batches;
+
+        std::uint32_t culled_pass_count{0};
+
+        std::span<render_graph_barrier const> barriers_before(std::uint32_t position) const
+        {
+            return std::span{barriers}.subspan(barrier_offsets[position], barrier_offsets[position + 1] - barrier_offsets[position]);
+        }
+
+        std::span<render_graph_barrier const> final_barriers() const
+        {
+            return std::span{barriers}.subspan(barrier_offsets.back());
+        }
+    };
+
+    // Culls the passes that don't contribute to imported resources or side effects, orders the rest,
+    // derives the barriers, the lifetimes of transient resources and the queue batches. Compilation is skipped
+    // when the topology of the graph is the same as the one of the previous call.
+    class render_graph_compiler final {
+    public:
+
+        compiled_render_graph const &compile(render_graph const &graph)
+        {
+            build_topology_key(graph);
+
+            if (compiled_once_ && key_ == cached_key_)
+                return compiled_;
+
+            std::swap(key_, cached_key_);
+
+            compile_graph(graph);
+
+            compiled_once_ = true;
+            ++compilation_count_;
+
+            return compiled_;
+        }
+
+        std::uint64_t compilation_count() const noexcept { return compilation_count_; }
+
+    private:
+
+        // Read after write and write after write edges carry data, write after read edges only order.
+        struct edge final {
+            std::uint32_t from, to;
+            bool data;
+        };
+
+        compiled_render_graph compiled_;
+        bool compiled_once_{false};
+
+        std::uint64_t compilation_count_{0};
+
+        std::vector<std::uint32_t> key_, cached_key_;
+
+        // Scratch storage that is kept between compilations.
+        std::vector<edge> edges_;
+        std::vector<std::uint32_t> predecessor_offsets_, predecessors_;
+        std::vector<std::uint32_t> last_writers_, reader_offsets_;
+        std::vector<std::uint32_t> readers_;
+        std::vector<std::uint32_t> successors_, successor_cursor_;
+        std::vector<std::uint32_t> pending_predecessors_, positions_, batch_of_;
+        std::vector<bool> alive_;
+        std::vector<resource_access> accesses_;
+
+        void build_topology_key(render_graph const &graph)
+        {
+            key_.clear();
+
+            key_.push_back(static_cast<std::uint32_t>(std::size(graph.resources())));
+
+            for (auto &&resource : graph.resources()) {
+                key_.push_back(resource.imported ? 1u : 0u);
+                key_.push_back(static_cast<std::uint32_t>(resource.initial_access));
+                key_.push_back(static_cast<std::uint32_t>(resource.final_access));
+            }
+
+            key_.push_back(static_cast<std::uint32_t>(std::size(graph.passes())));
+
+            for (auto &&pass : graph.passes()) {
+                key_.push_back(static_cast<std::uint32_t>(pass.queue) | (pass.side_effects ? 0x100u : 0u));
+                key_.push_back(static_cast<std::uint32_t>(std::size(pass.uses)));
+
+                for (auto &&use : pass.uses) {
+                    key_.push_back(use.resource);
+                    key_.push_back(static_cast<std::uint32_t>(use.access));
+                }
+            }
+        }
+
+        static bool is_write(resource_access access) noexcept
+        {
+            return (access & kWRITE_RESOURCE_ACCESS) != resource_access::undefined;
+        }
+
+        void compile_graph(render_graph const &graph)
+        {
+            auto const passes = graph.passes();
+            auto const resources = graph.resources();
+
+            auto const pass_count = static_cast<std::uint32_t>(std::size(passes));
+            auto const resource_count = static_cast<std::uint32_t>(std::size(resources));
+
+            collect_edges(passes, resource_count);
+            cull(passes, resources);
+            order(passes);
+
+            compiled_.culled_pass_count = pass_count - static_cast<std::uint32_t>(std::size(compiled_.order));
+
+            derive_barriers(passes, resources);
+            derive_lifetimes(passes, resources);
+            derive_batches(passes);
+        }
+
+        // Dependencies follow the declaration order: a use depends on the latest earlier write of the resource,
+        // and a write also on the reads since that write.
+        void collect_edges(std::span<render_graph::pass const> passes, std::uint32_t resource_count)
+        {
+            auto const pass_count = static_cast<std::uint32_t>(std::size(passes));
+
+            edges_.clear();
+
+            last_writers_.assign(resource_count, kINVALID_RENDER_GRAPH_INDEX);
+
+            // Readers since the last write of every resource, kept as per-resource lists threaded through 'readers_'.
+            reader_offsets_.assign(resource_count, kINVALID_RENDER_GRAPH_INDEX);
+            readers_.clear();
+
+            for (auto index = 0u; index < pass_count; ++index) {
+                for (auto &&[resource, access] : passes[index].uses) {
+                    if (auto const writer = last_writers_[resource]; writer != kINVALID_RENDER_GRAPH_INDEX && writer != index)
+                        edges_.push_back(edge{writer, index, true});
+
+                    if (!is_write(access)) {
+                        readers_.push_back(index);
+                        readers_.push_back(reader_offsets_[resource]);
+
+                        reader_offsets_[resource] = static_cast<std::uint32_t>(std::size(readers_) - 2);
+
+                        continue;
+                    }
+
+                    for (auto node = reader_offsets_[resource]; node != kINVALID_RENDER_GRAPH_INDEX; node = readers_[node + 1]) {
+                        if (readers_[node] != index)
+                            edges_.push_back(edge{readers_[node], index, false});
+                    }
+
+                    reader_offsets_[resource] = kINVALID_RENDER_GRAPH_INDEX;
+                    last_writers_[resource] = index;
+                }
+            }
+
+            // Predecessor lists in compressed form.
+            predecessor_offsets_.assign(pass_count + 1, 0);
+
+            for (auto &&edge : edges_)
+                ++predecessor_offsets_[edge.to + 1];
+
+            for (auto index = 0u; index < pass_count; ++index)
+                predecessor_offsets_[index + 1] += predecessor_offsets_[index];
+
+            predecessors_.resize(std::size(edges_));
+            positions_.assign(std::begin(predecessor_offsets_), std::end(predecessor_offsets_) - 1);
+
+            // The data flag is kept in the top bit.
+            for (auto &&edge : edges_)
+                predecessors_[positions_[edge.to]++] = edge.from | (edge.data ? 0x80000000u : 0u);
+        }
+
+        void cull(std::span<render_graph::pass const> passes, std::span<render_graph::resource const> resources)
+        {
+            auto const pass_count = static_cast<std::uint32_t>(std::size(passes));
+
+            alive_.assign(pass_count, false);
+
+            // Passes are visited from the last one, so every data predecessor is visited after its consumers.
+            for (auto index = pass_count; index-- > 0;) {
+                auto &&pass = passes[index];
+
+                if (!alive_[index]) {
+                    alive_[index] = pass.side_effects || std::any_of(std::begin(pass.uses), std::end(pass.uses), [resources] (auto &&use)
+                    {
+                        return is_write(use.access) && resources[use.resource].imported;
+                    });
+                }
+
+                if (!alive_[index])
+                    continue;
+
+                for (auto edge = predecessor_offsets_[index]; edge < predecessor_offsets_[index + 1]; ++edge) {
+                    if ((predecessors_[edge] & 0x80000000u) != 0)
+                        alive_[predecessors_[edge] & 0x7fffffffu] = true;
+                }
+            }
+        }
+
+        // Kahn's algorithm that keeps to the current queue while it has ready passes to limit queue switches,
+        // and otherwise falls back to the declaration order.
+        void order(std::span<render_graph::pass const> passes)
+        {
+            auto const pass_count = static_cast<std::uint32_t>(std::size(passes));
+
+            using ready_queue = std::priority_queue<std::uint32_t, std::vector<std::uint32_t>, std::greater<>>;
+
+            std::array<ready_queue, static_cast<std::size_t>(queue_type::count)> ready;
+
+            pending_predecessors_.assign(pass_count, 0);
+
+            for (auto &&edge : edges_) {
+                if (alive_[edge.from] && alive_[edge.to])
+                    ++pending_predecessors_[edge.to];
+            }
+
+            // Successor lists in compressed form.
+            positions_.assign(pass_count + 1, 0);
+
+            for (auto &&edge : edges_)
+                ++positions_[edge.from + 1];
+
+            for (auto index = 0u; index < pass_count; ++index)
+                positions_[index + 1] += positions_[index];
+
+            successors_.resize(std::size(edges_));
+            successor_cursor_.assign(std::begin(positions_), std::end(positions_) - 1);
+
+            for (auto &&edge : edges_)
+                successors_[successor_cursor_[edge.from]++] = edge.to;
+
+            for (auto index = 0u; index < pass_count; ++index) {
+                if (alive_[index] && pending_predecessors_[index] == 0)
+                    ready[static_cast<std::size_t>(passes[index].queue)].push(index);
+            }
+
+            compiled_.order.clear();
+
+            auto current = static_cast<std::size_t>(queue_type::graphics);
+
+            while (true) {
+                if (ready[current].empty()) {
+                    auto next = std::size(ready);
+
+                    for (auto queue = 0u; queue < std::size(ready); ++queue) {
+                        if (!ready[queue].empty() && (next == std::size(ready) || ready[queue].top() < ready[next].top()))
+                            next = queue;
+                    }
+
+                    if (next == std::size(ready))
+                        break;
+
+                    current = next;
+                }
+
+                auto const index = ready[current].top();
+                ready[current].pop();
+
+                compiled_.order.push_back(index);
+
+                for (auto edge = positions_[index]; edge < positions_[index + 1]; ++edge) {
+                    auto const successor = successors_[edge];
+
+                    if (alive_[successor] && --pending_predecessors_[successor] == 0)
+                        ready[static_cast<std::size_t>(passes[successor].queue)].push(successor);
+                }
+            }
+        }
+
+        void derive_barriers(std::span<render_graph::pass const> passes, std::span<render_graph::resource const> resources)
+        {
+            accesses_.resize(std::size(resources));
+
+            std::transform(std::begin(resources), std::end(resources), std::begin(accesses_), [] (auto &&resource)
+            {
+                return resource.initial_access;
+            });
+
+            compiled_.barriers.clear();
+            compiled_.barrier_offsets.clear();
+
+            for (auto index : compiled_.order) {
+                compiled_.barrier_offsets.push_back(static_cast<std::uint32_t>(std::size(compiled_.barriers)));
+
+                for (auto &&[resource, access] : passes[index].uses) {
+                    auto &&current = accesses_[resource];
+
+                    auto const unordered_access = current == resource_access::unordered_access && access == resource_access::unordered_access;
+
+                    if (current != access || unordered_access)
+                        compiled_.barriers.push_back(render_graph_barrier{resource, current, access});
+
+                    current = access;
+                }
+            }
+
+            compiled_.barrier_offsets.push_back(static_cast<std::uint32_t>(std::size(compiled_.barriers)));
+
+            for (auto resource = 0u; resource < std::size(resources); ++resource) {
+                auto &&description = resources[resource];
+
+                if (description.imported && description.final_access != resource_access::undefined && accesses_[resource] != description.final_access)
+                    compiled_.barriers.push_back(render_graph_barrier{resource, accesses_[resource], description.final_access});
+            }
+        }
+
+        void derive_lifetimes(std::span<render_graph::pass const> passes, std::span<render_graph::resource const> resources)
+        {
+            compiled_.lifetimes.assign(std::size(resources), render_graph_lifetime{});
+
+            for (auto position = 0u; position < std::size(compiled_.order); ++position) {
+                for (auto &&use : passes[compiled_.order[position]].uses) {
+                    if (resources[use.resource].imported)
+                        continue;
+
+                    auto &&lifetime = compiled_.lifetimes[use.resource];
+
+                    if (lifetime.first == kINVALID_RENDER_GRAPH_INDEX)
+                        lifetime.first = position;
+
+                    lifetime.last = position;
+                }
+            }
+        }
+
+        void derive_batches(std::span<render_graph::pass const> passes)
+        {
+            compiled_.batches.clear();
+
+            batch_of_.assign(std::size(passes), kINVALID_RENDER_GRAPH_INDEX);
+
+            for (auto position = 0u; position < std::size(compiled_.order); ++position) {
+                auto const index = compiled_.order[position];
+                auto const queue = passes[index].queue;
+
+                if (compiled_.batches.empty() || compiled_.batches.back().queue != queue) {
+                    render_graph_batch batch{queue, position, position, { }};
+                    batch.waits.fill(kINVALID_RENDER_GRAPH_INDEX);
+
+                    compiled_.batches.push_back(batch);
+                }
+
+                auto &&batch = compiled_.batches.back();
+                auto const batch_index = static_cast<std::uint32_t>(std::size(compiled_.batches) - 1);
+
+                batch.last = position + 1;
+                batch_of_[index] = batch_index;
+
+                for (auto edge = predecessor_offsets_[index]; edge < predecessor_offsets_[index + 1]; ++edge) {
+                    auto const predecessor = predecessors_[edge] & 0x7fffffffu;
+
+                    if (!alive_[predecessor] || batch_of_[predecessor] == batch_index)
+                        continue;
+
+                    auto const predecessor_queue = static_cast<std::size_t>(passes[predecessor].queue);
+
+                    // Work on the same queue is ordered by submission anyway.
+                    if (predecessor_queue == static_cast<std::size_t>(queue))
+                        continue;
+
+                    auto &&wait = batch.waits[predecessor_queue];
+
+                    if (wait == kINVALID_RENDER_GRAPH_INDEX || wait < batch_of_[predecessor])
+                        wait = batch_of_[predecessor];
+                }
+            }
+        }
+    };
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "main.hxx"
+#include "graphics/frame.hxx"
+#include "graphics/render_graph.hxx"
+#include "graphics/resource_state.hxx"
+#include "graphics/transient.hxx"
+
+
+D3D12_RESOURCE_STATES resource_state_of(graphics::resource_access access) noexcept
+{
+    using graphics::resource_access;
+
+    auto constexpr states = std::array{
+        std::pair{resource_access::vertex_buffer, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER},
+        std::pair{resource_access::index_buffer, D3D12_RESOURCE_STATE_INDEX_BUFFER},
+        std::pair{resource_access::constant_buffer, D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER},
+        std::pair{resource_access::indirect_argument, D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT},
+        std::pair{resource_access::shader_read, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE},
+        std::pair{resource_access::depth_read, D3D12_RESOURCE_STATE_DEPTH_READ},
+        std::pair{resource_access::copy_source, D3D12_RESOURCE_STATE_COPY_SOURCE},
+        std::pair{resource_access::present, D3D12_RESOURCE_STATE_PRESENT},
+        std::pair{resource_access::render_target, D3D12_RESOURCE_STATE_RENDER_TARGET},
+        std::pair{resource_access::depth_write, D3D12_RESOURCE_STATE_DEPTH_WRITE},
+        std::pair{resource_access::unordered_access, D3D12_RESOURCE_STATE_UNORDERED_ACCESS},
+        std::pair{resource_access::copy_dest, D3D12_RESOURCE_STATE_COPY_DEST}
+    };
+
+    auto state = D3D12_RESOURCE_STATE_COMMON;
+
+    for (auto [bit, bit_state] : states) {
+        if ((access & bit) != resource_access::undefined)
+            state = state | bit_state;
+    }
+
+    return state;
+}
+
+// Records the compiled passes into the frame's command lists; 'resources' maps graph resources to D3D ones.
+// The compiled barriers only say which state a pass needs, the state tracker knows the state a resource is in.
+// The transient resources have to be laid out for the lifetimes of 'compiled'; a pass that is the first to use
+// memory another transient resource used before is preceded by the aliasing barrier that hands it over.
+void execute_render_graph(graphics::render_graph const &graph, graphics::compiled_render_graph const &compiled,
+                          graphics::frame_context &frame, std::span<ID3D12Resource *const> resources,
+                          graphics::transient_resource_pool const &transient_resources)
+{
+    auto &&state_tracker = frame.state_tracker;
+
+    auto const transition = [&] (graphics::render_graph_barrier const &barrier)
+    {
+        auto const resource = resources[barrier.resource];
+
+        if (resource == nullptr)
+            return;
+
+        if (barrier.before == barrier.after)
+            state_tracker.uav_barrier(resource);
+
+        else state_tracker.transition(resource, resource_state_of(barrier.after));
+    };
+
+    for (auto position = 0u; position < std::size(compiled.order); ++position) {
+        state_tracker.aliasing_barriers(transient_resources.aliasing_barriers(position));
+
+        for (auto &&barrier : compiled.barriers_before(position))
+            transition(barrier);
+
+        // A pass may split the frame's current list by recording in parallel.
+        state_tracker.flush(frame.current_command_list);
+
+        if (auto &&execute = graph.passes()[compiled.order[position]].execute; execute)
+            execute();
+    }
+
+    for (auto &&barrier : compiled.final_barriers())
+        transition(barrier);
+
+    state_tracker.flush(frame.current_command_list);
+}
@@ -0,0 +1,214 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <vector>
+
+#include "graphics/backend.hxx"
+#include "graphics/render_graph.hxx"
+
+
+namespace graphics::backend
+{
+    struct render_graph_submission_statistics final {
+        std::uint64_t frames{0};
+        std::uint64_t command_lists{0};
+        std::uint64_t barriers{0};
+        std::uint64_t queue_waits{0};
+
+        // Frames that had to wait for the GPU to finish an earlier frame before reusing its command lists.
+        std::uint64_t blocked_frames{0};
+    };
+
+    // Records a compiled render graph through a backend and submits it: a command list per batch, the barriers
+    // of a pass in one call before it, and a queue wait for every batch of another queue a batch depends on. Every
+    // queue has a fence signaled after each of its batches. Each of the frames in flight owns its command lists,
+    // which are reused once the GPU is done with that frame. Passes record into command_list().
+    class render_graph_submitter final {
+    public:
+
+        render_graph_submitter(device_interface &device, std::uint32_t frame_count) : device_{device}, frames_(frame_count)
+        {
+            if (frame_count == 0)
+                throw std::invalid_argument("at least one frame has to be in flight");
+
+            for (auto index = 0u; index < kQUEUE_NUMBER; ++index) {
+                queues_[index] = device.create_queue(static_cast<queue_type>(index));
+                fences_[index] = device.create_fence(0);
+            }
+        }
+
+        render_graph_submitter(render_graph_submitter const &) = delete;
+        render_graph_submitter &operator=(render_graph_submitter const &) = delete;
+
+        queue_interface &queue(queue_type type) const noexcept { return *queues_[index_of(type)]; }
+
+        fence_interface &fence(queue_type type) const noexcept { return *fences_[index_of(type)]; }
+
+        // The list the executing pass records into.
+        command_list_interface &command_list() const
+        {
+            if (current_ == nullptr)
+                throw std::logic_error("no pass is being recorded");
+
+            return *current_;
+        }
+
+        // 'resources' maps graph resources to backend ones; null entries get no barriers.
+        void submit(render_graph const &graph, compiled_render_graph const &compiled, std::span<resource_interface *const> resources)
+        {
+            auto &&frame = frames_[frame_index_];
+
+            begin_frame(frame);
+
+            batch_values_.assign(std::size(compiled.batches), 0);
+
+            for (std::uint32_t batch_index = 0; batch_index < std::size(compiled.batches); ++batch_index) {
+                auto &&batch = compiled.batches[batch_index];
+                auto const queue_index = index_of(batch.queue);
+
+                current_ = &acquire_command_list(frame, batch.queue);
+
+                for (auto position = batch.first; position < batch.last; ++position) {
+                    record_barriers(compiled.barriers_before(position), resources);
+
+                    if (auto &&execute = graph.passes()[compiled.order[position]].execute; execute)
+                        execute();
+                }
+
+                if (batch_index + 1 == std::size(compiled.batches))
+                    record_barriers(compiled.final_barriers(), resources);
+
+                current_->close();
+
+                for (auto queue = 0u; queue < kQUEUE_NUMBER; ++queue) {
+                    auto const wait = batch.waits[queue];
+
+                    if (wait == kINVALID_RENDER_GRAPH_INDEX || queue == queue_index)
+                        continue;
+
+                    queues_[queue_index]->wait(*fences_[queue], batch_values_[wait]);
+                    ++statistics_.queue_waits;
+                }
+
+                command_list_interface *const lists[] = {current_};
+                queues_[queue_index]->execute(lists);
+
+                batch_values_[batch_index] = ++fence_values_[queue_index];
+                queues_[queue_index]->signal(*fences_[queue_index], fence_values_[queue_index]);
+
+                frame.fence_values[queue_index] = fence_values_[queue_index];
+
+                ++statistics_.command_lists;
+            }
+
+            current_ = nullptr;
+
+            ++statistics_.frames;
+            frame_index_ = (frame_index_ + 1) % static_cast<std::uint32_t>(std::size(frames_));
+        }
+
+        // Blocks until the GPU has finished everything submitted.
+        void flush()
+        {
+            for (auto index = 0u; index < kQUEUE_NUMBER; ++index)
+                fences_[index]->wait(fence_values_[index]);
+        }
+
+        render_graph_submission_statistics const &statistics() const noexcept { return statistics_; }
+
+    private:
+
+        static auto constexpr kQUEUE_NUMBER = static_cast<std::size_t>(queue_type::count);
+
+        struct frame final {
+            // Per queue, the lists created so far and how many of them the frame uses.
+            std::array<std::vector<std::unique_ptr<command_list_interface>>, kQUEUE_NUMBER> command_lists;
+            std::array<std::size_t, kQUEUE_NUMBER> used{ };
+
+            // The values the queues signaled after the frame's last batches.
+            std::array<std::uint64_t, kQUEUE_NUMBER> fence_values{ };
+        };
+
+        device_interface &device_;
+
+        std::array<std::unique_ptr<queue_interface>, kQUEUE_NUMBER> queues_;
+        std::array<std::unique_ptr<fence_interface>, kQUEUE_NUMBER> fences_;
+        std::array<std::uint64_t, kQUEUE_NUMBER> fence_values_{ };
+
+        std::vector<frame> frames_;
+        std::uint32_t frame_index_{0};
+
+        command_list_interface *current_{nullptr};
+
+        std::vector<std::uint64_t> batch_values_;
+        std::vector<resource_barrier> barriers_;
+
+        render_graph_submission_statistics statistics_;
+
+        static std::size_t index_of(queue_type type) noexcept { return static_cast<std::size_t>(type); }
+
+        void begin_frame(frame &frame)
+        {
+            auto blocked = false;
+
+            for (auto index = 0u; index < kQUEUE_NUMBER; ++index) {
+                if (fences_[index]->completed_value() >= frame.fence_values[index])
+                    continue;
+
+                fences_[index]->wait(frame.fence_values[index]);
+                blocked = true;
+            }
+
+            if (blocked)
+                ++statistics_.blocked_frames;
+
+            frame.used.fill(0);
+        }
+
+        command_list_interface &acquire_command_list(frame &frame, queue_type type)
+        {
+            auto const index = index_of(type);
+
+            auto &&lists = frame.command_lists[index];
+            auto const position = frame.used[index]++;
+
+            // New lists are created open, the others were closed when they were submitted.
+            if (position == std::size(lists)) {
+                lists.push_back(device_.create_command_list(type));
+                return *lists.back();
+            }
+
+            lists[position]->reset();
+
+            return *lists[position];
+        }
+
+        void record_barriers(std::span<render_graph_barrier const> barriers, std::span<resource_interface *const> resources)
+        {
+            barriers_.clear();
+
+            for (auto &&barrier : barriers) {
+                auto const resource = resources[barrier.resource];
+
+                if (resource == nullptr)
+                    continue;
+
+                if (barrier.before == barrier.after)
+                    barriers_.push_back(resource_barrier{barrier_type::unordered_access, resource});
+
+                else barriers_.push_back(resource_barrier{barrier_type::transition, resource, nullptr, kALL_SUBRESOURCES, barrier.before, barrier.after});
+            }
+
+            if (barriers_.empty())
+                return;
+
+            current_->resource_barriers(barriers_);
+
+            statistics_.barriers += std::size(barriers_);
+        }
+    };
+}
@@ -0,0 +1,305 @@
+#pragma once
+
+#include <mutex>
+#include <unordered_map>
+
+#include "main.hxx"
+#include "utility/exception.hxx"
+
+
+namespace graphics
+{
+    auto constexpr kUNKNOWN_RESOURCE_STATE = static_cast<D3D12_RESOURCE_STATES>(-1);
+
+    // States that can be combined with each other and don't need a barrier between uses of the combined bits.
+    auto constexpr kREAD_ONLY_RESOURCE_STATES = D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER | D3D12_RESOURCE_STATE_INDEX_BUFFER |
+                                                D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE |
+                                                D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT | D3D12_RESOURCE_STATE_COPY_SOURCE |
+                                                D3D12_RESOURCE_STATE_DEPTH_READ;
+
+    // The state of every resource as of the last submitted command list.
+    // Command lists are recorded without knowing it; it is only consulted when they are submitted in queue order.
+    class resource_state_registry final {
+    public:
+
+        void register_resource(ID3D12Resource *const resource, std::uint32_t subresource_count, D3D12_RESOURCE_STATES state)
+        {
+            std::unique_lock lock{mutex_};
+
+            resources_.insert_or_assign(resource, entry{subresource_count, {state}});
+        }
+
+        void unregister_resource(ID3D12Resource *const resource)
+        {
+            std::unique_lock lock{mutex_};
+
+            resources_.erase(resource);
+        }
+
+        std::uint32_t subresource_count(ID3D12Resource *const resource) const
+        {
+            std::unique_lock lock{mutex_};
+
+            return find(resource).subresource_count;
+        }
+
+        D3D12_RESOURCE_STATES state(ID3D12Resource *const resource, UINT subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES) const
+        {
+            std::unique_lock lock{mutex_};
+
+            auto &&states = find(resource).states;
+
+            if (std::size(states) == 1)
+                return states.front();
+
+            if (subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES) {
+                auto const uniform = std::all_of(std::begin(states), std::end(states), [&states] (auto state) { return state == states.front(); });
+
+                return uniform ? states.front() : kUNKNOWN_RESOURCE_STATE;
+            }
+
+            return states.at(subresource);
+        }
+
+    private:
+
+        friend class resource_state_tracker;
+
+        struct entry final {
+            std::uint32_t subresource_count{1};
+
+            // A single element while all subresources share the state.
+            std::vector<D3D12_RESOURCE_STATES> states;
+        };
+
+        mutable std::mutex mutex_;
+
+        std::unordered_map<ID3D12Resource *, entry> resources_;
+
+        entry &find(ID3D12Resource *const resource)
+        {
+            if (auto it = resources_.find(resource); it != std::end(resources_))
+                return it->second;
+
+            throw dx::resource_state_error("the resource isn't registered for state tracking"s);
+        }
+
+        entry const &find(ID3D12Resource *const resource) const
+        {
+            return const_cast<resource_state_registry *>(this)->find(resource);
+        }
+    };
+
+    // Per command list view of resource states. Transitions are deduced from the state each resource
+    // (or subresource) was last used in within the list and are queued until flush(), so all barriers
+    // between two commands go out in a single ResourceBarrier call. A first use within the list doesn't know the
+    // state the resource will be in when the list executes; it is recorded and resolved by resolve() at submit time.
+    class resource_state_tracker final {
+    public:
+
+        resource_state_tracker() = default;
+
+        explicit resource_state_tracker(resource_state_registry &registry) : registry_{&registry} { }
+
+        void transition(ID3D12Resource *const resource, D3D12_RESOURCE_STATES state, UINT subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+        {
+            auto &&states = resources_[resource];
+
+            if (states.empty())
+                states.assign(1, kUNKNOWN_RESOURCE_STATE);
+
+            if (subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES) {
+                if (std::size(states) == 1)
+                    update(resource, states.front(), state, subresource);
+
+                else {
+                    for (auto index = 0u; index < std::size(states); ++index)
+                        update(resource, states[index], state, index);
+
+                    states.assign(1, state);
+                }
+
+                return;
+            }
+
+            if (std::size(states) == 1) {
+                if (auto const count = subresource_count(resource); count > 1)
+                    states.assign(count, states.front());
+            }
+
+            update(resource, states.at(std::size(states) == 1 ? 0 : subresource), state, subresource);
+        }
+
+        void uav_barrier(ID3D12Resource *const resource)
+        {
+            pending_barriers_.push_back(CD3DX12_RESOURCE_BARRIER::UAV(resource));
+        }
+
+        void aliasing_barriers(std::span<D3D12_RESOURCE_BARRIER const> barriers)
+        {
+            pending_barriers_.insert(std::end(pending_barriers_), std::begin(barriers), std::end(barriers));
+        }
+
+        std::size_t pending_barrier_number() const noexcept { return std::size(pending_barriers_); }
+
+        // Works with anything that records barriers the way ID3D12GraphicsCommandList does.
+        template<class T>
+        void flush(T *const command_list)
+        {
+            if (pending_barriers_.empty())
+                return;
+
+            command_list->ResourceBarrier(static_cast<UINT>(std::size(pending_barriers_)), std::data(pending_barriers_));
+
+            pending_barriers_.clear();
+        }
+
+        // Has to be called in submission order, right before the list is executed. Returns the barriers that
+        // bring the resources from their submitted states to the ones expected by the first uses within the list;
+        // they have to execute before the list. The final states of the list become the submitted states.
+        [[nodiscard]] std::vector<D3D12_RESOURCE_BARRIER> resolve()
+        {
+            std::vector<D3D12_RESOURCE_BARRIER> barriers;
+
+            std::unique_lock lock{registry_->mutex_};
+
+            for (auto &&[resource, subresource, state] : first_uses_) {
+                auto &&entry = registry_->find(resource);
+                auto &&submitted = entry.states;
+
+                if (subresource == D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES && std::size(submitted) > 1) {
+                    for (auto index = 0u; index < std::size(submitted); ++index) {
+                        if (submitted[index] != state)
+                            barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource, submitted[index], state, index));
+                    }
+
+                    continue;
+                }
+
+                auto const before = std::size(submitted) == 1 ? submitted.front() : submitted.at(subresource);
+
+                // The first use within the list assumes the exact state, so even a covering read state is transitioned.
+                if (before != state)
+                    barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource, before, state, subresource));
+            }
+
+            for (auto &&[resource, states] : resources_) {
+                auto &&submitted = registry_->find(resource).states;
+
+                if (std::size(states) == 1) {
+                    if (states.front() != kUNKNOWN_RESOURCE_STATE)
+                        submitted.assign(1, states.front());
+
+                    continue;
+                }
+
+                if (std::size(submitted) == 1)
+                    submitted.assign(std::size(states), submitted.front());
+
+                for (auto index = 0u; index < std::size(states); ++index) {
+                    if (states[index] != kUNKNOWN_RESOURCE_STATE)
+                        submitted[index] = states[index];
+                }
+
+                if (std::all_of(std::begin(submitted), std::end(submitted), [&submitted] (auto state) { return state == submitted.front(); }))
+                    submitted.resize(1);
+            }
+
+            return barriers;
+        }
+
+        // Forgets the states of the previous recording.
+        void reset()
+        {
+            resources_.clear();
+            first_uses_.clear();
+            pending_barriers_.clear();
+        }
+
+    private:
+
+        struct first_use final {
+            ID3D12Resource *resource;
+            UINT subresource;
+            D3D12_RESOURCE_STATES state;
+        };
+
+        resource_state_registry *registry_{nullptr};
+
+        // A single element while all subresources share the state.
+        std::unordered_map<ID3D12Resource *, std::vector<D3D12_RESOURCE_STATES>> resources_;
+
+        std::vector<first_use> first_uses_;
+        std::vector<D3D12_RESOURCE_BARRIER> pending_barriers_;
+
+        static bool is_transition_redundant(D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after) noexcept
+        {
+            if (before == after)
+                return true;
+
+            // A combined read state already covers any of its read bits.
+            return after != D3D12_RESOURCE_STATE_COMMON && (before & ~kREAD_ONLY_RESOURCE_STATES) == 0 && (before & after) == after;
+        }
+
+        std::uint32_t subresource_count(ID3D12Resource *const resource) const
+        {
+            if (registry_ == nullptr)
+                throw dx::resource_state_error("subresource transitions need a resource state registry"s);
+
+            return registry_->subresource_count(resource);
+        }
+
+        void update(ID3D12Resource *const resource, D3D12_RESOURCE_STATES &current, D3D12_RESOURCE_STATES state, UINT subresource)
+        {
+            if (current == kUNKNOWN_RESOURCE_STATE) {
+                first_uses_.push_back(first_use{resource, subresource, state});
+                current = state;
+
+                return;
+            }
+
+            if (is_transition_redundant(current, state))
+                return;
+
+            queue_transition(resource, current, state, subresource);
+
+            current = state;
+        }
+
+        // Nothing is recorded between pending barriers, so A->B followed by B->C collapses into A->C, and A->B->A into nothing.
+        void queue_transition(ID3D12Resource *const resource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after, UINT subresource)
+        {
+            // Only the latest barrier that refers to the resource can be merged with.
+            auto it = std::find_if(std::rbegin(pending_barriers_), std::rend(pending_barriers_), [resource] (auto &&barrier)
+            {
+                switch (barrier.Type) {
+                    case D3D12_RESOURCE_BARRIER_TYPE_TRANSITION:
+                        return barrier.Transition.pResource == resource;
+
+                    case D3D12_RESOURCE_BARRIER_TYPE_ALIASING:
+                        return barrier.Aliasing.pResourceBefore == resource || barrier.Aliasing.pResourceAfter == resource;
+
+                    case D3D12_RESOURCE_BARRIER_TYPE_UAV:
+                        return barrier.UAV.pResource == resource;
+
+                    default:
+                        return false;
+                }
+            });
+
+            auto const mergeable = it != std::rend(pending_barriers_) && it->Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION &&
+                                   it->Transition.Subresource == subresource && it->Transition.StateAfter == before;
+
+            if (mergeable) {
+                if (it->Transition.StateBefore == after)
+                    pending_barriers_.erase(std::next(it).base());
+
+                else it->Transition.StateAfter = after;
+
+                return;
+            }
+
+            pending_barriers_.push_back(CD3DX12_RESOURCE_BARRIER::Transition(resource, before, after, subresource));
+        }
+    };
+}
@@ -0,0 +1,714 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <istream>
+#include <iterator>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <random>
+#include <span>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include "utility/hash.hxx"
+#include "utility/deduplicating_map.hxx"
+#include "platform/job_system.hxx"
+
+
+namespace graphics
+{
+    struct shader_error : public std::runtime_error {
+        explicit shader_error(std::string const &what_arg) : std::runtime_error(what_arg) { }
+    };
+
+    struct shader_define final {
+        std::string name;
+        std::string value;
+    };
+
+    struct shader_request final {
+        std::filesystem::path source;
+        std::string entry_point;
+
+        // Shader model profile, e.g. "ps_6_6".
+        std::string target;
+
+        std::vector<shader_define> defines;
+    };
+
+    struct shader_binary final {
+        std::vector<std::byte> bytecode;
+        std::vector<std::byte> reflection;
+    };
+
+    // An #include directive as written; 'system' for the angle bracket form.
+    struct shader_include final {
+        std::string name;
+        bool system{false};
+    };
+
+    struct shader_source_file final {
+        std::filesystem::path path;
+
+        std::filesystem::file_time_type write_time;
+        std::uintmax_t size{0};
+
+        std::string text;
+        std::uint64_t hash{0};
+
+        std::vector<shader_include> includes;
+    };
+
+    // Include directives of HLSL source, skipping comments. Directives in inactive #if blocks are reported as well;
+    // an include too many costs at most a rebuild, an include missed would leave a stale shader.
+    std::vector<shader_include> scan_shader_includes(std::string_view text)
+    {
+        std::vector<shader_include> includes;
+
+        auto in_comment = false;
+
+        while (!text.empty()) {
+            auto const end = text.find('\n');
+            auto line = text.substr(0, end);
+
+            text.remove_prefix(end == std::string_view::npos ? std::size(text) : end + 1);
+
+            // Comments are blanked out, so a directive is recognized only at the start of what remains.
+            std::string code;
+
+            for (std::size_t index = 0; index < std::size(line); ) {
+                if (in_comment) {
+                    if (auto close = line.find("*/", index); close != std::string_view::npos) {
+                        in_comment = false;
+                        index = close + 2;
+                        code += ' ';
+                    }
+
+                    else break;
+                }
+
+                else if (line.substr(index, 2) == "//")
+                    break;
+
+                else if (line.substr(index, 2) == "/*") {
+                    in_comment = true;
+                    index += 2;
+                }
+
+                else code += line[index++];
+            }
+
+            std::string_view directive{code};
+
+            auto const skip_spaces = [&directive]
+            {
+                auto const first = directive.find_first_not_of(" \t\r");
+                directive.remove_prefix(first == std::string_view::npos ? std::size(directive) : first);
+            };
+
+            skip_spaces();
+
+            if (!directive.starts_with('#'))
+                continue;
+
+            directive.remove_prefix(1);
+            skip_spaces();
+
+            if (auto constexpr kINCLUDE = std::string_view{"include"}; directive.starts_with(kINCLUDE))
+                directive.remove_prefix(std::size(kINCLUDE));
+
+            else continue;
+
+            skip_spaces();
+
+            if (directive.empty() || (directive.front() != '"' && directive.front() != '<'))
+                continue;
+
+            auto const system = directive.front() == '<';
+            auto const close = directive.find(system ? '>' : '"', 1);
+
+            if (close == std::string_view::npos || close == 1)
+                continue;
+
+            includes.push_back(shader_include{std::string{directive.substr(1, close - 1)}, system});
+        }
+
+        return includes;
+    }
+
+    // Source files shared by all builds. A file is read again only once its size or modification time changed,
+    // so an incremental build re-reads just the edited files.
+    class shader_source_store final {
+    public:
+
+        struct statistics final {
+            std::uint64_t reads{0};
+            std::uint64_t reuses{0};
+        };
+
+        // nullptr if the file doesn't exist.
+        std::shared_ptr<shader_source_file const> load(std::filesystem::path const &path)
+        {
+            std::error_code error;
+
+            auto const write_time = std::filesystem::last_write_time(path, error);
+
+            if (error)
+                return nullptr;
+
+            auto const size = std::filesystem::file_size(path, error);
+
+            if (error)
+                return nullptr;
+
+            {
+                std::unique_lock lock{mutex_};
+
+                if (auto it = files_.find(path.native()); it != std::end(files_)) {
+                    if (it->second->write_time == write_time && it->second->size == size) {
+                        ++statistics_.reuses;
+                        return it->second;
+                    }
+                }
+            }
+
+            std::ifstream stream{path, std::ios::binary};
+
+            if (!stream)
+                return nullptr;
+
+            auto file = std::make_shared<shader_source_file>();
+
+            file->path = path;
+            file->write_time = write_time;
+            file->size = size;
+
+            file->text.assign(std::istreambuf_iterator<char>{stream}, std::istreambuf_iterator<char>{});
+            file->hash = utility::hash_bytes(std::as_bytes(std::span{file->text}));
+            file->includes = scan_shader_includes(file->text);
+
+            std::unique_lock lock{mutex_};
+
+            ++statistics_.reads;
+
+            files_.insert_or_assign(path.native(), file);
+
+            return file;
+        }
+
+        statistics counters() const
+        {
+            std::unique_lock lock{mutex_};
+
+            return statistics_;
+        }
+
+    private:
+
+        mutable std::mutex mutex_;
+
+        std::unordered_map<std::filesystem::path::string_type, std::shared_ptr<shader_source_file const>> files_;
+
+        statistics statistics_;
+    };
+
+    std::filesystem::path normalize_shader_path(std::filesystem::path const &path)
+    {
+        return std::filesystem::absolute(path).lexically_normal();
+    }
+
+    // Every file a shader is built from, the main source first. Compilers read includes from here instead of
+    // from disk, so they compile exactly the contents the cache key was computed from.
+    class shader_sources final {
+    public:
+
+        shader_source_file const &main() const noexcept { return *files_.front(); }
+
+        std::span<std::shared_ptr<shader_source_file const> const> files() const noexcept { return files_; }
+
+        // nullptr if the path isn't one of the files.
+        shader_source_file const *find(std::filesystem::path const &path) const
+        {
+            if (auto it = indices_.find(normalize_shader_path(path).native()); it != std::end(indices_))
+                return files_[it->second].get();
+
+            return nullptr;
+        }
+
+        // Hash of the files' contents and the include graph between them.
+        std::uint64_t hash() const noexcept { return hash_; }
+
+    private:
+
+        friend class shader_builder;
+
+        std::vector<std::shared_ptr<shader_source_file const>> files_;
+        std::unordered_map<std::filesystem::path::string_type, std::size_t> indices_;
+
+        std::uint64_t hash_{0};
+    };
+
+    // Stand-in for the actual compiler, so the build logic doesn't depend on it.
+    class shader_compiler_interface {
+    public:
+
+        virtual ~shader_compiler_interface() = default;
+
+        // The compiler version and its options. It is part of every cache key, so switching either rebuilds everything.
+        virtual std::string identity() const = 0;
+
+        // Throws shader_error with the diagnostics if the shader doesn't compile. Called from several threads at once.
+        virtual shader_binary compile(shader_request const &request, shader_sources const &sources) = 0;
+    };
+
+    // Layout of a cached shader file, little-endian:
+    //   header         magic, format version, key, bytecode size, reflection size, payload checksum
+    //   payload        bytecode followed by reflection data
+    namespace shader_cache_file
+    {
+        auto constexpr kMAGIC = 0x31434853u; // "SHC1"
+        auto constexpr kVERSION = 1u;
+
+        struct header final {
+            std::uint32_t magic{kMAGIC};
+            std::uint32_t version{kVERSION};
+
+            std::uint64_t key{0};
+
+            std::uint64_t bytecode_size{0};
+            std::uint64_t reflection_size{0};
+
+            std::uint64_t checksum{0};
+        };
+
+        static_assert(sizeof(header) == 40, "the file layout must not contain padding");
+    }
+
+    // Compiled shaders on disk, one file per cache key, named after it. Concurrent processes may share the directory:
+    // a file is written under a temporary name and then renamed into place.
+    class shader_cache final {
+    public:
+
+        explicit shader_cache(std::filesystem::path directory) : directory_{std::move(directory)}
+        {
+            std::error_code error;
+            std::filesystem::create_directories(directory_, error);
+        }
+
+        // std::nullopt if the shader isn't cached or its file is corrupted.
+        std::optional<shader_binary> find(std::uint64_t key) const
+        {
+            using namespace shader_cache_file;
+
+            auto const path = path_of(key);
+
+            std::ifstream stream{path, std::ios::binary};
+
+            if (!stream)
+                return std::nullopt;
+
+            header value;
+
+            if (!stream.read(reinterpret_cast<char *>(&value), sizeof(value)))
+                return std::nullopt;
+
+            if (value.magic != kMAGIC || value.version != kVERSION || value.key != key)
+                return std::nullopt;
+
+            // Also keeps corrupted sizes from turning into huge allocations.
+            std::error_code error;
+
+            auto const size = std::filesystem::file_size(path, error);
+
+            if (error || size < sizeof(value))
+                return std::nullopt;
+
+            auto const payload_size = size - sizeof(value);
+
+            if (value.bytecode_size > payload_size || value.reflection_size != payload_size - value.bytecode_size)
+                return std::nullopt;
+
+            std::vector<std::byte> payload(static_cast<std::size_t>(payload_size));
+
+            if (!stream.read(reinterpret_cast<char *>(std::data(payload)), static_cast<std::streamsize>(std::size(payload))))
+                return std::nullopt;
+
+            if (utility::hash_bytes(payload) != value.checksum)
+                return std::nullopt;
+
+            shader_binary binary;
+
+            auto const split = std::next(std::begin(payload), static_cast<std::ptrdiff_t>(value.bytecode_size));
+
+            binary.bytecode.assign(std::begin(payload), split);
+            binary.reflection.assign(split, std::end(payload));
+
+            return binary;
+        }
+
+        // Returns false if the file couldn't be written; the shader is then just compiled again next time.
+        bool store(std::uint64_t key, shader_binary const &binary) const noexcept
+        {
+            using namespace shader_cache_file;
+
+            header value;
+
+            value.key = key;
+            value.bytecode_size = std::size(binary.bytecode);
+            value.reflection_size = std::size(binary.reflection);
+
+            value.checksum = utility::hash_bytes(binary.reflection, utility::hash_bytes(binary.bytecode));
+
+            std::error_code error;
+
+            try {
+                auto const path = path_of(key);
+
+                // Thread ids repeat across processes, so the suffix is random.
+                thread_local std::mt19937_64 generator{std::random_device{}()};
+
+                auto temporary = path;
+                temporary.concat(".tmp" + std::to_string(generator()));
+
+                {
+                    std::ofstream stream{temporary, std::ios::binary | std::ios::trunc};
+
+                    stream.write(reinterpret_cast<char const *>(&value), sizeof(value));
+                    stream.write(reinterpret_cast<char const *>(std::data(binary.bytecode)), static_cast<std::streamsize>(std::size(binary.bytecode)));
+                    stream.write(reinterpret_cast<char const *>(std::data(binary.reflection)), static_cast<std::streamsize>(std::size(binary.reflection)));
+
+                    stream.close();
+
+                    // A short write, e.g. on a full disk, must not be renamed into place.
+                    if (!stream) {
+                        std::filesystem::remove(temporary, error);
+                        return false;
+                    }
+                }
+
+                if (std::filesystem::rename(temporary, path, error); error) {
+                    std::filesystem::remove(temporary, error);
+                    return false;
+                }
+
+            } catch (std::exception const &) {
+                return false;
+            }
+
+            return true;
+        }
+
+        std::filesystem::path path_of(std::uint64_t key) const
+        {
+            char name[17];
+
+            for (auto index = 0; index < 16; ++index)
+                name[index] = "0123456789abcdef"[(key >> (60 - index * 4)) & 0xf];
+
+            name[16] = '\0';
+
+            return directory_ / (std::string{name} + ".shader");
+        }
+
+    private:
+
+        std::filesystem::path directory_;
+    };
+
+    enum class shader_origin : std::uint8_t {
+        // Built before by this builder.
+        memory = 0,
+        disk,
+        compiler
+    };
+
+    struct shader_build_result final {
+        std::uint64_t key{0};
+        std::shared_ptr<shader_binary const> binary;
+
+        shader_origin origin{shader_origin::memory};
+
+        // Set instead of 'binary' for a shader of a batch that failed to build.
+        std::string error;
+    };
+
+    struct shader_build_statistics final {
+        std::uint64_t memory_hits{0};
+        std::uint64_t disk_hits{0};
+        std::uint64_t compiled{0};
+        std::uint64_t failed{0};
+
+        // Compiled shaders that couldn't be written to the disk cache.
+        std::uint64_t cache_write_failures{0};
+
+        // Source files read from disk, and those whose previous contents were still current.
+        std::uint64_t files_read{0};
+        std::uint64_t files_reused{0};
+    };
+
+    // Builds shaders through a content-addressed cache: the key hashes the compiler identity, entry point, target,
+    // defines and the contents of the source with all the files it includes, transitively. The include directories
+    // are searched after the including file's directory, like the compiler does.
+    class shader_builder final {
+    public:
+
+        shader_builder(shader_compiler_interface &compiler, shader_cache &cache, std::vector<std::filesystem::path> include_directories = { })
+            : compiler_{compiler}, cache_{cache}, compiler_identity_{compiler.identity()}
+        {
+            for (auto &&directory : include_directories)
+                include_directories_.push_back(normalize_shader_path(directory));
+        }
+
+        // Throws shader_error for missing sources and compile errors.
+        shader_build_result build(shader_request const &request)
+        {
+            auto const sources = scan(request);
+            auto const key = key_of(request, sources);
+
+            auto origin = shader_origin::memory;
+
+            std::shared_ptr<shader_binary const> binary;
+
+            try {
+                binary = binaries_.get_or_create(key, [&]
+                {
+                    if (auto binary = cache_.find(key); binary) {
+                        origin = shader_origin::disk;
+                        return std::make_shared<shader_binary const>(std::move(*binary));
+                    }
+
+                    auto binary = compiler_.compile(request, sources);
+
+                    if (!cache_.store(key, binary))
+                        count_cache_write_failure();
+
+                    origin = shader_origin::compiler;
+                    return std::make_shared<shader_binary const>(std::move(binary));
+                });
+
+            } catch (...) {
+                std::unique_lock lock{statistics_mutex_};
+
+                ++statistics_.failed;
+                throw;
+            }
+
+            count(origin);
+
+            return shader_build_result{key, std::move(binary), origin, { }};
+        }
+
+        // Builds all shaders in parallel, e.g. as an offline prebuild. A shader that fails to build is reported
+        // in its result instead of throwing. Has to be called from the job system's owner thread or from a job.
+        std::vector<shader_build_result> build(platform::job_system &jobs, std::span<shader_request const> requests)
+        {
+            std::vector<shader_build_result> results(std::size(requests));
+
+            jobs.parallel_for(static_cast<std::uint32_t>(std::size(requests)), 1, [&] (std::uint32_t begin, std::uint32_t end)
+            {
+                for (auto index = begin; index < end; ++index) {
+                    try {
+                        results[index] = build(requests[index]);
+
+                    } catch (std::exception const &exception) {
+                        results[index].error = exception.what();
+                    }
+                }
+            });
+
+            return results;
+        }
+
+        // The source and everything it includes; includes that can't be resolved are part of the hash as missing.
+        shader_sources scan(shader_request const &request)
+        {
+            shader_sources sources;
+
+            auto main = sources_.load(normalize_shader_path(request.source));
+
+            if (main == nullptr)
+                throw shader_error(std::string{"missing shader source "} + request.source.string());
+
+            utility::hasher hasher;
+
+            auto const add = [&sources] (std::shared_ptr<shader_source_file const> file)
+            {
+                sources.indices_.emplace(file->path.native(), std::size(sources.files_));
+                sources.files_.push_back(std::move(file));
+            };
+
+            add(std::move(main));
+
+            // Breadth-first in directive order, so the hash doesn't depend on anything but the contents.
+            for (std::size_t index = 0; index < std::size(sources.files_); ++index) {
+                auto const file = sources.files_[index];
+
+                hasher.add(file->hash);
+
+                for (auto &&include : file->includes) {
+                    hasher.add(std::string_view{include.name});
+
+                    auto resolved = resolve(*file, include);
+
+                    if (resolved == nullptr) {
+                        hasher.add(std::uint64_t{0});
+                        continue;
+                    }
+
+                    if (auto it = sources.indices_.find(resolved->path.native()); it != std::end(sources.indices_)) {
+                        hasher.add(static_cast<std::uint64_t>(it->second + 1));
+                        continue;
+                    }
+
+                    hasher.add(static_cast<std::uint64_t>(std::size(sources.files_) + 1));
+
+                    add(std::move(resolved));
+                }
+            }
+
+            sources.hash_ = hasher.value();
+
+            return sources;
+        }
+
+        std::uint64_t key_of(shader_request const &request, shader_sources const &sources) const
+        {
+            utility::hasher hasher;
+
+            hasher.add(std::string_view{compiler_identity_});
+            hasher.add(std::string_view{request.entry_point}).add(std::string_view{request.target});
+
+            hasher.add(static_cast<std::uint64_t>(std::size(request.defines)));
+
+            for (auto &&define : request.defines)
+                hasher.add(std::string_view{define.name}).add(std::string_view{define.value});
+
+            hasher.add(sources.hash());
+
+            return hasher.value();
+        }
+
+        std::span<std::filesystem::path const> include_directories() const noexcept { return include_directories_; }
+
+        shader_build_statistics statistics() const
+        {
+            std::unique_lock lock{statistics_mutex_};
+
+            auto statistics = statistics_;
+
+            auto const files = sources_.counters();
+
+            statistics.files_read = files.reads;
+            statistics.files_reused = files.reuses;
+
+            return statistics;
+        }
+
+    private:
+
+        shader_compiler_interface &compiler_;
+        shader_cache &cache_;
+
+        std::string compiler_identity_;
+        std::vector<std::filesystem::path> include_directories_;
+
+        shader_source_store sources_;
+        utility::deduplicating_map<std::shared_ptr<shader_binary const>> binaries_;
+
+        mutable std::mutex statistics_mutex_;
+        shader_build_statistics statistics_;
+
+        std::shared_ptr<shader_source_file const> resolve(shader_source_file const &includer, shader_include const &include)
+        {
+            if (!include.system) {
+                if (auto file = sources_.load((includer.path.parent_path() / include.name).lexically_normal()); file != nullptr)
+                    return file;
+            }
+
+            for (auto &&directory : include_directories_) {
+                if (auto file = sources_.load((directory / include.name).lexically_normal()); file != nullptr)
+                    return file;
+            }
+
+            return nullptr;
+        }
+
+        void count_cache_write_failure()
+        {
+            std::unique_lock lock{statistics_mutex_};
+
+            ++statistics_.cache_write_failures;
+        }
+
+        void count(shader_origin origin)
+        {
+            std::unique_lock lock{statistics_mutex_};
+
+            switch (origin) {
+                case shader_origin::memory:
+                    ++statistics_.memory_hits;
+                    break;
+
+                case shader_origin::disk:
+                    ++statistics_.disk_hits;
+                    break;
+
+                case shader_origin::compiler:
+                    ++statistics_.compiled;
+                    break;
+            }
+        }
+    };
+
+    // Shaders for an offline prebuild, one per line: source, entry point, target and any number of NAME or NAME=VALUE
+    // defines, separated by whitespace. Relative sources are relative to 'directory'; '#' starts a comment.
+    std::vector<shader_request> parse_shader_manifest(std::istream &stream, std::filesystem::path const &directory)
+    {
+        std::vector<shader_request> requests;
+
+        std::string line;
+
+        for (auto line_number = 1u; std::getline(stream, line); ++line_number) {
+            if (auto comment = line.find('#'); comment != std::string::npos)
+                line.erase(comment);
+
+            std::istringstream fields{line};
+
+            std::string source;
+
+            if (!(fields >> source))
+                continue;
+
+            shader_request request;
+
+            if (!(fields >> request.entry_point >> request.target))
+                throw shader_error("shader manifest line " + std::to_string(line_number) + " needs a source, an entry point and a target");
+
+            request.source = directory / source;
+
+            for (std::string define; fields >> define; ) {
+                auto const equals = define.find('=');
+
+                if (equals == std::string::npos)
+                    request.defines.push_back(shader_define{define, "1"});
+
+                else request.defines.push_back(shader_define{define.substr(0, equals), define.substr(equals + 1)});
+            }
+
+            requests.push_back(std::move(request));
+        }
+
+        return requests;
+    }
+}
@@ -0,0 +1,486 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <cstring>
+#include <deque>
+#include <exception>
+#include <mutex>
+#include <optional>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "main.hxx"
+#include "utility/exception.hxx"
+#include "graphics/command_pool.hxx"
+#include "graphics/memory.hxx"
+#include "graphics/queue.hxx"
+#include "graphics/upload.hxx"
+
+
+namespace graphics
+{
+    // Identifies an upload request; tokens increase in the order the requests were enqueued.
+    struct upload_token final {
+        std::uint64_t value{0};
+    };
+
+    struct texture_subresource_data final {
+        std::vector<std::byte> data;
+
+        UINT64 row_pitch{0};
+        UINT64 slice_pitch{0};
+    };
+
+    struct upload_service_statistics final {
+        std::uint64_t requests{0};
+        std::uint64_t batches{0};
+        std::uint64_t bytes{0};
+    };
+
+    // Uploads buffer and texture data in the background on the copy queue. A worker thread stages the queued
+    // requests through a ring of persistently mapped upload pages and records the copies of a batch on a single
+    // copy list. The render thread never waits: it polls a request's token, or makes its queue wait on the GPU
+    // for the fence of the batch that carried the request.
+    // Destinations have to be in the COMMON state; the copy queue promotes them to COPY_DEST and they decay back
+    // to COMMON once the batch has finished.
+    class upload_service final {
+    public:
+
+        static UINT64 constexpr kDEFAULT_PAGE_SIZE = 4ull << 20;
+
+        upload_service(ID3D12Device6 *const device, command_pool &command_pool, queue_scheduler &queues,
+                       UINT64 page_size = kDEFAULT_PAGE_SIZE, std::uint32_t page_count = 4, UINT64 batch_size = kDEFAULT_PAGE_SIZE)
+            : device_{device}, command_pool_{command_pool}, queues_{queues},
+              page_size_{align_up(page_size, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT)}, page_count_{(std::max)(page_count, 1u)},
+              batch_size_{(std::min)(batch_size, page_size_)}
+        {
+            worker_ = std::thread{[this] { work(); }};
+        }
+
+        ~upload_service()
+        {
+            {
+                std::unique_lock lock{mutex_};
+                stop_ = true;
+            }
+
+            pending_condition_.notify_one();
+            worker_.join();
+
+            // The pages can't be released while the copy queue still reads them.
+            queues_.timeline(queue_type::copy).wait(last_fence_value_);
+
+            for (auto &&page : pages_)
+                page.buffer->Unmap(0, nullptr);
+
+            for (auto &&page : dedicated_pages_)
+                page.buffer->Unmap(0, nullptr);
+        }
+
+        upload_service(upload_service const &) = delete;
+        upload_service &operator=(upload_service const &) = delete;
+
+        [[nodiscard]] upload_token upload_buffer(ID3D12Resource *const destination, UINT64 offset, std::vector<std::byte> data)
+        {
+            request buffer_request;
+
+            buffer_request.destination = destination;
+            buffer_request.offset = offset;
+            buffer_request.staging_size = static_cast<UINT64>(std::size(data));
+            buffer_request.alignment = 4;
+            buffer_request.data = std::move(data);
+
+            return enqueue(std::move(buffer_request));
+        }
+
+        [[nodiscard]] upload_token
+        upload_texture(ID3D12Resource *const destination, UINT first_subresource, std::vector<texture_subresource_data> subresources)
+        {
+            auto const count = static_cast<UINT>(std::size(subresources));
+            auto const description = destination->GetDesc();
+
+            request texture_request;
+
+            texture_request.destination = destination;
+            texture_request.first_subresource = first_subresource;
+            texture_request.subresources = std::move(subresources);
+            texture_request.footprints.resize(count);
+            texture_request.row_counts.resize(count);
+            texture_request.row_sizes.resize(count);
+            texture_request.alignment = D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT;
+
+            device_->GetCopyableFootprints(&description, first_subresource, count, 0, std::data(texture_request.footprints),
+                                           std::data(texture_request.row_counts), std::data(texture_request.row_sizes),
+                                           &texture_request.staging_size);
+
+            return enqueue(std::move(texture_request));
+        }
+
+        bool is_complete(upload_token token)
+        {
+            if (token.value <= completed_token_.load(std::memory_order_acquire))
+                return true;
+
+            std::unique_lock lock{mutex_};
+
+            reclaim_batches();
+
+            return token.value <= completed_token_.load(std::memory_order_relaxed);
+        }
+
+        // The copy queue fence that a queue has to wait for before it uses the request's destination,
+        // or nothing if the request hasn't been submitted yet.
+        std::optional<queue_fence> fence(upload_token token)
+        {
+            std::unique_lock lock{mutex_};
+
+            reclaim_batches();
+
+            if (token.value <= completed_token_.load(std::memory_order_relaxed))
+                return queue_fence{queue_type::copy, 0};
+
+            auto batch = std::find_if(std::begin(batches_), std::end(batches_), [token] (auto &&batch)
+            {
+                return token.value <= batch.last_token;
+            });
+
+            if (batch == std::end(batches_))
+                return std::nullopt;
+
+            return queue_fence{queue_type::copy, batch->fence_value};
+        }
+
+        // Blocks until everything enqueued so far has been copied.
+        void flush()
+        {
+            UINT64 fence_value = 0;
+
+            {
+                std::unique_lock lock{mutex_};
+
+                submitted_condition_.wait(lock, [this]
+                {
+                    return error_ != nullptr || submitted_token_ == last_token_;
+                });
+
+                rethrow_error();
+
+                fence_value = last_fence_value_;
+            }
+
+            queues_.timeline(queue_type::copy).wait(fence_value);
+        }
+
+        upload_service_statistics statistics() const
+        {
+            std::unique_lock lock{mutex_};
+
+            return statistics_;
+        }
+
+    private:
+
+        struct request final {
+            std::uint64_t token{0};
+
+            ID3D12Resource *destination{nullptr};
+
+            // Buffers.
+            UINT64 offset{0};
+            std::vector<std::byte> data;
+
+            // Textures.
+            UINT first_subresource{0};
+            std::vector<texture_subresource_data> subresources;
+
+            std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> footprints;
+            std::vector<UINT> row_counts;
+            std::vector<UINT64> row_sizes;
+
+            UINT64 staging_size{0};
+            UINT64 alignment{0};
+        };
+
+        struct staging_page final {
+            winrt::com_ptr<ID3D12Resource> buffer;
+            std::byte *cpu_start{nullptr};
+
+            UINT64 size{0};
+
+            // The copy queue fence value of the last batch that was staged in the page.
+            UINT64 fence_value{0};
+        };
+
+        struct submitted_batch final {
+            std::uint64_t last_token{0};
+            UINT64 fence_value{0};
+        };
+
+        ID3D12Device6 *device_;
+
+        command_pool &command_pool_;
+        queue_scheduler &queues_;
+
+        UINT64 page_size_;
+        std::uint32_t page_count_;
+        UINT64 batch_size_;
+
+        mutable std::mutex mutex_;
+
+        std::condition_variable pending_condition_;
+        std::condition_variable submitted_condition_;
+
+        std::deque<request> pending_;
+        std::deque<submitted_batch> batches_;
+
+        std::uint64_t last_token_{0};
+        std::uint64_t submitted_token_{0};
+        std::atomic<std::uint64_t> completed_token_{0};
+
+        UINT64 last_fence_value_{0};
+
+        upload_service_statistics statistics_;
+
+        std::exception_ptr error_;
+        bool stop_{false};
+
+        // Only touched by the worker. The oldest page of the ring is at the front, batches are staged
+        // one after another in the newest one.
+        std::deque<staging_page> pages_;
+        std::vector<staging_page> dedicated_pages_;
+
+        UINT64 page_head_{0};
+
+        std::thread worker_;
+
+        upload_token enqueue(request &&value)
+        {
+            upload_token token;
+
+            {
+                std::unique_lock lock{mutex_};
+
+                rethrow_error();
+
+                token.value = value.token = ++last_token_;
+
+                pending_.push_back(std::move(value));
+            }
+
+            pending_condition_.notify_one();
+
+            return token;
+        }
+
+        void rethrow_error()
+        {
+            if (error_ != nullptr)
+                std::rethrow_exception(error_);
+        }
+
+        // Has to be called with the lock held.
+        void reclaim_batches()
+        {
+            auto &&timeline = queues_.timeline(queue_type::copy);
+
+            while (!batches_.empty() && timeline.is_complete(batches_.front().fence_value)) {
+                completed_token_.store(batches_.front().last_token, std::memory_order_release);
+                batches_.pop_front();
+            }
+        }
+
+        static std::byte *map(ID3D12Resource *const buffer)
+        {
+            D3D12_RANGE const read_range{0, 0};
+
+            void *data = nullptr;
+
+            if (auto result = buffer->Map(0, &read_range, &data); FAILED(result))
+                throw dx::device_error(fmt::format("failed to map a staging page: {0:#x}"s, result));
+
+            return static_cast<std::byte *>(data);
+        }
+
+        staging_page create_page(UINT64 size)
+        {
+            auto buffer = create_upload_buffer(device_, size);
+
+            return staging_page{buffer, map(buffer.get()), size};
+        }
+
+        // Returns the page and the offset where a batch of the size is staged. Batches that don't fit into a page
+        // of the ring get a page of their own that is released once the batch has finished.
+        std::pair<staging_page *, UINT64> allocate_staging(UINT64 size)
+        {
+            auto &&timeline = queues_.timeline(queue_type::copy);
+
+            auto it = std::remove_if(std::begin(dedicated_pages_), std::end(dedicated_pages_), [&timeline] (auto &&page)
+            {
+                if (!timeline.is_complete(page.fence_value))
+                    return false;
+
+                page.buffer->Unmap(0, nullptr);
+
+                return true;
+            });
+
+            dedicated_pages_.erase(it, std::end(dedicated_pages_));
+
+            if (size > page_size_)
+                return {&dedicated_pages_.emplace_back(create_page(align_up(size, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT))), 0};
+
+            if (auto const offset = align_up(page_head_, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT); !pages_.empty() && offset + size <= page_size_) {
+                page_head_ = offset + size;
+
+                return {&pages_.back(), offset};
+            }
+
+            if (std::size(pages_) < page_count_ && (pages_.empty() || !timeline.is_complete(pages_.front().fence_value)))
+                pages_.emplace_back(create_page(page_size_));
+
+            else {
+                // Only the worker waits here, when the copy queue is behind by the whole ring.
+                timeline.wait(pages_.front().fence_value);
+
+                pages_.push_back(std::move(pages_.front()));
+                pages_.pop_front();
+            }
+
+            page_head_ = size;
+
+            return {&pages_.back(), 0};
+        }
+
+        void stage(request const &value, ID3D12GraphicsCommandList5 *const command_list, staging_page &page, UINT64 offset)
+        {
+            if (value.subresources.empty()) {
+                std::memcpy(page.cpu_start + offset, std::data(value.data), std::size(value.data));
+
+                command_list->CopyBufferRegion(value.destination, value.offset, page.buffer.get(), offset, std::size(value.data));
+
+                return;
+            }
+
+            for (auto index = 0u; index < std::size(value.subresources); ++index) {
+                auto footprint = value.footprints[index];
+                auto &&source = value.subresources[index];
+
+                auto const row_count = value.row_counts[index];
+                auto const row_size = value.row_sizes[index];
+
+                footprint.Offset += offset;
+
+                // The rows of the staged copy are aligned to D3D12_TEXTURE_DATA_PITCH_ALIGNMENT.
+                for (auto slice = 0u; slice < footprint.Footprint.Depth; ++slice) {
+                    auto destination = page.cpu_start + footprint.Offset + static_cast<UINT64>(slice) * footprint.Footprint.RowPitch * row_count;
+
+                    for (auto row = 0u; row < row_count; ++row) {
+                        std::memcpy(destination + static_cast<UINT64>(row) * footprint.Footprint.RowPitch,
+                                    std::data(source.data) + slice * source.slice_pitch + row * source.row_pitch, static_cast<std::size_t>(row_size));
+                    }
+                }
+
+                CD3DX12_TEXTURE_COPY_LOCATION const destination_location{value.destination, value.first_subresource + index};
+                CD3DX12_TEXTURE_COPY_LOCATION const source_location{page.buffer.get(), footprint};
+
+                command_list->CopyTextureRegion(&destination_location, 0, 0, 0, &source_location, nullptr);
+            }
+        }
+
+        void submit_batch(std::vector<request> const &batch)
+        {
+            UINT64 size = 0;
+
+            for (auto &&value : batch)
+                size = align_up(size, value.alignment) + value.staging_size;
+
+            auto [page, head] = allocate_staging(size);
+
+            auto context = command_pool_.acquire(D3D12_COMMAND_LIST_TYPE_COPY);
+            auto command_list = context.command_list.get();
+
+            UINT64 bytes = 0;
+
+            // Offsets within the batch are aligned relative to its start, which is aligned to the largest alignment.
+            for (auto &&value : batch) {
+                head = align_up(head, value.alignment);
+
+                stage(value, command_list, *page, head);
+
+                head += value.staging_size;
+                bytes += value.staging_size;
+            }
+
+            if (auto result = command_list->Close(); FAILED(result))
+                throw dx::device_error(fmt::format("failed to close a command list: {0:#x}"s, result));
+
+            auto const command_lists = std::array<ID3D12CommandList *, 1>{command_list};
+
+            auto const fence_value = queues_.submit(queue_type::copy, command_lists).value;
+
+            command_pool_.release(std::move(context), queues_.timeline(queue_type::copy), fence_value);
+
+            page->fence_value = fence_value;
+
+            {
+                std::unique_lock lock{mutex_};
+
+                batches_.push_back(submitted_batch{batch.back().token, fence_value});
+
+                submitted_token_ = batch.back().token;
+                last_fence_value_ = fence_value;
+
+                statistics_.requests += std::size(batch);
+                statistics_.bytes += bytes;
+                ++statistics_.batches;
+            }
+
+            submitted_condition_.notify_all();
+        }
+
+        void work()
+        {
+            std::vector<request> batch;
+
+            while (true) {
+                batch.clear();
+
+                {
+                    std::unique_lock lock{mutex_};
+
+                    pending_condition_.wait(lock, [this] { return stop_ || !pending_.empty(); });
+
+                    if (pending_.empty())
+                        return;
+
+                    // A batch takes requests while they fit into the batch budget; a larger request goes alone.
+                    UINT64 size = 0;
+
+                    do {
+                        size = align_up(size, pending_.front().alignment) + pending_.front().staging_size;
+
+                        batch.push_back(std::move(pending_.front()));
+                        pending_.pop_front();
+
+                    } while (!pending_.empty() && align_up(size, pending_.front().alignment) + pending_.front().staging_size <= batch_size_);
+                }
+
+                try {
+                    submit_batch(batch);
+
+                } catch (...) {
+                    std::unique_lock lock{mutex_};
+
+                    error_ = std::current_exception();
+
+                    submitted_condition_.notify_all();
+
+                    return;
+                }
+            }
+        }
+    };
+}
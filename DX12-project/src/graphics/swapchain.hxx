@@ -0,0 +1,151 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+#include "main.hxx"
+#include "utility/exception.hxx"
+
+
+namespace graphics
+{
+    enum class present_mode : std::uint8_t {
+        // Presents on vertical blanks.
+        vsync,
+        // Presents right away; tears, or drives variable refresh rate displays, where tearing is supported.
+        immediate
+    };
+
+    struct swapchain_settings final {
+        std::uint32_t buffer_count{3};
+
+        // Frames queued for presentation before the frame latency wait blocks.
+        std::uint32_t max_frame_latency{1};
+
+        present_mode mode{present_mode::vsync};
+
+        DXGI_FORMAT format{DXGI_FORMAT_R8G8B8A8_UNORM};
+    };
+
+    bool tearing_supported(IDXGIFactory7 *const factory)
+    {
+        BOOL allow_tearing = FALSE;
+
+        if (FAILED(factory->CheckFeatureSupport(DXGI_FEATURE_PRESENT_ALLOW_TEARING, &allow_tearing, sizeof(allow_tearing))))
+            return false;
+
+        return allow_tearing == TRUE;
+    }
+
+    // Flip model swapchain with a frame latency waitable object. Waiting on it before sampling input keeps
+    // the queue of presented frames at the maximum frame latency instead of letting Present block on a full queue.
+    class swapchain final {
+    public:
+
+        swapchain(IDXGIFactory7 *const factory, ID3D12CommandQueue *const queue, HWND window, std::uint32_t width, std::uint32_t height,
+                  swapchain_settings const &settings)
+            : settings_{settings}
+        {
+            tearing_ = settings.mode == present_mode::immediate && tearing_supported(factory);
+
+            flags_ = DXGI_SWAP_CHAIN_FLAG_FRAME_LATENCY_WAITABLE_OBJECT;
+
+            if (tearing_)
+                flags_ |= DXGI_SWAP_CHAIN_FLAG_ALLOW_TEARING;
+
+            DXGI_SWAP_CHAIN_DESC1 const description{
+                width, height,
+                settings.format,
+                FALSE,
+                DXGI_SAMPLE_DESC{1, 0},
+                DXGI_USAGE_RENDER_TARGET_OUTPUT,
+                settings.buffer_count,
+                // Until a resize has been applied, the old buffers are stretched over the window.
+                DXGI_SCALING_STRETCH,
+                DXGI_SWAP_EFFECT_FLIP_DISCARD,
+                DXGI_ALPHA_MODE_UNSPECIFIED,
+                flags_
+            };
+
+            winrt::com_ptr<IDXGISwapChain1> swapchain;
+
+            if (auto result = factory->CreateSwapChainForHwnd(queue, window, &description, nullptr, nullptr, swapchain.put()); FAILED(result))
+                throw dx::swapchain(fmt::format("failed to create a swap chain: {0:#x}"s, result));
+
+            // Exclusive fullscreen would defeat the waitable object and tearing.
+            if (auto result = factory->MakeWindowAssociation(window, DXGI_MWA_NO_ALT_ENTER); FAILED(result))
+                throw dx::swapchain(fmt::format("failed to associate the window with the factory: {0:#x}"s, result));
+
+            swapchain_ = swapchain.try_as<IDXGISwapChain4>();
+
+            if (swapchain_ == nullptr)
+                throw dx::swapchain("failed to query 'IDXGISwapChain4' interface from swap chain"s);
+
+            if (auto result = swapchain_->SetMaximumFrameLatency(settings.max_frame_latency); FAILED(result))
+                throw dx::swapchain(fmt::format("failed to set the maximum frame latency: {0:#x}"s, result));
+
+            frame_latency_waitable_.attach(swapchain_->GetFrameLatencyWaitableObject());
+
+            if (!frame_latency_waitable_)
+                throw dx::swapchain("failed to get the frame latency waitable object"s);
+        }
+
+        swapchain(swapchain const &) = delete;
+        swapchain &operator=(swapchain const &) = delete;
+
+        IDXGISwapChain4 *get() const noexcept { return swapchain_.get(); }
+
+        // Blocks until the swapchain can take another frame; false on a timeout.
+        bool wait_for_frame(DWORD timeout = 1000) const
+        {
+            return WaitForSingleObjectEx(frame_latency_waitable_.get(), timeout, TRUE) == WAIT_OBJECT_0;
+        }
+
+        void present()
+        {
+            auto const sync_interval = settings_.mode == present_mode::vsync ? 1u : 0u;
+            auto const flags = tearing_ ? DXGI_PRESENT_ALLOW_TEARING : 0u;
+
+            if (auto result = swapchain_->Present(sync_interval, flags); FAILED(result))
+                throw dx::swapchain(fmt::format("failed to present: {0:#x}"s, result));
+        }
+
+        std::uint32_t current_back_buffer_index() const { return swapchain_->GetCurrentBackBufferIndex(); }
+
+        // Nothing may reference the buffers anymore: the GPU has to be done with them and they have to be released.
+        void resize(std::uint32_t width, std::uint32_t height)
+        {
+            if (auto result = swapchain_->ResizeBuffers(0, width, height, DXGI_FORMAT_UNKNOWN, flags_); FAILED(result))
+                throw dx::swapchain(fmt::format("failed to resize the swap chain buffers: {0:#x}"s, result));
+        }
+
+        swapchain_settings const &settings() const noexcept { return settings_; }
+
+        bool tearing() const noexcept { return tearing_; }
+
+        // Of the display the desktop is composed for; not known if composition is off.
+        static std::optional<std::chrono::nanoseconds> refresh_period()
+        {
+            DWM_TIMING_INFO timing_info{ };
+            timing_info.cbSize = sizeof(timing_info);
+
+            LARGE_INTEGER frequency{ };
+
+            if (FAILED(DwmGetCompositionTimingInfo(nullptr, &timing_info)) || !QueryPerformanceFrequency(&frequency) || timing_info.qpcRefreshPeriod == 0)
+                return std::nullopt;
+
+            return std::chrono::nanoseconds{static_cast<std::int64_t>(timing_info.qpcRefreshPeriod * 1'000'000'000ull / frequency.QuadPart)};
+        }
+
+    private:
+
+        swapchain_settings settings_;
+
+        winrt::com_ptr<IDXGISwapChain4> swapchain_;
+        winrt::handle frame_latency_waitable_;
+
+        UINT flags_{0};
+        bool tearing_{false};
+    };
+}
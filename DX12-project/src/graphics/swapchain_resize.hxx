@@ -0,0 +1,88 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <optional>
+
+
+namespace graphics
+{
+    struct extent final {
+        std::uint32_t width{0}, height{0};
+
+        constexpr bool empty() const noexcept { return width == 0 || height == 0; }
+
+        constexpr bool operator== (extent const &) const = default;
+    };
+
+    struct resize_policy final {
+        // A size is applied once no other size has come for this long...
+        std::chrono::nanoseconds settle_time{std::chrono::milliseconds{30}};
+
+        // ...or once the swapchain hasn't been resized for this long, so the image keeps up with a long drag.
+        std::chrono::nanoseconds max_interval{std::chrono::milliseconds{100}};
+    };
+
+    struct resize_statistics final {
+        std::uint64_t events{0};
+        std::uint64_t resizes{0};
+    };
+
+    // Turns the stream of size events of a window being dragged into few swapchain resizes. Every resize has
+    // to wait for the frames in flight, so the latest size is applied at the start of a frame once the size
+    // has settled or the last resize is old enough; until then the swapchain stretches the old buffers.
+    class resize_coalescer final {
+    public:
+
+        using clock = std::chrono::steady_clock;
+        using time_point = std::chrono::time_point<clock, std::chrono::nanoseconds>;
+
+        explicit resize_coalescer(extent size, resize_policy policy = { }) : policy_{policy}, current_{size}, pending_{size} { }
+
+        void on_resize(extent size, time_point time) noexcept
+        {
+            ++statistics_.events;
+
+            pending_ = size;
+            last_event_ = time;
+        }
+
+        // At the start of a frame: the size to resize the swapchain to now, if any.
+        std::optional<extent> poll(time_point now) noexcept
+        {
+            // A minimized window has no size to render at; the old buffers stay until it is restored.
+            if (pending_ == current_ || pending_.empty())
+                return std::nullopt;
+
+            if (now - last_event_ < policy_.settle_time && now - last_resize_ < policy_.max_interval)
+                return std::nullopt;
+
+            current_ = pending_;
+            last_resize_ = now;
+
+            ++statistics_.resizes;
+
+            return current_;
+        }
+
+        // The size of the swapchain buffers.
+        extent current() const noexcept { return current_; }
+
+        // Frames should be skipped while the window has no area.
+        bool minimized() const noexcept { return pending_.empty(); }
+
+        resize_statistics statistics() const noexcept { return statistics_; }
+
+    private:
+
+        resize_policy policy_;
+
+        extent current_;
+        extent pending_;
+
+        time_point last_event_;
+        time_point last_resize_;
+
+        resize_statistics statistics_;
+    };
+}
@@ -0,0 +1,331 @@
+#pragma once
+
+#include <array>
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+
+namespace graphics
+{
+    struct tlsf_statistics final {
+        std::uint64_t size{0};
+        std::uint64_t used{0};
+
+        std::uint64_t largest_free_block{0};
+        std::uint32_t free_block_count{0};
+        std::uint32_t allocation_count{0};
+
+        // Share of the free space that can't be handed out as one block: 0 is none, 1 is all of it.
+        float fragmentation() const noexcept
+        {
+            auto const free = size - used;
+
+            return free == 0 ? 0.f : 1.f - static_cast<float>(largest_free_block) / static_cast<float>(free);
+        }
+    };
+
+    // Two-level segregated fit allocator of offsets within [0, size).
+    // It only does bookkeeping, the memory itself lives elsewhere (a GPU heap for instance), so every block
+    // is described by a node in a side array. Allocation and free are O(1): the first level splits sizes by
+    // powers of two, the second level splits every power of two linearly, and bitmaps locate a non-empty list.
+    class tlsf_allocator final {
+    public:
+
+        static auto constexpr kINVALID_BLOCK = std::numeric_limits<std::uint32_t>::max();
+
+        struct allocation final {
+            std::uint64_t offset{0};
+            std::uint64_t size{0};
+
+            std::uint32_t block{kINVALID_BLOCK};
+
+            bool valid() const noexcept { return block != kINVALID_BLOCK; }
+        };
+
+        // The granularity is the smallest block size and has to be a power of two; all sizes are rounded up to it.
+        tlsf_allocator(std::uint64_t size, std::uint64_t granularity) : granularity_{granularity}
+        {
+            granularity_shift_ = static_cast<std::uint32_t>(std::countr_zero(granularity));
+            size_ = size & ~(granularity - 1);
+
+            for (auto &&lists : free_lists_)
+                lists.fill(kINVALID_BLOCK);
+
+            if (size_ != 0)
+                insert_free_block(create_block(block{0, size_}));
+        }
+
+        [[nodiscard]] allocation allocate(std::uint64_t size, std::uint64_t alignment)
+        {
+            if (size == 0)
+                return { };
+
+            size = align_up(size, granularity_);
+            alignment = alignment > granularity_ ? alignment : granularity_;
+
+            // Enough slack is requested to be able to align the start of whichever block is found.
+            auto const search_size = size + (alignment - granularity_);
+
+            if (search_size > size_)
+                return { };
+
+            auto const index = find_free_block(search_size >> granularity_shift_);
+
+            if (index == kINVALID_BLOCK)
+                return { };
+
+            remove_free_block(index);
+
+            if (auto const padding = align_up(blocks_[index].offset, alignment) - blocks_[index].offset; padding != 0)
+                split_front(index, padding);
+
+            if (blocks_[index].size - size >= granularity_)
+                split_back(index, size);
+
+            auto &allocated = blocks_[index];
+
+            allocated.free = false;
+
+            used_ += allocated.size;
+            ++allocation_count_;
+
+            return allocation{allocated.offset, allocated.size, index};
+        }
+
+        void free(allocation const &allocation)
+        {
+            if (!allocation.valid())
+                return;
+
+            auto index = allocation.block;
+
+            used_ -= blocks_[index].size;
+            --allocation_count_;
+
+            blocks_[index].free = true;
+
+            if (auto const previous = blocks_[index].previous; previous != kINVALID_BLOCK && blocks_[previous].free) {
+                remove_free_block(previous);
+                index = merge(previous, index);
+            }
+
+            if (auto const next = blocks_[index].next; next != kINVALID_BLOCK && blocks_[next].free) {
+                remove_free_block(next);
+                index = merge(index, next);
+            }
+
+            insert_free_block(index);
+        }
+
+        bool empty() const noexcept { return allocation_count_ == 0; }
+
+        std::uint64_t size() const noexcept { return size_; }
+
+        tlsf_statistics statistics() const noexcept
+        {
+            tlsf_statistics result{size_, used_, 0, 0, allocation_count_};
+
+            for (auto &&lists : free_lists_) {
+                for (auto index : lists) {
+                    for (; index != kINVALID_BLOCK; index = blocks_[index].next_free) {
+                        result.largest_free_block = blocks_[index].size > result.largest_free_block ? blocks_[index].size : result.largest_free_block;
+                        ++result.free_block_count;
+                    }
+                }
+            }
+
+            return result;
+        }
+
+    private:
+
+        static auto constexpr kSECOND_LEVEL_SHIFT = 4u;
+        static auto constexpr kSECOND_LEVEL_COUNT = 1u << kSECOND_LEVEL_SHIFT;
+        static auto constexpr kFIRST_LEVEL_COUNT = 64u - kSECOND_LEVEL_SHIFT;
+
+        struct block final {
+            std::uint64_t offset{0};
+            std::uint64_t size{0};
+
+            // Neighbours in address order.
+            std::uint32_t previous{kINVALID_BLOCK}, next{kINVALID_BLOCK};
+
+            // Neighbours within the same free list.
+            std::uint32_t previous_free{kINVALID_BLOCK}, next_free{kINVALID_BLOCK};
+
+            bool free{true};
+        };
+
+        struct bin final {
+            std::uint32_t first_level{0}, second_level{0};
+        };
+
+        std::uint64_t size_{0};
+        std::uint64_t granularity_{1};
+        std::uint32_t granularity_shift_{0};
+
+        std::uint64_t used_{0};
+        std::uint32_t allocation_count_{0};
+
+        std::vector<block> blocks_;
+        std::vector<std::uint32_t> unused_blocks_;
+
+        std::uint64_t first_level_bitmap_{0};
+        std::array<std::uint32_t, kFIRST_LEVEL_COUNT> second_level_bitmaps_{};
+
+        std::array<std::array<std::uint32_t, kSECOND_LEVEL_COUNT>, kFIRST_LEVEL_COUNT> free_lists_;
+
+        static constexpr std::uint64_t align_up(std::uint64_t value, std::uint64_t alignment) noexcept
+        {
+            return (value + alignment - 1) & ~(alignment - 1);
+        }
+
+        // Bin that holds blocks of the given size in granules.
+        static bin map(std::uint64_t units) noexcept
+        {
+            if (units < kSECOND_LEVEL_COUNT)
+                return bin{0, static_cast<std::uint32_t>(units)};
+
+            auto const top_bit = static_cast<std::uint32_t>(std::bit_width(units)) - 1;
+
+            return bin{
+                top_bit - kSECOND_LEVEL_SHIFT + 1,
+                static_cast<std::uint32_t>(units >> (top_bit - kSECOND_LEVEL_SHIFT)) - kSECOND_LEVEL_COUNT
+            };
+        }
+
+        // Returns a free block of at least the given size in granules: the size is rounded up to the next bin
+        // boundary, so any block of the found bin fits and the list head can be taken as is.
+        std::uint32_t find_free_block(std::uint64_t units) const noexcept
+        {
+            if (units >= kSECOND_LEVEL_COUNT) {
+                auto const top_bit = static_cast<std::uint32_t>(std::bit_width(units)) - 1;
+
+                units += (std::uint64_t{1} << (top_bit - kSECOND_LEVEL_SHIFT)) - 1;
+            }
+
+            auto [first_level, second_level] = map(units);
+
+            if (first_level >= kFIRST_LEVEL_COUNT)
+                return kINVALID_BLOCK;
+
+            auto second_level_map = second_level_bitmaps_[first_level] & (~0u << second_level);
+
+            if (second_level_map == 0) {
+                auto const first_level_map = first_level + 1 < 64 ? first_level_bitmap_ & (~std::uint64_t{0} << (first_level + 1)) : 0;
+
+                if (first_level_map == 0)
+                    return kINVALID_BLOCK;
+
+                first_level = static_cast<std::uint32_t>(std::countr_zero(first_level_map));
+                second_level_map = second_level_bitmaps_[first_level];
+            }
+
+            second_level = static_cast<std::uint32_t>(std::countr_zero(second_level_map));
+
+            return free_lists_[first_level][second_level];
+        }
+
+        std::uint32_t create_block(block const &value)
+        {
+            if (!unused_blocks_.empty()) {
+                auto const index = unused_blocks_.back();
+                unused_blocks_.pop_back();
+
+                blocks_[index] = value;
+
+                return index;
+            }
+
+            blocks_.push_back(value);
+
+            return static_cast<std::uint32_t>(std::size(blocks_) - 1);
+        }
+
+        void insert_free_block(std::uint32_t index) noexcept
+        {
+            auto const [first_level, second_level] = map(blocks_[index].size >> granularity_shift_);
+            auto &head = free_lists_[first_level][second_level];
+
+            blocks_[index].free = true;
+            blocks_[index].previous_free = kINVALID_BLOCK;
+            blocks_[index].next_free = head;
+
+            if (head != kINVALID_BLOCK)
+                blocks_[head].previous_free = index;
+
+            head = index;
+
+            first_level_bitmap_ |= std::uint64_t{1} << first_level;
+            second_level_bitmaps_[first_level] |= 1u << second_level;
+        }
+
+        void remove_free_block(std::uint32_t index) noexcept
+        {
+            auto const [first_level, second_level] = map(blocks_[index].size >> granularity_shift_);
+            auto &current = blocks_[index];
+
+            if (current.previous_free != kINVALID_BLOCK)
+                blocks_[current.previous_free].next_free = current.next_free;
+
+            else free_lists_[first_level][second_level] = current.next_free;
+
+            if (current.next_free != kINVALID_BLOCK)
+                blocks_[current.next_free].previous_free = current.previous_free;
+
+            current.previous_free = current.next_free = kINVALID_BLOCK;
+
+            if (free_lists_[first_level][second_level] == kINVALID_BLOCK) {
+                second_level_bitmaps_[first_level] &= ~(1u << second_level);
+
+                if (second_level_bitmaps_[first_level] == 0)
+                    first_level_bitmap_ &= ~(std::uint64_t{1} << first_level);
+            }
+        }
+
+        // Cuts 'size' bytes off the front of the block into a new free block.
+        void split_front(std::uint32_t index, std::uint64_t size)
+        {
+            auto const front = create_block(block{blocks_[index].offset, size, blocks_[index].previous, index});
+
+            if (blocks_[front].previous != kINVALID_BLOCK)
+                blocks_[blocks_[front].previous].next = front;
+
+            blocks_[index].previous = front;
+            blocks_[index].offset += size;
+            blocks_[index].size -= size;
+
+            insert_free_block(front);
+        }
+
+        // Keeps 'size' bytes in the block and moves the rest into a new free block.
+        void split_back(std::uint32_t index, std::uint64_t size)
+        {
+            auto const back = create_block(block{blocks_[index].offset + size, blocks_[index].size - size, index, blocks_[index].next});
+
+            if (blocks_[back].next != kINVALID_BLOCK)
+                blocks_[blocks_[back].next].previous = back;
+
+            blocks_[index].next = back;
+            blocks_[index].size = size;
+
+            insert_free_block(back);
+        }
+
+        // Absorbs the right block into the left one, its physical neighbour.
+        std::uint32_t merge(std::uint32_t left, std::uint32_t right)
+        {
+            blocks_[left].size += blocks_[right].size;
+            blocks_[left].next = blocks_[right].next;
+
+            if (blocks_[right].next != kINVALID_BLOCK)
+                blocks_[blocks_[right].next].previous = left;
+
+            unused_blocks_.push_back(right);
+
+            return left;
+        }
+    };
+}
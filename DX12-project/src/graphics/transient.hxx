@@ -0,0 +1,175 @@
+#pragma once
+
+#include <optional>
+#include <span>
+
+#include "main.hxx"
+#include "utility/exception.hxx"
+#include "graphics/aliasing.hxx"
+#include "graphics/memory.hxx"
+
+
+namespace graphics
+{
+    // Placed resources that are only alive within a part of a frame, e.g. window-size-dependent render targets.
+    // Resources are declared with the first and the last pass that use them, and build() packs every heap
+    // category into one memory range where resources with disjoint lifetimes share memory.
+    class transient_resource_pool final {
+    public:
+
+        transient_resource_pool(ID3D12Device6 *const device, memory_allocator &memory_allocator)
+            : device_{device}, memory_allocator_{memory_allocator} { }
+
+        ~transient_resource_pool()
+        {
+            release();
+        }
+
+        transient_resource_pool(transient_resource_pool const &) = delete;
+        transient_resource_pool &operator=(transient_resource_pool const &) = delete;
+
+        [[nodiscard]] std::uint32_t
+        declare(D3D12_RESOURCE_DESC const &description, std::uint32_t first_pass, std::uint32_t last_pass,
+                D3D12_RESOURCE_STATES initial_state, std::optional<D3D12_CLEAR_VALUE> clear_value = std::nullopt)
+        {
+            if (first_pass > last_pass)
+                throw dx::memory_error(fmt::format("invalid transient resource lifetime [{0}, {1}]"s, first_pass, last_pass));
+
+            entries_.push_back(entry{description, first_pass, last_pass, initial_state, clear_value, nullptr});
+
+            return static_cast<std::uint32_t>(std::size(entries_) - 1);
+        }
+
+        void build()
+        {
+            release();
+
+            std::array<std::vector<std::uint32_t>, static_cast<std::size_t>(resource_category::count)> groups;
+
+            for (auto index = 0u; index < std::size(entries_); ++index)
+                groups[static_cast<std::size_t>(memory_allocator_.category_of(entries_[index].description))].push_back(index);
+
+            auto pass_count = 0u;
+
+            for (auto &&entry : entries_)
+                pass_count = (std::max)(pass_count, entry.last_pass + 1);
+
+            aliasing_barriers_.assign(pass_count, { });
+
+            heap_size_ = 0;
+            unaliased_size_ = 0;
+
+            for (auto category = 0u; category < std::size(groups); ++category) {
+                if (!groups[category].empty())
+                    build_group(static_cast<resource_category>(category), groups[category]);
+            }
+        }
+
+        // The GPU has to be done with the resources.
+        void release()
+        {
+            for (auto &&entry : entries_)
+                entry.resource = nullptr;
+
+            for (auto &&allocation : allocations_)
+                memory_allocator_.free(allocation);
+
+            allocations_.clear();
+            aliasing_barriers_.clear();
+        }
+
+        // Forgets the declared resources, e.g. before declaring the targets of a new window size.
+        void clear()
+        {
+            release();
+
+            entries_.clear();
+        }
+
+        ID3D12Resource *resource(std::uint32_t id) const { return entries_.at(id).resource.get(); }
+
+        // Aliasing barriers that have to precede the pass, every frame: the first resource in a range takes it back
+        // from the last one of the previous frame. A resource that takes over memory from another one also has
+        // undefined contents, so its first use has to be a clear, a copy or a discard.
+        std::span<D3D12_RESOURCE_BARRIER const> aliasing_barriers(std::uint32_t pass) const
+        {
+            if (pass >= std::size(aliasing_barriers_))
+                return { };
+
+            return aliasing_barriers_[pass];
+        }
+
+        UINT64 heap_size() const noexcept { return heap_size_; }
+
+        UINT64 bytes_saved() const noexcept { return unaliased_size_ - heap_size_; }
+
+    private:
+
+        struct entry final {
+            D3D12_RESOURCE_DESC description;
+
+            std::uint32_t first_pass{0}, last_pass{0};
+
+            D3D12_RESOURCE_STATES initial_state{D3D12_RESOURCE_STATE_COMMON};
+            std::optional<D3D12_CLEAR_VALUE> clear_value;
+
+            winrt::com_ptr<ID3D12Resource> resource;
+        };
+
+        ID3D12Device6 *device_;
+        memory_allocator &memory_allocator_;
+
+        std::vector<entry> entries_;
+        std::vector<memory_allocation> allocations_;
+
+        std::vector<std::vector<D3D12_RESOURCE_BARRIER>> aliasing_barriers_;
+
+        UINT64 heap_size_{0};
+        UINT64 unaliased_size_{0};
+
+        void build_group(resource_category category, std::span<std::uint32_t const> group)
+        {
+            std::vector<aliasing_request> requests;
+            requests.reserve(std::size(group));
+
+            UINT64 alignment = D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+
+            for (auto index : group) {
+                auto const &entry = entries_[index];
+                auto const info = device_->GetResourceAllocationInfo(0, 1, &entry.description);
+
+                requests.push_back(aliasing_request{info.SizeInBytes, info.Alignment, entry.first_pass, entry.last_pass});
+
+                alignment = (std::max)(alignment, info.Alignment);
+            }
+
+            auto const layout = pack_aliased_resources(requests);
+
+            auto const allocation = memory_allocator_.allocate(D3D12_HEAP_TYPE_DEFAULT, category, D3D12_RESOURCE_ALLOCATION_INFO{layout.size, alignment});
+
+            allocations_.push_back(allocation);
+
+            heap_size_ += layout.size;
+            unaliased_size_ += layout.unaliased_size;
+
+            for (auto i = 0u; i < std::size(group); ++i) {
+                auto &entry = entries_[group[i]];
+                auto const clear_value = entry.clear_value ? &*entry.clear_value : nullptr;
+
+                if (auto result = device_->CreatePlacedResource(allocation.heap, allocation.offset + layout.placements[i].offset, &entry.description,
+                                                                entry.initial_state, clear_value, winrt::guid_of<ID3D12Resource>(), entry.resource.put_void()); FAILED(result))
+                    throw dx::memory_error(fmt::format("failed to create a transient resource: {0:#x}"s, result));
+            }
+
+            for (auto i = 0u; i < std::size(group); ++i) {
+                if (auto const predecessor = layout.placements[i].predecessor; predecessor != kNO_ALIASED_PREDECESSOR) {
+                    auto const &entry = entries_[group[i]];
+
+                    aliasing_barriers_[entry.first_pass].push_back(
+                        CD3DX12_RESOURCE_BARRIER::Aliasing(entries_[group[predecessor]].resource.get(), entry.resource.get())
+                    );
+                }
+            }
+        }
+    };
+}
@@ -0,0 +1,230 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+
+#include "main.hxx"
+#include "utility/exception.hxx"
+#include "graphics/fence.hxx"
+#include "graphics/memory.hxx"
+
+
+winrt::com_ptr<ID3D12Resource> create_upload_buffer(ID3D12Device6 *const device, UINT64 size)
+{
+    auto const description = CD3DX12_RESOURCE_DESC::Buffer(size);
+    CD3DX12_HEAP_PROPERTIES const heap_properties{D3D12_HEAP_TYPE_UPLOAD};
+
+    winrt::com_ptr<ID3D12Resource> buffer;
+
+    if (auto result = device->CreateCommittedResource(&heap_properties, D3D12_HEAP_FLAG_NONE, &description,
+                                                      D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, winrt::guid_of<ID3D12Resource>(), buffer.put_void()); FAILED(result))
+        throw dx::device_error(fmt::format("failed to create an upload buffer: {0:#x}"s, result));
+
+    return buffer;
+}
+
+namespace graphics
+{
+    struct upload_allocation final {
+        std::byte *cpu_address{nullptr};
+        D3D12_GPU_VIRTUAL_ADDRESS gpu_address{0};
+
+        ID3D12Resource *resource{nullptr};
+
+        UINT64 offset{0};
+        UINT64 size{0};
+    };
+
+    // Persistently mapped UPLOAD heap buffer used as a ring by the render thread.
+    // An allocation is an aligned bump of the head within the space that is known to be free; the tail follows
+    // the fence values of finished frames. When the ring is full, allocations either spill into overflow pages
+    // that live until the end of the frame, or wait for the oldest frame in flight.
+    class upload_ring final {
+    public:
+
+        upload_ring(ID3D12Device6 *const device, fence_timeline &timeline, UINT64 capacity, bool allow_overflow = true)
+            : device_{device}, timeline_{timeline}, capacity_{align_up(capacity, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT)}, allow_overflow_{allow_overflow}
+        {
+            buffer_ = create_upload_buffer(device, capacity_);
+
+            cpu_start_ = map(buffer_.get());
+            gpu_start_ = buffer_->GetGPUVirtualAddress();
+
+            limit_ = capacity_;
+        }
+
+        ~upload_ring()
+        {
+            buffer_->Unmap(0, nullptr);
+
+            for (auto &&page : overflow_pages_)
+                page.buffer->Unmap(0, nullptr);
+        }
+
+        upload_ring(upload_ring const &) = delete;
+        upload_ring &operator=(upload_ring const &) = delete;
+
+        [[nodiscard]] upload_allocation allocate(UINT64 size, UINT64 alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT)
+        {
+            auto const position = align_up(head_, alignment);
+
+            if (position + size <= limit_) [[likely]] {
+                head_ = position + size;
+
+                auto const offset = position % capacity_;
+
+                return upload_allocation{cpu_start_ + offset, gpu_start_ + offset, buffer_.get(), offset, size};
+            }
+
+            return allocate_slow(size, alignment);
+        }
+
+        // Everything allocated since the previous call is released once the fence reaches the value.
+        void end_frame(UINT64 fence_value)
+        {
+            retired_frames_.push_back(retired_frame{fence_value, head_});
+
+            for (auto &&page : overflow_pages_) {
+                if (page.fence_value == 0)
+                    page.fence_value = fence_value;
+            }
+        }
+
+        UINT64 capacity() const noexcept { return capacity_; }
+
+        UINT64 occupancy() const noexcept { return head_ - tail_; }
+
+        std::size_t overflow_page_number() const noexcept { return std::size(overflow_pages_); }
+
+    private:
+
+        static UINT64 constexpr kOVERFLOW_PAGE_SIZE = 2ull << 20;
+
+        struct retired_frame final {
+            UINT64 fence_value{0};
+            UINT64 head{0};
+        };
+
+        struct overflow_page final {
+            winrt::com_ptr<ID3D12Resource> buffer;
+            std::byte *cpu_start{nullptr};
+
+            UINT64 size{0};
+            UINT64 head{0};
+
+            // Zero until the frame that used the page has been submitted.
+            UINT64 fence_value{0};
+        };
+
+        ID3D12Device6 *device_;
+        fence_timeline &timeline_;
+
+        winrt::com_ptr<ID3D12Resource> buffer_;
+
+        std::byte *cpu_start_{nullptr};
+        D3D12_GPU_VIRTUAL_ADDRESS gpu_start_{0};
+
+        UINT64 capacity_{0};
+        bool allow_overflow_{true};
+
+        // Monotonic positions; the buffer offset is the position modulo the capacity.
+        // 'limit_' is the end of the contiguous range that is currently known to be free.
+        UINT64 head_{0}, tail_{0}, limit_{0};
+
+        std::deque<retired_frame> retired_frames_;
+        std::vector<overflow_page> overflow_pages_;
+
+        static std::byte *map(ID3D12Resource *const buffer)
+        {
+            D3D12_RANGE const read_range{0, 0};
+
+            void *data = nullptr;
+
+            if (auto result = buffer->Map(0, &read_range, &data); FAILED(result))
+                throw dx::device_error(fmt::format("failed to map an upload buffer: {0:#x}"s, result));
+
+            return static_cast<std::byte *>(data);
+        }
+
+        void reclaim()
+        {
+            while (!retired_frames_.empty() && timeline_.is_complete(retired_frames_.front().fence_value)) {
+                tail_ = retired_frames_.front().head;
+                retired_frames_.pop_front();
+            }
+
+            auto it = std::remove_if(std::begin(overflow_pages_), std::end(overflow_pages_), [this] (auto &&page)
+            {
+                if (page.fence_value == 0 || !timeline_.is_complete(page.fence_value))
+                    return false;
+
+                page.buffer->Unmap(0, nullptr);
+
+                return true;
+            });
+
+            overflow_pages_.erase(it, std::end(overflow_pages_));
+
+            update_limit();
+        }
+
+        void update_limit() noexcept
+        {
+            auto const lap_end = head_ - head_ % capacity_ + capacity_;
+
+            limit_ = (std::min)(lap_end, tail_ + capacity_);
+        }
+
+        upload_allocation allocate_slow(UINT64 size, UINT64 alignment)
+        {
+            if (size > capacity_)
+                return allocate_overflow(size, alignment);
+
+            reclaim();
+
+            while (true) {
+                auto position = align_up(head_, alignment);
+
+                // Allocations can't wrap around the end of the buffer, the rest of the lap is skipped instead.
+                if (position + size > head_ - head_ % capacity_ + capacity_)
+                    position = head_ - head_ % capacity_ + capacity_;
+
+                if (position + size <= tail_ + capacity_) {
+                    head_ = position;
+                    update_limit();
+
+                    return allocate(size, alignment);
+                }
+
+                if (allow_overflow_ || retired_frames_.empty())
+                    return allocate_overflow(size, alignment);
+
+                timeline_.wait(retired_frames_.front().fence_value);
+
+                reclaim();
+            }
+        }
+
+        upload_allocation allocate_overflow(UINT64 size, UINT64 alignment)
+        {
+            auto page = std::find_if(std::begin(overflow_pages_), std::end(overflow_pages_), [size, alignment] (auto &&page)
+            {
+                return page.fence_value == 0 && align_up(page.head, alignment) + size <= page.size;
+            });
+
+            if (page == std::end(overflow_pages_)) {
+                auto const page_size = align_up((std::max)(size, kOVERFLOW_PAGE_SIZE), D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT);
+                auto buffer = create_upload_buffer(device_, page_size);
+
+                overflow_pages_.push_back(overflow_page{buffer, map(buffer.get()), page_size});
+                page = std::prev(std::end(overflow_pages_));
+            }
+
+            auto const offset = align_up(page->head, alignment);
+
+            page->head = offset + size;
+
+            return upload_allocation{page->cpu_start + offset, page->buffer->GetGPUVirtualAddress() + offset, page->buffer.get(), offset, size};
+        }
+    };
+}
@@ -1,22 +1,45 @@
 #include "main.hxx"
 #include "utility/exception.hxx"
+#include "platform/frame_loop.hxx"
+#include "platform/job_system.hxx"
+#include "platform/startup_graph.hxx"
 #include "platform/window.hxx"
 
+#include "graphics/adapter.hxx"
+#include "graphics/bindless.hxx"
 #include "graphics/command.hxx"
+#include "graphics/command_pool.hxx"
 #include "graphics/descriptor.hxx"
+#include "graphics/descriptor_ring.hxx"
+#include "graphics/dxc_compiler.hxx"
+#include "graphics/fence.hxx"
+#include "graphics/frame.hxx"
+#include "graphics/frame_completion.hxx"
+#include "graphics/frame_pacing.hxx"
+#include "graphics/indirect.hxx"
+#include "graphics/memory.hxx"
+#include "graphics/parallel_recording.hxx"
+#include "graphics/pipeline.hxx"
+#include "graphics/queue.hxx"
+#include "graphics/render_graph.hxx"
+#include "graphics/render_graph_executor.hxx"
+#include "graphics/resource_state.hxx"
+#include "graphics/shader_build.hxx"
+#include "graphics/streaming.hxx"
+#include "graphics/swapchain.hxx"
+#include "graphics/swapchain_resize.hxx"
+#include "graphics/transient.hxx"
+#include "graphics/upload.hxx"
 
 #pragma comment(lib, "DXGI.lib")
 #pragma comment(lib, "D3D12.lib")
+#pragma comment(lib, "Dwmapi.lib")
 #pragma comment(lib, "RuntimeObject.lib")
 //#pragma comment(lib, "ComBase.lib")
 
 
 namespace graphics
 {
-    struct extent final {
-        std::uint32_t width{0}, height{0};
-    };
-
     DXGI_FORMAT constexpr kDEPTH_FORMAT{DXGI_FORMAT::DXGI_FORMAT_D32_FLOAT};
 }
 
@@ -30,93 +53,201 @@ namespace app
 
     auto constexpr kSWAPCHAIN_BUFFER_COUNT = 3u;
 
+    // One queued frame and input sampled just in time for the next vsync give the lowest input-to-display latency.
+    auto constexpr kMAX_FRAME_LATENCY = 1u;
+    auto constexpr kPRESENT_MODE = graphics::present_mode::vsync;
+    auto constexpr kFRAME_PACING = true;
+
+    // Renders only after events instead of every vsync; for a scene that doesn't move on its own, e.g. on a kiosk.
+    auto constexpr kRENDER_ON_DEMAND = false;
+
+    // Shader-visible descriptors shared by the transient tables of all frames in flight.
+    auto constexpr kTRANSIENT_DESCRIPTOR_COUNT = 1u << 16;
+
+    // Views and samplers addressed by bindless indices; 2048 is the limit of a shader-visible sampler heap.
+    auto constexpr kBINDLESS_VIEW_COUNT = 1u << 18;
+    auto constexpr kBINDLESS_SAMPLER_COUNT = 2048u;
+
+    // Per-frame constants and dynamic vertex data of all frames in flight.
+    auto constexpr kUPLOAD_RING_SIZE = 16ull << 20;
+
+    // Command lists the draws of the main pass are split into for parallel recording.
+    auto constexpr kMAIN_PASS_BATCH_COUNT = 4u;
+
+    // Instances and meshes of the GPU-driven draws: 80 bytes of instance data and a 24-byte draw command per instance.
+    auto constexpr kINSTANCE_CAPACITY = 1u << 18;
+    auto constexpr kMESH_CAPACITY = 1u << 12;
+
+    // Adapter probe results of earlier runs, kept in the working directory.
+    auto constexpr kADAPTER_CACHE_PATH = "adapters.cache"sv;
+
+    // Compiled pipeline states of earlier runs, valid for one adapter and driver.
+    auto constexpr kPIPELINE_CACHE_PATH = "pipelines.cache"sv;
+
+    // Compiled shaders, one file per content hash, and the directory searched for shared shader headers.
+    auto constexpr kSHADER_CACHE_PATH = "shaders.cache"sv;
+    auto constexpr kSHADER_INCLUDE_PATH = "shaders"sv;
+
     struct D3D final {
         winrt::com_ptr<IDXGIFactory7> dxgi_factory;
 
         winrt::com_ptr<IDXGIAdapter4> hardware_adapter;
         winrt::com_ptr<ID3D12Device6> device;
 
-        winrt::com_ptr<IDXGISwapChain4> swapchain;
+        std::unique_ptr<graphics::swapchain> swapchain;
 
         std::vector<winrt::com_ptr<ID3D12Resource>> swapchain_buffers;
-        winrt::com_ptr<ID3D12Resource> depth_stencil_buffer;
+        // Owned by 'transient_resources', which are laid out for the lifetimes of the compiled frame graph.
+        ID3D12Resource *depth_stencil_buffer{nullptr};
+        std::vector<graphics::render_graph_lifetime> transient_lifetimes;
+
+        std::vector<graphics::frame_context> frame_contexts;
+        std::uint32_t frame_index{0};
+
+        std::unique_ptr<graphics::queue_scheduler> queues;
+        std::unique_ptr<graphics::command_pool> command_pool;
+
+        std::unique_ptr<graphics::descriptor_allocator> descriptor_allocator;
+        std::unique_ptr<graphics::descriptor_ring> descriptor_ring;
+        std::unique_ptr<graphics::bindless_descriptors> bindless_descriptors;
+
+        graphics::root_signature root_signature;
+
+        std::unique_ptr<graphics::upload_ring> upload_ring;
+        // Nothing is streamed yet: the scene has no loaded meshes or textures, and the per-frame instance and mesh
+        // changes are small enough to go through 'upload_ring' on the direct queue. It is there for asset loading.
+        std::unique_ptr<graphics::upload_service> upload_service;
+        std::unique_ptr<graphics::pipeline_cache> pipeline_cache;
+        std::unique_ptr<graphics::pipeline_compiler> pipeline_compiler;
+        std::unique_ptr<graphics::memory_allocator> memory_allocator;
+        std::unique_ptr<graphics::transient_resource_pool> transient_resources;
+        std::unique_ptr<graphics::indirect_draws> indirect_draws;
+        std::unique_ptr<graphics::resource_state_registry> resource_states;
+        std::unique_ptr<graphics::render_graph_compiler> render_graph_compiler;
+
+        std::unique_ptr<platform::job_system> job_system;
+
+        std::vector<graphics::descriptor> render_target_views;
+        graphics::descriptor depth_stencil_view;
+    };
 
-        winrt::com_ptr<ID3D12GraphicsCommandList5> command_list;
-        winrt::com_ptr<ID3D12CommandAllocator> command_allocator;
-        winrt::com_ptr<ID3D12CommandQueue> command_queue;
+    // The window's size events arrive on the render thread, when the window's event queue is drained.
+    class resize_handler final : public platform::event_handler_interface {
+    public:
 
-        winrt::com_ptr<ID3D12Fence1> fence;
+        explicit resize_handler(graphics::resize_coalescer &coalescer) noexcept : coalescer_{coalescer} { }
 
-        winrt::com_ptr<ID3D12DescriptorHeap> rtv_descriptor_heaps;
-        winrt::com_ptr<ID3D12DescriptorHeap> dsv_descriptor_heap;
+        void on_resize(std::int32_t width, std::int32_t height) override
+        {
+            auto const size = graphics::extent{static_cast<std::uint32_t>((std::max)(width, 0)), static_cast<std::uint32_t>((std::max)(height, 0))};
+
+            coalescer_.on_resize(size, graphics::resize_coalescer::clock::now());
+        }
+
+    private:
+
+        graphics::resize_coalescer &coalescer_;
     };
 }
 
 
-winrt::com_ptr<IDXGIAdapter4> pick_hardware_adapter(IDXGIFactory7 *const dxgi_factory)
+// Adapter descriptions are fetched once; whether an adapter supports the required feature level, and its resource
+// binding tier, are remembered across runs until its driver changes.
+winrt::com_ptr<IDXGIAdapter4>
+pick_hardware_adapter(IDXGIFactory7 *const dxgi_factory, graphics::adapter_policy const &policy, std::filesystem::path const &cache_path)
 {
-    std::vector<winrt::com_ptr<IDXGIAdapter1>> adapters(16);
+    graphics::adapter_cache cache;
 
-    std::generate(std::begin(adapters), std::end(adapters), [dxgi_factory, i = 0u] () mutable
-    {
+    if (std::ifstream file{cache_path}; file)
+        cache.load(file);
+
+    std::vector<winrt::com_ptr<IDXGIAdapter4>> adapters;
+    std::vector<graphics::adapter_description> descriptions;
+
+    for (auto index = 0u; ; ++index) {
         winrt::com_ptr<IDXGIAdapter1> adapter;
 
-        dxgi_factory->EnumAdapters1(i++, adapter.put());
+        if (auto result = dxgi_factory->EnumAdapters1(index, adapter.put()); result == DXGI_ERROR_NOT_FOUND)
+            break;
 
-        return adapter;
-    });
+        else if (FAILED(result))
+            throw dx::dxgi_factory(fmt::format("failed to enumerate adapters: {0:#x}"s, result));
 
-    auto it = std::remove_if(std::begin(adapters), std::end(adapters), [] (auto &&adapter) { return adapter == nullptr; });
+        auto adapter4 = adapter.try_as<IDXGIAdapter4>();
 
-    adapters.erase(it, std::end(adapters));
+        if (adapter4 == nullptr)
+            continue;
 
-    for (auto &&adapter : adapters) {
         DXGI_ADAPTER_DESC1 description;
-        adapter->GetDesc1(&description);
 
-        std::wcout << L"Adapter "s + description.Description << std::endl;
-    }
+        if (auto result = adapter->GetDesc1(&description); FAILED(result))
+            throw dx::dxgi_factory(fmt::format("failed to get an adapter description: {0:#x}"s, result));
+
+        // The user mode driver version.
+        LARGE_INTEGER driver_version{};
+        adapter->CheckInterfaceSupport(winrt::guid_of<IDXGIDevice>(), &driver_version);
+
+        graphics::adapter_description value{
+            .name = description.Description,
+            .vendor_id = description.VendorId,
+            .device_id = description.DeviceId,
+            .subsystem_id = description.SubSysId,
+            .revision = description.Revision,
+            .luid = static_cast<std::uint64_t>(description.AdapterLuid.HighPart) << 32 | description.AdapterLuid.LowPart,
+            .driver_version = static_cast<std::uint64_t>(driver_version.QuadPart),
+            .dedicated_video_memory = description.DedicatedVideoMemory,
+            .dedicated_system_memory = description.DedicatedSystemMemory,
+            .shared_system_memory = description.SharedSystemMemory,
+            .software = (description.Flags & DXGI_ADAPTER_FLAG_SOFTWARE) != 0,
+            .supported = false
+        };
 
-    it = std::remove_if(std::begin(adapters), std::end(adapters), [] (auto &&adapter)
-    {
-        DXGI_ADAPTER_DESC1 description;
-        adapter->GetDesc1(&description);
+        if (auto supported = cache.supported(value); supported) {
+            value.supported = *supported;
+            value.resource_binding_tier = cache.resource_binding_tier(value).value_or(0);
+        }
 
-        if ((description.Flags & DXGI_ADAPTER_FLAG_SOFTWARE) != 0)
-            return true;
+        else {
+            // The binding tier is only known to a device, so one is created; the result is cached.
+            winrt::com_ptr<ID3D12Device6> device;
 
-        if (auto result = D3D12CreateDevice(adapter.get(), D3D_FEATURE_LEVEL_12_1, winrt::guid_of<ID3D12Device6>(), nullptr); FAILED(result))
-            return true;
+            if (SUCCEEDED(D3D12CreateDevice(adapter.get(), D3D_FEATURE_LEVEL_12_1, winrt::guid_of<ID3D12Device6>(), device.put_void()))) {
+                value.supported = true;
+                value.resource_binding_tier = graphics::resource_binding_tier(device.get());
+            }
 
-        return description.DedicatedVideoMemory == 0;
-    });
+            cache.store(value);
+        }
 
-    adapters.erase(it, std::end(adapters));
+        std::wcout << L"Adapter "s + value.name << std::endl;
 
-    std::sort(std::begin(adapters), std::end(adapters), [] (auto &&lhs, auto &&rhs)
-    {
-        DXGI_ADAPTER_DESC1 lhs_description;
-        lhs->GetDesc1(&lhs_description);
+        adapters.push_back(std::move(adapter4));
+        descriptions.push_back(std::move(value));
+    }
 
-        DXGI_ADAPTER_DESC1 rhs_description;
-        rhs->GetDesc1(&rhs_description);
+    if (cache.dirty()) {
+        if (std::ofstream file{cache_path}; file)
+            cache.save(file);
+    }
 
-        if (lhs_description.DedicatedVideoMemory != rhs_description.DedicatedVideoMemory)
-            return lhs_description.DedicatedVideoMemory > rhs_description.DedicatedVideoMemory;
+    auto const index = graphics::pick_adapter(descriptions, policy);
 
-        if (lhs_description.DedicatedSystemMemory != rhs_description.DedicatedSystemMemory)
-            return lhs_description.DedicatedSystemMemory > rhs_description.DedicatedSystemMemory;
+    if (index == graphics::kNO_ADAPTER) {
+        std::string below_tier;
 
-        return lhs_description.SharedSystemMemory > rhs_description.SharedSystemMemory;
-    });
+        for (auto &&description : descriptions) {
+            if (description.supported && description.resource_binding_tier < graphics::kREQUIRED_RESOURCE_BINDING_TIER)
+                below_tier += fmt::format("{}'{}' has tier {}"s, below_tier.empty() ? ""s : ", "s, winrt::to_string(description.name), description.resource_binding_tier);
+        }
 
-    if (adapters.empty())
-        throw dx::dxgi_factory("failed to pick hardware adapter"s);
+        if (!below_tier.empty())
+            throw dx::dxgi_factory(fmt::format("failed to pick hardware adapter: bindless descriptors need resource binding tier {}, {}"s,
+                                               graphics::kREQUIRED_RESOURCE_BINDING_TIER, below_tier));
 
-    if (auto adapter = adapters.front().try_as<IDXGIAdapter4>(); adapter == nullptr)
-        throw dx::dxgi_factory("failed to query 'IDXGIAdapter4' interface from adapter"s);
+        throw dx::dxgi_factory("failed to pick hardware adapter"s);
+    }
 
-    else return adapter;
+    return adapters[index];
 }
 
 winrt::com_ptr<ID3D12Device6> create_device(IDXGIAdapter4 *const hardware_adapter)
@@ -142,91 +273,39 @@ winrt::com_ptr<ID3D12Device6> create_device(IDXGIAdapter4 *const hardware_adapte
     return device;
 }
 
-winrt::com_ptr<IDXGISwapChain4>
-create_swapchain(IDXGIFactory7 *const factory, ID3D12CommandQueue *const queue, platform::window const &window,
-                 graphics::extent extent, DXGI_FORMAT format, std::uint32_t swapchain_buffer_count)
-{
-    auto [width, height] = extent;
-
-    DXGI_MODE_DESC const display_mode_description{
-        width, height,
-        DXGI_RATIONAL{60, 1},
-        format,
-        DXGI_MODE_SCANLINE_ORDER_UNSPECIFIED,
-        DXGI_MODE_SCALING_UNSPECIFIED
-    };
-
-    DXGI_SWAP_CHAIN_DESC description{
-        display_mode_description,
-        DXGI_SAMPLE_DESC{1, 0},
-        DXGI_USAGE_RENDER_TARGET_OUTPUT,
-        swapchain_buffer_count,
-        window.handle(),
-        TRUE,
-        DXGI_SWAP_EFFECT_FLIP_DISCARD,
-        DXGI_SWAP_CHAIN_FLAG_ALLOW_MODE_SWITCH
-    };
-
-    winrt::com_ptr<IDXGISwapChain> swap_chain;
-
-    if (auto result = factory->CreateSwapChain(queue, &description, swap_chain.put()); FAILED(result))
-        throw dx::dxgi_factory(fmt::format("failed to create a swap chain: {0:#x}"s, result));
-
-    if (auto sc = swap_chain.try_as<IDXGISwapChain4>(); sc == nullptr)
-        throw dx::dxgi_factory("failed to query 'IDXGISwapChain4' interface from swap chain"s);
-
-    else return sc;
-}
-
 D3D12_CPU_DESCRIPTOR_HANDLE
-current_back_buffer_view(ID3D12DescriptorHeap *const back_buffer, std::uint32_t current_back_buffer_index, std::uint32_t descriptor_byte_size)
+current_back_buffer_view(std::span<graphics::descriptor const> render_target_views, std::uint32_t current_back_buffer_index)
 {
-    auto handle_start = back_buffer->GetCPUDescriptorHandleForHeapStart();
-
-    return CD3DX12_CPU_DESCRIPTOR_HANDLE{handle_start, static_cast<std::int32_t>(current_back_buffer_index), descriptor_byte_size};
-}
-
-D3D12_CPU_DESCRIPTOR_HANDLE
-depth_stencil_buffer_view(ID3D12DescriptorHeap *const depth_stencil_buffer)
-{
-    return depth_stencil_buffer->GetCPUDescriptorHandleForHeapStart();
+    return render_target_views[current_back_buffer_index].cpu_handle;
 }
 
 std::vector<winrt::com_ptr<ID3D12Resource>>
-create_swapchain_buffers(ID3D12Device6 *const device, IDXGISwapChain4 *const swapchain, std::uint32_t swapchain_buffer_count,
-                      ID3D12DescriptorHeap *const rtv_descriptor_heap, std::uint32_t descriptor_byte_size)
+create_swapchain_buffers(ID3D12Device6 *const device, IDXGISwapChain4 *const swapchain, std::span<graphics::descriptor const> render_target_views,
+                         graphics::resource_state_registry &resource_states)
 {
-    std::vector<winrt::com_ptr<ID3D12Resource>> swapchain_buffers(swapchain_buffer_count);
-
-    auto rtv_heap_handle = static_cast<CD3DX12_CPU_DESCRIPTOR_HANDLE>(rtv_descriptor_heap->GetCPUDescriptorHandleForHeapStart());
+    std::vector<winrt::com_ptr<ID3D12Resource>> swapchain_buffers(std::size(render_target_views));
 
     std::generate(std::begin(swapchain_buffers), std::end(swapchain_buffers), [&, i = 0u] () mutable
     {
         winrt::com_ptr<ID3D12Resource> buffer;
 
-        if (auto result = swapchain->GetBuffer(i++, winrt::guid_of<ID3D12Resource>(), buffer.put_void()); FAILED(result))
+        if (auto result = swapchain->GetBuffer(i, winrt::guid_of<ID3D12Resource>(), buffer.put_void()); FAILED(result))
             throw dx::swapchain(fmt::format("failed to get swapchain buffer: {0:#x}"s, result));
 
-        device->CreateRenderTargetView(buffer.get(), nullptr, rtv_heap_handle);
+        device->CreateRenderTargetView(buffer.get(), nullptr, render_target_views[i++].cpu_handle);
+
+        resource_states.register_resource(buffer.get(), 1, D3D12_RESOURCE_STATE_PRESENT);
 
-        rtv_heap_handle.Offset(1, descriptor_byte_size);
-        
         return buffer;
     });
 
     return swapchain_buffers;
 }
 
-winrt::com_ptr<ID3D12Resource>
-create_depth_stencil_buffer(ID3D12Device6 *const device, ID3D12CommandAllocator *const command_allocator, ID3D12GraphicsCommandList5 *const command_list,
-                            ID3D12CommandQueue *const command_queue, ID3D12DescriptorHeap *const descriptor_heap, graphics::extent extent, DXGI_FORMAT format)
+std::uint32_t
+declare_depth_stencil_buffer(graphics::transient_resource_pool &transient_resources, graphics::render_graph_lifetime lifetime,
+                             graphics::extent extent, DXGI_FORMAT format)
 {
-    if (auto result = command_allocator->Reset(); FAILED(result))
-        throw dx::swapchain(fmt::format("failed to reset command allocator: {0:#x}"s, result));
-
-    if (auto result = command_list->Reset(command_allocator, nullptr); FAILED(result))
-        throw dx::swapchain(fmt::format("failed to reset command list: {0:#x}"s, result));
-
     auto [width, height] = extent;
 
 #if 1
@@ -254,19 +333,22 @@ create_depth_stencil_buffer(ID3D12Device6 *const device, ID3D12CommandAllocator
     };*/
 
     //auto constexpr initial_state = D3D12_RESOURCE_STATE_RENDER_TARGET;
-    auto constexpr initial_state = D3D12_RESOURCE_STATE_COMMON;
-    //auto constexpr initial_state = D3D12_RESOURCE_STATE_DEPTH_WRITE;
+    //auto constexpr initial_state = D3D12_RESOURCE_STATE_COMMON;
+    auto constexpr initial_state = D3D12_RESOURCE_STATE_DEPTH_WRITE;
 
     D3D12_CLEAR_VALUE const clear_value{
         .Format = format,
         .DepthStencil = D3D12_DEPTH_STENCIL_VALUE{1.f, 0}
     };
 
-    winrt::com_ptr<ID3D12Resource> buffer;
+    // The depth buffer is cleared by its first pass every frame, so it can share memory with targets of other passes.
+    return transient_resources.declare(description, lifetime.first, lifetime.last, initial_state, clear_value);
+}
 
-    if (auto result = device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES{D3D12_HEAP_TYPE_DEFAULT}, D3D12_HEAP_FLAG_NONE, &description,
-                                                      initial_state, &clear_value, winrt::guid_of<ID3D12Resource>(), buffer.put_void()); FAILED(result))
-        throw dx::swapchain(fmt::format("failed to create depth-stencil buffer: {0:#x}"s, result));
+void create_depth_stencil_view(ID3D12Device6 *const device, ID3D12Resource *const buffer, graphics::resource_state_registry &resource_states,
+                               D3D12_CPU_DESCRIPTOR_HANDLE buffer_view, DXGI_FORMAT format)
+{
+    resource_states.register_resource(buffer, 1, D3D12_RESOURCE_STATE_DEPTH_WRITE);
 
     D3D12_DEPTH_STENCIL_VIEW_DESC const view_description{
         .Format = format,
@@ -275,8 +357,6 @@ create_depth_stencil_buffer(ID3D12Device6 *const device, ID3D12CommandAllocator
         .Texture2D = D3D12_TEX2D_DSV{ .MipSlice = 0 }
     };
 
-    auto buffer_view = depth_stencil_buffer_view(descriptor_heap);
-
     /*try {
         auto x = buffer.get();
         auto y = &view_description;
@@ -285,55 +365,83 @@ create_depth_stencil_buffer(ID3D12Device6 *const device, ID3D12CommandAllocator
     } catch (std::exception const &ex) {
         std::cout << ex.what() << std::endl;
     }*/
-    device->CreateDepthStencilView(buffer.get(), &view_description, buffer_view);
+    device->CreateDepthStencilView(buffer, &view_description, buffer_view);
 
-    auto barriers = std::array{
-        CD3DX12_RESOURCE_BARRIER::Transition(buffer.get(), D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_DEPTH_WRITE)
-    };
-
-    command_list->ResourceBarrier(static_cast<UINT>(std::size(barriers)), std::data(barriers));
-    command_list->Close();
-
-    std::array<ID3D12CommandList *, 1> command_lists{command_list};
+    // Created in the state of its first use, so nothing has to be recorded or waited for here; the memory of
+    // a placed depth-stencil buffer has undefined contents until it is cleared, which the main pass does every frame.
+}
 
-    command_queue->ExecuteCommandLists(static_cast<UINT>(std::size(command_lists)), std::data(command_lists));
+void print_startup_timings(std::span<platform::startup_step_timing const> timings)
+{
+    using milliseconds = std::chrono::duration<double, std::milli>;
 
-    return buffer;
+    for (auto &&timing : timings) {
+        std::cout << fmt::format("startup: {0:<24} {1:>8.2f} ms at {2:>8.2f} ms on thread {3}\n"s, timing.name,
+                                 milliseconds{timing.duration}.count(), milliseconds{timing.start}.count(), timing.thread_index);
+    }
 }
 
-void flush_command_queue(ID3D12CommandQueue *const command_queue, ID3D12Fence1 *const fence)
+// Independent steps run concurrently on the job system; the window and the swapchain, which talks to
+// the window's message loop, are created on the calling thread.
+app::D3D init_D3D(graphics::extent extent, std::optional<platform::window> &window, std::string_view window_name)
 {
-    static UINT64 current_fence = 0;
+    auto job_system = std::make_unique<platform::job_system>();
+
+    auto resource_states = std::make_unique<graphics::resource_state_registry>();
+    auto render_graph_compiler = std::make_unique<graphics::render_graph_compiler>();
+
+    auto frame_contexts = create_frame_contexts(app::kSWAPCHAIN_BUFFER_COUNT, *resource_states);
 
-    if (auto result = command_queue->Signal(fence, ++current_fence); FAILED(result))
-        throw dx::swapchain(fmt::format("failed to update a fence: {0:#x}"s, result));
+    auto constexpr back_buffer_format = DXGI_FORMAT::DXGI_FORMAT_R8G8B8A8_UNORM;
 
-    if (fence->GetCompletedValue() < current_fence) {
-        auto event_handle = CreateEventEx(nullptr, nullptr, 0, EVENT_ALL_ACCESS);
+    winrt::com_ptr<IDXGIFactory7> dxgi_factory;
+    winrt::com_ptr<IDXGIAdapter4> hardware_adapter;
+    winrt::com_ptr<ID3D12Device6> device;
 
-        if (auto result = fence->SetEventOnCompletion(current_fence, event_handle); FAILED(result))
-            throw dx::swapchain(fmt::format("failed to specify a fence signaled event: {0:#x}"s, result));
+    std::unique_ptr<graphics::queue_scheduler> queues;
+    std::unique_ptr<graphics::command_pool> command_pool;
 
-        WaitForSingleObject(event_handle, INFINITE);
+    std::unique_ptr<graphics::swapchain> swapchain;
+    std::vector<winrt::com_ptr<ID3D12Resource>> swapchain_buffers;
 
-        CloseHandle(event_handle);
-    }
-}
+    std::unique_ptr<graphics::descriptor_allocator> descriptor_allocator;
+    std::unique_ptr<graphics::descriptor_ring> descriptor_ring;
+    std::unique_ptr<graphics::bindless_descriptors> bindless_descriptors;
 
-app::D3D init_D3D(graphics::extent extent, platform::window const &window)
-{
-    if constexpr (app::kDEBUG_D3D) {
-        winrt::com_ptr<ID3D12Debug3> debug_controller;
+    graphics::root_signature root_signature;
 
-        if (auto result = D3D12GetDebugInterface(winrt::guid_of<ID3D12Debug3>(), debug_controller.put_void()); FAILED(result))
-            throw dx::com_exception("failed get debug interface {0:#x}"s);
+    std::vector<graphics::descriptor> render_target_views(app::kSWAPCHAIN_BUFFER_COUNT);
+    graphics::descriptor depth_stencil_view;
 
-        debug_controller->EnableDebugLayer();
-    }
+    std::unique_ptr<graphics::upload_ring> upload_ring;
+    std::unique_ptr<graphics::upload_service> upload_service;
 
-    winrt::com_ptr<IDXGIFactory7> dxgi_factory;
+    std::unique_ptr<graphics::pipeline_cache> pipeline_cache;
+    std::unique_ptr<graphics::pipeline_compiler> pipeline_compiler;
+
+    std::unique_ptr<graphics::memory_allocator> memory_allocator;
+    std::unique_ptr<graphics::transient_resource_pool> transient_resources;
 
+    std::unique_ptr<graphics::indirect_draws> indirect_draws;
+
+    platform::startup_graph startup;
+
+    auto const window_step = startup.add_step("window"sv, [&]
+    {
+        window.emplace(window_name, static_cast<std::int32_t>(extent.width), static_cast<std::int32_t>(extent.height));
+    }, { }, platform::startup_thread::main);
+
+    auto const factory_step = startup.add_step("DXGI factory"sv, [&]
     {
+        if constexpr (app::kDEBUG_D3D) {
+            winrt::com_ptr<ID3D12Debug3> debug_controller;
+
+            if (auto result = D3D12GetDebugInterface(winrt::guid_of<ID3D12Debug3>(), debug_controller.put_void()); FAILED(result))
+                throw dx::com_exception("failed get debug interface {0:#x}"s);
+
+            debug_controller->EnableDebugLayer();
+        }
+
         UINT flags = 0;
 
         if constexpr (app::kDEBUG_D3D)
@@ -342,23 +450,19 @@ app::D3D init_D3D(graphics::extent extent, platform::window const &window)
         //if (auto result = CreateDXGIFactory2(flags, IID_IDXGIFactory7, dxgi_factory.put_void()); FAILED(result))
         if (auto result = CreateDXGIFactory2(flags, winrt::guid_of<IDXGIFactory7>(), dxgi_factory.put_void()); FAILED(result))
             throw dx::dxgi_factory(fmt::format("failed to create DXGI factory instance: {0:#x}"s, result));
-    }
-
-    auto hardware_adapter = pick_hardware_adapter(dxgi_factory.get());
-
-    auto device = create_device(hardware_adapter.get());
-
-    winrt::com_ptr<ID3D12Fence1> fence;
-
-    if (auto result = device->CreateFence(0, D3D12_FENCE_FLAG_NONE, winrt::guid_of<ID3D12Fence1>(), fence.put_void()); FAILED(result))
-        throw dx::device_error(fmt::format("failed to create a fence: {0:#x}"s, result));
+    });
 
-    auto const RTV_heap_size = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-    auto const DSV_heap_size = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
-    auto const CBV_SRV_UAV_heap_size = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+    auto const adapter_step = startup.add_step("adapter"sv, [&]
+    {
+        hardware_adapter = pick_hardware_adapter(dxgi_factory.get(), graphics::adapter_policy{ }, app::kADAPTER_CACHE_PATH);
+    }, {factory_step});
 
-    auto constexpr back_buffer_format = DXGI_FORMAT::DXGI_FORMAT_R8G8B8A8_UNORM;
+    auto const device_step = startup.add_step("device"sv, [&]
+    {
+        device = create_device(hardware_adapter.get());
+    }, {adapter_step});
 
+    startup.add_step("feature checks"sv, [&]
     {
         D3D12_FEATURE_DATA_MULTISAMPLE_QUALITY_LEVELS msaa_levels{
             back_buffer_format,
@@ -374,26 +478,100 @@ app::D3D init_D3D(graphics::extent extent, platform::window const &window)
 
         if (msaa_levels.NumQualityLevels < 1)
             throw dx::device_error("MSAA quality level lower than required level"s);
-    }
+    }, {device_step});
 
-    auto command_queue = create_command_queue(device.get(), D3D12_COMMAND_LIST_TYPE_DIRECT);
-    auto command_allocator = create_command_allocator(device.get(), D3D12_COMMAND_LIST_TYPE_DIRECT);
-    auto command_list = create_command_list(device.get(), command_allocator.get(), D3D12_COMMAND_LIST_TYPE_DIRECT);
+    auto const queue_step = startup.add_step("queues"sv, [&]
+    {
+        queues = std::make_unique<graphics::queue_scheduler>(device.get());
+        command_pool = std::make_unique<graphics::command_pool>(device.get());
+    }, {device_step});
+
+    auto const descriptor_step = startup.add_step("descriptor heaps"sv, [&]
+    {
+        descriptor_allocator = std::make_unique<graphics::descriptor_allocator>(device.get());
 
-    command_list->Close();
+        std::generate(std::begin(render_target_views), std::end(render_target_views), [&descriptor_allocator]
+        {
+            return descriptor_allocator->allocate(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+        });
 
-    auto swapchain = create_swapchain(dxgi_factory.get(), command_queue.get(), window, extent, back_buffer_format, app::kSWAPCHAIN_BUFFER_COUNT);
+        depth_stencil_view = descriptor_allocator->allocate(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
+    }, {device_step});
 
-    auto rtv_descriptor_heaps = create_descriptor_heaps(device.get(), D3D12_DESCRIPTOR_HEAP_TYPE::D3D12_DESCRIPTOR_HEAP_TYPE_RTV, app::kSWAPCHAIN_BUFFER_COUNT);
-    auto dsv_descriptor_heap = create_descriptor_heaps(device.get(), D3D12_DESCRIPTOR_HEAP_TYPE::D3D12_DESCRIPTOR_HEAP_TYPE_DSV, 1);
+    auto const descriptor_ring_step = startup.add_step("descriptor ring"sv, [&]
+    {
+        auto &&timeline = queues->timeline(graphics::queue_type::graphics);
 
-    auto swapchain_buffers = create_swapchain_buffers(device.get(), swapchain.get(), app::kSWAPCHAIN_BUFFER_COUNT,
-                                                      rtv_descriptor_heaps.get(), RTV_heap_size);
+        descriptor_ring = std::make_unique<graphics::descriptor_ring>(device.get(), timeline, app::kTRANSIENT_DESCRIPTOR_COUNT, app::kBINDLESS_VIEW_COUNT);
+        bindless_descriptors = std::make_unique<graphics::bindless_descriptors>(device.get(), *descriptor_ring, timeline, app::kBINDLESS_SAMPLER_COUNT);
+    }, {queue_step});
 
-    auto depth_stencil_buffer = create_depth_stencil_buffer(device.get(), command_allocator.get(), command_list.get(), command_queue.get(),
-                                                            dsv_descriptor_heap.get(), extent, graphics::kDEPTH_FORMAT);
+    auto const root_signature_step = startup.add_step("root signature"sv, [&]
+    {
+        root_signature = graphics::create_bindless_root_signature(device.get());
+    }, {device_step});
 
-    flush_command_queue(command_queue.get(), fence.get());
+    startup.add_step("upload heaps"sv, [&]
+    {
+        upload_ring = std::make_unique<graphics::upload_ring>(device.get(), queues->timeline(graphics::queue_type::graphics), app::kUPLOAD_RING_SIZE);
+        upload_service = std::make_unique<graphics::upload_service>(device.get(), *command_pool, *queues);
+    }, {queue_step});
+
+    auto const pipeline_cache_step = startup.add_step("pipeline cache"sv, [&]
+    {
+        pipeline_cache = std::make_unique<graphics::pipeline_cache>(device.get(), graphics::pipeline_cache_key_of(hardware_adapter.get()),
+                                                                    app::kPIPELINE_CACHE_PATH);
+
+        // Compilation must not take time away from the render thread and the frame's jobs.
+        pipeline_compiler = std::make_unique<graphics::pipeline_compiler>(graphics::pipeline_compiler::default_worker_count(), []
+        {
+            SetThreadPriority(GetCurrentThread(), THREAD_PRIORITY_BELOW_NORMAL);
+        });
+    }, {device_step});
+
+    // The depth-stencil buffer is transient: it is laid out with the lifetimes of the first compiled frame graph.
+    auto const memory_step = startup.add_step("memory"sv, [&]
+    {
+        memory_allocator = std::make_unique<graphics::memory_allocator>(device.get());
+        transient_resources = std::make_unique<graphics::transient_resource_pool>(device.get(), *memory_allocator);
+    }, {device_step});
+
+    startup.add_step("indirect draws"sv, [&]
+    {
+        indirect_draws = std::make_unique<graphics::indirect_draws>(device.get(), *memory_allocator, *resource_states, *bindless_descriptors,
+                                                                    root_signature, app::kINSTANCE_CAPACITY, app::kMESH_CAPACITY);
+
+        // Without the culling shader nothing is drawn indirectly, the rest of the frame doesn't depend on it.
+        try {
+            graphics::dxc_compiler compiler{{app::kSHADER_INCLUDE_PATH}};
+            graphics::shader_cache cache{app::kSHADER_CACHE_PATH};
+            graphics::shader_builder builder{compiler, cache, {app::kSHADER_INCLUDE_PATH}};
+
+            auto const shader = builder.build(graphics::shader_request{
+                std::filesystem::path{app::kSHADER_INCLUDE_PATH} / "cull_instances.hlsl"sv, "main"s, "cs_6_6"s, { }
+            });
+
+            indirect_draws->set_culling_pipeline(graphics::request_culling_pipeline(*pipeline_compiler, *pipeline_cache, root_signature, shader.binary));
+
+        } catch (std::exception const &exception) {
+            std::cerr << fmt::format("GPU culling is disabled: {0}\n"s, exception.what());
+        }
+    }, {descriptor_ring_step, root_signature_step, pipeline_cache_step, memory_step});
+
+    auto const swapchain_step = startup.add_step("swapchain"sv, [&]
+    {
+        graphics::swapchain_settings const settings{app::kSWAPCHAIN_BUFFER_COUNT, app::kMAX_FRAME_LATENCY, app::kPRESENT_MODE, back_buffer_format};
+
+        swapchain = std::make_unique<graphics::swapchain>(dxgi_factory.get(), queues->queue(graphics::queue_type::graphics), window->handle(),
+                                                          extent.width, extent.height, settings);
+    }, {window_step, queue_step}, platform::startup_thread::main);
+
+    startup.add_step("swapchain buffers"sv, [&]
+    {
+        swapchain_buffers = create_swapchain_buffers(device.get(), swapchain->get(), render_target_views, *resource_states);
+    }, {swapchain_step, descriptor_step});
+
+    print_startup_timings(startup.run(*job_system));
 
     return app::D3D{
         dxgi_factory,
@@ -401,33 +579,85 @@ app::D3D init_D3D(graphics::extent extent, platform::window const &window)
         hardware_adapter,
         device,
 
-        swapchain,
+        std::move(swapchain),
         swapchain_buffers,
-        depth_stencil_buffer,
+        nullptr,
+        { },
+
+        std::move(frame_contexts),
+        0,
+
+        std::move(queues),
+        std::move(command_pool),
+
+        std::move(descriptor_allocator),
+        std::move(descriptor_ring),
+        std::move(bindless_descriptors),
 
-        command_list,
-        command_allocator,
-        command_queue,
+        std::move(root_signature),
 
-        fence,
+        std::move(upload_ring),
+        std::move(upload_service),
+        std::move(pipeline_cache),
+        std::move(pipeline_compiler),
+        std::move(memory_allocator),
+        std::move(transient_resources),
+        std::move(indirect_draws),
+        std::move(resource_states),
+        std::move(render_graph_compiler),
 
-        rtv_descriptor_heaps,
-        dsv_descriptor_heap
+        std::move(job_system),
+
+        render_target_views,
+        depth_stencil_view
     };
 }
 
 void cleanup_D3D(app::D3D &d3d)
 {
-    d3d.dsv_descriptor_heap = nullptr;
-    d3d.rtv_descriptor_heaps = nullptr;
+    // Its worker may still be copying into the buffers released below.
+    d3d.upload_service.reset();
+
+    // Releases its views and placed buffers.
+    d3d.indirect_draws.reset();
+
+    for (auto &&view : d3d.render_target_views)
+        d3d.descriptor_allocator->free(view);
+
+    d3d.descriptor_allocator->free(d3d.depth_stencil_view);
+
+    d3d.render_target_views.clear();
+    d3d.descriptor_allocator.reset();
+    d3d.bindless_descriptors.reset();
+    d3d.descriptor_ring.reset();
+
+    d3d.root_signature = { };
+
+    d3d.upload_ring.reset();
+
+    // Cancels the queued compilations and finishes the running ones, which use the cache.
+    d3d.pipeline_compiler.reset();
 
-    d3d.swapchain = nullptr;
+    d3d.pipeline_cache->save();
+    d3d.pipeline_cache.reset();
 
-    d3d.command_list = nullptr;
-    d3d.command_allocator = nullptr;
-    d3d.command_queue = nullptr;
+    d3d.depth_stencil_buffer = nullptr;
 
-    d3d.fence = nullptr;
+    d3d.transient_resources.reset();
+    d3d.memory_allocator.reset();
+
+    d3d.resource_states.reset();
+    d3d.render_graph_compiler.reset();
+
+    d3d.job_system.reset();
+
+    d3d.swapchain.reset();
+    d3d.swapchain_buffers.clear();
+
+    d3d.frame_contexts.clear();
+    d3d.command_pool.reset();
+
+    d3d.queues.reset();
 
     d3d.device = nullptr;
     d3d.hardware_adapter = nullptr;
@@ -435,45 +665,239 @@ void cleanup_D3D(app::D3D &d3d)
     d3d.dxgi_factory = nullptr;
 }
 
-void draw(app::D3D &d3d, graphics::extent extent)
+graphics::frame_context &begin_frame(app::D3D &d3d)
 {
-    if (auto result = d3d.command_allocator->Reset(); FAILED(result))
-        throw dx::dxgi_factory(fmt::format("failed to reset a command allocator: {0:#x}"s, result));
+    auto &frame = d3d.frame_contexts.at(d3d.frame_index);
+
+    // Only the frame that was submitted from this slot 'frames in flight' frames ago has to be finished.
+    d3d.queues->timeline(graphics::queue_type::graphics).wait(frame.fence_value);
+
+    begin_command_lists(frame, *d3d.command_pool, D3D12_COMMAND_LIST_TYPE_DIRECT);
+
+    auto descriptor_heaps = d3d.bindless_descriptors->heaps();
 
-    if (auto result = d3d.command_list->Reset(d3d.command_allocator.get(), nullptr); FAILED(result))
-        throw dx::dxgi_factory(fmt::format("failed to reset a command list: {0:#x}"s, result));
+    frame.current_command_list->SetDescriptorHeaps(static_cast<UINT>(std::size(descriptor_heaps)), std::data(descriptor_heaps));
 
-    auto back_buffer_index = 0u;
+    d3d.bindless_descriptors->bind_graphics(frame.current_command_list, d3d.root_signature);
+
+    return frame;
+}
+
+// The GPU has to be done with them.
+void release_transient_resources(app::D3D &d3d)
+{
+    if (d3d.depth_stencil_buffer != nullptr)
+        d3d.resource_states->unregister_resource(d3d.depth_stencil_buffer);
+
+    d3d.depth_stencil_buffer = nullptr;
+    d3d.transient_lifetimes.clear();
+
+    d3d.transient_resources->clear();
+}
+
+// Places the transient resources for the pass positions of the compiled graph, so that resources whose lifetimes
+// don't intersect share memory. Frames in flight still use the previous layout and are waited for; that only happens
+// when the compiled graph or the window size changes.
+void build_transient_resources(app::D3D &d3d, graphics::compiled_render_graph const &compiled, std::uint32_t depth_stencil_buffer, graphics::extent extent)
+{
+    auto &&timeline = d3d.queues->timeline(graphics::queue_type::graphics);
+
+    timeline.wait(timeline.last_signaled_value());
+
+    release_transient_resources(d3d);
+
+    auto const depth_stencil_id = declare_depth_stencil_buffer(*d3d.transient_resources, compiled.lifetimes.at(depth_stencil_buffer),
+                                                               extent, graphics::kDEPTH_FORMAT);
+
+    d3d.transient_resources->build();
+
+    d3d.depth_stencil_buffer = d3d.transient_resources->resource(depth_stencil_id);
+
+    create_depth_stencil_view(d3d.device.get(), d3d.depth_stencil_buffer, *d3d.resource_states, d3d.depth_stencil_view.cpu_handle, graphics::kDEPTH_FORMAT);
+
+    d3d.transient_lifetimes = compiled.lifetimes;
+}
+
+// Only the frames in flight reference the old buffers, so only their fences are waited for; the other queues
+// keep running. The buffers and their views are then rebuilt in place.
+void resize_swapchain(app::D3D &d3d, graphics::extent extent)
+{
+    wait_for_frames_in_flight(d3d.frame_contexts, *d3d.queues);
+
+    for (auto &&buffer : d3d.swapchain_buffers)
+        d3d.resource_states->unregister_resource(buffer.get());
+
+    d3d.swapchain_buffers.clear();
+
+    d3d.swapchain->resize(extent.width, extent.height);
+
+    d3d.swapchain_buffers = create_swapchain_buffers(d3d.device.get(), d3d.swapchain->get(), d3d.render_target_views, *d3d.resource_states);
+
+    // The next frame lays the transient resources out again at the new size.
+    release_transient_resources(d3d);
+}
+
+void end_frame(app::D3D &d3d, graphics::frame_context &frame)
+{
+    frame.fence_value = submit_command_lists(frame, *d3d.command_pool, *d3d.queues, graphics::queue_type::graphics);
+
+    d3d.swapchain->present();
+
+    d3d.descriptor_ring->end_frame(frame.fence_value);
+    d3d.bindless_descriptors->end_frame(frame.fence_value);
+    d3d.upload_ring->end_frame(frame.fence_value);
+
+    d3d.frame_index = (d3d.frame_index + 1) % static_cast<std::uint32_t>(std::size(d3d.frame_contexts));
+}
+
+// Returns the fence value of the frame.
+UINT64 draw(app::D3D &d3d, graphics::extent extent)
+{
+    auto &frame = begin_frame(d3d);
+
+    auto back_buffer_index = d3d.swapchain->current_back_buffer_index();
 
     auto current_back_buffer = d3d.swapchain_buffers.at(back_buffer_index);
 
-    //current_back_buffer_view(d3d.rtv_descriptor_heaps.get(), back_buffer_index, );
+    auto const back_buffer_view = current_back_buffer_view(d3d.render_target_views, back_buffer_index);
 
-    auto barriers = std::array{
-        CD3DX12_RESOURCE_BARRIER::Transition(current_back_buffer.get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET)
-    };
+    graphics::render_graph graph;
 
-    d3d.command_list->ResourceBarrier(static_cast<UINT>(std::size(barriers)), std::data(barriers));
+    auto const back_buffer = graph.import_resource("back buffer"sv, graphics::resource_access::present, graphics::resource_access::present);
+    auto const depth_stencil_buffer = graph.create_resource("depth-stencil buffer"sv);
 
-    D3D12_VIEWPORT const viewport{
-        0, 0,
-        static_cast<float>(extent.width), static_cast<float>(extent.height),
-        0, 1
-    };
+    auto const instance_buffer = graph.import_resource("instance buffer"sv, graphics::resource_access::undefined, graphics::resource_access::undefined);
+    auto const mesh_buffer = graph.import_resource("mesh buffer"sv, graphics::resource_access::undefined, graphics::resource_access::undefined);
+    auto const command_buffer = graph.import_resource("draw command buffer"sv, graphics::resource_access::undefined, graphics::resource_access::undefined);
+    auto const count_buffer = graph.import_resource("draw count buffer"sv, graphics::resource_access::undefined, graphics::resource_access::undefined);
+
+    auto const instance_upload_pass = graph.add_pass("instance upload"sv, graphics::queue_type::graphics, [&d3d, &frame]
+    {
+        d3d.indirect_draws->upload(frame.current_command_list, *d3d.upload_ring);
+    });
+
+    graph.write(instance_upload_pass, instance_buffer, graphics::resource_access::copy_dest);
+    graph.write(instance_upload_pass, mesh_buffer, graphics::resource_access::copy_dest);
+    graph.write(instance_upload_pass, count_buffer, graphics::resource_access::copy_dest);
+
+    auto const culling_pass = graph.add_pass("culling"sv, graphics::queue_type::graphics, [&d3d, &frame]
+    {
+        // There is no camera yet: everything inside the clip space is visible.
+        auto const view_frustum = graphics::frustum_of({1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f});
+
+        d3d.indirect_draws->cull(frame.current_command_list, d3d.root_signature, *d3d.upload_ring, view_frustum);
+    });
+
+    graph.read(culling_pass, instance_buffer, graphics::resource_access::shader_read);
+    graph.read(culling_pass, mesh_buffer, graphics::resource_access::shader_read);
+    graph.write(culling_pass, command_buffer, graphics::resource_access::unordered_access);
+    graph.write(culling_pass, count_buffer, graphics::resource_access::unordered_access);
+
+    auto const main_pass = graph.add_pass("main"sv, graphics::queue_type::graphics, [&d3d, &frame, extent, back_buffer_view]
+    {
+        auto constexpr clear_color = std::array{0.f, 0.f, 0.f, 1.f};
+
+        frame.current_command_list->ClearRenderTargetView(back_buffer_view, std::data(clear_color), 0, nullptr);
+        frame.current_command_list->ClearDepthStencilView(d3d.depth_stencil_view.cpu_handle, D3D12_CLEAR_FLAG_DEPTH, 1.f, 0, 0, nullptr);
+
+        auto descriptor_heaps = d3d.bindless_descriptors->heaps();
+
+        record_parallel(frame, *d3d.command_pool, *d3d.job_system, app::kMAIN_PASS_BATCH_COUNT, descriptor_heaps,
+                        [&d3d, extent, back_buffer_view] (std::uint32_t batch, ID3D12GraphicsCommandList5 *const command_list)
+        {
+            d3d.bindless_descriptors->bind_graphics(command_list, d3d.root_signature);
+
+            command_list->OMSetRenderTargets(1, &back_buffer_view, FALSE, &d3d.depth_stencil_view.cpu_handle);
 
-    d3d.command_list->RSSetViewports(1, &viewport);
+            D3D12_VIEWPORT const viewport{
+                0, 0,
+                static_cast<float>(extent.width), static_cast<float>(extent.height),
+                0, 1
+            };
 
-    D3D12_RECT scissor{
-        0, 0,
-        static_cast<LONG>(extent.width), static_cast<LONG>(extent.height)
+            command_list->RSSetViewports(1, &viewport);
+
+            D3D12_RECT scissor{
+                0, 0,
+                static_cast<LONG>(extent.width), static_cast<LONG>(extent.height)
+            };
+
+            command_list->RSSetScissorRects(1, &scissor);
+
+            // All GPU-driven draws are one command.
+            if (batch == 0)
+                d3d.indirect_draws->execute(command_list);
+        });
+    });
+
+    graph.write(main_pass, back_buffer, graphics::resource_access::render_target);
+    graph.write(main_pass, depth_stencil_buffer, graphics::resource_access::depth_write);
+    graph.read(main_pass, instance_buffer, graphics::resource_access::shader_read);
+    graph.read(main_pass, mesh_buffer, graphics::resource_access::shader_read);
+    graph.read(main_pass, command_buffer, graphics::resource_access::indirect_argument);
+    graph.read(main_pass, count_buffer, graphics::resource_access::indirect_argument);
+
+    auto &&compiled = d3d.render_graph_compiler->compile(graph);
+
+    if (d3d.depth_stencil_buffer == nullptr || d3d.transient_lifetimes != compiled.lifetimes)
+        build_transient_resources(d3d, compiled, depth_stencil_buffer, extent);
+
+    auto const resources = std::array{
+        current_back_buffer.get(), d3d.depth_stencil_buffer,
+        d3d.indirect_draws->instance_buffer(), d3d.indirect_draws->mesh_buffer(),
+        d3d.indirect_draws->command_buffer(), d3d.indirect_draws->count_buffer()
     };
 
-    d3d.command_list->RSSetScissorRects(1, &scissor);
+    execute_render_graph(graph, compiled, frame, resources, *d3d.transient_resources);
+
+    end_frame(d3d, frame);
+
+    return frame.fence_value;
 }
 
 
-int main()
+// Compiles the shaders listed in a manifest into the shader cache, e.g. as a build step.
+int prebuild_shaders(std::filesystem::path const &manifest_path)
 {
+    std::ifstream manifest{manifest_path};
+
+    if (!manifest) {
+        std::cerr << fmt::format("failed to open the shader manifest {0}\n"s, manifest_path.string());
+        return EXIT_FAILURE;
+    }
+
+    auto const requests = graphics::parse_shader_manifest(manifest, manifest_path.parent_path());
+
+    platform::job_system job_system;
+
+    graphics::dxc_compiler compiler{{app::kSHADER_INCLUDE_PATH}};
+    graphics::shader_cache cache{app::kSHADER_CACHE_PATH};
+    graphics::shader_builder builder{compiler, cache, {app::kSHADER_INCLUDE_PATH}};
+
+    auto const start_time = std::chrono::steady_clock::now();
+
+    auto const results = builder.build(job_system, requests);
+
+    auto const duration = std::chrono::duration<double, std::milli>{std::chrono::steady_clock::now() - start_time};
+
+    for (auto &&result : results) {
+        if (!result.error.empty())
+            std::cerr << result.error << '\n';
+    }
+
+    auto const statistics = builder.statistics();
+
+    std::cout << fmt::format("{0} shaders in {1:.2f} ms: {2} compiled, {3} cached, {4} failed\n"s, std::size(requests), duration.count(),
+                             statistics.compiled, statistics.disk_hits + statistics.memory_hits, statistics.failed);
+
+    return statistics.failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+int main(int argc, char *argv[])
+{
+    if (argc == 3 && argv[1] == "--prebuild-shaders"sv)
+        return prebuild_shaders(argv[2]);
+
     if (auto result = glfwInit(); result != GLFW_TRUE)
         throw std::runtime_error(fmt::format("failed to init GLFW: {0:#x}\n"s, result));
 
@@ -483,16 +907,162 @@ int main()
 
     graphics::extent extent{800, 600};
 
-    platform::window window{"DX12 Project"sv, static_cast<std::int32_t>(extent.width), static_cast<std::int32_t>(extent.height)};
+    auto const start_time = std::chrono::steady_clock::now();
+
+    std::optional<platform::window> window;
+
+    auto d3d = init_D3D(extent, window, "DX12 Project"sv);
+
+    graphics::frame_pacer frame_pacer{graphics::frame_pacer_settings{
+        .enabled = app::kFRAME_PACING && app::kPRESENT_MODE == graphics::present_mode::vsync
+    }};
+
+    if (auto const refresh_period = graphics::swapchain::refresh_period(); refresh_period)
+        frame_pacer.set_refresh_period(*refresh_period);
+
+    graphics::resize_coalescer resize_coalescer{extent};
+
+    auto const resize_handler = std::make_shared<app::resize_handler>(resize_coalescer);
 
-    auto d3d = init_D3D(extent, window);
+    window->connect_event_handler(resize_handler);
 
-    window.update([]
+    // A frame whose wait has returned but which was skipped, e.g. because the window got minimized, keeps it.
+    auto frame_acquired = false;
+
+    // The loop waits for events instead of spinning while the window is minimized.
+    platform::frame_loop_settings const loop_settings{
+        .simulation_step = frame_pacer.statistics().period,
+        .on_demand = app::kRENDER_ON_DEMAND
+    };
+
+    // The pacer predicts the work of a frame from when the GPU finished the recent ones.
+    std::optional<graphics::frame_completion_timer> frame_completions{std::in_place, d3d.queues->timeline(graphics::queue_type::graphics)};
+
+    // The fence value of the last frame that hasn't been reported to the pacer.
+    std::optional<UINT64> unreported_frame;
+
+    auto const begin_frame = [&d3d, &frame_pacer, &resize_coalescer, &frame_acquired, &frame_completions, &unreported_frame]
     {
-        ;
-    });
+        if (resize_coalescer.minimized())
+            return;
+
+        if (!frame_acquired)
+            frame_acquired = d3d.swapchain->wait_for_frame();
+
+        // The frame is skipped rather than queued behind a present that hasn't been taken yet.
+        if (!frame_acquired) {
+            std::cerr << "the swapchain didn't take a frame within a second, the frame is skipped\n";
+            return;
+        }
+
+        // With a frame latency of one, the wait returns once the previous frame is displayed, so its fence
+        // has been reached already.
+        if (unreported_frame)
+            frame_pacer.end_frame(frame_completions->completion_time(*std::exchange(unreported_frame, std::nullopt)));
+
+        // Input is sampled by draining the events right after this.
+        graphics::sleep_until_precise(frame_pacer.begin_frame(graphics::frame_pacer::clock::now()));
+    };
+
+    auto render = [&d3d, &resize_coalescer, &frame_acquired, &frame_completions, &unreported_frame, start_time, first_frame = true] (double) mutable
+    {
+        if (resize_coalescer.minimized() || !frame_acquired)
+            return;
+
+        if (auto const size = resize_coalescer.poll(graphics::resize_coalescer::clock::now()); size)
+            resize_swapchain(d3d, *size);
+
+        auto const fence_value = draw(d3d, resize_coalescer.current());
+
+        frame_acquired = false;
+
+        frame_completions->submitted(fence_value);
+        unreported_frame = fence_value;
+
+        if (std::exchange(first_frame, false)) {
+            auto const time_to_first_frame = std::chrono::duration<double, std::milli>{std::chrono::steady_clock::now() - start_time};
+
+            std::cout << fmt::format("time to first frame: {0:.2f} ms\n"s, time_to_first_frame.count());
+        }
+    };
+
+    platform::frame_loop frame_loop{loop_settings};
+
+    std::exception_ptr render_exception;
+
+    // The main thread runs the window's message loop and pushes the window's events into its event queue,
+    // which the render thread drains once per frame.
+    std::thread render_thread{[&d3d, &window, &frame_loop, &begin_frame, &render, &render_exception]
+    {
+        // The main thread is done with the job system after startup; the frames record on it from here on.
+        d3d.job_system->take_ownership();
+
+        try {
+            frame_loop.run(window->events(), begin_frame, [] (std::chrono::nanoseconds) { return false; }, render);
+        }
+
+        catch (...) {
+            render_exception = std::current_exception();
+        }
+
+        window->close();
+    }};
+
+    window->pump_events();
+
+    render_thread.join();
+
+    auto const &loop = frame_loop.statistics();
+
+    if (loop.frames != 0) {
+        for (std::size_t index = 0; index < platform::kFRAME_STAGE_NUMBER; ++index) {
+            auto const stage = static_cast<platform::frame_stage>(index);
+
+            auto const average = std::chrono::duration<double, std::milli>{loop.total[stage]} / loop.frames;
+            auto const max = std::chrono::duration<double, std::milli>{loop.max[stage]};
+
+            std::cout << fmt::format("{0}: average {1:.3f} ms, max {2:.3f} ms\n"s, platform::name_of(stage), average.count(), max.count());
+        }
+    }
+
+    std::cout << fmt::format("{0} frames rendered, {1} idle waits\n"s, loop.frames, loop.idle_waits);
+
+    auto const events = window->events().statistics();
+
+    std::cout << fmt::format("{0} window events in {1} batches, {2} dropped\n"s, events.drained, events.batches, events.dropped);
+
+    auto const pacing = frame_pacer.statistics();
+
+    auto const latency = [&frame_pacer] (double percentile)
+    {
+        return std::chrono::duration<double, std::milli>{frame_pacer.latency_percentile(percentile)}.count();
+    };
+
+    std::cout << fmt::format("input-to-display latency: p50 {0:.2f} ms, p95 {1:.2f} ms, p99 {2:.2f} ms; {3} of {4} frames missed a vsync\n"s,
+                             latency(.5), latency(.95), latency(.99), pacing.missed, pacing.frames);
+
+    auto const resizes = resize_coalescer.statistics();
+
+    std::cout << fmt::format("{0} window size events, {1} swapchain resizes\n"s, resizes.events, resizes.resizes);
+
+    std::cout << fmt::format("transient resources: {0} KiB of heap, {1} KiB saved by aliasing\n"s,
+                             d3d.transient_resources->heap_size() / 1024, d3d.transient_resources->bytes_saved() / 1024);
+
+    // It waits on the graphics timeline, which cleanup_D3D() releases.
+    frame_completions.reset();
+
+    // The upload worker keeps submitting to the copy queue until it has drained its requests, so it is stopped
+    // before the queues are flushed; otherwise a batch submitted after the flush could still be reading its pages.
+    d3d.upload_service.reset();
+
+    d3d.queues->flush();
 
     cleanup_D3D(d3d);
 
     glfwTerminate();
+
+    // Only once the upload worker has stopped and the GPU is done with everything the frames used; rethrown
+    // right after the join, the exception would unwind past both while they are still running.
+    if (render_exception)
+        std::rethrow_exception(render_exception);
 }
@@ -10,7 +10,11 @@
 #include <algorithm>
 #include <execution>
 #include <exception>
+#include <filesystem>
+#include <fstream>
 #include <iostream>
+#include <span>
+#include <thread>
 #include <vector>
 
 #include <string>
@@ -22,7 +26,9 @@ using namespace std::string_view_literals;
 #include <fmt/format.h>
 
 #include <dxgi1_6.h>
+#include <dwmapi.h>
 #include <d3d12.h>
 #include <DX12/d3dx12.h>
+#include <dxcapi.h>
 
 #include <winrt/Windows.Graphics.Display.h>
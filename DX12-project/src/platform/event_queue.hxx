@@ -0,0 +1,384 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <semaphore>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+
+namespace platform
+{
+    struct resize_event final {
+        std::int32_t width{0}, height{0};
+    };
+
+    struct key_event final {
+        std::int32_t key{0}, scancode{0}, action{0}, mods{0};
+    };
+
+    struct cursor_event final {
+        double x{0.}, y{0.};
+    };
+
+    struct mouse_button_event final {
+        std::int32_t button{0}, action{0}, mods{0};
+    };
+
+    struct scroll_event final {
+        double x{0.}, y{0.};
+    };
+
+    struct focus_event final {
+        bool focused{false};
+    };
+
+    struct iconify_event final {
+        bool iconified{false};
+    };
+
+    using window_event = std::variant<resize_event, key_event, cursor_event, mouse_button_event, scroll_event, focus_event, iconify_event>;
+
+    static_assert(std::is_trivially_copyable_v<window_event>, "events are copied into the ring as they are");
+
+    // Notified on the thread that drains the event queue.
+    struct event_handler_interface {
+        virtual ~event_handler_interface() = default;
+
+        virtual void on_resize(std::int32_t width, std::int32_t height) = 0;
+
+        virtual void on_key(key_event const &) { }
+        virtual void on_cursor(cursor_event const &) { }
+        virtual void on_mouse_button(mouse_button_event const &) { }
+        virtual void on_scroll(scroll_event const &) { }
+        virtual void on_focus(bool) { }
+        virtual void on_iconify(bool) { }
+    };
+
+    // Bounded single-producer single-consumer ring. The indices only grow. The producer keeps a copy of the consumer's
+    // index and only reloads it when the ring looks full; the consumer reads the producer's index once per batch.
+    template<class T, std::size_t Capacity>
+    class spsc_ring final {
+    public:
+
+        static_assert(Capacity != 0 && (Capacity & (Capacity - 1)) == 0, "the capacity has to be a power of two");
+        static_assert(std::is_trivially_copyable_v<T>);
+
+        // Producer; false if the ring is full.
+        bool try_push(T const &value) noexcept
+        {
+            auto const tail = tail_.load(std::memory_order_relaxed);
+
+            if (tail - cached_head_ == Capacity) {
+                cached_head_ = head_.load(std::memory_order_acquire);
+
+                if (tail - cached_head_ == Capacity)
+                    return false;
+            }
+
+            items_[tail & (Capacity - 1)] = value;
+
+            tail_.store(tail + 1, std::memory_order_release);
+
+            return true;
+        }
+
+        // Consumer; calls 'function(value)' for up to 'max_count' values and frees their slots at once.
+        template<class F>
+        std::size_t drain(F &&function, std::size_t max_count = Capacity)
+        {
+            auto const head = head_.load(std::memory_order_relaxed);
+            auto const tail = tail_.load(std::memory_order_acquire);
+
+            auto const count = (std::min)(static_cast<std::size_t>(tail - head), max_count);
+
+            for (std::size_t index = 0; index < count; ++index)
+                function(items_[(head + index) & (Capacity - 1)]);
+
+            head_.store(head + count, std::memory_order_release);
+
+            return count;
+        }
+
+        // Either side; exact only when the other side is idle.
+        bool empty() const noexcept
+        {
+            return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+        }
+
+        static constexpr std::size_t capacity() noexcept { return Capacity; }
+
+    private:
+
+        static auto constexpr kCACHE_LINE_SIZE = std::size_t{64};
+
+        // Consumer side.
+        alignas(kCACHE_LINE_SIZE) std::atomic<std::uint64_t> head_{0};
+
+        // Producer side.
+        alignas(kCACHE_LINE_SIZE) std::atomic<std::uint64_t> tail_{0};
+        std::uint64_t cached_head_{0};
+
+        alignas(kCACHE_LINE_SIZE) std::array<T, Capacity> items_;
+    };
+
+    struct event_queue_statistics final {
+        std::uint64_t pushed{0};
+        std::uint64_t dropped{0};
+
+        std::uint64_t drained{0};
+        std::uint64_t batches{0};
+    };
+
+    // Window and input events from the thread that runs the window's message loop to the thread that renders.
+    // The platform thread pushes events as the window reports them; the render thread drains them in a batch per frame
+    // and notifies the event handlers. It is the frame loop's event source on the render thread (see platform::frame_loop).
+    // Nothing is allocated per event and the platform thread only takes the semaphore when the render thread sleeps.
+    class event_queue final {
+    public:
+
+        static auto constexpr kCAPACITY = std::size_t{1024};
+
+        // Platform thread. An event that doesn't fit is dropped and counted; the ring holds several frames of input.
+        // The latest size and iconified state are also kept outside the ring, so they survive a full ring.
+        void push(window_event const &event) noexcept
+        {
+            keep_state(event);
+
+            if (!ring_.try_push(event)) {
+                dropped_.fetch_add(1, std::memory_order_relaxed);
+
+                if (auto const state = state_of(event); state != 0) {
+                    dropped_state_.fetch_or(state, std::memory_order_release);
+                    wake();
+                }
+
+                return;
+            }
+
+            pushed_.fetch_add(1, std::memory_order_relaxed);
+
+            wake();
+        }
+
+        // Either thread.
+        void request_close() noexcept
+        {
+            close_requested_.store(true, std::memory_order_release);
+
+            wake();
+        }
+
+        bool close_requested() const noexcept { return close_requested_.load(std::memory_order_acquire); }
+
+        // Render thread, or before it starts. Handlers are kept alive while a batch is dispatched and are dropped
+        // once they expire.
+        void connect_event_handler(std::shared_ptr<event_handler_interface> handler)
+        {
+            handlers_.push_back(std::move(handler));
+            batch_handlers_.reserve(std::size(handlers_));
+        }
+
+        // The frame loop's event source, on the render thread.
+        bool should_close() const noexcept { return close_requested(); }
+
+        bool minimized() const noexcept { return iconified_ || empty_; }
+
+        void poll_events()
+        {
+            if (ring_.empty() && dropped_state_.load(std::memory_order_acquire) == 0)
+                return;
+
+            for (auto &&weak_handler : handlers_) {
+                if (auto handler = weak_handler.lock(); handler)
+                    batch_handlers_.push_back(std::move(handler));
+            }
+
+            auto const count = ring_.drain([this] (window_event const &event)
+            {
+                std::visit([this] (auto const &value) { dispatch(value); }, event);
+            });
+
+            // After the batch, since a dropped size or state is newer than anything in the ring.
+            if (auto const state = dropped_state_.exchange(0, std::memory_order_acquire); state != 0)
+                dispatch_dropped_state(state);
+
+            batch_handlers_.clear();
+
+            std::erase_if(handlers_, [] (auto const &handler) { return handler.expired(); });
+
+            event_count_ += count;
+            ++batches_;
+        }
+
+        void wait_events(std::chrono::nanoseconds timeout)
+        {
+            // Wake-ups left over from earlier waits.
+            while (wake_semaphore_.try_acquire());
+
+            sleeping_.store(true, std::memory_order_seq_cst);
+
+            // Pairs with the fence in wake(): either this sees the event or the producer sees the sleeping flag.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if (ring_.empty() && dropped_state_.load(std::memory_order_acquire) == 0 && !close_requested())
+                wake_semaphore_.try_acquire_for(timeout);
+
+            sleeping_.store(false, std::memory_order_relaxed);
+
+            poll_events();
+        }
+
+        std::uint64_t event_count() const noexcept { return event_count_; }
+
+        // Render thread.
+        event_queue_statistics statistics() const noexcept
+        {
+            return event_queue_statistics{
+                pushed_.load(std::memory_order_relaxed), dropped_.load(std::memory_order_relaxed), event_count_, batches_
+            };
+        }
+
+    private:
+
+        spsc_ring<window_event, kCAPACITY> ring_;
+
+        std::counting_semaphore<> wake_semaphore_{0};
+        std::atomic<bool> sleeping_{false};
+
+        std::atomic<bool> close_requested_{false};
+
+        static auto constexpr kSIZE_STATE = std::uint32_t{1};
+        static auto constexpr kICONIFIED_STATE = std::uint32_t{2};
+
+        // The latest size, width in the high half, and iconified state the platform thread pushed, and which of them
+        // were dropped since the last batch.
+        std::atomic<std::uint64_t> latest_size_{0};
+        std::atomic<bool> latest_iconified_{false};
+        std::atomic<std::uint32_t> dropped_state_{0};
+
+        std::atomic<std::uint64_t> pushed_{0};
+        std::atomic<std::uint64_t> dropped_{0};
+
+        // Render thread.
+        std::vector<std::weak_ptr<event_handler_interface>> handlers_;
+        std::vector<std::shared_ptr<event_handler_interface>> batch_handlers_;
+
+        std::uint64_t event_count_{0};
+        std::uint64_t batches_{0};
+
+        bool iconified_{false};
+        bool empty_{false};
+
+        // The last size the handlers were told of.
+        std::optional<std::uint64_t> size_;
+
+        static std::uint64_t pack(resize_event const &event) noexcept
+        {
+            return static_cast<std::uint64_t>(static_cast<std::uint32_t>(event.width)) << 32 | static_cast<std::uint32_t>(event.height);
+        }
+
+        static resize_event unpack(std::uint64_t size) noexcept
+        {
+            return resize_event{static_cast<std::int32_t>(size >> 32), static_cast<std::int32_t>(size & 0xFFFF'FFFF)};
+        }
+
+        static std::uint32_t state_of(window_event const &event) noexcept
+        {
+            if (std::holds_alternative<resize_event>(event))
+                return kSIZE_STATE;
+
+            if (std::holds_alternative<iconify_event>(event))
+                return kICONIFIED_STATE;
+
+            return 0;
+        }
+
+        // Platform thread.
+        void keep_state(window_event const &event) noexcept
+        {
+            if (auto const resize = std::get_if<resize_event>(&event); resize != nullptr)
+                latest_size_.store(pack(*resize), std::memory_order_relaxed);
+
+            else if (auto const iconify = std::get_if<iconify_event>(&event); iconify != nullptr)
+                latest_iconified_.store(iconify->iconified, std::memory_order_relaxed);
+        }
+
+        // Reports the latest of the dropped states where it differs from what the handlers were last told.
+        void dispatch_dropped_state(std::uint32_t state)
+        {
+            if ((state & kSIZE_STATE) != 0) {
+                if (auto const size = latest_size_.load(std::memory_order_relaxed); size != size_)
+                    dispatch(unpack(size));
+            }
+
+            if ((state & kICONIFIED_STATE) != 0) {
+                if (auto const iconified = latest_iconified_.load(std::memory_order_relaxed); iconified != iconified_)
+                    dispatch(iconify_event{iconified});
+            }
+        }
+
+        void wake() noexcept
+        {
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if (sleeping_.exchange(false, std::memory_order_seq_cst))
+                wake_semaphore_.release();
+        }
+
+        void dispatch(resize_event const &event)
+        {
+            size_ = pack(event);
+
+            empty_ = event.width <= 0 || event.height <= 0;
+
+            for (auto &&handler : batch_handlers_)
+                handler->on_resize(event.width, event.height);
+        }
+
+        void dispatch(key_event const &event)
+        {
+            for (auto &&handler : batch_handlers_)
+                handler->on_key(event);
+        }
+
+        void dispatch(cursor_event const &event)
+        {
+            for (auto &&handler : batch_handlers_)
+                handler->on_cursor(event);
+        }
+
+        void dispatch(mouse_button_event const &event)
+        {
+            for (auto &&handler : batch_handlers_)
+                handler->on_mouse_button(event);
+        }
+
+        void dispatch(scroll_event const &event)
+        {
+            for (auto &&handler : batch_handlers_)
+                handler->on_scroll(event);
+        }
+
+        void dispatch(focus_event const &event)
+        {
+            for (auto &&handler : batch_handlers_)
+                handler->on_focus(event.focused);
+        }
+
+        void dispatch(iconify_event const &event)
+        {
+            iconified_ = event.iconified;
+
+            for (auto &&handler : batch_handlers_)
+                handler->on_iconify(event.iconified);
+        }
+    };
+}
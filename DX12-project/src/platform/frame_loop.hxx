@@ -0,0 +1,218 @@
+#pragma once
+
+#include <algorithm>
+#include <array>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+
+
+namespace platform
+{
+    enum class frame_stage : std::uint8_t {
+        // Waiting before the frame: for the swapchain and the frame pacer, or for events while idle.
+        wait,
+        events,
+        simulation,
+        render
+    };
+
+    auto constexpr kFRAME_STAGE_NUMBER = static_cast<std::size_t>(frame_stage::render) + 1;
+
+    constexpr std::string_view name_of(frame_stage stage) noexcept
+    {
+        constexpr std::array<std::string_view, kFRAME_STAGE_NUMBER> kNAMES{"wait", "events", "simulation", "render"};
+
+        return kNAMES[static_cast<std::size_t>(stage)];
+    }
+
+    struct frame_loop_settings final {
+        // Of a simulation step; the simulation runs as many steps as the elapsed time holds.
+        std::chrono::nanoseconds simulation_step{16'666'667};
+
+        // Elapsed time beyond this many steps is dropped, so a long stall doesn't make every later frame catch up.
+        std::uint32_t max_steps_per_frame{8};
+
+        // An idle loop still wakes up this often without any event, e.g. to notice a closed window.
+        std::chrono::nanoseconds idle_timeout{std::chrono::milliseconds{500}};
+
+        // Only render when an event came or the simulation changed something; otherwise the loop waits for events.
+        bool on_demand{false};
+    };
+
+    struct frame_timing final {
+        std::array<std::chrono::nanoseconds, kFRAME_STAGE_NUMBER> stages{ };
+
+        std::uint32_t simulation_steps{0};
+
+        std::chrono::nanoseconds &operator[] (frame_stage stage) noexcept { return stages[static_cast<std::size_t>(stage)]; }
+        std::chrono::nanoseconds operator[] (frame_stage stage) const noexcept { return stages[static_cast<std::size_t>(stage)]; }
+    };
+
+    struct frame_loop_statistics final {
+        // Rendered ones.
+        std::uint64_t frames{0};
+
+        std::uint64_t simulation_steps{0};
+
+        // Times the loop slept in the event wait instead of rendering.
+        std::uint64_t idle_waits{0};
+
+        // Simulation time lost to the step limit.
+        std::chrono::nanoseconds dropped_time{0};
+
+        // Of the rendered frames, by stage.
+        frame_timing total;
+        frame_timing max;
+    };
+
+    // The loop of the thread that renders: waits for the frame to start, drains its event source, advances the simulation
+    // in fixed steps by the elapsed time and renders with the fraction of a step left over, for interpolation. While the
+    // window is minimized, or in the on-demand mode while nothing changes, it blocks in the source's event wait instead
+    // of spinning. The application runs it on a render thread over the window's event_queue, which the message loop
+    // fills on the window's thread; a platform::window is a source as well, for a loop on the window's own thread.
+    //
+    // 'EventSource' provides:
+    //     bool should_close();
+    //     bool minimized();
+    //     void poll_events();                          // doesn't block
+    //     void wait_events(std::chrono::nanoseconds);  // blocks until an event comes or the timeout
+    //     std::uint64_t event_count();                 // of the events received so far
+    //
+    // 'Clock' needs a now() that returns a std::chrono time point.
+    template<class Clock = std::chrono::steady_clock>
+    class frame_loop final {
+    public:
+
+        using time_point = decltype(std::declval<Clock &>().now());
+        using duration = std::chrono::nanoseconds;
+
+        explicit frame_loop(frame_loop_settings settings = { }, Clock clock = { }) : settings_{settings}, clock_{std::move(clock)} { }
+
+        // 'begin_frame()' runs before the events are polled and may block until the frame should start,
+        // 'simulate(step)' advances the simulation by one step and may return whether it is still changing,
+        // 'render(alpha)' gets how far the time is between the last and the next simulation step, in [0, 1).
+        template<class EventSource, class BeginFrame, class Simulate, class Render>
+        void run(EventSource &source, BeginFrame &&begin_frame, Simulate &&simulate, Render &&render)
+        {
+            auto last_events = source.event_count();
+            auto changed = true;
+
+            // As of the last simulation step.
+            auto animating = false;
+
+            // Events that no simulation step has seen yet; they may set the simulation in motion.
+            auto unsimulated = false;
+
+            auto const new_events = [&source, &last_events]
+            {
+                auto const count = source.event_count();
+
+                return std::exchange(last_events, count) != count;
+            };
+
+            auto previous = clock_.now();
+            auto accumulator = duration{0};
+
+            while (!source.should_close()) {
+                if (source.minimized() || (settings_.on_demand && !changed)) {
+                    source.wait_events(settings_.idle_timeout);
+
+                    ++statistics_.idle_waits;
+
+                    // The simulation is paused while nothing is shown or it has come to rest.
+                    previous = clock_.now();
+                    accumulator = duration{0};
+
+                    changed = unsimulated = new_events();
+                    continue;
+                }
+
+                frame_timing timing;
+
+                auto time = clock_.now();
+
+                auto const end_stage = [this, &timing, &time] (frame_stage stage)
+                {
+                    auto const now = clock_.now();
+
+                    timing[stage] = now - time;
+                    time = now;
+                };
+
+                begin_frame();
+                end_stage(frame_stage::wait);
+
+                source.poll_events();
+                end_stage(frame_stage::events);
+
+                if (new_events())
+                    unsimulated = true;
+
+                accumulator += time - previous;
+                previous = time;
+
+                if (auto const limit = settings_.simulation_step * settings_.max_steps_per_frame; accumulator > limit) {
+                    statistics_.dropped_time += accumulator - limit;
+                    accumulator = limit;
+                }
+
+                while (accumulator >= settings_.simulation_step) {
+                    if constexpr (std::is_void_v<std::invoke_result_t<Simulate &, duration>>)
+                        simulate(settings_.simulation_step);
+
+                    else animating = static_cast<bool>(simulate(settings_.simulation_step));
+
+                    accumulator -= settings_.simulation_step;
+                    ++timing.simulation_steps;
+
+                    unsimulated = false;
+                }
+
+                end_stage(frame_stage::simulation);
+
+                render(std::chrono::duration<double>{accumulator} / std::chrono::duration<double>{settings_.simulation_step});
+                end_stage(frame_stage::render);
+
+                record(timing);
+
+                // The rendered frame has shown the changes so far; a simulation that is still moving, or hasn't
+                // stepped since the last events, needs the next one.
+                changed = animating || unsimulated;
+            }
+        }
+
+        frame_loop_statistics const &statistics() const noexcept { return statistics_; }
+
+        frame_timing const &last_frame() const noexcept { return last_frame_; }
+
+        frame_loop_settings const &settings() const noexcept { return settings_; }
+
+    private:
+
+        frame_loop_settings settings_;
+        Clock clock_;
+
+        frame_loop_statistics statistics_;
+        frame_timing last_frame_;
+
+        void record(frame_timing const &timing) noexcept
+        {
+            ++statistics_.frames;
+            statistics_.simulation_steps += timing.simulation_steps;
+
+            for (std::size_t index = 0; index < kFRAME_STAGE_NUMBER; ++index) {
+                statistics_.total.stages[index] += timing.stages[index];
+                statistics_.max.stages[index] = (std::max)(statistics_.max.stages[index], timing.stages[index]);
+            }
+
+            statistics_.total.simulation_steps += timing.simulation_steps;
+            statistics_.max.simulation_steps = (std::max)(statistics_.max.simulation_steps, timing.simulation_steps);
+
+            last_frame_ = timing;
+        }
+    };
+}
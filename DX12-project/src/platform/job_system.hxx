@@ -0,0 +1,353 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <random>
+#include <stdexcept>
+#include <thread>
+#include <utility>
+#include <vector>
+
+
+namespace platform
+{
+    // Number of jobs in flight that a job_counter tracks; wait() returns when it drops to zero
+    // and rethrows the first exception thrown by one of the jobs.
+    class job_counter final {
+    public:
+
+        bool done() const noexcept { return pending_.load(std::memory_order_acquire) == 0; }
+
+    private:
+
+        friend class job_system;
+
+        std::atomic<std::uint32_t> pending_{0};
+
+        std::atomic_flag failed_;
+        std::exception_ptr exception_;
+    };
+
+    // Fixed-size pool of workers with one work-stealing deque per thread (Chase-Lev). A thread pushes and
+    // pops jobs at the bottom of its own deque, idle threads steal from the top of others. One thread outside the pool,
+    // the owner, takes part as thread 0: wait() executes jobs instead of blocking, so jobs may spawn and wait
+    // for other jobs, which stands in for continuations. The thread that creates the job system owns it until another
+    // one takes ownership, e.g. the main thread during startup and then the render thread; deque 0 has a single owner,
+    // so any other thread is turned away.
+    class job_system final {
+    public:
+
+        explicit job_system(std::uint32_t worker_count = default_worker_count()) : owner_{std::this_thread::get_id()}
+        {
+            threads_.reserve(worker_count + 1);
+
+            for (auto index = 0u; index < worker_count + 1; ++index)
+                threads_.push_back(std::make_unique<thread_state>(index));
+
+            workers_.reserve(worker_count);
+
+            for (auto index = 1u; index < worker_count + 1; ++index)
+                workers_.emplace_back([this, index] { work(index); });
+        }
+
+        ~job_system()
+        {
+            stop_.store(true, std::memory_order_release);
+
+            epoch_.fetch_add(1, std::memory_order_acq_rel);
+            epoch_.notify_all();
+
+            for (auto &&worker : workers_)
+                worker.join();
+        }
+
+        job_system(job_system const &) = delete;
+        job_system &operator=(job_system const &) = delete;
+
+        // The calling thread becomes the owner. The previous owner must be done with the job system, and its last use
+        // has to happen before this call, e.g. by having started the calling thread afterwards.
+        void take_ownership() noexcept
+        {
+            owner_.store(std::this_thread::get_id(), std::memory_order_relaxed);
+        }
+
+        // Has to be called from the owner thread or from a job.
+        void run(job_counter &counter, std::function<void()> function)
+        {
+            auto const index = caller_index();
+
+            counter.pending_.fetch_add(1, std::memory_order_relaxed);
+
+            auto job = new job_system::job{std::move(function), &counter};
+
+            // A full deque degrades to running the job in place.
+            if (!threads_[index]->jobs.push(job)) {
+                execute(job);
+                return;
+            }
+
+            // Pairs with the sleeping worker count increment: either the worker sees the job or this sees the worker.
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+
+            if (sleeping_workers_.load(std::memory_order_relaxed) != 0) {
+                epoch_.fetch_add(1, std::memory_order_acq_rel);
+                epoch_.notify_one();
+            }
+        }
+
+        // Calls 'function(begin, end)' for consecutive ranges of at most 'batch_size' indices of [0, count).
+        template<class F>
+        void parallel_for(std::uint32_t count, std::uint32_t batch_size, F &&function)
+        {
+            job_counter counter;
+
+            for (auto begin = 0u; begin < count; begin += batch_size) {
+                auto const end = (std::min)(count, begin + batch_size);
+
+                run(counter, [&function, begin, end] { function(begin, end); });
+            }
+
+            wait(counter);
+        }
+
+        // Has to be called from the owner thread or from a job.
+        void wait(job_counter &counter)
+        {
+            caller_index();
+
+            while (!counter.done()) {
+                if (!try_execute())
+                    std::this_thread::yield();
+            }
+
+            if (counter.exception_)
+                std::rethrow_exception(std::exchange(counter.exception_, nullptr));
+        }
+
+        // Executes one pending job, if there is any, on the calling thread.
+        bool try_execute()
+        {
+            if (auto job = find_job(caller_index()); job != nullptr) {
+                execute(job);
+                return true;
+            }
+
+            return false;
+        }
+
+        std::uint32_t thread_count() const noexcept { return static_cast<std::uint32_t>(std::size(threads_)); }
+
+        // Zero for the owner thread, or any other thread outside this pool, [1, thread_count()) for its workers.
+        std::uint32_t thread_index() const noexcept
+        {
+            return current_worker_.system == this ? current_worker_.index : 0;
+        }
+
+        static std::uint32_t default_worker_count() noexcept
+        {
+            auto const hardware_threads = std::thread::hardware_concurrency();
+
+            return hardware_threads > 1 ? hardware_threads - 1 : 1;
+        }
+
+    private:
+
+        struct job final {
+            std::function<void()> function;
+            job_counter *counter;
+        };
+
+        class deque final {
+        public:
+
+            bool push(job *const value) noexcept
+            {
+                auto const bottom = bottom_.load(std::memory_order_relaxed);
+                auto const top = top_.load(std::memory_order_acquire);
+
+                if (bottom - top >= static_cast<std::int64_t>(kCAPACITY))
+                    return false;
+
+                buffer_[bottom & kMASK].store(value, std::memory_order_relaxed);
+
+                std::atomic_thread_fence(std::memory_order_release);
+
+                bottom_.store(bottom + 1, std::memory_order_relaxed);
+
+                return true;
+            }
+
+            job *pop() noexcept
+            {
+                auto const bottom = bottom_.load(std::memory_order_relaxed) - 1;
+
+                bottom_.store(bottom, std::memory_order_relaxed);
+
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+
+                auto top = top_.load(std::memory_order_relaxed);
+
+                if (top > bottom) {
+                    bottom_.store(bottom + 1, std::memory_order_relaxed);
+                    return nullptr;
+                }
+
+                auto value = buffer_[bottom & kMASK].load(std::memory_order_relaxed);
+
+                // The last job races with thieves.
+                if (top == bottom) {
+                    if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                        value = nullptr;
+
+                    bottom_.store(bottom + 1, std::memory_order_relaxed);
+                }
+
+                return value;
+            }
+
+            job *steal() noexcept
+            {
+                auto top = top_.load(std::memory_order_acquire);
+
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+
+                auto const bottom = bottom_.load(std::memory_order_acquire);
+
+                if (top >= bottom)
+                    return nullptr;
+
+                auto value = buffer_[top & kMASK].load(std::memory_order_relaxed);
+
+                if (!top_.compare_exchange_strong(top, top + 1, std::memory_order_seq_cst, std::memory_order_relaxed))
+                    return nullptr;
+
+                return value;
+            }
+
+        private:
+
+            static std::uint64_t constexpr kCAPACITY = 1u << 12;
+            static std::uint64_t constexpr kMASK = kCAPACITY - 1;
+
+            alignas(64) std::atomic<std::int64_t> top_{0};
+            alignas(64) std::atomic<std::int64_t> bottom_{0};
+
+            std::array<std::atomic<job *>, kCAPACITY> buffer_{};
+        };
+
+        // The deque of a thread, and the generator that picks the deques it steals from; only that thread uses the generator.
+        struct thread_state final {
+            explicit thread_state(std::uint32_t index) : random{index + 1} { }
+
+            deque jobs;
+            std::minstd_rand random;
+        };
+
+        // Set on the workers only. It names the pool along with the index, so a worker of one job system that calls
+        // into another one is an outside thread there rather than one of its workers.
+        struct worker final {
+            job_system const *system;
+            std::uint32_t index;
+        };
+
+        static inline thread_local worker current_worker_{nullptr, 0};
+
+        std::vector<std::unique_ptr<thread_state>> threads_;
+        std::vector<std::thread> workers_;
+
+        // Only read by threads outside the pool.
+        std::atomic<std::thread::id> owner_;
+
+        std::atomic<bool> stop_{false};
+
+        // Idle workers sleep on the epoch, it is bumped when new work may be there.
+        std::atomic<std::uint32_t> epoch_{0};
+        std::atomic<std::uint32_t> sleeping_workers_{0};
+
+        static void execute(job *const value)
+        {
+            auto &&counter = *value->counter;
+
+            try {
+                value->function();
+
+            } catch (...) {
+                if (!counter.failed_.test_and_set(std::memory_order_relaxed))
+                    counter.exception_ = std::current_exception();
+            }
+
+            // Publishes the exception to the waiting thread.
+            counter.pending_.fetch_sub(1, std::memory_order_acq_rel);
+
+            delete value;
+        }
+
+        std::uint32_t caller_index() const
+        {
+            if (current_worker_.system == this)
+                return current_worker_.index;
+
+            if (owner_.load(std::memory_order_relaxed) == std::this_thread::get_id())
+                return 0;
+
+            throw std::logic_error("the job system is used from a thread that neither owns it nor is one of its workers");
+        }
+
+        job *find_job(std::uint32_t index)
+        {
+            if (auto value = threads_[index]->jobs.pop(); value != nullptr)
+                return value;
+
+            auto const count = static_cast<std::uint32_t>(std::size(threads_));
+            auto const first = static_cast<std::uint32_t>(threads_[index]->random() % count);
+
+            for (auto offset = 0u; offset < count; ++offset) {
+                auto const victim = (first + offset) % count;
+
+                if (victim == index)
+                    continue;
+
+                if (auto value = threads_[victim]->jobs.steal(); value != nullptr)
+                    return value;
+            }
+
+            return nullptr;
+        }
+
+        void work(std::uint32_t index)
+        {
+            current_worker_ = worker{this, index};
+
+            auto constexpr kSPIN_COUNT = 64u;
+
+            while (!stop_.load(std::memory_order_acquire)) {
+                auto const epoch = epoch_.load(std::memory_order_acquire);
+
+                job *value = nullptr;
+
+                for (auto spin = 0u; spin < kSPIN_COUNT && value == nullptr; ++spin)
+                    value = find_job(index);
+
+                if (value != nullptr) {
+                    execute(value);
+                    continue;
+                }
+
+                sleeping_workers_.fetch_add(1, std::memory_order_seq_cst);
+
+                // Work pushed after the epoch was read bumps it, so the wait returns immediately.
+                if ((value = find_job(index)) == nullptr)
+                    epoch_.wait(epoch, std::memory_order_acquire);
+
+                sleeping_workers_.fetch_sub(1, std::memory_order_acq_rel);
+
+                if (value != nullptr)
+                    execute(value);
+            }
+        }
+    };
+}
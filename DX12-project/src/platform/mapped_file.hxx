@@ -0,0 +1,62 @@
+#pragma once
+
+#include <cstddef>
+#include <filesystem>
+#include <span>
+
+#include "main.hxx"
+
+
+namespace platform
+{
+    // Read-only mapping of a whole file. A missing or empty file maps to no bytes.
+    class mapped_file final {
+    public:
+
+        explicit mapped_file(std::filesystem::path const &path)
+        {
+            file_ = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+
+            if (file_ == INVALID_HANDLE_VALUE)
+                return;
+
+            LARGE_INTEGER size;
+
+            if (!GetFileSizeEx(file_, &size) || size.QuadPart == 0)
+                return;
+
+            if (mapping_ = CreateFileMappingW(file_, nullptr, PAGE_READONLY, 0, 0, nullptr); mapping_ == nullptr)
+                return;
+
+            if (view_ = MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0); view_ == nullptr)
+                return;
+
+            size_ = static_cast<std::size_t>(size.QuadPart);
+        }
+
+        ~mapped_file()
+        {
+            if (view_ != nullptr)
+                UnmapViewOfFile(view_);
+
+            if (mapping_ != nullptr)
+                CloseHandle(mapping_);
+
+            if (file_ != INVALID_HANDLE_VALUE)
+                CloseHandle(file_);
+        }
+
+        mapped_file(mapped_file const &) = delete;
+        mapped_file &operator=(mapped_file const &) = delete;
+
+        std::span<std::byte const> bytes() const noexcept { return {static_cast<std::byte const *>(view_), size_}; }
+
+    private:
+
+        HANDLE file_{INVALID_HANDLE_VALUE};
+        HANDLE mapping_{nullptr};
+
+        void const *view_{nullptr};
+        std::size_t size_{0};
+    };
+}
@@ -0,0 +1,187 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <initializer_list>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+#include "platform/job_system.hxx"
+
+
+namespace platform
+{
+    enum class startup_thread : std::uint8_t {
+        any, main
+    };
+
+    struct startup_step_timing final {
+        std::string_view name;
+
+        // Relative to the start of the run.
+        std::chrono::steady_clock::duration start{0};
+        std::chrono::steady_clock::duration duration{0};
+
+        std::uint32_t thread_index{0};
+    };
+
+    // Initialization split into steps with explicit dependencies. A step starts as soon as the steps it depends on
+    // have finished, so independent ones overlap on the job system. Dependencies can only name steps that were added
+    // before, which keeps the graph acyclic. Steps pinned to the main thread (window creation, anything that talks to
+    // the window's message loop) run on the thread that calls run().
+    class startup_graph final {
+    public:
+
+        std::uint32_t add_step(std::string_view name, std::function<void()> function,
+                               std::initializer_list<std::uint32_t> dependencies = { }, startup_thread thread = startup_thread::any)
+        {
+            auto const index = static_cast<std::uint32_t>(std::size(steps_));
+
+            for (auto dependency : dependencies) {
+                if (dependency >= index)
+                    throw std::invalid_argument("a startup step can only depend on steps added before it");
+
+                steps_[dependency].dependents.push_back(index);
+            }
+
+            steps_.push_back(step{name, std::move(function), static_cast<std::uint32_t>(std::size(dependencies)), { }, thread});
+
+            return index;
+        }
+
+        // Has to be called from the job system's owner thread. Rethrows the first exception thrown by a step
+        // once the steps that were already running have finished; the steps that haven't started by then are skipped.
+        std::vector<startup_step_timing> run(job_system &jobs)
+        {
+            run_state state{jobs, std::size(steps_)};
+
+            for (auto index = 0u; index < std::size(steps_); ++index)
+                state.remaining_dependencies[index].store(steps_[index].dependency_count, std::memory_order_relaxed);
+
+            for (auto index = 0u; index < std::size(steps_); ++index) {
+                if (steps_[index].dependency_count == 0)
+                    launch(state, index);
+            }
+
+            while (state.unfinished.load(std::memory_order_acquire) != 0) {
+                if (auto index = pop_main_thread_step(state); index != kNO_STEP)
+                    execute(state, index);
+
+                else if (!jobs.try_execute())
+                    std::this_thread::yield();
+            }
+
+            jobs.wait(state.counter);
+
+            if (state.exception)
+                std::rethrow_exception(state.exception);
+
+            return std::move(state.timings);
+        }
+
+        std::size_t step_count() const noexcept { return std::size(steps_); }
+
+    private:
+
+        static auto constexpr kNO_STEP = std::numeric_limits<std::uint32_t>::max();
+
+        struct step final {
+            std::string_view name;
+            std::function<void()> function;
+
+            std::uint32_t dependency_count{0};
+            std::vector<std::uint32_t> dependents;
+
+            startup_thread thread{startup_thread::any};
+        };
+
+        struct run_state final {
+            run_state(job_system &jobs, std::size_t step_count)
+                : jobs{jobs}, start{std::chrono::steady_clock::now()}, unfinished{step_count},
+                  remaining_dependencies{std::make_unique<std::atomic<std::uint32_t>[]>(step_count)}, timings(step_count) { }
+
+            job_system &jobs;
+
+            std::chrono::steady_clock::time_point start;
+
+            std::atomic<std::size_t> unfinished{0};
+            std::unique_ptr<std::atomic<std::uint32_t>[]> remaining_dependencies;
+
+            std::vector<startup_step_timing> timings;
+
+            job_counter counter;
+
+            std::mutex mutex;
+            std::deque<std::uint32_t> main_thread_steps;
+
+            std::atomic_flag failed;
+            std::exception_ptr exception;
+        };
+
+        std::vector<step> steps_;
+
+        void launch(run_state &state, std::uint32_t index)
+        {
+            if (steps_[index].thread == startup_thread::main) {
+                std::unique_lock lock{state.mutex};
+
+                state.main_thread_steps.push_back(index);
+            }
+
+            else state.jobs.run(state.counter, [this, &state, index] { execute(state, index); });
+        }
+
+        static std::uint32_t pop_main_thread_step(run_state &state)
+        {
+            std::unique_lock lock{state.mutex};
+
+            if (state.main_thread_steps.empty())
+                return kNO_STEP;
+
+            auto const index = state.main_thread_steps.front();
+            state.main_thread_steps.pop_front();
+
+            return index;
+        }
+
+        void execute(run_state &state, std::uint32_t index)
+        {
+            auto &&value = steps_[index];
+            auto &&timing = state.timings[index];
+
+            auto const start = std::chrono::steady_clock::now();
+
+            timing.name = value.name;
+            timing.start = start - state.start;
+            timing.thread_index = state.jobs.thread_index();
+
+            if (!state.failed.test(std::memory_order_acquire)) {
+                try {
+                    value.function();
+
+                } catch (...) {
+                    if (!state.failed.test_and_set(std::memory_order_acq_rel))
+                        state.exception = std::current_exception();
+                }
+            }
+
+            timing.duration = std::chrono::steady_clock::now() - start;
+
+            for (auto dependent : value.dependents) {
+                if (state.remaining_dependencies[dependent].fetch_sub(1, std::memory_order_acq_rel) == 1)
+                    launch(state, dependent);
+            }
+
+            state.unfinished.fetch_sub(1, std::memory_order_acq_rel);
+        }
+    };
+}
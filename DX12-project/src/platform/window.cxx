@@ -1,4 +1,5 @@
 #include <stdexcept>
+#include <utility>
 using namespace std::string_literals;
 
 #include <fmt/format.h>
@@ -31,35 +32,75 @@ namespace platform
 
     void window::connect_event_handler(std::shared_ptr<event_handler_interface> handler)
     {
-        using boost::placeholders::_1;
-        using boost::placeholders::_2;
+        events_.connect_event_handler(std::move(handler));
+    }
+
+    void window::pump_events()
+    {
+        while (!should_close())
+            glfwWaitEvents();
 
-        resize_callback_.connect(decltype(resize_callback_)::slot_type(
-            &event_handler_interface::on_resize, handler.get(), _1, _2
-        ).track_foreign(handler));
+        events_.request_close();
     }
 
-    void window::update(std::function<void()> &&callback)
+    void window::close() noexcept
     {
-        while (glfwWindowShouldClose(handle_) == GLFW_FALSE && glfwGetKey(handle_, GLFW_KEY_ESCAPE) != GLFW_PRESS) {
-            glfwPollEvents();
+        events_.request_close();
 
-            callback();
-        }
+        // Wakes up the message loop.
+        glfwPostEmptyEvent();
+    }
+
+    void window::push_event(GLFWwindow *handle, window_event const &event) noexcept
+    {
+        if (auto instance = reinterpret_cast<window *>(glfwGetWindowUserPointer(handle)); instance)
+            instance->events_.push(event);
     }
 
     void window::set_callbacks()
     {
         glfwSetWindowSizeCallback(handle_, [] (auto handle, auto width, auto height)
         {
-            auto instance = reinterpret_cast<window *>(glfwGetWindowUserPointer(handle));
-
-            if (instance) {
+            if (auto instance = reinterpret_cast<window *>(glfwGetWindowUserPointer(handle)); instance) {
                 instance->width_ = width;
                 instance->height_ = height;
-
-                instance->resize_callback_(width, height);
             }
+
+            push_event(handle, resize_event{width, height});
+        });
+
+        // Instead of polling the key state every frame.
+        glfwSetKeyCallback(handle_, [] (auto handle, auto key, auto scancode, auto action, auto mods)
+        {
+            if (key == GLFW_KEY_ESCAPE && action == GLFW_PRESS)
+                glfwSetWindowShouldClose(handle, GLFW_TRUE);
+
+            push_event(handle, key_event{key, scancode, action, mods});
+        });
+
+        glfwSetCursorPosCallback(handle_, [] (auto handle, auto x, auto y)
+        {
+            push_event(handle, cursor_event{x, y});
+        });
+
+        glfwSetMouseButtonCallback(handle_, [] (auto handle, auto button, auto action, auto mods)
+        {
+            push_event(handle, mouse_button_event{button, action, mods});
+        });
+
+        glfwSetScrollCallback(handle_, [] (auto handle, auto x, auto y)
+        {
+            push_event(handle, scroll_event{x, y});
+        });
+
+        glfwSetWindowFocusCallback(handle_, [] (auto handle, auto focused)
+        {
+            push_event(handle, focus_event{focused == GLFW_TRUE});
+        });
+
+        glfwSetWindowIconifyCallback(handle_, [] (auto handle, auto iconified)
+        {
+            push_event(handle, iconify_event{iconified == GLFW_TRUE});
         });
     }
 }
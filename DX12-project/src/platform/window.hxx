@@ -1,16 +1,18 @@
 #pragma once
 
+#include <chrono>
 #include <cstdint>
 #include <memory>
 #include <string>
 #include <string_view>
 
-#include <boost/signals2.hpp>
-
 #define GLFW_EXPOSE_NATIVE_WIN32
 #include <GLFW/glfw3.h>
 #include <GLFW/glfw3native.h>
 
+#include "platform/event_queue.hxx"
+#include "platform/frame_loop.hxx"
+
 
 namespace platform
 {
@@ -21,16 +23,54 @@ namespace platform
 
         ~window();
 
-        void update(std::function<void()> &&callback);
+        // Runs the frame loop until the window is closed; see platform::frame_loop for the callables.
+        template<class BeginFrame, class Simulate, class Render>
+        frame_loop_statistics update(frame_loop_settings const &settings, BeginFrame &&begin_frame, Simulate &&simulate, Render &&render)
+        {
+            frame_loop loop{settings};
 
-        HWND handle() const noexcept { return glfwGetWin32Window(handle_); }
+            loop.run(*this, std::forward<BeginFrame>(begin_frame), std::forward<Simulate>(simulate), std::forward<Render>(render));
+
+            return loop.statistics();
+        }
+
+        template<class Callback>
+        frame_loop_statistics update(Callback &&callback)
+        {
+            return update(frame_loop_settings{ }, [] { }, [] (auto) { }, [&callback] (double) { callback(); });
+        }
+
+        // Runs the message loop on the thread that created the window while another thread renders with events()
+        // as its event source; returns once the window is closed or close() is called.
+        void pump_events();
+
+        // Any thread.
+        void close() noexcept;
 
-        struct event_handler_interface {
-            virtual ~event_handler_interface() = default;
+        // The event source of the frame loop when it runs on the window's thread.
+        bool should_close() const noexcept { return glfwWindowShouldClose(handle_) == GLFW_TRUE || events_.close_requested(); }
 
-            virtual void on_resize(std::int32_t width, std::int32_t height) = 0;
-        };
+        bool minimized() const noexcept { return glfwGetWindowAttrib(handle_, GLFW_ICONIFIED) == GLFW_TRUE || width_ == 0 || height_ == 0; }
 
+        void poll_events()
+        {
+            glfwPollEvents();
+            events_.poll_events();
+        }
+
+        void wait_events(std::chrono::nanoseconds timeout)
+        {
+            glfwWaitEventsTimeout(std::chrono::duration<double>{timeout}.count());
+            events_.poll_events();
+        }
+
+        std::uint64_t event_count() const noexcept { return events_.event_count(); }
+
+        HWND handle() const noexcept { return glfwGetWin32Window(handle_); }
+
+        event_queue &events() noexcept { return events_; }
+
+        // The handlers are notified where the events are drained.
         void connect_event_handler(std::shared_ptr<event_handler_interface> handler);
 
     private:
@@ -41,8 +81,10 @@ namespace platform
 
         std::string name_;
 
-        boost::signals2::signal<void(std::int32_t, std::int32_t)> resize_callback_;
+        event_queue events_;
 
         void set_callbacks();
+
+        static void push_event(GLFWwindow *handle, window_event const &event) noexcept;
     };
 }
@@ -0,0 +1,110 @@
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <future>
+#include <mutex>
+#include <unordered_map>
+#include <utility>
+
+
+namespace utility
+{
+    // Memoizes values by a precomputed hash. Concurrent requests for a key that is still being created
+    // share the first request's result instead of creating it again. A failed creation is forgotten,
+    // so a later request retries it; the requests that were waiting get the exception.
+    template<class T>
+    class deduplicating_map final {
+    public:
+
+        struct statistics final {
+            std::uint64_t created{0};
+            std::uint64_t reused{0};
+        };
+
+        template<class F>
+        T get_or_create(std::uint64_t key, F &&create)
+        {
+            std::promise<T> promise;
+
+            {
+                std::unique_lock lock{mutex_};
+
+                if (auto it = values_.find(key); it != std::end(values_)) {
+                    ++statistics_.reused;
+
+                    auto future = it->second;
+
+                    lock.unlock();
+
+                    return future.get();
+                }
+
+                values_.emplace(key, promise.get_future().share());
+
+                ++statistics_.created;
+            }
+
+            try {
+                auto value = create();
+
+                promise.set_value(value);
+
+                return value;
+
+            } catch (...) {
+                // Erased first, so for_each() never sees a failed value.
+                {
+                    std::unique_lock lock{mutex_};
+
+                    values_.erase(key);
+                }
+
+                promise.set_exception(std::current_exception());
+
+                throw;
+            }
+        }
+
+        bool contains(std::uint64_t key) const
+        {
+            std::unique_lock lock{mutex_};
+
+            return values_.contains(key);
+        }
+
+        std::size_t size() const
+        {
+            std::unique_lock lock{mutex_};
+
+            return std::size(values_);
+        }
+
+        statistics counters() const
+        {
+            std::unique_lock lock{mutex_};
+
+            return statistics_;
+        }
+
+        // Calls 'function(key, value)' for every value that has been created successfully.
+        template<class F>
+        void for_each(F &&function) const
+        {
+            std::unique_lock lock{mutex_};
+
+            for (auto &&[key, future] : values_) {
+                if (future.wait_for(std::chrono::seconds{0}) == std::future_status::ready)
+                    function(key, future.get());
+            }
+        }
+
+    private:
+
+        mutable std::mutex mutex_;
+
+        std::unordered_map<std::uint64_t, std::shared_future<T>> values_;
+
+        statistics statistics_;
+    };
+}
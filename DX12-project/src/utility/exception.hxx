@@ -1,25 +1,37 @@
 #pragma once
 
-#include <exception>
+#include <stdexcept>
 #include <string>
 
 
 namespace dx
 {
-    struct com_exception : public std::exception {
-        explicit com_exception(std::string const &what_arg) : std::exception(what_arg.c_str()) { }
+    struct com_exception : public std::runtime_error {
+        explicit com_exception(std::string const &what_arg) : std::runtime_error(what_arg) { }
     };
 
-    struct dxgi_factory : public std::exception {
-        explicit dxgi_factory(std::string const &what_arg) : std::exception(what_arg.c_str()) { }
+    struct dxgi_factory : public std::runtime_error {
+        explicit dxgi_factory(std::string const &what_arg) : std::runtime_error(what_arg) { }
     };
 
-    struct device_error : public std::exception {
-        explicit device_error(std::string const &what_arg) : std::exception(what_arg.c_str()) { }
+    struct device_error : public std::runtime_error {
+        explicit device_error(std::string const &what_arg) : std::runtime_error(what_arg) { }
     };
 
-    struct swapchain : public std::exception {
-        explicit swapchain(std::string const &what_arg) : std::exception(what_arg.c_str()) { }
+    struct swapchain : public std::runtime_error {
+        explicit swapchain(std::string const &what_arg) : std::runtime_error(what_arg) { }
+    };
+
+    struct fence_error : public std::runtime_error {
+        explicit fence_error(std::string const &what_arg) : std::runtime_error(what_arg) { }
+    };
+
+    struct memory_error : public std::runtime_error {
+        explicit memory_error(std::string const &what_arg) : std::runtime_error(what_arg) { }
+    };
+
+    struct resource_state_error : public std::runtime_error {
+        explicit resource_state_error(std::string const &what_arg) : std::runtime_error(what_arg) { }
     };
 }
 
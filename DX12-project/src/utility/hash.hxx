@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <type_traits>
+
+
+namespace utility
+{
+    auto constexpr kFNV_OFFSET_BASIS = 0xcbf29ce484222325ull;
+    auto constexpr kFNV_PRIME = 0x100000001b3ull;
+
+    // 64-bit FNV-1a; stable across runs and platforms, so it can key data on disk.
+    constexpr std::uint64_t hash_bytes(std::span<std::byte const> bytes, std::uint64_t seed = kFNV_OFFSET_BASIS) noexcept
+    {
+        auto hash = seed;
+
+        for (auto byte : bytes) {
+            hash ^= static_cast<std::uint64_t>(byte);
+            hash *= kFNV_PRIME;
+        }
+
+        return hash;
+    }
+
+    // Accumulates fields one by one. Structures are hashed member-wise by the caller, so padding never takes part.
+    class hasher final {
+    public:
+
+        template<class T> requires std::is_arithmetic_v<T> || std::is_enum_v<T>
+        hasher &add(T value) noexcept
+        {
+            hash_ = hash_bytes(std::as_bytes(std::span{&value, 1}), hash_);
+            return *this;
+        }
+
+        hasher &add(std::span<std::byte const> bytes) noexcept
+        {
+            // The size keeps adjacent variable-length fields from running into each other.
+            add(static_cast<std::uint64_t>(std::size(bytes)));
+
+            hash_ = hash_bytes(bytes, hash_);
+            return *this;
+        }
+
+        hasher &add(std::string_view string) noexcept
+        {
+            return add(std::as_bytes(std::span{string}));
+        }
+
+        std::uint64_t value() const noexcept { return hash_; }
+
+    private:
+
+        std::uint64_t hash_{kFNV_OFFSET_BASIS};
+    };
+}
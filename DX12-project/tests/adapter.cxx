@@ -0,0 +1,320 @@
+#include <sstream>
+
+#include "test.hxx"
+
+#include "graphics/adapter.hxx"
+
+
+namespace
+{
+    auto constexpr kGIGABYTE = 1ull << 30;
+
+    graphics::adapter_policy policy_of(graphics::adapter_preference preference)
+    {
+        graphics::adapter_policy policy;
+        policy.preference = preference;
+
+        return policy;
+    }
+
+    graphics::adapter_description discrete(std::uint64_t luid, std::uint64_t video_memory)
+    {
+        graphics::adapter_description adapter;
+
+        adapter.name = L"discrete";
+        adapter.vendor_id = 0x10de;
+        adapter.device_id = 0x2484;
+        adapter.subsystem_id = static_cast<std::uint32_t>(luid);
+        adapter.luid = luid;
+        adapter.driver_version = 0x1f0000000ull;
+        adapter.dedicated_video_memory = video_memory;
+        adapter.shared_system_memory = 16 * kGIGABYTE;
+        adapter.supported = true;
+        adapter.resource_binding_tier = graphics::kREQUIRED_RESOURCE_BINDING_TIER;
+
+        return adapter;
+    }
+
+    graphics::adapter_description integrated(std::uint64_t luid)
+    {
+        graphics::adapter_description adapter;
+
+        adapter.name = L"integrated";
+        adapter.vendor_id = 0x8086;
+        adapter.device_id = 0x9a49;
+        adapter.luid = luid;
+        adapter.driver_version = 0x1e0000000ull;
+        adapter.dedicated_video_memory = 128ull << 20;
+        adapter.shared_system_memory = 16 * kGIGABYTE;
+        adapter.supported = true;
+        adapter.resource_binding_tier = graphics::kREQUIRED_RESOURCE_BINDING_TIER;
+
+        return adapter;
+    }
+
+    // Like the Microsoft Basic Render Driver.
+    graphics::adapter_description software(std::uint64_t luid)
+    {
+        graphics::adapter_description adapter;
+
+        adapter.name = L"software";
+        adapter.vendor_id = 0x1414;
+        adapter.device_id = 0x8c;
+        adapter.luid = luid;
+        adapter.shared_system_memory = 16 * kGIGABYTE;
+        adapter.software = true;
+        adapter.supported = true;
+        adapter.resource_binding_tier = graphics::kREQUIRED_RESOURCE_BINDING_TIER;
+
+        return adapter;
+    }
+}
+
+TEST(discrete_and_integrated_adapters_are_preferred_as_asked)
+{
+    auto const adapters = std::vector{software(1), integrated(2), discrete(3, 8 * kGIGABYTE)};
+
+    CHECK(graphics::pick_adapter(adapters, policy_of(graphics::adapter_preference::discrete)) == 2);
+    CHECK(graphics::pick_adapter(adapters, policy_of(graphics::adapter_preference::integrated)) == 1);
+
+    // Without a preference the most dedicated memory wins.
+    CHECK(graphics::pick_adapter(adapters, policy_of(graphics::adapter_preference::any)) == 2);
+
+    // A preference is no requirement: the other kind is picked if it is all there is.
+    auto const only_integrated = std::vector{integrated(2)};
+
+    CHECK(graphics::pick_adapter(only_integrated, policy_of(graphics::adapter_preference::discrete)) == 0);
+
+    // Among adapters of the preferred kind, the one with more video memory wins.
+    auto const two_discrete = std::vector{discrete(4, 4 * kGIGABYTE), integrated(2), discrete(5, 12 * kGIGABYTE)};
+
+    CHECK(graphics::pick_adapter(two_discrete, graphics::adapter_policy{ }) == 2);
+
+    // Adapters that can't create a device are never picked.
+    auto unsupported = two_discrete;
+    unsupported[2].supported = false;
+
+    CHECK(graphics::pick_adapter(unsupported, graphics::adapter_policy{ }) == 0);
+    CHECK(!graphics::score_adapter(unsupported[2], graphics::adapter_policy{ }));
+}
+
+TEST(a_pinned_luid_wins_if_it_is_present)
+{
+    auto const adapters = std::vector{discrete(3, 12 * kGIGABYTE), integrated(2), discrete(4, 4 * kGIGABYTE)};
+
+    graphics::adapter_policy policy;
+
+    policy.pinned_luid = 2;
+    CHECK(graphics::pick_adapter(adapters, policy) == 1);
+
+    policy.pinned_luid = 4;
+    CHECK(graphics::pick_adapter(adapters, policy) == 2);
+
+    // A LUID that isn't there, e.g. after a reboot, falls back to the preference.
+    policy.pinned_luid = 42;
+    CHECK(graphics::pick_adapter(adapters, policy) == 0);
+
+    // The pinned adapter still has to pass the policy.
+    policy.pinned_luid = 2;
+    policy.minimum_video_memory = kGIGABYTE;
+
+    CHECK(graphics::pick_adapter(adapters, policy) == 0);
+}
+
+TEST(adapters_below_the_video_memory_floor_are_excluded)
+{
+    auto const adapters = std::vector{integrated(2), discrete(3, 2 * kGIGABYTE), discrete(4, 6 * kGIGABYTE)};
+
+    auto policy = policy_of(graphics::adapter_preference::integrated);
+
+    CHECK(graphics::pick_adapter(adapters, policy) == 0);
+
+    policy.minimum_video_memory = kGIGABYTE;
+    CHECK(graphics::pick_adapter(adapters, policy) == 2);
+
+    // The floor is inclusive.
+    policy.minimum_video_memory = 6 * kGIGABYTE;
+    CHECK(graphics::pick_adapter(adapters, policy) == 2);
+
+    policy.minimum_video_memory = 6 * kGIGABYTE + 1;
+    CHECK(graphics::pick_adapter(adapters, policy) == graphics::kNO_ADAPTER);
+}
+
+TEST(software_adapters_are_excluded_unless_allowed)
+{
+    auto const adapters = std::vector{software(1)};
+
+    auto policy = policy_of(graphics::adapter_preference::any);
+
+    CHECK(graphics::pick_adapter(adapters, policy) == graphics::kNO_ADAPTER);
+    CHECK(!graphics::score_adapter(adapters[0], policy));
+
+    policy.allow_software = true;
+    CHECK(graphics::pick_adapter(adapters, policy) == 0);
+
+    // Allowed, but still behind real hardware.
+    auto const mixed = std::vector{software(1), integrated(2)};
+
+    CHECK(graphics::pick_adapter(mixed, policy) == 1);
+
+    // Pinning it makes it win.
+    policy.pinned_luid = 1;
+    CHECK(graphics::pick_adapter(mixed, policy) == 0);
+}
+
+TEST(adapters_below_the_required_resource_binding_tier_are_excluded)
+{
+    // Feature level 12_1 without unbounded UAV tables, and more memory than the tier 3 one.
+    auto tier_2 = discrete(4, 16 * kGIGABYTE);
+    tier_2.resource_binding_tier = 2;
+
+    auto const adapters = std::vector{tier_2, discrete(3, 8 * kGIGABYTE)};
+
+    CHECK(!graphics::score_adapter(tier_2, policy_of(graphics::adapter_preference::discrete)));
+    CHECK(graphics::pick_adapter(adapters, policy_of(graphics::adapter_preference::discrete)) == 1);
+
+    // Pinning doesn't bring it back.
+    auto policy = policy_of(graphics::adapter_preference::any);
+    policy.pinned_luid = 4;
+
+    CHECK(graphics::pick_adapter(adapters, policy) == 1);
+
+    auto const alone = std::vector{tier_2};
+
+    CHECK(graphics::pick_adapter(alone, policy) == graphics::kNO_ADAPTER);
+}
+
+TEST(the_cache_survives_a_save_and_load)
+{
+    graphics::adapter_cache cache;
+
+    auto supported = discrete(3, 8 * kGIGABYTE);
+    supported.resource_binding_tier = 2;
+
+    auto unsupported = integrated(2);
+    unsupported.supported = false;
+    unsupported.resource_binding_tier = 0;
+
+    CHECK(!cache.supported(supported));
+    CHECK(!cache.dirty());
+
+    cache.store(supported);
+    cache.store(unsupported);
+
+    CHECK(cache.dirty());
+    CHECK(cache.size() == 2);
+
+    // Storing the same hardware again replaces its entry.
+    cache.store(supported);
+    CHECK(cache.size() == 2);
+
+    std::stringstream stream;
+    cache.save(stream);
+
+    CHECK(!cache.dirty());
+
+    graphics::adapter_cache loaded;
+    loaded.load(stream);
+
+    CHECK(loaded.size() == 2);
+    CHECK(!loaded.dirty());
+
+    CHECK(loaded.supported(supported) == std::optional{true});
+    CHECK(loaded.supported(unsupported) == std::optional{false});
+
+    CHECK(loaded.resource_binding_tier(supported) == std::optional{2u});
+    CHECK(loaded.resource_binding_tier(unsupported) == std::optional{0u});
+
+    // Entries are keyed by the PCI identity, not the LUID, which changes between reboots.
+    auto rebooted = supported;
+    rebooted.luid = 77;
+
+    CHECK(loaded.supported(rebooted) == std::optional{true});
+
+    // Other hardware has no entry.
+    auto other = supported;
+    other.revision = 1;
+
+    CHECK(!loaded.supported(other));
+    CHECK(!loaded.resource_binding_tier(other));
+}
+
+TEST(a_driver_update_invalidates_the_entry)
+{
+    graphics::adapter_cache cache;
+
+    auto adapter = discrete(3, 8 * kGIGABYTE);
+    cache.store(adapter);
+
+    auto updated = adapter;
+    updated.driver_version += 1;
+
+    CHECK(!cache.supported(updated));
+
+    // Probing again with the new driver replaces the entry.
+    updated.supported = false;
+    cache.store(updated);
+
+    CHECK(cache.size() == 1);
+    CHECK(cache.supported(updated) == std::optional{false});
+    CHECK(!cache.supported(adapter));
+    CHECK(!cache.resource_binding_tier(adapter));
+}
+
+TEST(lines_of_other_versions_are_skipped_and_malformed_ones_end_the_load)
+{
+    graphics::adapter_cache cache;
+
+    auto const first = discrete(3, 8 * kGIGABYTE);
+    auto const second = integrated(2);
+
+    std::stringstream stream;
+
+    stream << "adapter-v0 " << first.vendor_id << ' ' << first.device_id << ' ' << first.subsystem_id << ' ' << first.revision << ' '
+           << first.driver_version << " 1 3\n";
+
+    stream << "adapter-v2 " << second.vendor_id << ' ' << second.device_id << ' ' << second.subsystem_id << ' ' << second.revision << ' '
+           << second.driver_version << " 1 3\n";
+
+    stream << "adapter-v2 " << first.vendor_id << " garbage\n";
+
+    stream << "adapter-v2 " << first.vendor_id << ' ' << first.device_id << ' ' << first.subsystem_id << ' ' << first.revision << ' '
+           << first.driver_version << " 1 3\n";
+
+    cache.load(stream);
+
+    // Only the line before the malformed one made it.
+    CHECK(cache.size() == 1);
+    CHECK(cache.supported(second) == std::optional{true});
+    CHECK(cache.resource_binding_tier(second) == std::optional{3u});
+    CHECK(!cache.supported(first));
+
+    // Loading replaces what was there, an empty or truncated file leaves an empty cache.
+    std::stringstream truncated{"adapter-v2 4318 9348"};
+    cache.load(truncated);
+
+    CHECK(cache.size() == 0);
+    CHECK(!cache.supported(second));
+}
+
+TEST(a_cache_from_before_the_resource_binding_tier_is_probed_again)
+{
+    graphics::adapter_cache cache;
+
+    auto const first = discrete(3, 8 * kGIGABYTE);
+    auto const second = integrated(2);
+
+    // Its lines are a field shorter.
+    std::stringstream stream;
+
+    for (auto &&adapter : {first, second}) {
+        stream << "adapter-v1 " << adapter.vendor_id << ' ' << adapter.device_id << ' ' << adapter.subsystem_id << ' ' << adapter.revision << ' '
+               << adapter.driver_version << " 1\n";
+    }
+
+    cache.load(stream);
+
+    CHECK(cache.size() == 0);
+    CHECK(!cache.supported(first));
+    CHECK(!cache.supported(second));
+}
@@ -0,0 +1,196 @@
+#include <cstring>
+#include <map>
+#include <random>
+#include <set>
+#include <thread>
+
+#include "test.hxx"
+
+#include "graphics/bindless_layout.hxx"
+
+
+TEST(indices_are_unique_until_the_table_is_full)
+{
+    graphics::descriptor_index_allocator allocator{64};
+
+    std::set<std::uint32_t> indices;
+
+    for (auto index = 0; index < 64; ++index) {
+        auto const value = allocator.allocate();
+
+        CHECK(value.valid() && value.value < 64);
+
+        indices.insert(value.value);
+    }
+
+    CHECK(std::size(indices) == 64);
+    CHECK(allocator.size() == 64);
+
+    CHECK_THROWS(std::length_error, allocator.allocate());
+
+    // Freeing an invalid index does nothing.
+    allocator.free(graphics::bindless_index{ });
+    allocator.end_frame(1);
+    allocator.reclaim(1);
+
+    CHECK_THROWS(std::length_error, allocator.allocate());
+}
+
+TEST(freed_indices_wait_for_their_frame)
+{
+    graphics::descriptor_index_allocator allocator{4};
+
+    auto const first = allocator.allocate();
+    auto const second = allocator.allocate();
+
+    allocator.free(first);
+
+    // Still read by the frame being recorded.
+    CHECK(allocator.allocate().value == 2);
+
+    allocator.end_frame(5);
+
+    allocator.reclaim(4);
+    CHECK(allocator.allocate().value == 3);
+
+    // The table is full until the frame has finished.
+    CHECK_THROWS(std::length_error, allocator.allocate());
+    CHECK(allocator.size() == 4);
+
+    allocator.reclaim(5);
+
+    CHECK(allocator.size() == 3);
+    CHECK(allocator.allocate() == first);
+
+    allocator.free(second);
+    allocator.end_frame(6);
+
+    allocator.reclaim(6);
+
+    CHECK(allocator.allocate() == second);
+}
+
+// Frames allocate and free random indices with three frames in flight; no index is handed out while a frame
+// that may still read it is on the GPU.
+TEST(indices_are_never_reused_by_frames_in_flight)
+{
+    auto constexpr kFRAMES_IN_FLIGHT = 3u;
+
+    graphics::descriptor_index_allocator allocator{512};
+
+    std::mt19937 generator{19};
+
+    std::vector<graphics::bindless_index> live;
+
+    // The last fence value of a frame that could read each index.
+    std::map<std::uint32_t, std::uint64_t> last_use;
+
+    std::uint64_t completed = 0;
+    auto reuse_failures = 0;
+
+    for (std::uint64_t frame = 1; frame <= 2000; ++frame) {
+        // The GPU is kFRAMES_IN_FLIGHT frames behind.
+        if (frame > kFRAMES_IN_FLIGHT)
+            completed = frame - kFRAMES_IN_FLIGHT;
+
+        allocator.reclaim(completed);
+
+        auto const allocations = std::uniform_int_distribution<int>{0, 12}(generator);
+
+        for (auto index = 0; index < allocations && std::size(live) < 400; ++index) {
+            auto const value = allocator.allocate();
+
+            if (auto it = last_use.find(value.value); it != std::end(last_use) && it->second > completed)
+                ++reuse_failures;
+
+            live.push_back(value);
+        }
+
+        auto const frees = std::uniform_int_distribution<int>{0, 12}(generator);
+
+        for (auto index = 0; index < frees && !live.empty(); ++index) {
+            auto const position = std::uniform_int_distribution<std::size_t>{0, std::size(live) - 1}(generator);
+
+            allocator.free(live[position]);
+
+            // The frame being recorded may still have used it.
+            last_use[live[position].value] = frame;
+
+            live[position] = live.back();
+            live.pop_back();
+        }
+
+        allocator.end_frame(frame);
+    }
+
+    CHECK(reuse_failures == 0);
+
+    // Freed indices were reused, the table didn't just keep growing.
+    CHECK(allocator.size() < 400 + 3 * 12 + 12);
+}
+
+TEST(concurrent_allocations_are_unique)
+{
+    auto constexpr kTHREAD_NUMBER = 4u;
+    auto constexpr kPER_THREAD = 2000u;
+
+    graphics::descriptor_index_allocator allocator{kTHREAD_NUMBER * kPER_THREAD};
+
+    std::vector<std::vector<std::uint32_t>> allocated(kTHREAD_NUMBER);
+    std::vector<std::thread> threads;
+
+    for (auto thread = 0u; thread < kTHREAD_NUMBER; ++thread) {
+        threads.emplace_back([&allocator, &indices = allocated[thread]]
+        {
+            for (auto index = 0u; index < kPER_THREAD; ++index) {
+                indices.push_back(allocator.allocate().value);
+
+                // Some go back right away, so the free list is contended too.
+                if (index % 3 == 0) {
+                    allocator.free(graphics::bindless_index{indices.back()});
+                    indices.pop_back();
+                }
+            }
+        });
+    }
+
+    for (auto &&thread : threads)
+        thread.join();
+
+    std::set<std::uint32_t> indices;
+    std::size_t count = 0;
+
+    for (auto &&values : allocated) {
+        indices.insert(std::begin(values), std::end(values));
+        count += std::size(values);
+    }
+
+    CHECK(std::size(indices) == count);
+    CHECK(allocator.size() == kTHREAD_NUMBER * kPER_THREAD);
+}
+
+TEST(layout_blocks_fill_their_offsets)
+{
+    using namespace graphics::root_constant_layout_checks;
+
+    // What SetGraphicsRoot32BitConstants writes for each block.
+    std::array<std::uint32_t, graphics::kROOT_CONSTANT_COUNT> constants{};
+
+    auto const write = [&constants] <class Block> (Block const &block)
+    {
+        std::memcpy(std::data(constants) + layout::offset_of<Block>(), &block, layout::size_of<Block>() * 4);
+    };
+
+    write(material{.5f, 0.f, {7}, {8}});
+    write(view{{1}});
+    write(draw{{2}, {3}, 4});
+
+    CHECK(constants[0] == 1 && constants[1] == 2 && constants[2] == 3 && constants[3] == 4);
+    CHECK(constants[6] == 7 && constants[7] == 8);
+
+    float roughness;
+    std::memcpy(&roughness, &constants[4], sizeof(roughness));
+
+    CHECK(roughness == .5f);
+    CHECK(constants[layout::kSIZE] == 0);
+}
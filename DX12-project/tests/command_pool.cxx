@@ -0,0 +1,176 @@
+#include <random>
+
+#include "test.hxx"
+
+#include "main.hxx"
+#include "graphics/command_pool.hxx"
+#include "graphics/queue.hxx"
+
+
+namespace
+{
+    // Frames that record a varying number of lists, each submitted with a single ExecuteCommandLists.
+    struct renderer final {
+        winrt::com_ptr<ID3D12Device6> device{stand_in::create_device()};
+
+        graphics::queue_scheduler queues{device.get()};
+        graphics::command_pool command_pool{device.get()};
+
+        std::vector<UINT64> frame_fences;
+        std::uint32_t frame_index{0};
+
+        explicit renderer(std::uint32_t frames_in_flight) : frame_fences(frames_in_flight, 0) { }
+
+        ~renderer() { queues.flush(); }
+
+        auto &timeline() { return queues.timeline(graphics::queue_type::graphics); }
+
+        void frame(std::uint32_t list_count)
+        {
+            timeline().wait(frame_fences[frame_index]);
+
+            std::vector<graphics::command_context> contexts;
+            std::vector<ID3D12CommandList *> command_lists;
+
+            for (auto index = 0u; index < list_count; ++index) {
+                auto &&context = contexts.emplace_back(command_pool.acquire(D3D12_COMMAND_LIST_TYPE_DIRECT));
+
+                context.command_list->DrawIndexedInstanced(3, 1, 0, 0, 0);
+
+                CHECK(SUCCEEDED(context.command_list->Close()));
+
+                command_lists.push_back(context.command_list.get());
+            }
+
+            auto const fence_value = queues.submit(graphics::queue_type::graphics, command_lists).value;
+
+            for (auto &&context : contexts)
+                command_pool.release(std::move(context), timeline(), fence_value);
+
+            frame_fences[frame_index] = fence_value;
+            frame_index = (frame_index + 1) % static_cast<std::uint32_t>(std::size(frame_fences));
+        }
+
+        graphics::command_pool_statistics statistics() const
+        {
+            return command_pool.statistics(D3D12_COMMAND_LIST_TYPE_DIRECT);
+        }
+    };
+}
+
+TEST(bursty_frames_keep_the_pool_bounded)
+{
+    auto constexpr kFRAMES_IN_FLIGHT = 3u;
+    auto constexpr kBURST_SIZE = 8u;
+
+    stand_in::debug_layer::instance().clear();
+
+    // The GPU lags behind, so the retired pairs of every frame in flight are still executing when a burst comes.
+    stand_in::gpu_thread gpu{std::chrono::microseconds{100}};
+
+    renderer renderer{kFRAMES_IN_FLIGHT};
+
+    std::mt19937 generator{7};
+
+    for (auto index = 0; index < 300; ++index) {
+        auto const burst = std::uniform_int_distribution<int>{0, 9}(generator) == 0;
+
+        renderer.frame(burst ? kBURST_SIZE : 2);
+    }
+
+    auto const statistics = renderer.statistics();
+
+    // The pool can't outgrow the lists of every frame in flight recording a burst at once.
+    CHECK(statistics.created <= kFRAMES_IN_FLIGHT * kBURST_SIZE);
+    CHECK(statistics.high_water_mark == kBURST_SIZE);
+    CHECK(statistics.in_use == 0);
+
+    CHECK(renderer.device->statistics().command_lists == statistics.created);
+    CHECK(renderer.device->statistics().command_allocators == statistics.created);
+
+    // After the bursts, steady frames only recycle.
+    for (auto index = 0; index < 200; ++index)
+        renderer.frame(2);
+
+    CHECK(renderer.statistics().created == statistics.created);
+    CHECK(renderer.device->statistics().command_lists == statistics.created);
+
+    CHECK(stand_in::debug_layer::instance().messages().empty());
+}
+
+TEST(steady_frames_create_nothing)
+{
+    stand_in::gpu_thread gpu{std::chrono::microseconds{50}};
+
+    renderer renderer{2};
+
+    for (auto index = 0; index < 10; ++index)
+        renderer.frame(3);
+
+    auto const created = renderer.statistics().created;
+
+    for (auto index = 0; index < 500; ++index)
+        renderer.frame(3);
+
+    CHECK(renderer.statistics().created == created);
+
+    // Two frames in flight plus the one being recorded.
+    CHECK(created <= 3 * 3);
+}
+
+TEST(pairs_are_recycled_only_after_their_fence)
+{
+    renderer renderer{1};
+
+    auto first = renderer.command_pool.acquire(D3D12_COMMAND_LIST_TYPE_DIRECT);
+    auto const allocator = first.command_allocator.get();
+
+    CHECK(SUCCEEDED(first.command_list->Close()));
+
+    ID3D12CommandList *const command_lists[] = {first.command_list.get()};
+    auto const fence_value = renderer.queues.submit(graphics::queue_type::graphics, command_lists).value;
+
+    renderer.command_pool.release(std::move(first), renderer.timeline(), fence_value);
+
+    // Nothing has executed yet, so the pool has to grow.
+    {
+        auto second = renderer.command_pool.acquire(D3D12_COMMAND_LIST_TYPE_DIRECT);
+
+        CHECK(second.command_allocator.get() != allocator);
+        CHECK(renderer.statistics().created == 2);
+
+        CHECK(SUCCEEDED(second.command_list->Close()));
+        renderer.command_pool.release(std::move(second), renderer.timeline(), renderer.timeline().signal(renderer.queues.queue(graphics::queue_type::graphics)));
+    }
+
+    stand_in::gpu::instance().execute();
+
+    auto const reset_count = allocator->reset_count();
+
+    auto recycled = renderer.command_pool.acquire(D3D12_COMMAND_LIST_TYPE_DIRECT);
+
+    CHECK(recycled.command_allocator.get() == allocator);
+    CHECK(allocator->reset_count() == reset_count + 1);
+    CHECK(!recycled.command_list->closed());
+    CHECK(renderer.statistics().created == 2);
+
+    CHECK(SUCCEEDED(recycled.command_list->Close()));
+    renderer.command_pool.release(std::move(recycled), renderer.timeline(), fence_value);
+}
+
+TEST(types_are_pooled_separately)
+{
+    renderer renderer{1};
+
+    auto copy = renderer.command_pool.acquire(D3D12_COMMAND_LIST_TYPE_COPY);
+    auto compute = renderer.command_pool.acquire(D3D12_COMMAND_LIST_TYPE_COMPUTE);
+
+    CHECK(copy.command_list->GetType() == D3D12_COMMAND_LIST_TYPE_COPY);
+    CHECK(compute.command_list->GetType() == D3D12_COMMAND_LIST_TYPE_COMPUTE);
+
+    CHECK(renderer.command_pool.statistics(D3D12_COMMAND_LIST_TYPE_COPY).in_use == 1);
+    CHECK(renderer.command_pool.statistics(D3D12_COMMAND_LIST_TYPE_COMPUTE).in_use == 1);
+    CHECK(renderer.statistics().created == 0);
+
+    CHECK_THROWS(dx::device_error, renderer.command_pool.acquire(static_cast<D3D12_COMMAND_LIST_TYPE>(7)));
+}
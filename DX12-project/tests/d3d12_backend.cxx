@@ -0,0 +1,180 @@
+#include <cstring>
+#include <vector>
+
+#include "test.hxx"
+
+#include "main.hxx"
+#include "graphics/d3d12_backend.hxx"
+#include "graphics/render_graph_submission.hxx"
+
+
+namespace
+{
+    using namespace graphics::backend;
+
+    auto constexpr kFRAMES_IN_FLIGHT = 2u;
+    auto constexpr kCOPY_SIZE = 256u;
+
+    ID3D12Resource *d3d12_resource_of(std::unique_ptr<resource_interface> const &resource)
+    {
+        return static_cast<d3d12_resource &>(*resource).get();
+    }
+
+    ID3D12GraphicsCommandList5 *d3d12_command_list_of(command_list_interface &command_list)
+    {
+        return static_cast<d3d12_command_list &>(command_list).get();
+    }
+
+    // An upload on the copy queue that a graphics pass reads from, through the D3D12 backend on the stand-in device.
+    struct scene final {
+        d3d12_device device{stand_in::create_device()};
+
+        std::unique_ptr<resource_interface> upload = device.create_committed_resource(
+            resource_description{resource_dimension::buffer, kCOPY_SIZE}, heap_type::upload, graphics::resource_access::copy_source);
+
+        std::unique_ptr<resource_interface> instances = device.create_committed_resource(
+            resource_description{resource_dimension::buffer, kCOPY_SIZE}, heap_type::gpu, graphics::resource_access::shader_read);
+
+        std::unique_ptr<resource_interface> back_buffer = device.create_committed_resource(
+            resource_description{resource_dimension::texture_2d, 64, 64, 1, 1, 28, resource_flags::render_target}, heap_type::gpu,
+            graphics::resource_access::present);
+
+        render_graph_submitter submitter{device, kFRAMES_IN_FLIGHT};
+
+        graphics::render_graph graph;
+
+        // The lists the passes recorded into during the last submission.
+        ID3D12GraphicsCommandList5 *copy_list{nullptr};
+        ID3D12GraphicsCommandList5 *graphics_list{nullptr};
+
+        scene()
+        {
+            using graphics::resource_access;
+
+            auto const instances_resource = graph.import_resource("instances", resource_access::shader_read, resource_access::shader_read);
+            auto const back_buffer_resource = graph.import_resource("back buffer", resource_access::present, resource_access::present);
+
+            auto const upload_pass = graph.add_pass("upload", graphics::queue_type::copy, [this]
+            {
+                copy_list = d3d12_command_list_of(submitter.command_list());
+
+                submitter.command_list().copy_buffer_region(*instances, 0, *upload, 0, kCOPY_SIZE);
+            });
+
+            graph.write(upload_pass, instances_resource, resource_access::copy_dest);
+
+            auto const draw_pass = graph.add_pass("draw", graphics::queue_type::graphics, [this]
+            {
+                graphics_list = d3d12_command_list_of(submitter.command_list());
+
+                submitter.command_list().draw_indexed(36, 1, 0, 0, 0);
+            });
+
+            graph.read(draw_pass, instances_resource, resource_access::shader_read);
+            graph.write(draw_pass, back_buffer_resource, resource_access::render_target);
+        }
+
+        graphics::compiled_render_graph const &submit(graphics::render_graph_compiler &compiler)
+        {
+            resource_interface *const resources[] = {instances.get(), back_buffer.get()};
+
+            auto &&compiled = compiler.compile(graph);
+
+            submitter.submit(graph, compiled, resources);
+
+            return compiled;
+        }
+    };
+}
+
+TEST(a_compiled_graph_is_submitted_through_the_d3d12_backend)
+{
+    stand_in::debug_layer::instance().clear();
+
+    scene scene;
+    graphics::render_graph_compiler compiler;
+
+    void *data = nullptr;
+    d3d12_resource_of(scene.upload)->Map(0, nullptr, &data);
+
+    for (auto index = 0u; index < kCOPY_SIZE; ++index)
+        static_cast<std::byte *>(data)[index] = static_cast<std::byte>(index);
+
+    d3d12_resource_of(scene.upload)->Unmap(0, nullptr);
+
+    auto &&compiled = scene.submit(compiler);
+
+    CHECK(std::size(compiled.batches) == 2);
+
+    CHECK(scene.copy_list != nullptr && scene.copy_list->GetType() == D3D12_COMMAND_LIST_TYPE_COPY);
+    CHECK(scene.graphics_list != nullptr && scene.graphics_list->GetType() == D3D12_COMMAND_LIST_TYPE_DIRECT);
+
+    CHECK(scene.copy_list->closed() && scene.graphics_list->closed());
+
+    auto &&copies = scene.copy_list->recorded().buffer_copies;
+
+    CHECK(std::size(copies) == 1);
+    CHECK(copies.front().destination == d3d12_resource_of(scene.instances) && copies.front().source == d3d12_resource_of(scene.upload));
+    CHECK(copies.front().size == kCOPY_SIZE);
+
+    CHECK(scene.graphics_list->recorded().draws == 1);
+
+    // The lists carry the compiled barriers in order, mapped to D3D12 states.
+    std::vector<D3D12_RESOURCE_BARRIER> recorded;
+
+    for (auto list : {scene.copy_list, scene.graphics_list}) {
+        auto &&barriers = list->recorded().barriers;
+        recorded.insert(std::end(recorded), std::begin(barriers), std::end(barriers));
+    }
+
+    CHECK(std::size(recorded) == std::size(compiled.barriers));
+    CHECK(scene.submitter.statistics().barriers == std::size(compiled.barriers));
+
+    ID3D12Resource *const resources[] = {d3d12_resource_of(scene.instances), d3d12_resource_of(scene.back_buffer)};
+
+    for (std::size_t index = 0; index < (std::min)(std::size(recorded), std::size(compiled.barriers)); ++index) {
+        auto &&barrier = compiled.barriers[index];
+
+        CHECK(recorded[index].Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION);
+        CHECK(recorded[index].Transition.pResource == resources[barrier.resource]);
+        CHECK(recorded[index].Transition.StateBefore == resource_state_of(barrier.before));
+        CHECK(recorded[index].Transition.StateAfter == resource_state_of(barrier.after));
+    }
+
+    // The graphics queue waits on the copy queue's fence for the upload.
+    auto const waits = static_cast<d3d12_queue &>(scene.submitter.queue(graphics::queue_type::graphics)).get()->issued_waits();
+    auto const copy_fence = static_cast<d3d12_fence &>(scene.submitter.fence(graphics::queue_type::copy)).get();
+
+    CHECK(std::size(waits) == 1);
+    CHECK(waits.front().fence == copy_fence && waits.front().value == 1);
+
+    scene.submitter.flush();
+
+    CHECK(copy_fence->GetCompletedValue() == 1);
+    CHECK(scene.submitter.fence(graphics::queue_type::graphics).completed_value() == 1);
+
+    CHECK(std::memcmp(d3d12_resource_of(scene.instances)->memory(), data, kCOPY_SIZE) == 0);
+
+    CHECK(stand_in::debug_layer::instance().messages().empty());
+}
+
+TEST(the_d3d12_backend_reuses_the_command_lists_of_each_frame_in_flight)
+{
+    stand_in::debug_layer::instance().clear();
+
+    scene scene;
+    graphics::render_graph_compiler compiler;
+
+    for (auto frame = 0; frame < 10; ++frame)
+        scene.submit(compiler);
+
+    scene.submitter.flush();
+
+    // A copy and a graphics list per frame in flight, reset only once the GPU is done with them.
+    CHECK(scene.device.get()->statistics().command_lists == 2 * kFRAMES_IN_FLIGHT);
+    CHECK(scene.submitter.statistics().command_lists == 20);
+
+    CHECK(scene.submitter.fence(graphics::queue_type::graphics).completed_value() == 10);
+
+    CHECK(stand_in::debug_layer::instance().messages().empty());
+}
@@ -0,0 +1,181 @@
+#include <set>
+
+#include "test.hxx"
+
+#include "main.hxx"
+#include "graphics/descriptor.hxx"
+
+
+namespace
+{
+    auto constexpr kHEAP_TYPES = std::array{
+        D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV, D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER, D3D12_DESCRIPTOR_HEAP_TYPE_RTV, D3D12_DESCRIPTOR_HEAP_TYPE_DSV
+    };
+}
+
+TEST(handles_are_unique_across_heap_types)
+{
+    auto device = stand_in::create_device();
+    graphics::descriptor_allocator allocator{device.get()};
+
+    std::set<SIZE_T> handles;
+    std::vector<graphics::descriptor> descriptors;
+
+    for (auto type : kHEAP_TYPES) {
+        for (auto index = 0; index < 10; ++index) {
+            auto descriptor = allocator.allocate(type);
+
+            CHECK(descriptor.valid());
+            CHECK(descriptor.type == type);
+            CHECK(handles.insert(descriptor.cpu_handle.ptr).second);
+
+            descriptors.push_back(descriptor);
+        }
+    }
+
+    for (auto &&descriptor : descriptors)
+        allocator.free(descriptor);
+}
+
+TEST(freed_descriptors_are_reused)
+{
+    auto device = stand_in::create_device();
+    graphics::descriptor_allocator allocator{device.get()};
+
+    auto const first = allocator.allocate(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+    allocator.free(first);
+
+    auto const second = allocator.allocate(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
+
+    CHECK(second.index == first.index);
+    CHECK(second.cpu_handle.ptr == first.cpu_handle.ptr);
+
+    allocator.free(second);
+
+    // Freeing an invalid descriptor does nothing.
+    allocator.free(graphics::descriptor{ });
+
+    for (auto round = 0; round < 100; ++round) {
+        std::vector<graphics::descriptor> descriptors;
+
+        for (auto index = 0; index < 64; ++index)
+            descriptors.push_back(allocator.allocate(D3D12_DESCRIPTOR_HEAP_TYPE_RTV));
+
+        for (auto &&descriptor : descriptors)
+            allocator.free(descriptor);
+    }
+
+    CHECK(allocator.heap_number(D3D12_DESCRIPTOR_HEAP_TYPE_RTV) == 1);
+}
+
+TEST(grows_by_chaining_heaps)
+{
+    auto device = stand_in::create_device();
+    graphics::descriptor_allocator allocator{device.get()};
+
+    auto const increment = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
+
+    std::set<SIZE_T> handles;
+    std::vector<graphics::descriptor> descriptors;
+
+    // Sixteen DSVs fit into a heap.
+    for (auto index = 0; index < 40; ++index) {
+        auto descriptor = allocator.allocate(D3D12_DESCRIPTOR_HEAP_TYPE_DSV);
+
+        CHECK(handles.insert(descriptor.cpu_handle.ptr).second);
+
+        descriptors.push_back(descriptor);
+    }
+
+    CHECK(allocator.heap_number(D3D12_DESCRIPTOR_HEAP_TYPE_DSV) == 3);
+
+    // Every handle is a whole number of increments from the start of some heap; with the stand-in's
+    // non-overlapping heap ranges no two may be closer than an increment.
+    for (auto it = std::begin(handles); std::next(it) != std::end(handles); ++it)
+        CHECK(*std::next(it) - *it >= increment);
+
+    for (auto &&descriptor : descriptors)
+        allocator.free(descriptor);
+}
+
+TEST(threads_never_share_a_descriptor)
+{
+    auto device = stand_in::create_device();
+    graphics::descriptor_allocator allocator{device.get()};
+
+    auto constexpr kTHREAD_NUMBER = 8;
+    auto constexpr kHELD_NUMBER = 300;
+
+    std::vector<std::vector<graphics::descriptor>> held(kTHREAD_NUMBER);
+    std::vector<std::thread> threads;
+
+    std::atomic<int> ready{0};
+
+    for (auto thread = 0; thread < kTHREAD_NUMBER; ++thread) {
+        threads.emplace_back([&, thread]
+        {
+            ++ready;
+
+            while (ready.load() != kTHREAD_NUMBER)
+                std::this_thread::yield();
+
+            // Churn through allocations and frees, then keep a set of descriptors.
+            for (auto round = 0; round < 50; ++round) {
+                std::vector<graphics::descriptor> descriptors;
+
+                for (auto index = 0; index < 100; ++index)
+                    descriptors.push_back(allocator.allocate(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV));
+
+                for (auto &&descriptor : descriptors)
+                    allocator.free(descriptor);
+            }
+
+            for (auto index = 0; index < kHELD_NUMBER; ++index)
+                held[thread].push_back(allocator.allocate(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV));
+        });
+    }
+
+    for (auto &&thread : threads)
+        thread.join();
+
+    std::set<std::uint32_t> indices;
+
+    for (auto &&descriptors : held) {
+        for (auto &&descriptor : descriptors)
+            CHECK(indices.insert(descriptor.index).second);
+    }
+
+    CHECK(std::size(indices) == kTHREAD_NUMBER * kHELD_NUMBER);
+
+    // The exited threads handed their caches back, so all of it fits into the heaps that were needed for the held descriptors.
+    CHECK(allocator.heap_number(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV) <= 4);
+}
+
+TEST(heaps_die_with_the_allocator)
+{
+    auto device = stand_in::create_device();
+
+    auto const live_number = ID3D12DescriptorHeap::live_number().load();
+
+    {
+        graphics::descriptor_allocator allocator{device.get()};
+
+        // This thread's cache keeps some of the descriptors after the frees.
+        for (auto type : kHEAP_TYPES)
+            allocator.free(allocator.allocate(type));
+
+        CHECK(ID3D12DescriptorHeap::live_number() == live_number + static_cast<int>(std::size(kHEAP_TYPES)));
+    }
+
+    CHECK(ID3D12DescriptorHeap::live_number() == live_number);
+
+    // A new allocator doesn't pick up the descriptors cached for the old one.
+    graphics::descriptor_allocator allocator{device.get()};
+
+    std::set<std::uint32_t> indices;
+
+    for (auto index = 0; index < 16; ++index)
+        CHECK(indices.insert(allocator.allocate(D3D12_DESCRIPTOR_HEAP_TYPE_DSV).index).second);
+
+    CHECK(allocator.heap_number(D3D12_DESCRIPTOR_HEAP_TYPE_DSV) == 1);
+}
@@ -0,0 +1,149 @@
+#include <random>
+
+#include "test.hxx"
+
+#include "main.hxx"
+#include "graphics/descriptor_ring.hxx"
+#include "graphics/queue.hxx"
+
+
+namespace
+{
+    auto constexpr kFRAMES_IN_FLIGHT = 3u;
+    auto constexpr kDRAWS_PER_FRAME = 10'000u;
+    auto constexpr kFRAME_NUMBER = 30u;
+
+    auto constexpr kPERSISTENT_CAPACITY = 16u;
+
+    struct stress_result final {
+        graphics::descriptor_ring_statistics statistics;
+
+        std::uint64_t overlaps{0};
+        std::uint64_t out_of_range{0};
+        std::uint64_t tables{0};
+        std::uint64_t device_copy_calls{0};
+    };
+
+    // Every draw copies a table of one to eight descriptors into the ring, and the frames are submitted with
+    // 'frames in flight' slots as draw() does. A table may not overlap a table of a frame the GPU hasn't finished.
+    stress_result stress(std::uint32_t capacity)
+    {
+        auto constexpr kFREE = (std::numeric_limits<UINT64>::max)();
+        auto constexpr kCURRENT_FRAME = UINT64{0};
+
+        auto device = stand_in::create_device();
+
+        graphics::queue_scheduler queues{device.get()};
+        auto &&timeline = queues.timeline(graphics::queue_type::graphics);
+
+        graphics::descriptor_ring ring{device.get(), timeline, capacity, kPERSISTENT_CAPACITY};
+
+        std::mt19937 generator{42};
+        std::uniform_int_distribution<std::uint32_t> table_size{1, 8};
+
+        std::array<D3D12_CPU_DESCRIPTOR_HANDLE, 8> sources{ };
+        std::array<UINT64, kFRAMES_IN_FLIGHT> frame_fences{ };
+
+        // The fence value of the frame that last used each slot of the ring.
+        std::vector<UINT64> slots(capacity, kFREE);
+        std::vector<std::uint32_t> frame_slots;
+
+        stress_result result;
+
+        for (auto frame = 0u; frame < kFRAME_NUMBER; ++frame) {
+            timeline.wait(frame_fences[frame % kFRAMES_IN_FLIGHT]);
+
+            frame_slots.clear();
+
+            for (auto draw = 0u; draw < kDRAWS_PER_FRAME; ++draw) {
+                auto const size = table_size(generator);
+                auto const table = ring.copy_table(std::span{std::data(sources), size});
+
+                ++result.tables;
+
+                if (table.offset < kPERSISTENT_CAPACITY || table.offset + table.size > kPERSISTENT_CAPACITY + capacity) {
+                    ++result.out_of_range;
+                    continue;
+                }
+
+                for (auto slot = table.offset - kPERSISTENT_CAPACITY; slot < table.offset - kPERSISTENT_CAPACITY + table.size; ++slot) {
+                    if (auto const owner = slots[slot]; owner == kCURRENT_FRAME || (owner != kFREE && !timeline.is_complete(owner)))
+                        ++result.overlaps;
+
+                    slots[slot] = kCURRENT_FRAME;
+                    frame_slots.push_back(slot);
+                }
+            }
+
+            auto const fence_value = queues.submit(graphics::queue_type::graphics, { }).value;
+
+            for (auto slot : frame_slots)
+                slots[slot] = fence_value;
+
+            ring.end_frame(fence_value);
+
+            frame_fences[frame % kFRAMES_IN_FLIGHT] = fence_value;
+        }
+
+        queues.flush();
+
+        result.statistics = ring.statistics();
+        result.device_copy_calls = device->statistics().descriptor_copy_calls.load();
+
+        return result;
+    }
+
+    void report(std::string_view name, stress_result const &result)
+    {
+        auto &&statistics = result.statistics;
+
+        fmt::print("{}: {} draws per frame, {} frames in flight, capacity {}, peak occupancy {} ({:.0f}%), wrap stalls {}, copy calls {}\n",
+                   name, kDRAWS_PER_FRAME, kFRAMES_IN_FLIGHT, statistics.capacity, statistics.peak_occupancy,
+                   100. * static_cast<double>(statistics.peak_occupancy) / statistics.capacity, statistics.wrap_stalls, statistics.copy_calls);
+    }
+}
+
+TEST(ring_that_fits_the_frames_in_flight)
+{
+    // Tables average 4.5 descriptors, so three frames need about 135k and the ring has room for four.
+    auto const result = stress(4 * 45'000);
+
+    report("roomy ring", result);
+
+    CHECK(result.overlaps == 0);
+    CHECK(result.out_of_range == 0);
+    CHECK(result.statistics.wrap_stalls == 0);
+
+    // One CopyDescriptors call per table.
+    CHECK(result.statistics.copy_calls == result.tables);
+    CHECK(result.device_copy_calls == result.tables);
+}
+
+TEST(ring_smaller_than_the_frames_in_flight)
+{
+    // Room for about one and a half frames: the ring has to wait for the GPU, but never hands out live descriptors.
+    auto const result = stress(70'000);
+
+    report("tight ring", result);
+
+    CHECK(result.overlaps == 0);
+    CHECK(result.out_of_range == 0);
+    CHECK(result.statistics.wrap_stalls != 0);
+    CHECK(result.statistics.peak_occupancy <= result.statistics.capacity);
+}
+
+TEST(a_single_frame_cannot_exhaust_the_ring)
+{
+    auto device = stand_in::create_device();
+
+    graphics::queue_scheduler queues{device.get()};
+    graphics::descriptor_ring ring{device.get(), queues.timeline(graphics::queue_type::graphics), 64};
+
+    CHECK_THROWS(dx::device_error, ring.allocate(0));
+    CHECK_THROWS(dx::device_error, ring.allocate(65));
+
+    for (auto index = 0; index < 8; ++index)
+        (void)ring.allocate(8);
+
+    CHECK_THROWS(dx::device_error, ring.allocate(1));
+}
@@ -0,0 +1,245 @@
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include "test.hxx"
+
+#include "platform/event_queue.hxx"
+
+
+namespace
+{
+    using namespace std::chrono_literals;
+
+    struct recording_handler final : platform::event_handler_interface {
+        std::vector<double> cursor_x;
+        std::vector<platform::resize_event> resizes;
+        std::vector<bool> iconified;
+
+        void on_resize(std::int32_t width, std::int32_t height) override { resizes.push_back({width, height}); }
+
+        void on_cursor(platform::cursor_event const &event) override { cursor_x.push_back(event.x); }
+
+        void on_iconify(bool value) override { iconified.push_back(value); }
+    };
+}
+
+TEST(ring_indices_wrap_around_the_capacity)
+{
+    platform::spsc_ring<std::uint32_t, 8> ring;
+
+    std::vector<std::uint32_t> drained;
+
+    auto next_value = 0u;
+
+    // Batches of 5 put the indices at every offset into the ring, far past the capacity.
+    for (auto cycle = 0u; cycle < 1000; ++cycle) {
+        for (auto index = 0u; index < 5; ++index)
+            CHECK(ring.try_push(next_value++));
+
+        ring.drain([&drained] (auto value) { drained.push_back(value); });
+
+        CHECK(ring.empty());
+    }
+
+    CHECK(std::size(drained) == next_value);
+
+    for (auto index = 0u; index < std::size(drained); ++index)
+        CHECK(drained[index] == index);
+
+    // Full at an offset that isn't a multiple of the capacity.
+    for (auto index = 0u; index < ring.capacity(); ++index)
+        CHECK(ring.try_push(index));
+
+    CHECK(!ring.try_push(0));
+
+    drained.clear();
+
+    CHECK(ring.drain([&drained] (auto value) { drained.push_back(value); }, 3) == 3);
+    CHECK(ring.try_push(100));
+
+    ring.drain([&drained] (auto value) { drained.push_back(value); });
+
+    CHECK((drained == std::vector<std::uint32_t>{0, 1, 2, 3, 4, 5, 6, 7, 100}));
+}
+
+TEST(events_that_do_not_fit_are_dropped_and_counted)
+{
+    platform::event_queue queue;
+
+    auto handler = std::make_shared<recording_handler>();
+    queue.connect_event_handler(handler);
+
+    auto constexpr kOVERFLOW = 10u;
+
+    for (auto index = 0u; index < platform::event_queue::kCAPACITY + kOVERFLOW; ++index)
+        queue.push(platform::cursor_event{static_cast<double>(index), 0.});
+
+    auto statistics = queue.statistics();
+
+    CHECK(statistics.pushed == platform::event_queue::kCAPACITY);
+    CHECK(statistics.dropped == kOVERFLOW);
+    CHECK(statistics.drained == 0);
+
+    queue.poll_events();
+
+    // The oldest events are kept.
+    CHECK(std::size(handler->cursor_x) == platform::event_queue::kCAPACITY);
+    CHECK(handler->cursor_x.front() == 0.);
+    CHECK(handler->cursor_x.back() == static_cast<double>(platform::event_queue::kCAPACITY - 1));
+
+    // The ring takes events again once drained.
+    queue.push(platform::cursor_event{-1., 0.});
+    queue.poll_events();
+
+    CHECK(handler->cursor_x.back() == -1.);
+
+    statistics = queue.statistics();
+
+    CHECK(statistics.pushed == platform::event_queue::kCAPACITY + 1);
+    CHECK(statistics.dropped == kOVERFLOW);
+    CHECK(statistics.drained == platform::event_queue::kCAPACITY + 1);
+    CHECK(statistics.batches == 2);
+}
+
+TEST(a_full_ring_keeps_the_latest_size_and_iconified_state)
+{
+    platform::event_queue queue;
+
+    auto handler = std::make_shared<recording_handler>();
+    queue.connect_event_handler(handler);
+
+    queue.push(platform::resize_event{800, 600});
+
+    for (auto index = 1u; index < platform::event_queue::kCAPACITY; ++index)
+        queue.push(platform::cursor_event{static_cast<double>(index), 0.});
+
+    // The window is minimized to a zero size and back while the ring is full.
+    queue.push(platform::iconify_event{true});
+    queue.push(platform::resize_event{0, 0});
+    queue.push(platform::resize_event{1024, 768});
+    queue.push(platform::iconify_event{false});
+    queue.push(platform::resize_event{0, 0});
+    queue.push(platform::iconify_event{true});
+
+    CHECK(queue.statistics().dropped == 6);
+
+    queue.poll_events();
+
+    CHECK(queue.minimized());
+
+    CHECK(std::size(handler->resizes) == 2);
+    CHECK(handler->resizes.back().width == 0 && handler->resizes.back().height == 0);
+    CHECK((handler->iconified == std::vector<bool>{true}));
+
+    // Neither is reported again while it is unchanged.
+    queue.push(platform::cursor_event{});
+    queue.poll_events();
+
+    CHECK(std::size(handler->resizes) == 2);
+    CHECK(std::size(handler->iconified) == 1);
+
+    // A size the handlers already have isn't reported again either, when it is dropped.
+    for (auto index = 0u; index < platform::event_queue::kCAPACITY; ++index)
+        queue.push(platform::cursor_event{});
+
+    queue.push(platform::resize_event{0, 0});
+    queue.poll_events();
+
+    CHECK(std::size(handler->resizes) == 2);
+
+    // Restored through the ring once it has room.
+    queue.push(platform::iconify_event{false});
+    queue.push(platform::resize_event{1024, 768});
+    queue.poll_events();
+
+    CHECK(!queue.minimized());
+    CHECK(handler->resizes.back().width == 1024 && handler->resizes.back().height == 768);
+}
+
+TEST(a_dropped_resize_wakes_up_a_waiting_consumer)
+{
+    platform::event_queue queue;
+
+    auto handler = std::make_shared<recording_handler>();
+    queue.connect_event_handler(handler);
+
+    for (auto index = 0u; index < platform::event_queue::kCAPACITY; ++index)
+        queue.push(platform::cursor_event{});
+
+    queue.poll_events();
+
+    for (auto index = 0u; index < platform::event_queue::kCAPACITY; ++index)
+        queue.push(platform::cursor_event{});
+
+    queue.push(platform::resize_event{640, 480});
+
+    // The ring is full, so the consumer doesn't sleep; draining it reports the dropped size.
+    auto const start = std::chrono::steady_clock::now();
+
+    queue.wait_events(10s);
+
+    CHECK(std::chrono::steady_clock::now() - start < 1s);
+    CHECK(std::size(handler->resizes) == 1);
+    CHECK(handler->resizes.back().width == 640 && handler->resizes.back().height == 480);
+}
+
+TEST(a_waiting_consumer_is_woken_up_by_every_push)
+{
+    platform::event_queue queue;
+
+    auto handler = std::make_shared<recording_handler>();
+    queue.connect_event_handler(handler);
+
+    auto constexpr kEVENT_NUMBER = 20'000u;
+
+    // Pushes land before, during and after the consumer goes to sleep; a lost wake-up would show as a wait that
+    // runs out its timeout.
+    std::thread producer{[&queue]
+    {
+        for (auto index = 0u; index < kEVENT_NUMBER; ++index) {
+            queue.push(platform::cursor_event{static_cast<double>(index), 0.});
+
+            if (index % 7 == 0)
+                std::this_thread::yield();
+        }
+    }};
+
+    auto longest_wait = std::chrono::steady_clock::duration{0};
+
+    while (std::size(handler->cursor_x) < kEVENT_NUMBER) {
+        auto const start = std::chrono::steady_clock::now();
+
+        queue.wait_events(10s);
+
+        longest_wait = (std::max)(longest_wait, std::chrono::steady_clock::now() - start);
+    }
+
+    producer.join();
+
+    CHECK(longest_wait < 1s);
+    CHECK(queue.statistics().dropped == 0);
+
+    for (auto index = 0u; index < kEVENT_NUMBER; ++index)
+        CHECK(handler->cursor_x[index] == static_cast<double>(index));
+}
+
+TEST(close_requests_wake_up_a_waiting_consumer)
+{
+    platform::event_queue queue;
+
+    auto const start = std::chrono::steady_clock::now();
+
+    std::thread closer{[&queue]
+    {
+        std::this_thread::sleep_for(10ms);
+        queue.request_close();
+    }};
+
+    while (!queue.should_close())
+        queue.wait_events(10s);
+
+    closer.join();
+
+    CHECK(std::chrono::steady_clock::now() - start < 1s);
+}
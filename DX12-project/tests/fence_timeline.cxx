@@ -0,0 +1,166 @@
+#include "test.hxx"
+
+#include "main.hxx"
+#include "graphics/command.hxx"
+#include "graphics/fence.hxx"
+
+
+namespace
+{
+    struct queue_and_fence final {
+        winrt::com_ptr<ID3D12Device6> device{stand_in::create_device()};
+        winrt::com_ptr<ID3D12CommandQueue> queue{create_command_queue(device.get(), D3D12_COMMAND_LIST_TYPE_DIRECT)};
+
+        graphics::fence_timeline timeline{device.get()};
+    };
+
+    // Queued work runs only when execute() is called.
+    struct stalled_gpu final {
+        stalled_gpu() { stand_in::gpu::instance().set_execute_on_wait(false); }
+        ~stalled_gpu() { stand_in::gpu::instance().set_execute_on_wait(true); }
+    };
+}
+
+TEST(values_increase_and_complete_in_order)
+{
+    queue_and_fence fixture;
+
+    CHECK(fixture.timeline.is_complete(0));
+
+    auto const first = fixture.timeline.signal(fixture.queue.get());
+    auto const second = fixture.timeline.signal(fixture.queue.get());
+
+    CHECK(first == 1);
+    CHECK(second == 2);
+    CHECK(fixture.timeline.last_signaled_value() == 2);
+
+    CHECK(!fixture.timeline.is_complete(first));
+
+    stand_in::gpu::instance().execute();
+
+    CHECK(fixture.timeline.is_complete(second));
+    CHECK(fixture.timeline.completed_value() == 2);
+}
+
+TEST(wait_blocks_until_the_value_is_reached)
+{
+    queue_and_fence fixture;
+
+    auto const value = fixture.timeline.signal(fixture.queue.get());
+
+    CHECK(fixture.timeline.wait(value));
+    CHECK(fixture.timeline.is_complete(value));
+}
+
+TEST(wait_times_out_and_a_later_wait_succeeds)
+{
+    queue_and_fence fixture;
+    stalled_gpu stalled;
+
+    auto const value = fixture.timeline.signal(fixture.queue.get());
+
+    CHECK(!fixture.timeline.wait(value, std::chrono::milliseconds{5}));
+
+    stand_in::gpu::instance().execute();
+
+    // The registration of the timed out wait fired too, which must not confuse the next one.
+    auto const next = fixture.timeline.signal(fixture.queue.get());
+
+    CHECK(fixture.timeline.wait(value, std::chrono::milliseconds{0}));
+    CHECK(!fixture.timeline.wait(next, std::chrono::milliseconds{1}));
+
+    stand_in::gpu::instance().execute();
+
+    CHECK(fixture.timeline.wait(next, std::chrono::milliseconds{1}));
+}
+
+TEST(timeouts_longer_than_a_dword_are_not_truncated)
+{
+    queue_and_fence fixture;
+
+    auto const value = fixture.timeline.signal(fixture.queue.get());
+
+    // A DWORD holds 2^32 + 1 ms as 1 ms and what is left of it once the wait starts as 0 ms, which would
+    // return before the GPU got a chance to run.
+    CHECK(fixture.timeline.wait(value, std::chrono::milliseconds{(1ll << 32) + 1}));
+}
+
+TEST(wait_all_waits_for_the_largest_value)
+{
+    queue_and_fence fixture;
+
+    std::vector<UINT64> values;
+
+    for (auto index = 0; index < 4; ++index)
+        values.push_back(fixture.timeline.signal(fixture.queue.get()));
+
+    std::swap(values.front(), values.back());
+
+    auto const waits = stand_in::win32().waits.load();
+
+    CHECK(fixture.timeline.wait_all(values));
+    CHECK(fixture.timeline.is_complete(4));
+    CHECK(stand_in::win32().waits.load() == waits + 1);
+
+    CHECK(fixture.timeline.wait_all({ }));
+}
+
+TEST(wait_events_are_pooled)
+{
+    queue_and_fence fixture;
+
+    auto const created = stand_in::win32().events_created.load();
+
+    for (auto index = 0; index < 100; ++index)
+        fixture.timeline.flush(fixture.queue.get());
+
+    CHECK(stand_in::win32().events_created.load() == created + 1);
+}
+
+TEST(failed_waits_throw)
+{
+    queue_and_fence fixture;
+
+    auto const value = fixture.timeline.signal(fixture.queue.get());
+
+    stand_in::injected_wait_failures() = 1;
+
+    CHECK_THROWS(dx::fence_error, fixture.timeline.wait(value));
+
+    // The failed event is discarded rather than handed to the next waiter.
+    CHECK(fixture.timeline.wait(value));
+}
+
+TEST(concurrent_waiters)
+{
+    queue_and_fence fixture;
+    stand_in::gpu_thread gpu{std::chrono::microseconds{50}};
+
+    auto constexpr kTHREAD_NUMBER = 4;
+    auto constexpr kVALUE_NUMBER = 200;
+
+    std::atomic<int> early_returns{0};
+    std::vector<std::thread> waiters;
+
+    for (auto thread = 0; thread < kTHREAD_NUMBER; ++thread) {
+        waiters.emplace_back([&fixture, &early_returns]
+        {
+            for (UINT64 value = 1; value <= kVALUE_NUMBER; ++value) {
+                while (fixture.timeline.last_signaled_value() < value)
+                    std::this_thread::yield();
+
+                if (!fixture.timeline.wait(value) || !fixture.timeline.is_complete(value))
+                    ++early_returns;
+            }
+        });
+    }
+
+    // Signals have to be serialized, waits don't.
+    for (auto value = 0; value < kVALUE_NUMBER; ++value)
+        fixture.timeline.signal(fixture.queue.get());
+
+    for (auto &&waiter : waiters)
+        waiter.join();
+
+    CHECK(early_returns.load() == 0);
+}
@@ -0,0 +1,114 @@
+#include <map>
+
+#include "test.hxx"
+
+#include "main.hxx"
+#include "graphics/command_pool.hxx"
+#include "graphics/frame.hxx"
+#include "graphics/queue.hxx"
+
+
+namespace
+{
+    // The frame loop of draw(): wait for the slot's previous frame, record, submit, advance.
+    struct renderer final {
+        winrt::com_ptr<ID3D12Device6> device{stand_in::create_device()};
+
+        graphics::resource_state_registry resource_states;
+        graphics::queue_scheduler queues{device.get()};
+        graphics::command_pool command_pool{device.get()};
+
+        std::vector<graphics::frame_context> frame_contexts;
+        std::uint32_t frame_index{0};
+
+        // The fence value of the last submission that used each allocator.
+        std::map<ID3D12CommandAllocator *, UINT64> submitted_allocators;
+
+        std::size_t early_resets{0};
+
+        explicit renderer(std::uint32_t frames_in_flight) : frame_contexts{create_frame_contexts(frames_in_flight, resource_states)} { }
+
+        ~renderer() { queues.flush(); }
+
+        auto &timeline() { return queues.timeline(graphics::queue_type::graphics); }
+
+        void frame()
+        {
+            auto &frame = frame_contexts.at(frame_index);
+
+            timeline().wait(frame.fence_value);
+
+            begin_command_lists(frame, command_pool, D3D12_COMMAND_LIST_TYPE_DIRECT);
+
+            auto const allocator = frame.command_contexts.back().command_allocator.get();
+
+            if (auto it = submitted_allocators.find(allocator); it != std::end(submitted_allocators) && !timeline().is_complete(it->second))
+                ++early_resets;
+
+            frame.current_command_list->DrawIndexedInstanced(3, 1, 0, 0, 0);
+
+            frame.fence_value = submit_command_lists(frame, command_pool, queues, graphics::queue_type::graphics);
+
+            submitted_allocators.insert_or_assign(allocator, frame.fence_value);
+
+            frame_index = (frame_index + 1) % static_cast<std::uint32_t>(std::size(frame_contexts));
+        }
+    };
+}
+
+TEST(allocators_are_reset_only_after_their_fence)
+{
+    for (auto frames_in_flight = 1u; frames_in_flight <= 3; ++frames_in_flight) {
+        stand_in::debug_layer::instance().clear();
+
+        renderer renderer{frames_in_flight};
+
+        for (auto index = 0; index < 100; ++index)
+            renderer.frame();
+
+        CHECK(renderer.early_resets == 0);
+        CHECK(stand_in::debug_layer::instance().messages().empty());
+
+        // One pair per frame in flight, plus one while the oldest slot's fence is being reached.
+        CHECK(renderer.command_pool.statistics(D3D12_COMMAND_LIST_TYPE_DIRECT).created <= frames_in_flight + 1);
+    }
+}
+
+TEST(cpu_records_ahead_of_the_gpu)
+{
+    renderer renderer{3};
+
+    // Nothing executes until the CPU has to wait, so three frames are submitted without the GPU starting any of them.
+    for (auto index = 0; index < 3; ++index)
+        renderer.frame();
+
+    CHECK(renderer.timeline().completed_value() == 0);
+    CHECK(renderer.timeline().last_signaled_value() == 3);
+
+    // The fourth frame reuses the first slot and waits only for the first frame.
+    renderer.frame();
+
+    CHECK(renderer.timeline().completed_value() >= 1);
+    CHECK(renderer.early_resets == 0);
+}
+
+TEST(resetting_an_executing_allocator_is_caught)
+{
+    stand_in::debug_layer::instance().clear();
+
+    renderer renderer{2};
+
+    auto context = renderer.command_pool.acquire(D3D12_COMMAND_LIST_TYPE_DIRECT);
+
+    CHECK(SUCCEEDED(context.command_list->Close()));
+
+    ID3D12CommandList *const command_lists[] = {context.command_list.get()};
+    renderer.queues.submit(graphics::queue_type::graphics, command_lists);
+
+    CHECK(FAILED(context.command_allocator->Reset()));
+    CHECK(std::size(stand_in::debug_layer::instance().messages()) == 1);
+
+    stand_in::gpu::instance().execute();
+
+    CHECK(SUCCEEDED(context.command_allocator->Reset()));
+}
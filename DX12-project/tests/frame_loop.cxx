@@ -0,0 +1,202 @@
+#include <functional>
+#include <vector>
+
+#include "test.hxx"
+
+#include "platform/frame_loop.hxx"
+
+
+namespace
+{
+    using namespace std::chrono_literals;
+
+    using time_point = std::chrono::steady_clock::time_point;
+
+    // Time only moves when the test moves it.
+    struct manual_clock final {
+        time_point const *time;
+
+        time_point now() const noexcept { return *time; }
+    };
+
+    // The frame loop's event source; its waits pass the whole timeout on the clock.
+    struct simulated_window final {
+        time_point time{ };
+
+        bool closed{false};
+
+        // Waits left until the window is restored.
+        std::uint32_t minimized_waits{0};
+
+        std::uint64_t events{0};
+
+        std::chrono::nanoseconds poll_cost{0};
+
+        std::vector<std::chrono::nanoseconds> waits{ };
+
+        // Called at the end of each wait.
+        std::function<void(simulated_window &)> on_wait{ };
+
+        bool should_close() const noexcept { return closed; }
+
+        bool minimized() const noexcept { return minimized_waits != 0; }
+
+        void poll_events() { time += poll_cost; }
+
+        void wait_events(std::chrono::nanoseconds timeout)
+        {
+            waits.push_back(timeout);
+            time += timeout;
+
+            if (minimized_waits != 0)
+                --minimized_waits;
+
+            if (on_wait)
+                on_wait(*this);
+        }
+
+        std::uint64_t event_count() const noexcept { return events; }
+
+        manual_clock clock() const noexcept { return manual_clock{&time}; }
+    };
+}
+
+TEST(simulation_steps_follow_the_elapsed_time)
+{
+    simulated_window window;
+
+    platform::frame_loop loop{platform::frame_loop_settings{.simulation_step = 10ms}, window.clock()};
+
+    std::vector<std::uint32_t> steps;
+    std::vector<double> alphas;
+
+    auto frame_steps = 0u;
+
+    loop.run(window, [] { }, [&frame_steps] (std::chrono::nanoseconds step)
+    {
+        CHECK(step == 10ms);
+        ++frame_steps;
+    },
+    [&] (double alpha)
+    {
+        steps.push_back(std::exchange(frame_steps, 0u));
+        alphas.push_back(alpha);
+
+        // Each frame takes 25 ms.
+        window.time += 25ms;
+
+        window.closed = std::size(steps) == 8;
+    });
+
+    CHECK((steps == std::vector<std::uint32_t>{0, 2, 3, 2, 3, 2, 3, 2}));
+    CHECK((alphas == std::vector<double>{0., .5, 0., .5, 0., .5, 0., .5}));
+
+    CHECK(loop.statistics().frames == 8);
+    CHECK(loop.statistics().simulation_steps == 17);
+    CHECK(loop.statistics().dropped_time == 0ns);
+    CHECK(window.waits.empty());
+}
+
+TEST(stages_are_timed_with_the_injected_clock)
+{
+    simulated_window window{.poll_cost = 1ms};
+
+    platform::frame_loop loop{platform::frame_loop_settings{.simulation_step = 10ms}, window.clock()};
+
+    loop.run(window, [&window] { window.time += 3ms; }, [&window] (std::chrono::nanoseconds) { window.time += 2ms; },
+    [&window, &loop] (double)
+    {
+        window.time += 4ms;
+
+        window.closed = loop.statistics().frames == 1;
+    });
+
+    // The second frame sees 4 + 4 + 3 + 1 ms since the first one sampled the time: one step.
+    auto const &last = loop.last_frame();
+
+    CHECK(last[platform::frame_stage::wait] == 3ms);
+    CHECK(last[platform::frame_stage::events] == 1ms);
+    CHECK(last[platform::frame_stage::simulation] == 2ms);
+    CHECK(last[platform::frame_stage::render] == 4ms);
+    CHECK(last.simulation_steps == 1);
+
+    auto const &statistics = loop.statistics();
+
+    CHECK(statistics.frames == 2);
+    CHECK(statistics.total[platform::frame_stage::render] == 8ms);
+    CHECK(statistics.total[platform::frame_stage::simulation] == 2ms);
+    CHECK(statistics.max[platform::frame_stage::wait] == 3ms);
+}
+
+TEST(a_stall_is_dropped_beyond_the_step_limit)
+{
+    simulated_window window;
+
+    platform::frame_loop loop{platform::frame_loop_settings{.simulation_step = 10ms, .max_steps_per_frame = 8}, window.clock()};
+
+    std::vector<double> alphas;
+
+    loop.run(window, [] { }, [] (std::chrono::nanoseconds) { }, [&] (double alpha)
+    {
+        alphas.push_back(alpha);
+
+        window.time += 1s + 5ms;
+        window.closed = std::size(alphas) == 2;
+    });
+
+    CHECK(loop.statistics().simulation_steps == 8);
+    CHECK(loop.statistics().dropped_time == 925ms);
+    CHECK(alphas.back() == 0.);
+}
+
+TEST(a_minimized_window_waits_and_pauses_the_simulation)
+{
+    simulated_window window{.minimized_waits = 3};
+
+    platform::frame_loop loop{platform::frame_loop_settings{.simulation_step = 10ms, .idle_timeout = 250ms}, window.clock()};
+
+    auto simulation_steps = 0u;
+
+    loop.run(window, [] { }, [&simulation_steps] (std::chrono::nanoseconds) { ++simulation_steps; }, [&window] (double)
+    {
+        window.time += 10ms;
+        window.closed = true;
+    });
+
+    CHECK((window.waits == std::vector<std::chrono::nanoseconds>(3, 250ms)));
+
+    // The 750 ms spent minimized don't have to be caught up with.
+    CHECK(simulation_steps == 0);
+    CHECK(loop.statistics().idle_waits == 3);
+    CHECK(loop.statistics().frames == 1);
+    CHECK(loop.statistics().dropped_time == 0ns);
+}
+
+TEST(on_demand_renders_for_events_and_while_animating)
+{
+    simulated_window window;
+
+    // The first wait brings an event that starts a three step animation, the second one closes the window.
+    window.on_wait = [waits = 0] (simulated_window &window) mutable
+    {
+        if (++waits == 1)
+            ++window.events;
+
+        else window.closed = true;
+    };
+
+    platform::frame_loop loop{platform::frame_loop_settings{.simulation_step = 10ms, .on_demand = true}, window.clock()};
+
+    auto animation_steps = 0u;
+
+    loop.run(window, [] { }, [&animation_steps] (std::chrono::nanoseconds) { return ++animation_steps < 3; },
+    [&window] (double) { window.time += 10ms; });
+
+    auto const &statistics = loop.statistics();
+
+    // The first frame, the one that shows the event, and the three animated ones.
+    CHECK(statistics.frames == 5);
+    CHECK(statistics.simulation_steps == 3);
+    CHECK(statistics.idle_waits == 2);
+    CHECK(std::size(window.waits) == 2);
+}
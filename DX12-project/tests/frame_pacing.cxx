@@ -0,0 +1,218 @@
+#include <random>
+#include <thread>
+
+#include "test.hxx"
+
+#include "main.hxx"
+#include "graphics/frame_completion.hxx"
+#include "graphics/frame_pacing.hxx"
+#include "graphics/queue.hxx"
+
+
+namespace
+{
+    using namespace std::chrono_literals;
+
+    using duration = graphics::frame_pacer::duration;
+    using time_point = graphics::frame_pacer::time_point;
+
+    auto constexpr kPERIOD = duration{16'666'667};
+
+    struct simulation_result final {
+        std::uint32_t missed_vsyncs{0};
+
+        graphics::frame_pacer_statistics statistics;
+
+        duration median_latency{0};
+    };
+
+    // A display with a maximum frame latency of one: the wait returns at the vsync that shows the previous frame,
+    // and a frame is shown at the first vsync after its work is done, but not before the one after its wake-up.
+    // Vsyncs missed during the first 'warm_up' frames, before the pacer has a prediction, aren't counted.
+    template<class W>
+    simulation_result simulate(graphics::frame_pacer &pacer, std::uint32_t frames, W &&work_of, std::uint32_t warm_up = 8)
+    {
+        simulation_result result;
+
+        auto wake_time = time_point{kPERIOD};
+
+        for (auto frame = 0u; frame < frames; ++frame) {
+            auto const sample_time = pacer.begin_frame(wake_time);
+
+            CHECK(sample_time >= wake_time);
+
+            auto const ready_time = sample_time + work_of(frame);
+
+            pacer.end_frame(ready_time);
+
+            auto const next_vsync = wake_time + kPERIOD;
+            auto const shown = (std::max)(next_vsync, time_point{(ready_time.time_since_epoch() + kPERIOD - duration{1}) / kPERIOD * kPERIOD});
+
+            if (shown != next_vsync && frame >= warm_up)
+                ++result.missed_vsyncs;
+
+            wake_time = shown;
+        }
+
+        result.statistics = pacer.statistics();
+        result.median_latency = pacer.latency_percentile(.5);
+
+        return result;
+    }
+
+    // Like simulate(), with 'gpu' of GPU work that starts once the CPU has submitted the frame and the GPU is done
+    // with the previous one. The pacer is told when the GPU finished, or, if 'report_cpu_time', when the CPU did.
+    simulation_result simulate(graphics::frame_pacer &pacer, std::uint32_t frames, duration cpu, duration gpu, bool report_cpu_time = false)
+    {
+        simulation_result result;
+
+        auto wake_time = time_point{kPERIOD};
+        auto gpu_done = time_point{ };
+
+        for (auto frame = 0u; frame < frames; ++frame) {
+            auto const sample_time = pacer.begin_frame(wake_time);
+
+            auto const submitted = sample_time + cpu;
+
+            gpu_done = (std::max)(submitted, gpu_done) + gpu;
+
+            pacer.end_frame(report_cpu_time ? submitted : gpu_done);
+
+            auto const next_vsync = wake_time + kPERIOD;
+            auto const shown = (std::max)(next_vsync, time_point{(gpu_done.time_since_epoch() + kPERIOD - duration{1}) / kPERIOD * kPERIOD});
+
+            if (shown != next_vsync && frame >= 8)
+                ++result.missed_vsyncs;
+
+            wake_time = shown;
+        }
+
+        result.statistics = pacer.statistics();
+        result.median_latency = pacer.latency_percentile(.5);
+
+        return result;
+    }
+}
+
+TEST(steady_work_is_started_late_and_makes_every_vsync)
+{
+    graphics::frame_pacer pacer;
+
+    std::mt19937 generator{21};
+    std::uniform_int_distribution<duration::rep> jitter{-500'000, 500'000};
+
+    auto const result = simulate(pacer, 600, [&] (std::uint32_t) { return 5ms + duration{jitter(generator)}; });
+
+    CHECK(result.missed_vsyncs == 0);
+
+    // About the worst recent frame plus the margin before the vsync, instead of a whole period.
+    CHECK(result.statistics.predicted_work >= 5ms && result.statistics.predicted_work <= 5500us);
+    CHECK(result.median_latency >= 5ms && result.median_latency <= 7ms);
+    CHECK(result.statistics.delay >= kPERIOD - 7ms);
+}
+
+TEST(disabled_pacing_samples_input_at_the_wake_up)
+{
+    graphics::frame_pacer pacer{graphics::frame_pacer_settings{.enabled = false}};
+
+    auto const result = simulate(pacer, 120, [] (std::uint32_t) { return 5ms; });
+
+    CHECK(result.missed_vsyncs == 0);
+    CHECK(result.statistics.missed == 0);
+    CHECK(result.statistics.delay == duration{0});
+    CHECK(result.median_latency == kPERIOD);
+}
+
+TEST(a_spike_widens_the_margin_which_then_decays)
+{
+    graphics::frame_pacer pacer;
+
+    // Warm up, then one frame that takes longer than the time left before its vsync.
+    auto result = simulate(pacer, 200, [] (std::uint32_t frame) { return frame == 150 ? 12ms : 5ms; });
+
+    auto const missed_before = result.statistics.missed;
+
+    CHECK(result.missed_vsyncs == 1);
+    CHECK(result.statistics.margin > 1ms);
+
+    // The one slow frame isn't the 99th percentile of the history, so the prediction stays put.
+    CHECK(result.statistics.predicted_work == 5ms);
+
+    result = simulate(pacer, 600, [] (std::uint32_t) { return 5ms; }, 0);
+
+    CHECK(result.missed_vsyncs == 0);
+    CHECK(result.statistics.missed == missed_before);
+    CHECK(result.statistics.margin < 1100us);
+}
+
+TEST(work_longer_than_a_period_halves_the_frame_rate_without_delay)
+{
+    graphics::frame_pacer pacer;
+
+    auto const result = simulate(pacer, 120, [] (std::uint32_t) { return 20ms; });
+
+    // Every frame misses its vsync; delaying input would only add to that.
+    CHECK(result.missed_vsyncs == 120 - 8);
+    CHECK(result.statistics.delay == duration{0});
+    CHECK(result.statistics.margin == kPERIOD / 2);
+}
+
+TEST(gpu_bound_frames_are_predicted_from_the_gpu_completion)
+{
+    // 2 ms on the CPU and 10 ms on the GPU at 60 Hz.
+    graphics::frame_pacer pacer;
+
+    auto const result = simulate(pacer, 300, 2ms, 10ms);
+
+    CHECK(result.missed_vsyncs == 0);
+    CHECK(result.statistics.predicted_work == 12ms);
+    CHECK(result.statistics.delay >= kPERIOD - 12ms - 2ms);
+
+    // Told when the CPU was done, the pacer starts the frames so late that the GPU misses every vsync,
+    // even with the widest margin.
+    graphics::frame_pacer cpu_timed;
+
+    auto const cpu_result = simulate(cpu_timed, 300, 2ms, 10ms, true);
+
+    CHECK(cpu_result.missed_vsyncs == 300 - 8);
+    CHECK(cpu_result.statistics.margin == kPERIOD / 2);
+}
+
+TEST(frame_completions_are_timed_when_the_gpu_reaches_the_fence)
+{
+    stand_in::gpu::instance().set_execute_on_wait(false);
+
+    auto device = stand_in::create_device();
+    graphics::queue_scheduler queues{device.get()};
+
+    {
+        graphics::frame_completion_timer completions{queues.timeline(graphics::queue_type::graphics)};
+
+        auto const first = queues.signal(graphics::queue_type::graphics).value;
+        auto const second = queues.signal(graphics::queue_type::graphics).value;
+
+        completions.submitted(first);
+        completions.submitted(second);
+
+        // The GPU takes a while to get to the frames.
+        std::this_thread::sleep_for(20ms);
+
+        auto const executed = graphics::frame_completion_timer::clock::now();
+
+        stand_in::gpu::instance().execute();
+
+        auto const second_time = completions.completion_time(second);
+
+        CHECK(second_time >= executed);
+        CHECK(second_time <= graphics::frame_completion_timer::clock::now());
+
+        // Goes away while it waits for a value the GPU hasn't reached.
+        completions.submitted(queues.signal(graphics::queue_type::graphics).value);
+
+        std::this_thread::sleep_for(5ms);
+    }
+
+    stand_in::gpu::instance().set_execute_on_wait(true);
+
+    queues.flush();
+}
@@ -0,0 +1,182 @@
+#include <random>
+
+#include "test.hxx"
+
+#include "graphics/draw_commands.hxx"
+#include "graphics/instance_store.hxx"
+
+
+namespace
+{
+    graphics::gpu_instance instance_at(float x, float y, float z, std::uint32_t mesh = 0)
+    {
+        graphics::gpu_instance instance;
+
+        instance.transform[3] = x;
+        instance.transform[7] = y;
+        instance.transform[11] = z;
+
+        instance.bounds = {0.f, 0.f, 0.f, .1f};
+        instance.mesh = mesh;
+
+        return instance;
+    }
+
+    // Clip space is the view space: x and y in [-1, 1], z in [0, 1].
+    auto const kIDENTITY_FRUSTUM = graphics::frustum_of({1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f, 0.f, 0.f, 0.f, 0.f, 1.f});
+}
+
+TEST(handles_survive_compaction)
+{
+    graphics::instance_store<graphics::gpu_instance> store{8};
+
+    auto const first = store.insert(instance_at(0.f, 0.f, .1f, 1));
+    auto const second = store.insert(instance_at(0.f, 0.f, .2f, 2));
+    auto const third = store.insert(instance_at(0.f, 0.f, .3f, 3));
+
+    store.clear_dirty();
+
+    CHECK(store.erase(first));
+
+    // The last instance moved into the hole and only that element has to be uploaded again.
+    CHECK(store.size() == 2);
+    CHECK(store.index_of(third) == 0);
+    CHECK(store.find(third)->mesh == 3);
+    CHECK(store.find(second)->mesh == 2);
+    CHECK((store.dirty_ranges() == std::vector{graphics::dirty_range{0, 1}}));
+
+    // A stale handle doesn't refer to the instance that reuses its slot.
+    CHECK(!store.contains(first));
+    CHECK(!store.erase(first));
+    CHECK(!store.update(first, instance_at(0.f, 0.f, 0.f)));
+
+    auto const fourth = store.insert(instance_at(0.f, 0.f, .4f, 4));
+
+    CHECK(fourth.slot == first.slot && fourth.generation != first.generation);
+    CHECK(store.find(first) == nullptr);
+    CHECK(store.handle_of(store.index_of(fourth)) == fourth);
+}
+
+TEST(dirty_ranges_merge_small_gaps)
+{
+    graphics::instance_store<graphics::gpu_instance> store{256};
+
+    std::vector<graphics::instance_handle> handles;
+
+    for (auto index = 0; index < 200; ++index)
+        handles.push_back(store.insert(instance_at(0.f, 0.f, .5f)));
+
+    CHECK((store.dirty_ranges() == std::vector{graphics::dirty_range{0, 200}}));
+
+    store.clear_dirty();
+
+    for (auto index : {10, 12, 40, 41, 150})
+        store.update(handles[static_cast<std::size_t>(index)], instance_at(.5f, 0.f, .5f));
+
+    CHECK(std::size(store.dirty_ranges()) == 4);
+    CHECK((store.dirty_ranges(16) == std::vector{graphics::dirty_range{10, 3}, graphics::dirty_range{40, 2}, graphics::dirty_range{150, 1}}));
+    CHECK(std::size(store.dirty_ranges(200)) == 1);
+
+    // Elements past the end after erasing aren't uploaded.
+    store.clear_dirty();
+    store.erase(handles[199]);
+
+    CHECK(store.dirty_ranges().empty());
+
+    CHECK_THROWS(std::length_error, [&store]
+    {
+        for (auto index = 0; index < 100; ++index)
+            (void)store.insert(instance_at(0.f, 0.f, 0.f));
+    }());
+}
+
+// Random edits mirrored in a plain list of handles: the store keeps every instance reachable and the dirty ranges
+// cover every element whose contents changed since the last upload.
+TEST(randomized_edits_keep_the_gpu_copy_in_sync)
+{
+    graphics::instance_store<graphics::gpu_instance> store{1024};
+
+    std::vector<graphics::gpu_instance> gpu_copy;
+    std::vector<std::pair<graphics::instance_handle, std::uint32_t>> live;
+
+    std::mt19937 generator{5};
+    std::uint32_t next_mesh = 0;
+
+    auto failures = 0;
+
+    for (auto frame = 0; frame < 300; ++frame) {
+        for (auto edit = 0; edit < 20; ++edit) {
+            auto const kind = std::uniform_int_distribution<int>{0, 2}(generator);
+
+            if (kind == 0 || live.empty()) {
+                if (store.size() < store.capacity())
+                    live.emplace_back(store.insert(instance_at(0.f, 0.f, .5f, next_mesh)), next_mesh), ++next_mesh;
+            }
+
+            else {
+                auto const position = std::uniform_int_distribution<std::size_t>{0, std::size(live) - 1}(generator);
+
+                if (kind == 1) {
+                    store.erase(live[position].first);
+
+                    live[position] = live.back();
+                    live.pop_back();
+                }
+
+                else {
+                    live[position].second = next_mesh++;
+                    store.update(live[position].first, instance_at(0.f, 0.f, .5f, live[position].second));
+                }
+            }
+        }
+
+        // The upload of indirect_draws.
+        gpu_copy.resize((std::max)(std::size(gpu_copy), static_cast<std::size_t>(store.size())));
+
+        store.for_each_dirty_range(16, [&] (graphics::dirty_range range)
+        {
+            std::copy_n(std::begin(store.instances()) + range.first, range.count, std::begin(gpu_copy) + range.first);
+        });
+
+        store.clear_dirty();
+
+        for (auto index = 0u; index < store.size(); ++index) {
+            if (gpu_copy[index].mesh != store.instances()[index].mesh)
+                ++failures;
+        }
+
+        for (auto &&[handle, mesh] : live) {
+            if (auto instance = store.find(handle); instance == nullptr || instance->mesh != mesh)
+                ++failures;
+        }
+    }
+
+    CHECK(failures == 0);
+    CHECK(store.size() == std::size(live));
+}
+
+TEST(pack_draw_commands_culls_and_skips_invalid_meshes)
+{
+    auto const meshes = std::vector{graphics::mesh_draw{36, 0, 0, 0}, graphics::mesh_draw{72, 36, 10, 0}};
+
+    auto const instances = std::vector{
+        instance_at(0.f, 0.f, .5f, 0),
+        instance_at(3.f, 0.f, .5f, 0),
+        instance_at(0.f, 0.f, .5f, 1),
+        instance_at(0.f, 0.f, .5f, 7),
+        // Partly inside: the sphere reaches over the left plane.
+        instance_at(-1.05f, 0.f, .5f, 1),
+        instance_at(0.f, 0.f, -.5f, 0)
+    };
+
+    std::vector<graphics::indirect_draw_command> commands(std::size(instances));
+
+    auto const count = graphics::pack_draw_commands(instances, meshes, kIDENTITY_FRUSTUM, commands);
+
+    CHECK(count == 3);
+
+    CHECK(commands[0].instance_index == 0 && commands[0].arguments.index_count_per_instance == 36);
+    CHECK(commands[1].instance_index == 2 && commands[1].arguments.start_index_location == 36);
+    CHECK(commands[1].arguments.base_vertex_location == 10 && commands[1].arguments.instance_count == 1);
+    CHECK(commands[2].instance_index == 4);
+}
@@ -0,0 +1,147 @@
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+#include <thread>
+
+#include "test.hxx"
+
+#include "platform/job_system.hxx"
+
+
+namespace
+{
+    // Runs 'count' jobs that each spawn a child job and returns how many ran.
+    std::uint32_t run_nested_jobs(platform::job_system &jobs, std::uint32_t count)
+    {
+        std::atomic<std::uint32_t> executed{0};
+
+        platform::job_counter counter;
+
+        for (auto index = 0u; index < count; ++index) {
+            jobs.run(counter, [&jobs, &executed]
+            {
+                platform::job_counter child;
+
+                jobs.run(child, [&executed] { ++executed; });
+                jobs.wait(child);
+
+                ++executed;
+            });
+        }
+
+        jobs.wait(counter);
+
+        return executed.load();
+    }
+}
+
+TEST(only_the_owner_and_the_workers_use_the_job_system)
+{
+    platform::job_system jobs{2};
+
+    CHECK(run_nested_jobs(jobs, 64) == 128);
+
+    auto rejected = false;
+
+    std::thread{[&jobs, &rejected]
+    {
+        platform::job_counter counter;
+
+        try {
+            jobs.run(counter, [] { });
+        }
+
+        catch (std::logic_error const &) {
+            rejected = true;
+        }
+    }}.join();
+
+    CHECK(rejected);
+}
+
+TEST(ownership_is_handed_to_another_thread)
+{
+    platform::job_system jobs{2};
+
+    CHECK(run_nested_jobs(jobs, 16) == 32);
+
+    auto executed = 0u;
+
+    // Like the render thread after startup.
+    std::thread{[&jobs, &executed]
+    {
+        jobs.take_ownership();
+
+        executed = run_nested_jobs(jobs, 64);
+
+        CHECK(jobs.thread_index() == 0);
+    }}.join();
+
+    CHECK(executed == 128);
+
+    platform::job_counter counter;
+
+    CHECK_THROWS(std::logic_error, jobs.run(counter, [] { }));
+    CHECK_THROWS(std::logic_error, jobs.wait(counter));
+
+    jobs.take_ownership();
+
+    CHECK(run_nested_jobs(jobs, 16) == 32);
+}
+
+TEST(workers_are_outside_threads_of_other_job_systems)
+{
+    platform::job_system larger{4};
+    platform::job_system smaller{1};
+
+    std::atomic<int> rejected{0};
+    std::atomic<int> misplaced{0};
+
+    platform::job_counter counter;
+
+    // Runs on workers of the larger pool, whose indices are out of range in the smaller one.
+    for (auto index = 0; index < 64; ++index) {
+        larger.run(counter, [&]
+        {
+            if (larger.thread_index() >= larger.thread_count() || smaller.thread_index() != 0)
+                ++misplaced;
+
+            platform::job_counter nested;
+
+            try {
+                smaller.run(nested, [] { });
+                smaller.wait(nested);
+            }
+
+            catch (std::logic_error const &) {
+                ++rejected;
+            }
+
+            // Long enough for the workers to take some of the jobs.
+            std::this_thread::sleep_for(std::chrono::microseconds{200});
+        });
+    }
+
+    larger.wait(counter);
+
+    // The owner runs some of the jobs itself, and it owns both pools.
+    CHECK(misplaced.load() == 0);
+    CHECK(rejected.load() > 0);
+
+    // Both pools still work from their owner.
+    CHECK(run_nested_jobs(smaller, 16) == 32);
+    CHECK(run_nested_jobs(larger, 16) == 32);
+}
+
+TEST(exceptions_reach_the_waiting_owner)
+{
+    platform::job_system jobs{1};
+
+    platform::job_counter counter;
+
+    for (auto index = 0; index < 8; ++index)
+        jobs.run(counter, [index] { if (index == 5) throw std::runtime_error{"job"}; });
+
+    CHECK_THROWS(std::runtime_error, jobs.wait(counter));
+    CHECK(counter.done());
+}
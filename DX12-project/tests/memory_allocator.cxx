@@ -0,0 +1,69 @@
+#include "test.hxx"
+
+#include "main.hxx"
+#include "graphics/memory.hxx"
+
+
+TEST(placed_resources_respect_the_alignment_classes)
+{
+    auto device = stand_in::create_device();
+    graphics::memory_allocator allocator{device.get(), 16ull << 20};
+
+    auto const buffer = allocator.create_placed_resource(D3D12_HEAP_TYPE_DEFAULT, CD3DX12_RESOURCE_DESC::Buffer(100'000),
+                                                         D3D12_RESOURCE_STATE_COMMON);
+
+    auto const msaa = allocator.create_placed_resource(D3D12_HEAP_TYPE_DEFAULT,
+                                                       CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 256, 256, 1, 1, 4, 0,
+                                                                                    D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET),
+                                                       D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+    CHECK(buffer.allocation.offset % D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT == 0);
+    CHECK(msaa.allocation.offset % D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT == 0);
+
+    // Different alignment classes live in different pools, hence different heaps.
+    CHECK(buffer.allocation.heap != msaa.allocation.heap);
+    CHECK(msaa.allocation.heap->GetDesc().Alignment == D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT);
+
+    CHECK(stand_in::debug_layer::instance().messages().empty());
+}
+
+TEST(many_resources_share_a_few_heaps)
+{
+    auto device = stand_in::create_device();
+    graphics::memory_allocator allocator{device.get(), 16ull << 20};
+
+    std::vector<graphics::placed_resource> resources;
+
+    for (auto index = 0; index < 1000; ++index)
+        resources.push_back(allocator.create_placed_resource(D3D12_HEAP_TYPE_DEFAULT, CD3DX12_RESOURCE_DESC::Buffer(4096), D3D12_RESOURCE_STATE_COMMON));
+
+    // 1000 64K buffers in 16M blocks.
+    CHECK(device->statistics().heaps.load() == 4);
+    CHECK(device->statistics().committed_resources.load() == 0);
+
+    for (auto &&resource : resources)
+        allocator.release(resource);
+
+    allocator.trim();
+
+    for (auto &&pool : allocator.statistics()) {
+        CHECK(pool.usage.used == 0);
+        CHECK(pool.usage.allocation_count == 0);
+    }
+}
+
+TEST(tier_1_keeps_buffers_and_textures_apart)
+{
+    auto device = stand_in::create_device();
+    device->set_resource_heap_tier(D3D12_RESOURCE_HEAP_TIER_1);
+
+    graphics::memory_allocator allocator{device.get(), 16ull << 20};
+
+    auto const buffer = allocator.create_placed_resource(D3D12_HEAP_TYPE_DEFAULT, CD3DX12_RESOURCE_DESC::Buffer(4096), D3D12_RESOURCE_STATE_COMMON);
+    auto const texture = allocator.create_placed_resource(D3D12_HEAP_TYPE_DEFAULT, CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 64, 64),
+                                                          D3D12_RESOURCE_STATE_COMMON);
+
+    CHECK(buffer.allocation.heap != texture.allocation.heap);
+    CHECK(buffer.allocation.heap->GetDesc().Flags == D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS);
+    CHECK(texture.allocation.heap->GetDesc().Flags == D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES);
+}
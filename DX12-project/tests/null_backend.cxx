@@ -0,0 +1,262 @@
+#include <stdexcept>
+#include <vector>
+
+#include "test.hxx"
+
+#include "graphics/null_backend.hxx"
+
+
+namespace
+{
+    using namespace graphics::backend;
+    using namespace std::chrono_literals;
+
+    std::unique_ptr<resource_interface> create_buffer(null_device &device, std::uint64_t size)
+    {
+        return device.create_committed_resource(resource_description{resource_dimension::buffer, size}, heap_type::gpu,
+                                                graphics::resource_access::copy_dest);
+    }
+
+    void execute(queue_interface &queue, command_list_interface &command_list)
+    {
+        command_list_interface *const lists[] = {&command_list};
+        queue.execute(lists);
+    }
+}
+
+TEST(commands_are_decoded_as_they_were_recorded)
+{
+    null_device device;
+
+    auto const source = create_buffer(device, 1024);
+    auto const destination = create_buffer(device, 1024);
+    auto const heap = device.create_descriptor_heap(descriptor_heap_description{descriptor_heap_type::view, 16, true});
+
+    auto const list = device.create_command_list(graphics::queue_type::graphics);
+
+    resource_barrier const barriers[] = {
+        resource_barrier{barrier_type::transition, destination.get(), nullptr, 3, graphics::resource_access::copy_dest,
+                         graphics::resource_access::shader_read},
+        resource_barrier{barrier_type::aliasing, nullptr, source.get()}
+    };
+
+    descriptor_heap_interface *const heaps[] = {heap.get()};
+
+    list->resource_barriers(barriers);
+    list->set_descriptor_heaps(heaps);
+    list->copy_buffer_region(*destination, 16, *source, 32, 64);
+    list->draw_indexed(36, 2, 6, -4, 1);
+    list->dispatch(8, 4, 2);
+    list->close();
+
+    auto &&null_list = static_cast<null_command_list &>(*list);
+
+    CHECK(null_list.command_count() == 6);
+
+    auto const id_of = [] (auto const &resource) { return static_cast<null_resource const &>(*resource).id(); };
+
+    std::vector<null_command> commands;
+
+    for_each_null_command(null_list.stream(), [&] (null_command command, std::span<std::byte const> payload)
+    {
+        commands.push_back(command);
+
+        null_payload_reader reader{payload};
+
+        switch (command) {
+            case null_command::barrier:
+            {
+                auto const type = static_cast<barrier_type>(reader.read<std::uint8_t>());
+                auto const resource = reader.read<std::uint32_t>();
+                auto const resource_after = reader.read<std::uint32_t>();
+                auto const subresource = reader.read<std::uint32_t>();
+                auto const before = static_cast<graphics::resource_access>(reader.read<std::uint32_t>());
+                auto const after = static_cast<graphics::resource_access>(reader.read<std::uint32_t>());
+
+                if (type == barrier_type::transition) {
+                    CHECK(resource == id_of(destination) && resource_after == 0 && subresource == 3);
+                    CHECK(before == graphics::resource_access::copy_dest && after == graphics::resource_access::shader_read);
+                }
+
+                else CHECK(type == barrier_type::aliasing && resource == 0 && resource_after == id_of(source));
+
+                break;
+            }
+
+            case null_command::set_descriptor_heaps:
+                CHECK(reader.read<std::uint8_t>() == 1);
+                CHECK(reader.read<std::uint32_t>() == static_cast<null_descriptor_heap const &>(*heap).id());
+                CHECK(reader.read<std::uint32_t>() == 0);
+                break;
+
+            case null_command::copy_buffer_region:
+                CHECK(reader.read<std::uint32_t>() == id_of(destination));
+                CHECK(reader.read<std::uint64_t>() == 16);
+                CHECK(reader.read<std::uint32_t>() == id_of(source));
+                CHECK(reader.read<std::uint64_t>() == 32);
+                CHECK(reader.read<std::uint64_t>() == 64);
+                break;
+
+            case null_command::draw_indexed:
+                CHECK(reader.read<std::uint32_t>() == 36);
+                CHECK(reader.read<std::uint32_t>() == 2);
+                CHECK(reader.read<std::uint32_t>() == 6);
+                CHECK(reader.read<std::int32_t>() == -4);
+                CHECK(reader.read<std::uint32_t>() == 1);
+                break;
+
+            case null_command::dispatch:
+                CHECK(reader.read<std::uint32_t>() == 8);
+                CHECK(reader.read<std::uint32_t>() == 4);
+                CHECK(reader.read<std::uint32_t>() == 2);
+
+                // Past the end of the payload.
+                CHECK_THROWS(std::out_of_range, reader.read<std::uint32_t>());
+                break;
+        }
+    });
+
+    CHECK((commands == std::vector{null_command::barrier, null_command::barrier, null_command::set_descriptor_heaps,
+                                   null_command::copy_buffer_region, null_command::draw_indexed, null_command::dispatch}));
+
+    // A stream cut inside a payload.
+    auto const stream = null_list.stream();
+    CHECK_THROWS(std::out_of_range, for_each_null_command(stream.first(std::size(stream) - 1), [] (auto, auto) { }));
+
+    // Reset empties the stream.
+    list->reset();
+
+    CHECK(null_list.stream().empty());
+    CHECK(null_list.command_count() == 0);
+}
+
+TEST(fences_complete_when_the_virtual_gpu_gets_to_them)
+{
+    null_timing timing;
+    timing.command_list = 0.;
+    timing.dispatch = 0.;
+    timing.thread_group = 1'000'000.;
+
+    null_device device{timing};
+
+    auto const queue = device.create_queue(graphics::queue_type::compute);
+    auto const fence = device.create_fence(0);
+
+    // 100 thread groups, 100 ms of virtual GPU time.
+    auto const list = device.create_command_list(graphics::queue_type::compute);
+    list->dispatch(100, 1, 1);
+    list->close();
+
+    CHECK(static_cast<null_command_list &>(*list).cost() == 100ms);
+
+    auto const submitted = device.clock().now();
+
+    execute(*queue, *list);
+    queue->signal(*fence, 1);
+
+    // The host doesn't take 100 ms to get here.
+    CHECK(fence->completed_value() == 0);
+
+    // A wait moves the virtual clock to the completion instead of sleeping.
+    auto const start = std::chrono::steady_clock::now();
+
+    fence->wait(1);
+
+    CHECK(std::chrono::steady_clock::now() - start < 50ms);
+
+    CHECK(fence->completed_value() == 1);
+    CHECK(device.clock().now() - submitted >= 100ms);
+    CHECK(device.clock().skipped() > 50ms);
+
+    CHECK(device.statistics().host_waits == 1);
+    CHECK(device.statistics().busy[static_cast<std::size_t>(graphics::queue_type::compute)] == 100ms);
+
+    // Waiting for a value the fence has reached doesn't move the clock.
+    auto const skipped = device.clock().skipped();
+
+    fence->wait(1);
+
+    CHECK(device.clock().skipped() == skipped);
+}
+
+TEST(queues_execute_in_order_and_wait_for_other_queues)
+{
+    null_timing timing;
+    timing.command_list = 10'000'000.;
+
+    null_device device{timing};
+
+    auto const copy_queue = device.create_queue(graphics::queue_type::copy);
+    auto const graphics_queue = device.create_queue(graphics::queue_type::graphics);
+
+    auto const copy_fence = device.create_fence(0);
+    auto const graphics_fence = device.create_fence(0);
+
+    auto const copy_list = device.create_command_list(graphics::queue_type::copy);
+    copy_list->close();
+
+    auto const graphics_list = device.create_command_list(graphics::queue_type::graphics);
+    graphics_list->close();
+
+    auto const start = device.clock().now();
+
+    // Two copies back to back, the graphics list after the second one.
+    execute(*copy_queue, *copy_list);
+    copy_queue->signal(*copy_fence, 1);
+
+    execute(*copy_queue, *copy_list);
+    copy_queue->signal(*copy_fence, 2);
+
+    graphics_queue->wait(*copy_fence, 2);
+    execute(*graphics_queue, *graphics_list);
+    graphics_queue->signal(*graphics_fence, 1);
+
+    auto &&null_graphics_queue = static_cast<null_queue &>(*graphics_queue);
+
+    CHECK(null_graphics_queue.busy_until() - start >= 30ms);
+    CHECK(null_graphics_queue.busy_until() - start < 40ms);
+
+    graphics_fence->wait(1);
+
+    CHECK(copy_fence->completed_value() == 2);
+    CHECK(device.statistics().executed_command_lists == 3);
+}
+
+TEST(misuse_of_the_null_backend_throws)
+{
+    null_device device;
+
+    auto const buffer = create_buffer(device, 256);
+
+    auto const list = device.create_command_list(graphics::queue_type::graphics);
+    list->close();
+
+    // Recording into a closed list, or closing it twice.
+    CHECK_THROWS(std::logic_error, list->draw_indexed(3, 1, 0, 0, 0));
+    CHECK_THROWS(std::logic_error, list->copy_buffer_region(*buffer, 0, *buffer, 128, 64));
+    CHECK_THROWS(std::logic_error, list->close());
+
+    // Executing a list that is still recording.
+    auto const graphics_queue = device.create_queue(graphics::queue_type::graphics);
+    auto const open_list = device.create_command_list(graphics::queue_type::graphics);
+
+    CHECK_THROWS(std::logic_error, execute(*graphics_queue, *open_list));
+
+    // A list type that doesn't match the queue.
+    auto const compute_queue = device.create_queue(graphics::queue_type::compute);
+
+    CHECK_THROWS(std::invalid_argument, execute(*compute_queue, *list));
+
+    // Waiting on a value nothing will signal, from the host or from a queue.
+    auto const fence = device.create_fence(0);
+
+    graphics_queue->signal(*fence, 1);
+
+    CHECK_THROWS(std::logic_error, fence->wait(2));
+    CHECK_THROWS(std::logic_error, compute_queue->wait(*fence, 2));
+
+    // Signaled values have to increase.
+    CHECK_THROWS(std::logic_error, graphics_queue->signal(*fence, 1));
+
+    CHECK_THROWS(std::invalid_argument, create_buffer(device, 0));
+}
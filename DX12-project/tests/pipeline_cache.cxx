@@ -0,0 +1,526 @@
+#include <atomic>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <thread>
+
+#include "test.hxx"
+
+#include "main.hxx"
+#include "utility/deduplicating_map.hxx"
+#include "graphics/pipeline_cache_file.hxx"
+#include "graphics/pipeline_description.hxx"
+
+
+namespace
+{
+    auto constexpr kKEY = graphics::pipeline_cache_key{0x10de, 0x2484, 0x1f0000000ull};
+
+    std::vector<std::byte> to_bytes(std::string_view text)
+    {
+        auto const bytes = std::as_bytes(std::span{text});
+
+        return {std::begin(bytes), std::end(bytes)};
+    }
+
+    std::vector<std::byte> write_file(std::vector<graphics::pipeline_cache_entry> const &entries, std::span<std::byte const> library = { })
+    {
+        std::ostringstream stream;
+
+        graphics::write_pipeline_cache(stream, kKEY, entries, library);
+
+        return to_bytes(stream.str());
+    }
+
+    // Three blobs of different sizes, so that they need padding in between, and a library.
+    struct cache_contents final {
+        std::vector<std::byte> first = to_bytes("first pipeline");
+        std::vector<std::byte> second = to_bytes("the second, longer pipeline blob");
+        std::vector<std::byte> third = to_bytes("3rd");
+        std::vector<std::byte> library = to_bytes("serialized pipeline library");
+
+        // Not in hash order.
+        std::vector<graphics::pipeline_cache_entry> entries{{30, first}, {10, second}, {20, third}};
+
+        std::vector<std::byte> file = write_file(entries, library);
+    };
+
+    graphics::pipeline_cache_file::header header_of(std::span<std::byte const> file)
+    {
+        graphics::pipeline_cache_file::header value;
+        std::memcpy(&value, std::data(file), sizeof(value));
+
+        return value;
+    }
+
+    void set_header(std::vector<std::byte> &file, graphics::pipeline_cache_file::header const &value)
+    {
+        std::memcpy(std::data(file), &value, sizeof(value));
+    }
+
+    bool equal(std::span<std::byte const> lhs, std::span<std::byte const> rhs)
+    {
+        return std::equal(std::begin(lhs), std::end(lhs), std::begin(rhs), std::end(rhs));
+    }
+}
+
+TEST(written_files_open_and_find_every_blob)
+{
+    cache_contents contents;
+
+    auto const view = graphics::pipeline_cache_view::open(contents.file, kKEY);
+
+    CHECK(view.has_value());
+    CHECK(view->size() == 3);
+
+    CHECK(equal(view->find(30), contents.first));
+    CHECK(equal(view->find(10), contents.second));
+    CHECK(equal(view->find(20), contents.third));
+    CHECK(equal(view->library(), contents.library));
+
+    // Hashes on either side of and between the stored ones.
+    for (auto hash : {0ull, 15ull, 25ull, 31ull, ~0ull})
+        CHECK(view->find(hash).empty());
+
+    // Blobs are 8-byte aligned within the file.
+    std::vector<std::uint64_t> hashes;
+
+    view->for_each([&] (std::uint64_t hash, std::span<std::byte const> blob)
+    {
+        hashes.push_back(hash);
+
+        CHECK((std::data(blob) - std::data(contents.file)) % 8 == 0);
+    });
+
+    CHECK((hashes == std::vector<std::uint64_t>{10, 20, 30}));
+
+    // An empty cache is a valid file as well.
+    auto const empty = write_file({ });
+    auto const empty_view = graphics::pipeline_cache_view::open(empty, kKEY);
+
+    CHECK(empty_view.has_value());
+    CHECK(empty_view->size() == 0);
+    CHECK(empty_view->find(10).empty());
+    CHECK(empty_view->library().empty());
+}
+
+TEST(files_of_another_format_or_adapter_are_ignored)
+{
+    cache_contents contents;
+
+    {
+        auto file = contents.file;
+        file[0] ^= std::byte{1};
+
+        CHECK(!graphics::pipeline_cache_view::open(file, kKEY));
+    }
+
+    // With a valid header checksum, so that only the version tells it apart.
+    {
+        auto file = contents.file;
+
+        auto header = header_of(file);
+        header.version = graphics::pipeline_cache_file::kVERSION + 1;
+        header.header_checksum = graphics::pipeline_cache_file::header_checksum(header);
+
+        set_header(file, header);
+
+        CHECK(!graphics::pipeline_cache_view::open(file, kKEY));
+    }
+
+    // Another driver version, device or vendor.
+    for (auto key : {graphics::pipeline_cache_key{kKEY.vendor_id, kKEY.device_id, kKEY.driver_version + 1},
+                     graphics::pipeline_cache_key{kKEY.vendor_id, kKEY.device_id + 1, kKEY.driver_version},
+                     graphics::pipeline_cache_key{kKEY.vendor_id + 1, kKEY.device_id, kKEY.driver_version}}) {
+        CHECK(!graphics::pipeline_cache_view::open(contents.file, key));
+    }
+}
+
+TEST(corrupted_headers_and_indices_are_rejected)
+{
+    cache_contents contents;
+
+    // Every byte of the header, except those the magic, version and key checks catch before the checksum.
+    for (auto offset = offsetof(graphics::pipeline_cache_file::header, entry_count); offset < sizeof(graphics::pipeline_cache_file::header); ++offset) {
+        auto file = contents.file;
+        file[offset] ^= std::byte{0x40};
+
+        CHECK(!graphics::pipeline_cache_view::open(file, kKEY));
+    }
+
+    auto const index_size = 3 * sizeof(graphics::pipeline_cache_file::index_entry);
+
+    for (auto offset = sizeof(graphics::pipeline_cache_file::header); offset < sizeof(graphics::pipeline_cache_file::header) + index_size; ++offset) {
+        auto file = contents.file;
+        file[offset] ^= std::byte{0x01};
+
+        CHECK(!graphics::pipeline_cache_view::open(file, kKEY));
+    }
+}
+
+TEST(truncated_files_are_rejected_or_miss_the_cut_off_blobs)
+{
+    cache_contents contents;
+
+    auto const index_end = sizeof(graphics::pipeline_cache_file::header) + 3 * sizeof(graphics::pipeline_cache_file::index_entry);
+
+    // Without the whole header and index there is nothing to read.
+    for (auto size : {std::size_t{0}, std::size_t{8}, sizeof(graphics::pipeline_cache_file::header) - 1, index_end - 1}) {
+        auto const file = std::span{contents.file}.first(size);
+
+        CHECK(!graphics::pipeline_cache_view::open(file, kKEY));
+    }
+
+    // The blobs are in hash order: cutting the file in the last one loses that one and the library only.
+    auto const view = graphics::pipeline_cache_view::open(contents.file, kKEY);
+    auto const last_blob = view->find(30);
+
+    auto const cut = static_cast<std::size_t>(std::data(last_blob) - std::data(contents.file)) + 4;
+    auto const truncated = graphics::pipeline_cache_view::open(std::span{contents.file}.first(cut), kKEY);
+
+    CHECK(truncated.has_value());
+
+    CHECK(equal(truncated->find(10), contents.second));
+    CHECK(equal(truncated->find(20), contents.third));
+    CHECK(truncated->find(30).empty());
+    CHECK(truncated->library().empty());
+}
+
+TEST(corrupted_blobs_are_missing)
+{
+    cache_contents contents;
+
+    auto const view = graphics::pipeline_cache_view::open(contents.file, kKEY);
+
+    auto file = contents.file;
+
+    auto const offset = static_cast<std::size_t>(std::data(view->find(20)) - std::data(contents.file));
+    file[offset + 1] ^= std::byte{0x20};
+
+    auto const library_offset = static_cast<std::size_t>(std::data(view->library()) - std::data(contents.file));
+    file[library_offset] ^= std::byte{0x20};
+
+    auto const corrupted = graphics::pipeline_cache_view::open(file, kKEY);
+
+    // The index is intact, so the file opens; only the damaged blob and the library are gone.
+    CHECK(corrupted.has_value());
+    CHECK(corrupted->size() == 3);
+
+    CHECK(corrupted->find(20).empty());
+    CHECK(equal(corrupted->find(10), contents.second));
+    CHECK(equal(corrupted->find(30), contents.first));
+
+    CHECK(corrupted->library().empty());
+}
+
+TEST(duplicate_hashes_are_written_once)
+{
+    auto const blob = to_bytes("pipeline");
+    auto const other = to_bytes("another pipeline");
+
+    auto const file = write_file({{7, blob}, {3, other}, {7, blob}, {7, blob}, {3, other}});
+
+    auto const view = graphics::pipeline_cache_view::open(file, kKEY);
+
+    CHECK(view.has_value());
+    CHECK(view->size() == 2);
+
+    CHECK(equal(view->find(7), blob));
+    CHECK(equal(view->find(3), other));
+
+    auto const unique_file = write_file({{7, blob}, {3, other}});
+
+    CHECK(std::size(file) == std::size(unique_file));
+}
+
+TEST(concurrent_requests_create_a_value_once)
+{
+    utility::deduplicating_map<int> map;
+
+    std::atomic<int> creations{0};
+    std::atomic<int> ready{0};
+
+    auto constexpr kTHREAD_NUMBER = 8;
+    auto constexpr kKEY_NUMBER = 64;
+
+    std::vector<std::thread> threads;
+    std::vector<std::vector<int>> results(kTHREAD_NUMBER);
+
+    for (auto thread = 0; thread < kTHREAD_NUMBER; ++thread) {
+        threads.emplace_back([&, thread]
+        {
+            ++ready;
+
+            while (ready.load() != kTHREAD_NUMBER)
+                std::this_thread::yield();
+
+            for (auto key = 0; key < kKEY_NUMBER; ++key) {
+                results[thread].push_back(map.get_or_create(static_cast<std::uint64_t>(key), [&creations, key]
+                {
+                    ++creations;
+
+                    // Long enough for the other threads to ask for the key while it is being created.
+                    std::this_thread::sleep_for(std::chrono::microseconds{200});
+
+                    return key * 10;
+                }));
+            }
+        });
+    }
+
+    for (auto &&thread : threads)
+        thread.join();
+
+    CHECK(creations.load() == kKEY_NUMBER);
+    CHECK(map.size() == kKEY_NUMBER);
+
+    auto const counters = map.counters();
+
+    CHECK(counters.created == kKEY_NUMBER);
+    CHECK(counters.reused == (kTHREAD_NUMBER - 1) * kKEY_NUMBER);
+
+    for (auto &&values : results) {
+        for (auto key = 0; key < kKEY_NUMBER; ++key)
+            CHECK(values[key] == key * 10);
+    }
+}
+
+TEST(failed_creations_are_retried)
+{
+    utility::deduplicating_map<int> map;
+
+    CHECK_THROWS(std::runtime_error, map.get_or_create(5, [] () -> int { throw std::runtime_error{"compilation failed"}; }));
+
+    CHECK(!map.contains(5));
+    CHECK(map.size() == 0);
+
+    // The waiters of a failing creation get its exception.
+    std::atomic<bool> creating{false};
+    std::atomic<bool> release{false};
+
+    std::thread creator{[&]
+    {
+        try {
+            map.get_or_create(6, [&] () -> int
+            {
+                creating = true;
+
+                while (!release.load())
+                    std::this_thread::yield();
+
+                throw std::runtime_error{"compilation failed"};
+            });
+        }
+
+        catch (std::runtime_error const &) { }
+    }};
+
+    while (!creating.load())
+        std::this_thread::yield();
+
+    std::thread waiter{[&]
+    {
+        CHECK_THROWS(std::runtime_error, map.get_or_create(6, [] { return 0; }));
+    }};
+
+    // The waiter has found the pending creation once it counts as reused.
+    while (map.counters().reused == 0)
+        std::this_thread::yield();
+
+    release = true;
+
+    creator.join();
+    waiter.join();
+
+    // A later request creates it again, and the value sticks this time.
+    CHECK(map.get_or_create(5, [] { return 50; }) == 50);
+    CHECK(map.get_or_create(5, [] { return 51; }) == 50);
+
+    auto visited = 0;
+
+    map.for_each([&visited] (std::uint64_t key, int value)
+    {
+        CHECK(key == 5);
+        CHECK(value == 50);
+
+        ++visited;
+    });
+
+    CHECK(visited == 1);
+}
+
+TEST(every_field_of_a_description_changes_its_hash)
+{
+    auto const vertex_shader = to_bytes("vertex shader bytecode");
+    auto const pixel_shader = to_bytes("pixel shader bytecode");
+
+    std::array<D3D12_INPUT_ELEMENT_DESC, 2> elements{{
+        {"POSITION", 0, DXGI_FORMAT_R32G32B32A32_FLOAT, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+        {"TEXCOORD", 0, DXGI_FORMAT_R16G16B16A16_FLOAT, 0, 16, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0}
+    }};
+
+    std::array<D3D12_SO_DECLARATION_ENTRY, 1> stream_output_entries{{{0, "SV_POSITION", 0, 0, 4, 0}}};
+    std::array<UINT, 1> stream_output_strides{16};
+
+    D3D12_GRAPHICS_PIPELINE_STATE_DESC base{ };
+
+    base.VS = D3D12_SHADER_BYTECODE{std::data(vertex_shader), std::size(vertex_shader)};
+    base.PS = D3D12_SHADER_BYTECODE{std::data(pixel_shader), std::size(pixel_shader)};
+    base.StreamOutput = D3D12_STREAM_OUTPUT_DESC{std::data(stream_output_entries), 1, std::data(stream_output_strides), 1, 0};
+    base.BlendState.RenderTarget[0].RenderTargetWriteMask = 0xf;
+    base.SampleMask = ~0u;
+    base.RasterizerState.FillMode = D3D12_FILL_MODE_SOLID;
+    base.RasterizerState.CullMode = D3D12_CULL_MODE_BACK;
+    base.RasterizerState.DepthClipEnable = 1;
+    base.DepthStencilState.DepthEnable = 1;
+    base.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ALL;
+    base.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_GREATER_EQUAL;
+    base.InputLayout = D3D12_INPUT_LAYOUT_DESC{std::data(elements), static_cast<UINT>(std::size(elements))};
+    base.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE;
+    base.NumRenderTargets = 1;
+    base.RTVFormats[0] = DXGI_FORMAT_R8G8B8A8_UNORM;
+    base.DSVFormat = DXGI_FORMAT_D32_FLOAT;
+    base.SampleDesc = DXGI_SAMPLE_DESC{1, 0};
+
+    auto constexpr kROOT_SIGNATURE_HASH = 0x1234ull;
+
+    auto const base_hash = graphics::hash_pipeline_description(base, kROOT_SIGNATURE_HASH);
+
+    using mutation = std::function<void(D3D12_GRAPHICS_PIPELINE_STATE_DESC &)>;
+
+    // Pointed-to data is copied along, so that changing it doesn't change the base.
+    auto vertex_shader_copy = vertex_shader;
+    auto elements_copy = elements;
+    auto stream_output_entries_copy = stream_output_entries;
+    auto stream_output_strides_copy = stream_output_strides;
+
+    auto const mutations = std::vector<std::pair<std::string_view, mutation>>{
+        {"VS contents", [&] (auto &&d) { vertex_shader_copy[0] ^= std::byte{1}; d.VS.pShaderBytecode = std::data(vertex_shader_copy); }},
+        {"VS length", [] (auto &&d) { --d.VS.BytecodeLength; }},
+        {"PS", [] (auto &&d) { d.PS = { }; }},
+        {"DS", [&] (auto &&d) { d.DS = d.PS; }},
+        {"HS", [&] (auto &&d) { d.HS = d.PS; }},
+        {"GS", [&] (auto &&d) { d.GS = d.PS; }},
+        {"SO entry count", [] (auto &&d) { d.StreamOutput.NumEntries = 0; }},
+        {"SO stride count", [] (auto &&d) { d.StreamOutput.NumStrides = 0; }},
+        {"SO rasterized stream", [] (auto &&d) { d.StreamOutput.RasterizedStream = 1; }},
+        {"SO stream", [&] (auto &&d) { stream_output_entries_copy[0].Stream = 1; d.StreamOutput.pSODeclaration = std::data(stream_output_entries_copy); }},
+        {"SO semantic", [&] (auto &&d) { stream_output_entries_copy[0].SemanticName = "COLOR"; d.StreamOutput.pSODeclaration = std::data(stream_output_entries_copy); }},
+        {"SO semantic index", [&] (auto &&d) { stream_output_entries_copy[0].SemanticIndex = 1; d.StreamOutput.pSODeclaration = std::data(stream_output_entries_copy); }},
+        {"SO start component", [&] (auto &&d) { stream_output_entries_copy[0].StartComponent = 1; d.StreamOutput.pSODeclaration = std::data(stream_output_entries_copy); }},
+        {"SO component count", [&] (auto &&d) { stream_output_entries_copy[0].ComponentCount = 3; d.StreamOutput.pSODeclaration = std::data(stream_output_entries_copy); }},
+        {"SO output slot", [&] (auto &&d) { stream_output_entries_copy[0].OutputSlot = 1; d.StreamOutput.pSODeclaration = std::data(stream_output_entries_copy); }},
+        {"SO stride", [&] (auto &&d) { stream_output_strides_copy[0] = 32; d.StreamOutput.pBufferStrides = std::data(stream_output_strides_copy); }},
+        {"alpha to coverage", [] (auto &&d) { d.BlendState.AlphaToCoverageEnable = 1; }},
+        {"independent blend", [] (auto &&d) { d.BlendState.IndependentBlendEnable = 1; }},
+        {"blend enable", [] (auto &&d) { d.BlendState.RenderTarget[0].BlendEnable = 1; }},
+        {"logic op enable", [] (auto &&d) { d.BlendState.RenderTarget[0].LogicOpEnable = 1; }},
+        {"source blend", [] (auto &&d) { d.BlendState.RenderTarget[0].SrcBlend = D3D12_BLEND_SRC_ALPHA; }},
+        {"destination blend", [] (auto &&d) { d.BlendState.RenderTarget[0].DestBlend = D3D12_BLEND_INV_SRC_ALPHA; }},
+        {"blend op", [] (auto &&d) { d.BlendState.RenderTarget[0].BlendOp = D3D12_BLEND_OP_ADD; }},
+        {"source blend alpha", [] (auto &&d) { d.BlendState.RenderTarget[0].SrcBlendAlpha = D3D12_BLEND_ONE; }},
+        {"destination blend alpha", [] (auto &&d) { d.BlendState.RenderTarget[0].DestBlendAlpha = D3D12_BLEND_ZERO; }},
+        {"blend op alpha", [] (auto &&d) { d.BlendState.RenderTarget[0].BlendOpAlpha = D3D12_BLEND_OP_SUBTRACT; }},
+        {"logic op", [] (auto &&d) { d.BlendState.RenderTarget[0].LogicOp = D3D12_LOGIC_OP_NOOP; }},
+        {"write mask", [] (auto &&d) { d.BlendState.RenderTarget[0].RenderTargetWriteMask = 0x7; }},
+        {"last render target blend", [] (auto &&d) { d.BlendState.RenderTarget[7].BlendEnable = 1; }},
+        {"sample mask", [] (auto &&d) { d.SampleMask = 1; }},
+        {"fill mode", [] (auto &&d) { d.RasterizerState.FillMode = D3D12_FILL_MODE_WIREFRAME; }},
+        {"cull mode", [] (auto &&d) { d.RasterizerState.CullMode = D3D12_CULL_MODE_NONE; }},
+        {"front counter-clockwise", [] (auto &&d) { d.RasterizerState.FrontCounterClockwise = 1; }},
+        {"depth bias", [] (auto &&d) { d.RasterizerState.DepthBias = 1; }},
+        {"depth bias clamp", [] (auto &&d) { d.RasterizerState.DepthBiasClamp = .5f; }},
+        {"slope scaled depth bias", [] (auto &&d) { d.RasterizerState.SlopeScaledDepthBias = 2.f; }},
+        {"depth clip", [] (auto &&d) { d.RasterizerState.DepthClipEnable = 0; }},
+        {"multisample", [] (auto &&d) { d.RasterizerState.MultisampleEnable = 1; }},
+        {"antialiased lines", [] (auto &&d) { d.RasterizerState.AntialiasedLineEnable = 1; }},
+        {"forced sample count", [] (auto &&d) { d.RasterizerState.ForcedSampleCount = 4; }},
+        {"conservative raster", [] (auto &&d) { d.RasterizerState.ConservativeRaster = D3D12_CONSERVATIVE_RASTERIZATION_MODE_ON; }},
+        {"depth enable", [] (auto &&d) { d.DepthStencilState.DepthEnable = 0; }},
+        {"depth write mask", [] (auto &&d) { d.DepthStencilState.DepthWriteMask = D3D12_DEPTH_WRITE_MASK_ZERO; }},
+        {"depth function", [] (auto &&d) { d.DepthStencilState.DepthFunc = D3D12_COMPARISON_FUNC_LESS; }},
+        {"stencil enable", [] (auto &&d) { d.DepthStencilState.StencilEnable = 1; }},
+        {"stencil read mask", [] (auto &&d) { d.DepthStencilState.StencilReadMask = 0xff; }},
+        {"stencil write mask", [] (auto &&d) { d.DepthStencilState.StencilWriteMask = 0xff; }},
+        {"front stencil fail", [] (auto &&d) { d.DepthStencilState.FrontFace.StencilFailOp = D3D12_STENCIL_OP_KEEP; }},
+        {"front stencil depth fail", [] (auto &&d) { d.DepthStencilState.FrontFace.StencilDepthFailOp = D3D12_STENCIL_OP_KEEP; }},
+        {"front stencil pass", [] (auto &&d) { d.DepthStencilState.FrontFace.StencilPassOp = D3D12_STENCIL_OP_REPLACE; }},
+        {"front stencil function", [] (auto &&d) { d.DepthStencilState.FrontFace.StencilFunc = D3D12_COMPARISON_FUNC_ALWAYS; }},
+        {"back stencil fail", [] (auto &&d) { d.DepthStencilState.BackFace.StencilFailOp = D3D12_STENCIL_OP_KEEP; }},
+        {"back stencil depth fail", [] (auto &&d) { d.DepthStencilState.BackFace.StencilDepthFailOp = D3D12_STENCIL_OP_KEEP; }},
+        {"back stencil pass", [] (auto &&d) { d.DepthStencilState.BackFace.StencilPassOp = D3D12_STENCIL_OP_REPLACE; }},
+        {"back stencil function", [] (auto &&d) { d.DepthStencilState.BackFace.StencilFunc = D3D12_COMPARISON_FUNC_ALWAYS; }},
+        {"element count", [] (auto &&d) { d.InputLayout.NumElements = 1; }},
+        {"element semantic", [&] (auto &&d) { elements_copy[1].SemanticName = "NORMAL"; d.InputLayout.pInputElementDescs = std::data(elements_copy); }},
+        {"element semantic index", [&] (auto &&d) { elements_copy[1].SemanticIndex = 1; d.InputLayout.pInputElementDescs = std::data(elements_copy); }},
+        {"element format", [&] (auto &&d) { elements_copy[1].Format = DXGI_FORMAT_R32_UINT; d.InputLayout.pInputElementDescs = std::data(elements_copy); }},
+        {"element slot", [&] (auto &&d) { elements_copy[1].InputSlot = 1; d.InputLayout.pInputElementDescs = std::data(elements_copy); }},
+        {"element offset", [&] (auto &&d) { elements_copy[1].AlignedByteOffset = 32; d.InputLayout.pInputElementDescs = std::data(elements_copy); }},
+        {"element class", [&] (auto &&d) { elements_copy[1].InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA; d.InputLayout.pInputElementDescs = std::data(elements_copy); }},
+        {"element step rate", [&] (auto &&d) { elements_copy[1].InstanceDataStepRate = 1; d.InputLayout.pInputElementDescs = std::data(elements_copy); }},
+        {"strip cut value", [] (auto &&d) { d.IBStripCutValue = D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_0xFFFF; }},
+        {"topology type", [] (auto &&d) { d.PrimitiveTopologyType = D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE; }},
+        {"render target count", [] (auto &&d) { d.NumRenderTargets = 2; }},
+        {"first render target format", [] (auto &&d) { d.RTVFormats[0] = DXGI_FORMAT_R16G16B16A16_FLOAT; }},
+        {"last render target format", [] (auto &&d) { d.RTVFormats[7] = DXGI_FORMAT_R8G8B8A8_UNORM; }},
+        {"depth format", [] (auto &&d) { d.DSVFormat = DXGI_FORMAT_D24_UNORM_S8_UINT; }},
+        {"sample count", [] (auto &&d) { d.SampleDesc.Count = 4; }},
+        {"sample quality", [] (auto &&d) { d.SampleDesc.Quality = 1; }},
+        {"node mask", [] (auto &&d) { d.NodeMask = 1; }},
+        {"flags", [] (auto &&d) { d.Flags = D3D12_PIPELINE_STATE_FLAG_TOOL_DEBUG; }}
+    };
+
+    std::set<std::uint64_t> hashes{base_hash};
+
+    for (auto &&[name, mutate] : mutations) {
+        vertex_shader_copy = vertex_shader;
+        elements_copy = elements;
+        stream_output_entries_copy = stream_output_entries;
+        stream_output_strides_copy = stream_output_strides;
+
+        auto description = base;
+        mutate(description);
+
+        if (!hashes.insert(graphics::hash_pipeline_description(description, kROOT_SIGNATURE_HASH)).second)
+            std::cerr << "no hash change: " << name << '\n';
+    }
+
+    CHECK(std::size(hashes) == std::size(mutations) + 1);
+
+    CHECK(graphics::hash_pipeline_description(base, kROOT_SIGNATURE_HASH + 1) != base_hash);
+
+    // The pointers themselves, the root signature interface and the cached blob don't take part.
+    auto moved = base;
+
+    vertex_shader_copy = vertex_shader;
+    elements_copy = elements;
+
+    moved.VS.pShaderBytecode = std::data(vertex_shader_copy);
+    moved.InputLayout.pInputElementDescs = std::data(elements_copy);
+    moved.pRootSignature = reinterpret_cast<ID3D12RootSignature *>(0x1000);
+    moved.CachedPSO = D3D12_CACHED_PIPELINE_STATE{std::data(pixel_shader), std::size(pixel_shader)};
+
+    CHECK(graphics::hash_pipeline_description(moved, kROOT_SIGNATURE_HASH) == base_hash);
+
+    // Compute pipelines.
+    D3D12_COMPUTE_PIPELINE_STATE_DESC compute{ };
+    compute.CS = base.VS;
+
+    auto const compute_hash = graphics::hash_pipeline_description(compute, kROOT_SIGNATURE_HASH);
+
+    auto other_compute = compute;
+    other_compute.CS.BytecodeLength -= 1;
+
+    CHECK(graphics::hash_pipeline_description(other_compute, kROOT_SIGNATURE_HASH) != compute_hash);
+
+    other_compute = compute;
+    other_compute.NodeMask = 1;
+
+    CHECK(graphics::hash_pipeline_description(other_compute, kROOT_SIGNATURE_HASH) != compute_hash);
+
+    other_compute = compute;
+    other_compute.Flags = D3D12_PIPELINE_STATE_FLAG_TOOL_DEBUG;
+
+    CHECK(graphics::hash_pipeline_description(other_compute, kROOT_SIGNATURE_HASH) != compute_hash);
+    CHECK(graphics::hash_pipeline_description(compute, kROOT_SIGNATURE_HASH + 1) != compute_hash);
+}
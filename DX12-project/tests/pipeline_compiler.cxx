@@ -0,0 +1,302 @@
+#include <atomic>
+#include <chrono>
+#include <latch>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "test.hxx"
+
+#include "graphics/pipeline_compiler.hxx"
+
+
+namespace
+{
+    using namespace std::chrono_literals;
+
+    using compiler = graphics::basic_pipeline_compiler<int>;
+
+    // Stands in for the driver's compiler: takes 'latency' and returns 'value'.
+    std::function<int()> compile_in(std::chrono::milliseconds latency, int value)
+    {
+        return [latency, value]
+        {
+            std::this_thread::sleep_for(latency);
+            return value;
+        };
+    }
+
+    // Occupies the only worker of a compiler until released, so that the requests after it stay queued.
+    struct busy_worker final {
+        std::latch started{1};
+        std::latch released{1};
+
+        compiler::handle occupy(compiler &pipelines)
+        {
+            auto handle = pipelines.request([this]
+            {
+                started.count_down();
+                released.wait();
+
+                return 0;
+            });
+
+            started.wait();
+
+            return handle;
+        }
+    };
+
+    // Records the order in which the compile functions ran.
+    struct compile_log final {
+        std::mutex mutex;
+        std::vector<int> order;
+
+        std::function<int()> record(int value)
+        {
+            return [this, value]
+            {
+                std::lock_guard lock{mutex};
+                order.push_back(value);
+
+                return value;
+            };
+        }
+    };
+}
+
+TEST(pending_requests_become_ready)
+{
+    compiler pipelines{2};
+
+    auto const pipeline = pipelines.request(compile_in(20ms, 42));
+
+    CHECK(pipeline);
+    CHECK(pipeline.status() == graphics::pipeline_status::pending);
+    CHECK(pipeline.get() == nullptr);
+    CHECK(pipeline.error() == nullptr);
+
+    pipelines.wait_idle();
+
+    CHECK(pipeline.status() == graphics::pipeline_status::ready);
+    CHECK(pipeline.get() != nullptr && *pipeline.get() == 42);
+    CHECK(pipeline.current() == pipeline.get());
+    CHECK(pipeline.error() == nullptr);
+
+    auto const statistics = pipelines.statistics();
+
+    CHECK(statistics.requested == 1);
+    CHECK(statistics.compiled == 1);
+    CHECK(statistics.failed == 0);
+    CHECK(statistics.queued == 0);
+}
+
+TEST(failed_requests_carry_their_error)
+{
+    compiler pipelines{1};
+
+    auto const pipeline = pipelines.request([]() -> int
+    {
+        std::this_thread::sleep_for(5ms);
+        throw std::runtime_error{"invalid root signature"};
+    });
+
+    CHECK(pipeline.status() == graphics::pipeline_status::pending);
+    CHECK(pipeline.error() == nullptr);
+
+    pipelines.wait_idle();
+
+    CHECK(pipeline.status() == graphics::pipeline_status::failed);
+    CHECK(pipeline.get() == nullptr);
+    CHECK(pipeline.current() == nullptr);
+
+    CHECK(pipeline.error() != nullptr);
+    CHECK_THROWS(std::runtime_error, std::rethrow_exception(pipeline.error()));
+
+    CHECK(pipelines.statistics().failed == 1);
+    CHECK(pipelines.statistics().compiled == 0);
+
+    // The worker survives the failure.
+    auto const next = pipelines.request(compile_in(0ms, 7));
+    pipelines.wait_idle();
+
+    CHECK(next.get() != nullptr && *next.get() == 7);
+}
+
+TEST(draws_use_the_fallback_until_the_pipeline_is_ready)
+{
+    compiler pipelines{1};
+
+    busy_worker busy;
+    busy.occupy(pipelines);
+
+    auto const fallback = compiler::handle::make_ready(1);
+
+    CHECK(fallback.status() == graphics::pipeline_status::ready);
+
+    auto const with_fallback = pipelines.request(compile_in(0ms, 2), graphics::pipeline_priority::high, fallback);
+    auto const without_fallback = pipelines.request(compile_in(0ms, 3), graphics::pipeline_priority::high);
+    auto const failing = pipelines.request([]() -> int { throw std::runtime_error{"out of memory"}; }, graphics::pipeline_priority::high, fallback);
+
+    // Still queued behind the busy worker.
+    CHECK(with_fallback.get() == nullptr);
+    CHECK(with_fallback.current() == fallback.get());
+
+    // Nothing to draw with: the draw is skipped.
+    CHECK(without_fallback.current() == nullptr);
+
+    // A fallback that isn't ready yet doesn't help either.
+    auto const fallback_of_pending = pipelines.request(compile_in(0ms, 4), graphics::pipeline_priority::normal, without_fallback);
+
+    CHECK(fallback_of_pending.current() == nullptr);
+
+    busy.released.count_down();
+    pipelines.wait_idle();
+
+    CHECK(with_fallback.current() != nullptr && *with_fallback.current() == 2);
+    CHECK(without_fallback.current() != nullptr && *without_fallback.current() == 3);
+    CHECK(fallback_of_pending.current() != nullptr && *fallback_of_pending.current() == 4);
+
+    // A failed pipeline keeps drawing with its fallback.
+    CHECK(failing.status() == graphics::pipeline_status::failed);
+    CHECK(failing.current() == fallback.get());
+
+    // An empty handle has nothing to draw with.
+    compiler::handle empty;
+
+    CHECK(!empty);
+    CHECK(empty.status() == graphics::pipeline_status::failed);
+    CHECK(empty.current() == nullptr);
+    CHECK(empty.error() == nullptr);
+}
+
+TEST(workers_take_the_oldest_request_of_the_highest_priority)
+{
+    compiler pipelines{1};
+    compile_log log;
+
+    busy_worker busy;
+    busy.occupy(pipelines);
+
+    pipelines.request(log.record(0), graphics::pipeline_priority::low);
+    pipelines.request(log.record(1), graphics::pipeline_priority::normal);
+    pipelines.request(log.record(2), graphics::pipeline_priority::high);
+    pipelines.request(log.record(3), graphics::pipeline_priority::normal);
+    pipelines.request(log.record(4), graphics::pipeline_priority::low);
+    pipelines.request(log.record(5), graphics::pipeline_priority::high);
+
+    CHECK(pipelines.statistics().queued == 6);
+
+    busy.released.count_down();
+    pipelines.wait_idle();
+
+    CHECK((log.order == std::vector{2, 5, 1, 3, 0, 4}));
+}
+
+TEST(prioritize_moves_a_queued_request_up)
+{
+    compiler pipelines{1};
+    compile_log log;
+
+    busy_worker busy;
+    auto const running = busy.occupy(pipelines);
+
+    auto const first = pipelines.request(log.record(0), graphics::pipeline_priority::low);
+    auto const second = pipelines.request(log.record(1), graphics::pipeline_priority::low);
+    auto const third = pipelines.request(log.record(2), graphics::pipeline_priority::normal);
+    auto const fourth = pipelines.request(log.record(3), graphics::pipeline_priority::normal);
+
+    // A draw needs the second one now.
+    pipelines.prioritize(second, graphics::pipeline_priority::high);
+
+    // Moved behind the requests that already had the priority.
+    pipelines.prioritize(first, graphics::pipeline_priority::normal);
+
+    // Lowering is not a thing, and a request that is being compiled can't be moved.
+    pipelines.prioritize(fourth, graphics::pipeline_priority::low);
+    pipelines.prioritize(running, graphics::pipeline_priority::high);
+
+    CHECK(pipelines.statistics().queued == 4);
+
+    busy.released.count_down();
+    pipelines.wait_idle();
+
+    CHECK((log.order == std::vector{1, 2, 3, 0}));
+
+    // Nothing happens for requests that are done.
+    pipelines.prioritize(third, graphics::pipeline_priority::high);
+
+    CHECK(third.get() != nullptr && *third.get() == 2);
+}
+
+TEST(queued_requests_are_cancelled_when_the_compiler_goes_away)
+{
+    std::atomic<int> compiled{0};
+
+    compiler::handle running;
+    std::vector<compiler::handle> queued;
+
+    busy_worker busy;
+
+    // Lets the running request finish once the destructor has taken the queued ones.
+    std::thread releaser{[&busy]
+    {
+        std::this_thread::sleep_for(50ms);
+        busy.released.count_down();
+    }};
+
+    {
+        compiler pipelines{1};
+
+        running = busy.occupy(pipelines);
+
+        for (auto index = 0; index < 3; ++index) {
+            queued.push_back(pipelines.request([&compiled]
+            {
+                return ++compiled;
+            }));
+        }
+    }
+
+    releaser.join();
+
+    // The request that was being compiled finishes.
+    CHECK(running.status() == graphics::pipeline_status::ready);
+
+    CHECK(compiled.load() == 0);
+
+    // The handles outlive the compiler. Cancelled requests have failed, without an error.
+    for (auto &&pipeline : queued) {
+        CHECK(pipeline.status() == graphics::pipeline_status::failed);
+        CHECK(pipeline.error() == nullptr);
+        CHECK(pipeline.current() == nullptr);
+    }
+}
+
+TEST(wait_idle_returns_once_every_request_is_compiled)
+{
+    std::atomic<std::uint32_t> started_threads{0};
+
+    compiler pipelines{3, [&started_threads] { ++started_threads; }};
+
+    // Nothing to wait for.
+    pipelines.wait_idle();
+
+    std::vector<compiler::handle> handles;
+
+    for (auto index = 0; index < 30; ++index)
+        handles.push_back(pipelines.request(compile_in(1ms, index), static_cast<graphics::pipeline_priority>(index % 3)));
+
+    pipelines.wait_idle();
+
+    for (auto index = 0; index < 30; ++index)
+        CHECK(handles[index].get() != nullptr && *handles[index].get() == index);
+
+    auto const statistics = pipelines.statistics();
+
+    CHECK(statistics.requested == 30);
+    CHECK(statistics.compiled == 30);
+    CHECK(statistics.queued == 0);
+
+    CHECK(started_threads.load() == 3);
+}
@@ -0,0 +1,174 @@
+#include <atomic>
+#include <random>
+#include <thread>
+
+#include "test.hxx"
+
+#include "main.hxx"
+#include "graphics/queue.hxx"
+
+
+namespace
+{
+    auto constexpr kQUEUE_TYPES = std::array{graphics::queue_type::graphics, graphics::queue_type::compute, graphics::queue_type::copy};
+
+    // Queued work runs only when execute() is called.
+    struct stalled_gpu final {
+        stalled_gpu() { stand_in::gpu::instance().set_execute_on_wait(false); }
+        ~stalled_gpu() { stand_in::gpu::instance().set_execute_on_wait(true); }
+    };
+
+    bool drained(graphics::queue_scheduler const &scheduler)
+    {
+        return std::all_of(std::begin(kQUEUE_TYPES), std::end(kQUEUE_TYPES), [&scheduler] (auto type)
+        {
+            return scheduler.queue(type)->pending_operations() == 0;
+        });
+    }
+}
+
+TEST(random_dependency_graphs_drain_with_only_the_needed_waits)
+{
+    stalled_gpu stalled;
+
+    auto device = stand_in::create_device();
+
+    std::mt19937 generator{5};
+
+    for (auto round = 0; round < 20; ++round) {
+        graphics::queue_scheduler scheduler{device.get()};
+
+        // The largest value of each source queue that every target queue has been made to wait for.
+        std::array<std::array<UINT64, graphics::kQUEUE_TYPE_NUMBER>, graphics::kQUEUE_TYPE_NUMBER> waited{ };
+        std::array<std::vector<stand_in::queue_wait>, graphics::kQUEUE_TYPE_NUMBER> expected;
+
+        std::vector<graphics::queue_fence> submitted;
+
+        for (auto index = 0; index < 300; ++index) {
+            auto const target = static_cast<std::size_t>(generator() % graphics::kQUEUE_TYPE_NUMBER);
+
+            // Any of the earlier submissions, of any queue, in any order and with duplicates.
+            std::vector<graphics::queue_fence> dependencies;
+
+            for (auto count = submitted.empty() ? 0 : generator() % 4; count > 0; --count)
+                dependencies.push_back(submitted[generator() % std::size(submitted)]);
+
+            for (auto &&[queue, value] : dependencies) {
+                auto const source = static_cast<std::size_t>(queue);
+                auto &&timeline = scheduler.timeline(queue);
+
+                if (source == target || value <= waited[target][source] || value <= timeline.get()->GetCompletedValue())
+                    continue;
+
+                expected[target].push_back(stand_in::queue_wait{timeline.get(), value});
+                waited[target][source] = value;
+            }
+
+            submitted.push_back(scheduler.submit(kQUEUE_TYPES[target], { }, dependencies));
+
+            // Now and then the GPU catches up, which makes some of the later waits unnecessary.
+            if (generator() % 16 == 0) {
+                stand_in::gpu::instance().execute();
+
+                CHECK(drained(scheduler));
+            }
+        }
+
+        stand_in::gpu::instance().execute();
+
+        CHECK(drained(scheduler));
+
+        for (auto type : kQUEUE_TYPES) {
+            auto &&timeline = scheduler.timeline(type);
+
+            CHECK(timeline.is_complete(timeline.last_signaled_value()));
+
+            auto const issued = scheduler.queue(type)->issued_waits();
+            auto &&expected_waits = expected[static_cast<std::size_t>(type)];
+
+            CHECK(std::size(issued) == std::size(expected_waits));
+
+            CHECK(std::equal(std::begin(issued), std::end(issued), std::begin(expected_waits), std::end(expected_waits), [] (auto &&lhs, auto &&rhs)
+            {
+                return lhs.fence == rhs.fence && lhs.value == rhs.value;
+            }));
+        }
+    }
+}
+
+TEST(queues_fed_from_their_own_threads_never_deadlock)
+{
+    stand_in::gpu_thread gpu;
+
+    auto device = stand_in::create_device();
+    graphics::queue_scheduler scheduler{device.get()};
+
+    // The latest value each queue has signaled; the threads make their queues wait for random earlier ones.
+    std::array<std::atomic<UINT64>, graphics::kQUEUE_TYPE_NUMBER> latest{ };
+
+    std::vector<std::thread> threads;
+
+    for (auto type : kQUEUE_TYPES) {
+        threads.emplace_back([&scheduler, &latest, type]
+        {
+            std::mt19937 generator{static_cast<std::uint32_t>(type) + 1};
+
+            for (auto index = 0; index < 500; ++index) {
+                std::vector<graphics::queue_fence> dependencies;
+
+                for (auto source : kQUEUE_TYPES) {
+                    if (auto const value = latest[static_cast<std::size_t>(source)].load(); value != 0 && generator() % 2 == 0)
+                        dependencies.push_back(graphics::queue_fence{source, generator() % value + 1});
+                }
+
+                auto const fence = scheduler.submit(type, { }, dependencies);
+
+                latest[static_cast<std::size_t>(type)].store(fence.value);
+            }
+        });
+    }
+
+    for (auto &&thread : threads)
+        thread.join();
+
+    scheduler.flush();
+
+    for (auto type : kQUEUE_TYPES)
+        CHECK(scheduler.timeline(type).is_complete(500));
+
+    CHECK(drained(scheduler));
+}
+
+TEST(values_that_were_never_signaled_cant_be_waited_for)
+{
+    stalled_gpu stalled;
+
+    auto device = stand_in::create_device();
+    graphics::queue_scheduler scheduler{device.get()};
+
+    auto const fence = scheduler.signal(graphics::queue_type::compute);
+
+    auto const ahead = std::array{graphics::queue_fence{graphics::queue_type::compute, fence.value + 1}};
+
+    CHECK_THROWS(dx::fence_error, scheduler.wait(graphics::queue_type::graphics, ahead));
+    CHECK_THROWS(dx::fence_error, scheduler.submit(graphics::queue_type::copy, { }, ahead));
+
+    // Nothing reached the queues, so a wait that would never be satisfied can't stall them.
+    CHECK(scheduler.queue(graphics::queue_type::graphics)->issued_waits().empty());
+    CHECK(scheduler.queue(graphics::queue_type::copy)->issued_waits().empty());
+
+    // A queue's own values are skipped rather than waited for.
+    auto const own = std::array{graphics::queue_fence{graphics::queue_type::compute, fence.value}};
+    scheduler.wait(graphics::queue_type::compute, own);
+
+    CHECK(scheduler.queue(graphics::queue_type::compute)->issued_waits().empty());
+
+    auto const signaled = std::array{fence};
+    scheduler.wait(graphics::queue_type::graphics, signaled);
+
+    CHECK(std::size(scheduler.queue(graphics::queue_type::graphics)->issued_waits()) == 1);
+
+    stand_in::gpu::instance().execute();
+
+    CHECK(drained(scheduler));
+}
@@ -0,0 +1,435 @@
+#include <random>
+
+#include "test.hxx"
+
+#include "graphics/render_graph.hxx"
+
+
+namespace
+{
+    using graphics::queue_type;
+    using graphics::resource_access;
+
+    std::uint32_t position_of(graphics::compiled_render_graph const &compiled, std::uint32_t pass)
+    {
+        auto const it = std::find(std::begin(compiled.order), std::end(compiled.order), pass);
+
+        return it == std::end(compiled.order) ? graphics::kINVALID_RENDER_GRAPH_INDEX : static_cast<std::uint32_t>(it - std::begin(compiled.order));
+    }
+
+    bool is_write(resource_access access)
+    {
+        return (access & graphics::kWRITE_RESOURCE_ACCESS) != resource_access::undefined;
+    }
+
+    // Every pass uses a few of the resources, on a random queue; some write imported resources or have side effects.
+    void build_random_graph(graphics::render_graph &graph, std::mt19937 &generator, std::uint32_t pass_number, std::uint32_t resource_number)
+    {
+        graph.clear();
+
+        for (auto index = 0u; index < resource_number; ++index) {
+            if (index % 8 == 0)
+                graph.import_resource("imported", resource_access::shader_read, resource_access::shader_read);
+
+            else graph.create_resource("transient");
+        }
+
+        for (auto index = 0u; index < pass_number; ++index) {
+            auto const pass = graph.add_pass("pass", static_cast<queue_type>(generator() % 3));
+
+            for (auto use = generator() % 4 + 1; use > 0; --use) {
+                auto const resource = static_cast<std::uint32_t>(generator() % resource_number);
+
+                switch (generator() % 4) {
+                    case 0: graph.write(pass, resource, resource_access::unordered_access); break;
+                    case 1: graph.write(pass, resource, resource_access::render_target); break;
+                    default: graph.read(pass, resource, resource_access::shader_read); break;
+                }
+            }
+
+            if (generator() % 16 == 0)
+                graph.set_side_effects(pass);
+        }
+    }
+}
+
+TEST(passes_that_contribute_nothing_are_culled)
+{
+    graphics::render_graph graph;
+    graphics::render_graph_compiler compiler;
+
+    auto const back_buffer = graph.import_resource("back buffer", resource_access::present, resource_access::present);
+    auto const gbuffer = graph.create_resource("gbuffer");
+    auto const debug = graph.create_resource("debug");
+    auto const readback = graph.create_resource("readback");
+
+    auto const geometry = graph.add_pass("geometry", queue_type::graphics);
+    graph.write(geometry, gbuffer, resource_access::render_target);
+
+    // Writes a target that nothing reads.
+    auto const debug_view = graph.add_pass("debug view", queue_type::graphics);
+    graph.read(debug_view, gbuffer, resource_access::shader_read);
+    graph.write(debug_view, debug, resource_access::render_target);
+
+    auto const lighting = graph.add_pass("lighting", queue_type::graphics);
+    graph.read(lighting, gbuffer, resource_access::shader_read);
+    graph.write(lighting, back_buffer, resource_access::render_target);
+
+    // Nothing reads what it writes either, but the side effect keeps it.
+    auto const statistics = graph.add_pass("statistics", queue_type::compute);
+    graph.read(statistics, gbuffer, resource_access::shader_read);
+    graph.write(statistics, readback, resource_access::unordered_access);
+    graph.set_side_effects(statistics);
+
+    auto &&compiled = compiler.compile(graph);
+
+    CHECK(compiled.culled_pass_count == 1);
+    CHECK(std::size(compiled.order) == 3);
+
+    CHECK(position_of(compiled, debug_view) == graphics::kINVALID_RENDER_GRAPH_INDEX);
+    CHECK(position_of(compiled, geometry) == 0);
+    CHECK(position_of(compiled, lighting) != graphics::kINVALID_RENDER_GRAPH_INDEX);
+    CHECK(position_of(compiled, statistics) != graphics::kINVALID_RENDER_GRAPH_INDEX);
+
+    // A culled pass doesn't keep the transient it writes alive.
+    CHECK(compiled.lifetimes[debug] == graphics::render_graph_lifetime{});
+}
+
+TEST(culling_follows_data_through_the_chain)
+{
+    graphics::render_graph graph;
+    graphics::render_graph_compiler compiler;
+
+    auto const output = graph.import_resource("output", resource_access::undefined, resource_access::shader_read);
+    auto const first = graph.create_resource("first");
+    auto const second = graph.create_resource("second");
+
+    auto const a = graph.add_pass("a", queue_type::compute);
+    graph.write(a, first, resource_access::unordered_access);
+
+    auto const b = graph.add_pass("b", queue_type::compute);
+    graph.read(b, first, resource_access::shader_read);
+    graph.write(b, second, resource_access::unordered_access);
+
+    auto const c = graph.add_pass("c", queue_type::graphics);
+    graph.read(c, second, resource_access::shader_read);
+    graph.write(c, output, resource_access::render_target);
+
+    CHECK(compiler.compile(graph).culled_pass_count == 0);
+
+    // Without the write of the imported output the whole chain goes.
+    graph.clear();
+
+    graph.import_resource("output", resource_access::undefined, resource_access::shader_read);
+    graph.create_resource("first");
+    graph.create_resource("second");
+
+    graph.write(graph.add_pass("a", queue_type::compute), first, resource_access::unordered_access);
+
+    auto const reader = graph.add_pass("b", queue_type::compute);
+    graph.read(reader, first, resource_access::shader_read);
+    graph.write(reader, second, resource_access::unordered_access);
+
+    graph.read(graph.add_pass("c", queue_type::graphics), second, resource_access::shader_read);
+
+    auto &&compiled = compiler.compile(graph);
+
+    CHECK(compiled.culled_pass_count == 3);
+    CHECK(compiled.order.empty());
+}
+
+TEST(reads_follow_the_write_they_read)
+{
+    graphics::render_graph graph;
+    graphics::render_graph_compiler compiler;
+
+    auto const output = graph.import_resource("output", resource_access::present, resource_access::present);
+    auto const shadow = graph.create_resource("shadow");
+
+    // Declared before the pass that writes the shadow, so its read comes first whatever order the uses are added in.
+    auto const main = graph.add_pass("main", queue_type::graphics);
+
+    auto const shadows = graph.add_pass("shadows", queue_type::compute);
+    graph.write(shadows, shadow, resource_access::unordered_access);
+
+    graph.read(main, shadow, resource_access::shader_read);
+    graph.write(main, output, resource_access::render_target);
+
+    auto &&compiled = compiler.compile(graph);
+
+    // The shadow pass only overwrites what the main pass read, which doesn't keep it.
+    CHECK(std::size(compiled.order) == 1);
+    CHECK(position_of(compiled, main) == 0);
+    CHECK(position_of(compiled, shadows) == graphics::kINVALID_RENDER_GRAPH_INDEX);
+
+    graph.clear();
+
+    graph.import_resource("output", resource_access::present, resource_access::present);
+    graph.create_resource("shadow");
+
+    auto const writer = graph.add_pass("shadows", queue_type::compute);
+    graph.write(writer, shadow, resource_access::unordered_access);
+
+    auto const reader = graph.add_pass("main", queue_type::graphics);
+    graph.read(reader, shadow, resource_access::shader_read);
+    graph.write(reader, output, resource_access::render_target);
+
+    auto &&recompiled = compiler.compile(graph);
+
+    CHECK(std::size(recompiled.order) == 2);
+    CHECK(position_of(recompiled, writer) < position_of(recompiled, reader));
+
+    // The transition from the write to the read is recorded before the reading pass.
+    auto const barriers = recompiled.barriers_before(position_of(recompiled, reader));
+
+    CHECK(std::any_of(std::begin(barriers), std::end(barriers), [shadow] (auto &&barrier)
+    {
+        return barrier.resource == shadow && barrier.before == resource_access::unordered_access && barrier.after == resource_access::shader_read;
+    }));
+}
+
+TEST(writes_wait_for_earlier_reads_and_writes)
+{
+    graphics::render_graph graph;
+    graphics::render_graph_compiler compiler;
+
+    auto const history = graph.import_resource("history", resource_access::shader_read, resource_access::shader_read);
+    auto const output = graph.import_resource("output", resource_access::present, resource_access::present);
+    auto const counters = graph.import_resource("counters", resource_access::unordered_access, resource_access::unordered_access);
+
+    auto const independent = graph.add_pass("independent", queue_type::graphics);
+    graph.write(independent, output, resource_access::render_target);
+
+    // Reads the history on the compute queue before the graphics pass below overwrites it. Without the write after
+    // read edge the compiler would stay on the graphics queue and run the overwrite first.
+    auto const reader = graph.add_pass("reader", queue_type::compute);
+    graph.read(reader, history, resource_access::shader_read);
+    graph.write(reader, counters, resource_access::unordered_access);
+
+    auto const overwrite = graph.add_pass("overwrite", queue_type::graphics);
+    graph.write(overwrite, history, resource_access::render_target);
+
+    // A second write of the counters, which needs an unordered access barrier after the first.
+    auto const second_writer = graph.add_pass("second writer", queue_type::graphics);
+    graph.write(second_writer, counters, resource_access::unordered_access);
+
+    auto &&compiled = compiler.compile(graph);
+
+    CHECK(compiled.culled_pass_count == 0);
+
+    CHECK(position_of(compiled, independent) == 0);
+    CHECK(position_of(compiled, reader) < position_of(compiled, overwrite));
+    CHECK(position_of(compiled, reader) < position_of(compiled, second_writer));
+
+    auto const barriers = compiled.barriers_before(position_of(compiled, second_writer));
+
+    CHECK(std::size(barriers) == 1);
+    CHECK(barriers[0].resource == counters);
+    CHECK(barriers[0].before == resource_access::unordered_access && barriers[0].after == resource_access::unordered_access);
+
+    // The history and the output end up in their final accesses again, the counters already are in theirs.
+    auto const final_barriers = compiled.final_barriers();
+
+    CHECK(std::size(final_barriers) == 2);
+    CHECK(final_barriers[0].resource == history);
+    CHECK(final_barriers[0].before == resource_access::render_target && final_barriers[0].after == resource_access::shader_read);
+    CHECK(final_barriers[1].resource == output && final_barriers[1].after == resource_access::present);
+}
+
+TEST(randomized_graphs_keep_every_conflicting_pair_in_declaration_order)
+{
+    std::mt19937 generator{7};
+
+    graphics::render_graph graph;
+    graphics::render_graph_compiler compiler;
+
+    for (auto round = 0; round < 200; ++round) {
+        build_random_graph(graph, generator, 40, 12);
+
+        auto &&compiled = compiler.compile(graph);
+        auto const passes = graph.passes();
+
+        CHECK(std::size(compiled.order) + compiled.culled_pass_count == std::size(passes));
+
+        for (auto lhs = 0u; lhs < std::size(passes); ++lhs) {
+            for (auto rhs = lhs + 1; rhs < std::size(passes); ++rhs) {
+                auto const lhs_position = position_of(compiled, lhs);
+                auto const rhs_position = position_of(compiled, rhs);
+
+                if (lhs_position == graphics::kINVALID_RENDER_GRAPH_INDEX || rhs_position == graphics::kINVALID_RENDER_GRAPH_INDEX)
+                    continue;
+
+                auto const conflict = std::any_of(std::begin(passes[lhs].uses), std::end(passes[lhs].uses), [&] (auto &&lhs_use)
+                {
+                    return std::any_of(std::begin(passes[rhs].uses), std::end(passes[rhs].uses), [&] (auto &&rhs_use)
+                    {
+                        return lhs_use.resource == rhs_use.resource && (is_write(lhs_use.access) || is_write(rhs_use.access));
+                    });
+                });
+
+                if (conflict)
+                    CHECK(lhs_position < rhs_position);
+            }
+        }
+    }
+}
+
+TEST(the_same_topology_is_compiled_once)
+{
+    graphics::render_graph graph;
+    graphics::render_graph_compiler compiler;
+
+    auto const build = [&graph] (std::string_view name, resource_access read_access)
+    {
+        graph.clear();
+
+        auto const output = graph.import_resource("output", resource_access::present, resource_access::present);
+        auto const target = graph.create_resource(name);
+
+        auto const producer = graph.add_pass("producer", queue_type::graphics);
+        graph.write(producer, target, resource_access::render_target);
+
+        auto const consumer = graph.add_pass("consumer", queue_type::graphics, [] { });
+        graph.read(consumer, target, read_access);
+        graph.write(consumer, output, resource_access::render_target);
+    };
+
+    build("target", resource_access::shader_read);
+
+    auto const *const compiled = &compiler.compile(graph);
+
+    CHECK(compiler.compilation_count() == 1);
+
+    // Rebuilt every frame with the same topology, under other names and with other callbacks: a cache hit.
+    for (auto frame = 0; frame < 10; ++frame) {
+        build(frame % 2 == 0 ? "renamed" : "target", resource_access::shader_read);
+
+        CHECK(&compiler.compile(graph) == compiled);
+    }
+
+    CHECK(compiler.compilation_count() == 1);
+
+    // A different access changes the key.
+    build("target", resource_access::shader_read | resource_access::copy_source);
+
+    auto &&recompiled = compiler.compile(graph);
+
+    CHECK(compiler.compilation_count() == 2);
+    CHECK(recompiled.barriers_before(1)[0].after == (resource_access::shader_read | resource_access::copy_source));
+
+    // Going back to the first topology compiles it again, only the last one is cached.
+    build("target", resource_access::shader_read);
+    compiler.compile(graph);
+
+    CHECK(compiler.compilation_count() == 3);
+
+    // So do side effects, which don't change any use.
+    graph.set_side_effects(0);
+    compiler.compile(graph);
+
+    CHECK(compiler.compilation_count() == 4);
+}
+
+TEST(transient_lifetimes_span_their_first_and_last_use)
+{
+    graphics::render_graph graph;
+    graphics::render_graph_compiler compiler;
+
+    auto const output = graph.import_resource("output", resource_access::present, resource_access::present);
+    auto const gbuffer = graph.create_resource("gbuffer");
+    auto const lighting = graph.create_resource("lighting");
+    auto const bloom = graph.create_resource("bloom");
+
+    auto const geometry_pass = graph.add_pass("geometry", queue_type::graphics);
+    graph.write(geometry_pass, gbuffer, resource_access::render_target);
+
+    auto const lighting_pass = graph.add_pass("lighting", queue_type::graphics);
+    graph.read(lighting_pass, gbuffer, resource_access::shader_read);
+    graph.write(lighting_pass, lighting, resource_access::render_target);
+
+    auto const bloom_pass = graph.add_pass("bloom", queue_type::graphics);
+    graph.read(bloom_pass, lighting, resource_access::shader_read);
+    graph.write(bloom_pass, bloom, resource_access::render_target);
+
+    auto const composite_pass = graph.add_pass("composite", queue_type::graphics);
+    graph.read(composite_pass, lighting, resource_access::shader_read);
+    graph.read(composite_pass, bloom, resource_access::shader_read);
+    graph.write(composite_pass, output, resource_access::render_target);
+
+    auto &&compiled = compiler.compile(graph);
+
+    CHECK((compiled.order == std::vector<std::uint32_t>{geometry_pass, lighting_pass, bloom_pass, composite_pass}));
+
+    CHECK((compiled.lifetimes[gbuffer] == graphics::render_graph_lifetime{0, 1}));
+    CHECK((compiled.lifetimes[lighting] == graphics::render_graph_lifetime{1, 3}));
+    CHECK((compiled.lifetimes[bloom] == graphics::render_graph_lifetime{2, 3}));
+
+    // Imported resources live outside of the graph.
+    CHECK(compiled.lifetimes[output] == graphics::render_graph_lifetime{});
+
+    // A transient starts out undefined, so its first use gets a barrier out of it.
+    auto const barriers = compiled.barriers_before(0);
+
+    CHECK(std::size(barriers) == 1);
+    CHECK(barriers[0].resource == gbuffer && barriers[0].before == resource_access::undefined);
+}
+
+TEST(batches_wait_for_the_batches_of_other_queues_they_depend_on)
+{
+    graphics::render_graph graph;
+    graphics::render_graph_compiler compiler;
+
+    auto const output = graph.import_resource("output", resource_access::present, resource_access::present);
+    auto const instances = graph.create_resource("instances");
+    auto const commands = graph.create_resource("commands");
+    auto const depth = graph.create_resource("depth");
+
+    auto const upload = graph.add_pass("upload", queue_type::copy);
+    graph.write(upload, instances, resource_access::copy_dest);
+
+    auto const prepass = graph.add_pass("depth prepass", queue_type::graphics);
+    graph.write(prepass, depth, resource_access::depth_write);
+
+    auto const culling = graph.add_pass("culling", queue_type::compute);
+    graph.read(culling, instances, resource_access::shader_read);
+    graph.read(culling, depth, resource_access::shader_read);
+    graph.write(culling, commands, resource_access::unordered_access);
+
+    auto const main = graph.add_pass("main", queue_type::graphics);
+    graph.read(main, commands, resource_access::indirect_argument);
+    graph.read(main, instances, resource_access::shader_read);
+    graph.write(main, output, resource_access::render_target);
+
+    auto &&compiled = compiler.compile(graph);
+
+    // The compiler starts on the graphics queue.
+    CHECK((compiled.order == std::vector<std::uint32_t>{prepass, upload, culling, main}));
+
+    auto constexpr kNONE = graphics::kINVALID_RENDER_GRAPH_INDEX;
+    auto constexpr kGRAPHICS = static_cast<std::size_t>(queue_type::graphics);
+    auto constexpr kCOMPUTE = static_cast<std::size_t>(queue_type::compute);
+    auto constexpr kCOPY = static_cast<std::size_t>(queue_type::copy);
+
+    auto &&batches = compiled.batches;
+
+    CHECK(std::size(batches) == 4);
+
+    CHECK(batches[0].queue == queue_type::graphics && batches[0].first == 0 && batches[0].last == 1);
+    CHECK(batches[1].queue == queue_type::copy);
+    CHECK(batches[2].queue == queue_type::compute);
+    CHECK(batches[3].queue == queue_type::graphics && batches[3].first == 3 && batches[3].last == 4);
+
+    CHECK(std::all_of(std::begin(batches[0].waits), std::end(batches[0].waits), [] (auto wait) { return wait == kNONE; }));
+    CHECK(std::all_of(std::begin(batches[1].waits), std::end(batches[1].waits), [] (auto wait) { return wait == kNONE; }));
+
+    // Culling waits for the upload and the depth prepass.
+    CHECK(batches[2].waits[kCOPY] == 1);
+    CHECK(batches[2].waits[kGRAPHICS] == 0);
+    CHECK(batches[2].waits[kCOMPUTE] == kNONE);
+
+    // The main pass reads the instances too, so it waits for the copy queue as well as for the culling; it never
+    // waits for its own queue.
+    CHECK(batches[3].waits[kCOMPUTE] == 2);
+    CHECK(batches[3].waits[kCOPY] == 1);
+    CHECK(batches[3].waits[kGRAPHICS] == kNONE);
+}
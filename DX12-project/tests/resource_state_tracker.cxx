@@ -0,0 +1,292 @@
+#include "test.hxx"
+
+#include "main.hxx"
+#include "graphics/resource_state.hxx"
+
+
+namespace
+{
+    struct recording_list final {
+        winrt::com_ptr<ID3D12CommandAllocator> allocator;
+        winrt::com_ptr<ID3D12GraphicsCommandList> command_list;
+
+        recording_list()
+        {
+            allocator.attach(new ID3D12CommandAllocator{D3D12_COMMAND_LIST_TYPE_DIRECT});
+            command_list.attach(new ID3D12GraphicsCommandList{D3D12_COMMAND_LIST_TYPE_DIRECT, allocator.get()});
+        }
+
+        ID3D12GraphicsCommandList *operator-> () const noexcept { return command_list.get(); }
+        ID3D12GraphicsCommandList *get() const noexcept { return command_list.get(); }
+
+        stand_in::recording const &recorded() const noexcept { return command_list->recorded(); }
+    };
+
+    winrt::com_ptr<ID3D12Resource> create_texture(UINT16 mip_levels = 1)
+    {
+        winrt::com_ptr<ID3D12Resource> resource;
+        resource.attach(new ID3D12Resource{CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 1024, 1024, 1, mip_levels), D3D12_HEAP_TYPE_DEFAULT});
+
+        return resource;
+    }
+
+    winrt::com_ptr<ID3D12Resource> create_buffer()
+    {
+        winrt::com_ptr<ID3D12Resource> resource;
+        resource.attach(new ID3D12Resource{CD3DX12_RESOURCE_DESC::Buffer(65536), D3D12_HEAP_TYPE_DEFAULT});
+
+        return resource;
+    }
+
+    bool is_transition(D3D12_RESOURCE_BARRIER const &barrier, ID3D12Resource *const resource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after,
+                       UINT subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES)
+    {
+        return barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_TRANSITION && barrier.Transition.pResource == resource &&
+               barrier.Transition.StateBefore == before && barrier.Transition.StateAfter == after && barrier.Transition.Subresource == subresource;
+    }
+}
+
+// The frame draw() records: the back buffer goes to a render target and back to present, the depth buffer stays put.
+TEST(forward_frame)
+{
+    graphics::resource_state_registry registry;
+
+    auto const back_buffer = create_texture();
+    auto const depth_buffer = create_texture();
+
+    registry.register_resource(back_buffer.get(), 1, D3D12_RESOURCE_STATE_PRESENT);
+    registry.register_resource(depth_buffer.get(), 1, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+
+    recording_list command_list;
+    graphics::resource_state_tracker tracker{registry};
+
+    tracker.transition(back_buffer.get(), D3D12_RESOURCE_STATE_RENDER_TARGET);
+    tracker.transition(depth_buffer.get(), D3D12_RESOURCE_STATE_DEPTH_WRITE);
+    tracker.flush(command_list.get());
+
+    command_list->DrawIndexedInstanced(3, 1, 0, 0, 0);
+
+    tracker.transition(back_buffer.get(), D3D12_RESOURCE_STATE_PRESENT);
+    tracker.flush(command_list.get());
+
+    // First uses aren't known while recording, so only the transition back to present is in the list.
+    CHECK(command_list.recorded().barrier_calls == 1);
+    CHECK(std::size(command_list.recorded().barriers) == 1);
+    CHECK(is_transition(command_list.recorded().barriers.front(), back_buffer.get(), D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT));
+
+    auto const barriers = tracker.resolve();
+
+    CHECK(std::size(barriers) == 1);
+    CHECK(is_transition(barriers.front(), back_buffer.get(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET));
+
+    CHECK(registry.state(back_buffer.get()) == D3D12_RESOURCE_STATE_PRESENT);
+    CHECK(registry.state(depth_buffer.get()) == D3D12_RESOURCE_STATE_DEPTH_WRITE);
+}
+
+// A deferred frame: G-buffer, lighting and post-processing, each pass flushing once before it records.
+TEST(deferred_frame_flushes_once_per_pass)
+{
+    graphics::resource_state_registry registry;
+
+    auto const back_buffer = create_texture();
+    auto const depth_buffer = create_texture();
+    auto const albedo = create_texture();
+    auto const normals = create_texture();
+    auto const lit = create_texture();
+    auto const instances = create_buffer();
+
+    registry.register_resource(back_buffer.get(), 1, D3D12_RESOURCE_STATE_PRESENT);
+    registry.register_resource(depth_buffer.get(), 1, D3D12_RESOURCE_STATE_DEPTH_WRITE);
+    registry.register_resource(albedo.get(), 1, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    registry.register_resource(normals.get(), 1, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    registry.register_resource(lit.get(), 1, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    registry.register_resource(instances.get(), 1, D3D12_RESOURCE_STATE_COPY_DEST);
+
+    auto const record_frame = [&] (recording_list &command_list, graphics::resource_state_tracker &tracker)
+    {
+        // G-buffer pass.
+        tracker.transition(instances.get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+        tracker.transition(albedo.get(), D3D12_RESOURCE_STATE_RENDER_TARGET);
+        tracker.transition(normals.get(), D3D12_RESOURCE_STATE_RENDER_TARGET);
+        tracker.transition(depth_buffer.get(), D3D12_RESOURCE_STATE_DEPTH_WRITE);
+        tracker.flush(command_list.get());
+        command_list->DrawIndexedInstanced(3, 1, 0, 0, 0);
+
+        // Lighting pass.
+        tracker.transition(albedo.get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        tracker.transition(normals.get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        tracker.transition(depth_buffer.get(), D3D12_RESOURCE_STATE_DEPTH_READ | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        tracker.transition(lit.get(), D3D12_RESOURCE_STATE_RENDER_TARGET);
+        tracker.flush(command_list.get());
+        command_list->DrawIndexedInstanced(3, 1, 0, 0, 0);
+
+        // Post-processing: the depth buffer is read again, which its combined read state already covers.
+        tracker.transition(lit.get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        tracker.transition(depth_buffer.get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        tracker.transition(back_buffer.get(), D3D12_RESOURCE_STATE_RENDER_TARGET);
+        tracker.flush(command_list.get());
+        command_list->DrawIndexedInstanced(3, 1, 0, 0, 0);
+
+        tracker.transition(back_buffer.get(), D3D12_RESOURCE_STATE_PRESENT);
+        tracker.transition(instances.get(), D3D12_RESOURCE_STATE_COPY_DEST);
+        tracker.flush(command_list.get());
+    };
+
+    {
+        recording_list command_list;
+        graphics::resource_state_tracker tracker{registry};
+
+        record_frame(command_list, tracker);
+
+        // Lighting: albedo, normals, depth. Post-processing: lit. End of frame: back buffer, instances.
+        // The lighting target and the back buffer are first used by those passes, so they aren't in the list.
+        CHECK(command_list.recorded().barrier_calls == 3);
+        CHECK(std::size(command_list.recorded().barriers) == 6);
+
+        // Everything but the depth buffer starts in another state than the one of its first use.
+        auto const barriers = tracker.resolve();
+
+        CHECK(std::size(barriers) == 5);
+    }
+
+    // The second frame starts from the states the first one left behind.
+    {
+        recording_list command_list;
+        graphics::resource_state_tracker tracker{registry};
+
+        record_frame(command_list, tracker);
+
+        CHECK(std::size(command_list.recorded().barriers) == 6);
+
+        auto const barriers = tracker.resolve();
+
+        // The depth buffer was left in a read state.
+        CHECK(std::size(barriers) == 6);
+        CHECK(std::any_of(std::begin(barriers), std::end(barriers), [&] (auto &&barrier)
+        {
+            return is_transition(barrier, depth_buffer.get(), D3D12_RESOURCE_STATE_DEPTH_READ | D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE,
+                                 D3D12_RESOURCE_STATE_DEPTH_WRITE);
+        }));
+    }
+}
+
+TEST(pending_transitions_merge)
+{
+    graphics::resource_state_registry registry;
+
+    auto const texture = create_texture();
+    auto const buffer = create_buffer();
+
+    registry.register_resource(texture.get(), 1, D3D12_RESOURCE_STATE_COMMON);
+    registry.register_resource(buffer.get(), 1, D3D12_RESOURCE_STATE_COMMON);
+
+    recording_list command_list;
+    graphics::resource_state_tracker tracker{registry};
+
+    tracker.transition(texture.get(), D3D12_RESOURCE_STATE_COPY_DEST);
+    tracker.transition(buffer.get(), D3D12_RESOURCE_STATE_COPY_DEST);
+    tracker.flush(command_list.get());
+
+    // A->B->C collapses into A->C.
+    tracker.transition(texture.get(), D3D12_RESOURCE_STATE_RENDER_TARGET);
+    tracker.transition(texture.get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+    // A->B->A cancels out.
+    tracker.transition(buffer.get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    tracker.transition(buffer.get(), D3D12_RESOURCE_STATE_COPY_DEST);
+
+    CHECK(tracker.pending_barrier_number() == 1);
+
+    tracker.flush(command_list.get());
+
+    CHECK(command_list.recorded().barrier_calls == 1);
+    CHECK(is_transition(command_list.recorded().barriers.front(), texture.get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+
+    // A UAV barrier in between keeps the transitions apart.
+    tracker.transition(buffer.get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS);
+    tracker.uav_barrier(buffer.get());
+    tracker.transition(buffer.get(), D3D12_RESOURCE_STATE_COPY_SOURCE);
+
+    CHECK(tracker.pending_barrier_number() == 3);
+
+    // An empty flush doesn't record a call.
+    tracker.flush(command_list.get());
+    tracker.flush(command_list.get());
+
+    CHECK(command_list.recorded().barrier_calls == 2);
+}
+
+TEST(subresource_states)
+{
+    graphics::resource_state_registry registry;
+
+    auto const texture = create_texture(4);
+
+    registry.register_resource(texture.get(), 4, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+
+    // Mip generation: each level is written after the previous one is read.
+    {
+        recording_list command_list;
+        graphics::resource_state_tracker tracker{registry};
+
+        tracker.transition(texture.get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, 0);
+
+        for (auto level = 1u; level < 4; ++level) {
+            tracker.transition(texture.get(), D3D12_RESOURCE_STATE_UNORDERED_ACCESS, level);
+            tracker.flush(command_list.get());
+
+            command_list->Dispatch(1, 1, 1);
+
+            tracker.transition(texture.get(), D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, level);
+        }
+
+        tracker.flush(command_list.get());
+
+        // Only the UAV to SRV transitions of levels 1 and 2 are recorded before the next dispatch, level 3 at the end.
+        CHECK(std::size(command_list.recorded().barriers) == 3);
+
+        auto const barriers = tracker.resolve();
+
+        // Every level starts as a pixel shader resource.
+        CHECK(std::size(barriers) == 4);
+        CHECK(is_transition(barriers.front(), texture.get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE, 0));
+
+        // All levels ended in the same state, which collapses back into a single one.
+        CHECK(registry.state(texture.get()) == D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE);
+    }
+
+    // A whole-resource use after a subresource use is resolved per level.
+    {
+        recording_list command_list;
+        graphics::resource_state_tracker tracker{registry};
+
+        tracker.transition(texture.get(), D3D12_RESOURCE_STATE_COPY_DEST, 2);
+        tracker.transition(texture.get(), D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+        tracker.flush(command_list.get());
+
+        // Only level 2 has a known state within the list; the other three are first used by the whole-resource use.
+        CHECK(std::size(command_list.recorded().barriers) == 1);
+        CHECK(is_transition(command_list.recorded().barriers.front(), texture.get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, 2));
+
+        CHECK(std::size(tracker.resolve()) == 4);
+        CHECK(registry.state(texture.get()) == D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+    }
+}
+
+TEST(unregistered_resources_throw)
+{
+    graphics::resource_state_registry registry;
+
+    auto const texture = create_texture(2);
+
+    graphics::resource_state_tracker tracker{registry};
+    tracker.transition(texture.get(), D3D12_RESOURCE_STATE_COPY_DEST);
+
+    CHECK_THROWS(dx::resource_state_error, tracker.resolve());
+
+    graphics::resource_state_tracker standalone;
+
+    CHECK_THROWS(dx::resource_state_error, standalone.transition(texture.get(), D3D12_RESOURCE_STATE_COPY_DEST, 1));
+
+    CHECK(stand_in::debug_layer::instance().messages().empty());
+}
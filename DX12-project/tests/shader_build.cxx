@@ -0,0 +1,249 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <random>
+
+#include "test.hxx"
+
+#include "graphics/shader_build.hxx"
+
+
+namespace
+{
+    // Turns the sources into "bytecode" verbatim, so a stale binary shows up as stale contents.
+    class fake_compiler final : public graphics::shader_compiler_interface {
+    public:
+
+        std::atomic<std::uint32_t> compilations{0};
+
+        std::string identity() const override { return "fake compiler 1"; }
+
+        graphics::shader_binary compile(graphics::shader_request const &request, graphics::shader_sources const &sources) override
+        {
+            ++compilations;
+
+            std::string text = request.entry_point + ' ' + request.target;
+
+            for (auto &&file : sources.files())
+                text += '\n' + file->text;
+
+            if (text.find("#error") != std::string::npos)
+                throw graphics::shader_error("#error in " + request.source.string());
+
+            graphics::shader_binary binary;
+
+            binary.bytecode.resize(std::size(text));
+            std::memcpy(std::data(binary.bytecode), std::data(text), std::size(text));
+
+            binary.reflection.assign(4, std::byte{0x52});
+
+            return binary;
+        }
+    };
+
+    class scratch_directory final {
+    public:
+
+        scratch_directory() : path_{std::filesystem::temp_directory_path() / ("shader_build_test_" + std::to_string(std::random_device{}()))}
+        {
+            std::filesystem::create_directories(path_);
+        }
+
+        ~scratch_directory()
+        {
+            std::error_code error;
+            std::filesystem::remove_all(path_, error);
+        }
+
+        std::filesystem::path const &path() const noexcept { return path_; }
+
+        void write(std::string const &name, std::string const &text) const
+        {
+            std::ofstream{path_ / name, std::ios::binary | std::ios::trunc} << text;
+        }
+
+    private:
+
+        std::filesystem::path path_;
+    };
+
+    std::string text_of(graphics::shader_binary const &binary)
+    {
+        return std::string{reinterpret_cast<char const *>(std::data(binary.bytecode)), std::size(binary.bytecode)};
+    }
+
+    std::size_t temporary_file_count(std::filesystem::path const &directory)
+    {
+        return static_cast<std::size_t>(std::count_if(std::filesystem::directory_iterator{directory}, { }, [] (auto &&entry)
+        {
+            return entry.path().string().find(".tmp") != std::string::npos;
+        }));
+    }
+}
+
+// Three shaders over a two-level include tree. Editing a header rebuilds exactly the shaders that include it,
+// directly or not, and rereads only the edited file.
+TEST(incremental_rebuild_after_a_header_change)
+{
+    scratch_directory sources;
+    scratch_directory cache_directory;
+
+    sources.write("common.hlsli", "float4 common() { return 0; }\n");
+    sources.write("lighting.hlsli", "#include \"common.hlsli\"\nfloat4 light() { return common(); }\n");
+    sources.write("lit.hlsl", "#include \"lighting.hlsli\"\nfloat4 main() : SV_Target { return light(); }\n");
+    sources.write("unlit.hlsl", "#include <common.hlsli>\nfloat4 main() : SV_Target { return common(); }\n");
+    sources.write("blit.hlsl", "// #include \"lighting.hlsli\"\nfloat4 main() : SV_Target { return 1; }\n");
+
+    auto const requests = std::vector<graphics::shader_request>{
+        {sources.path() / "lit.hlsl", "main", "ps_6_6", { }},
+        {sources.path() / "unlit.hlsl", "main", "ps_6_6", { }},
+        {sources.path() / "blit.hlsl", "main", "ps_6_6", { }}
+    };
+
+    fake_compiler compiler;
+    graphics::shader_cache cache{cache_directory.path()};
+    platform::job_system jobs{2};
+
+    graphics::shader_builder builder{compiler, cache, {sources.path()}};
+
+    auto results = builder.build(jobs, requests);
+
+    CHECK(compiler.compilations == 3);
+    CHECK(std::all_of(std::begin(results), std::end(results), [] (auto &&result) { return result.origin == graphics::shader_origin::compiler; }));
+
+    // A fresh builder, as in the next run of the app, finds everything on disk.
+    {
+        graphics::shader_builder next_run{compiler, cache, {sources.path()}};
+
+        auto const cached = next_run.build(jobs, requests);
+
+        CHECK(compiler.compilations == 3);
+        CHECK(next_run.statistics().disk_hits == 3);
+
+        for (auto index = 0u; index < std::size(requests); ++index)
+            CHECK(text_of(*cached[index].binary) == text_of(*results[index].binary));
+    }
+
+    // Different sizes, so the edit is seen even if the modification time doesn't change within its resolution.
+    sources.write("lighting.hlsli", "#include \"common.hlsli\"\nfloat4 light() { return common() * 2; }\n");
+
+    auto const before = builder.statistics();
+
+    auto const after_lighting = builder.build(jobs, requests);
+
+    CHECK(compiler.compilations == 4);
+    CHECK(after_lighting[0].origin == graphics::shader_origin::compiler);
+    CHECK(after_lighting[1].origin == graphics::shader_origin::memory);
+    CHECK(after_lighting[2].origin == graphics::shader_origin::memory);
+    CHECK(text_of(*after_lighting[0].binary).find("common() * 2") != std::string::npos);
+
+    CHECK(builder.statistics().files_read - before.files_read == 1);
+
+    sources.write("common.hlsli", "float4 common() { return 0.5; }\n");
+
+    auto const after_common = builder.build(jobs, requests);
+
+    CHECK(compiler.compilations == 6);
+    CHECK(after_common[0].origin == graphics::shader_origin::compiler);
+    CHECK(after_common[1].origin == graphics::shader_origin::compiler);
+    CHECK(after_common[2].origin == graphics::shader_origin::memory);
+
+    // Defines are part of the key.
+    auto with_define = requests[2];
+    with_define.defines.push_back(graphics::shader_define{"MSAA", "4"});
+
+    CHECK(builder.build(with_define).origin == graphics::shader_origin::compiler);
+    CHECK(builder.build(with_define).origin == graphics::shader_origin::memory);
+
+    CHECK(builder.statistics().cache_write_failures == 0);
+    CHECK(temporary_file_count(cache_directory.path()) == 0);
+}
+
+TEST(failed_builds_are_reported_per_shader)
+{
+    scratch_directory sources;
+    scratch_directory cache_directory;
+
+    sources.write("good.hlsl", "float4 main() : SV_Target { return 1; }\n");
+    sources.write("bad.hlsl", "#error not yet\n");
+
+    auto const requests = std::vector<graphics::shader_request>{
+        {sources.path() / "good.hlsl", "main", "ps_6_6", { }},
+        {sources.path() / "bad.hlsl", "main", "ps_6_6", { }},
+        {sources.path() / "missing.hlsl", "main", "ps_6_6", { }}
+    };
+
+    fake_compiler compiler;
+    graphics::shader_cache cache{cache_directory.path()};
+    platform::job_system jobs{1};
+
+    graphics::shader_builder builder{compiler, cache};
+
+    auto const results = builder.build(jobs, requests);
+
+    CHECK(results[0].binary != nullptr && results[0].error.empty());
+    CHECK(results[1].binary == nullptr && results[1].error.find("#error") != std::string::npos);
+    CHECK(results[2].binary == nullptr && !results[2].error.empty());
+
+    CHECK_THROWS(graphics::shader_error, builder.build(requests[1]));
+}
+
+// A cache that can't be written to only costs compiling again.
+TEST(cache_write_failures_are_not_fatal)
+{
+    scratch_directory sources;
+    scratch_directory scratch;
+
+    sources.write("blit.hlsl", "float4 main() : SV_Target { return 1; }\n");
+
+    // A file where the cache directory should be.
+    scratch.write("cache", "not a directory");
+
+    fake_compiler compiler;
+    graphics::shader_cache cache{scratch.path() / "cache"};
+
+    graphics::shader_builder builder{compiler, cache};
+
+    auto const request = graphics::shader_request{sources.path() / "blit.hlsl", "main", "ps_6_6", { }};
+
+    auto const result = builder.build(request);
+
+    CHECK(result.binary != nullptr);
+    CHECK(result.origin == graphics::shader_origin::compiler);
+    CHECK(builder.statistics().cache_write_failures == 1);
+
+    CHECK(!cache.store(result.key, *result.binary));
+}
+
+TEST(corrupted_cache_files_are_rebuilt)
+{
+    scratch_directory sources;
+    scratch_directory cache_directory;
+
+    sources.write("blit.hlsl", "float4 main() : SV_Target { return 1; }\n");
+
+    fake_compiler compiler;
+    graphics::shader_cache cache{cache_directory.path()};
+
+    auto const request = graphics::shader_request{sources.path() / "blit.hlsl", "main", "ps_6_6", { }};
+
+    auto const key = graphics::shader_builder{compiler, cache}.build(request).key;
+
+    CHECK(cache.find(key).has_value());
+
+    // Flips a payload byte.
+    {
+        std::fstream file{cache.path_of(key), std::ios::binary | std::ios::in | std::ios::out};
+
+        file.seekp(sizeof(graphics::shader_cache_file::header));
+        file.put('x');
+    }
+
+    CHECK(!cache.find(key).has_value());
+
+    graphics::shader_builder builder{compiler, cache};
+
+    CHECK(builder.build(request).origin == graphics::shader_origin::compiler);
+    CHECK(compiler.compilations == 2);
+    CHECK(cache.find(key).has_value());
+}
@@ -0,0 +1,190 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <utility>
+
+
+// The part of GLFW the window uses, without a display. A window is a plain object; the thread that plays the
+// platform fires its callbacks through the functions in stand_in, as the message loop would for the OS's messages.
+struct GLFWmonitor;
+struct GLFWwindow;
+
+typedef void (*GLFWwindowsizefun)(GLFWwindow *, int, int);
+typedef void (*GLFWkeyfun)(GLFWwindow *, int, int, int, int);
+typedef void (*GLFWcursorposfun)(GLFWwindow *, double, double);
+typedef void (*GLFWmousebuttonfun)(GLFWwindow *, int, int, int);
+typedef void (*GLFWscrollfun)(GLFWwindow *, double, double);
+typedef void (*GLFWwindowfocusfun)(GLFWwindow *, int);
+typedef void (*GLFWwindowiconifyfun)(GLFWwindow *, int);
+
+#define GLFW_TRUE 1
+#define GLFW_FALSE 0
+
+#define GLFW_RELEASE 0
+#define GLFW_PRESS 1
+
+#define GLFW_KEY_ESCAPE 256
+
+#define GLFW_ICONIFIED 0x00020002
+#define GLFW_CLIENT_API 0x00022001
+#define GLFW_NO_API 0
+
+struct GLFWwindow final {
+    int width{0}, height{0};
+
+    void *user_pointer{nullptr};
+
+    std::atomic<bool> should_close{false};
+    std::atomic<bool> iconified{false};
+
+    GLFWwindowsizefun size_callback{nullptr};
+    GLFWkeyfun key_callback{nullptr};
+    GLFWcursorposfun cursor_callback{nullptr};
+    GLFWmousebuttonfun mouse_button_callback{nullptr};
+    GLFWscrollfun scroll_callback{nullptr};
+    GLFWwindowfocusfun focus_callback{nullptr};
+    GLFWwindowiconifyfun iconify_callback{nullptr};
+};
+
+namespace stand_in
+{
+    // Wakes up glfwWaitEvents() on glfwPostEmptyEvent().
+    struct glfw_message_loop final {
+        std::mutex mutex;
+        std::condition_variable posted;
+
+        bool empty_event{false};
+
+        template<class D>
+        void wait(D timeout)
+        {
+            std::unique_lock lock{mutex};
+
+            posted.wait_for(lock, timeout, [this] { return empty_event; });
+
+            empty_event = false;
+        }
+    };
+
+    inline glfw_message_loop &glfw() noexcept
+    {
+        static glfw_message_loop loop;
+        return loop;
+    }
+
+    inline void resize_window(GLFWwindow *window, int width, int height)
+    {
+        window->width = width;
+        window->height = height;
+
+        if (window->size_callback != nullptr)
+            window->size_callback(window, width, height);
+    }
+
+    inline void press_key(GLFWwindow *window, int key, int action)
+    {
+        if (window->key_callback != nullptr)
+            window->key_callback(window, key, 0, action, 0);
+    }
+
+    inline void move_cursor(GLFWwindow *window, double x, double y)
+    {
+        if (window->cursor_callback != nullptr)
+            window->cursor_callback(window, x, y);
+    }
+
+    inline void iconify_window(GLFWwindow *window, bool iconified)
+    {
+        window->iconified = iconified;
+
+        if (window->iconify_callback != nullptr)
+            window->iconify_callback(window, iconified ? GLFW_TRUE : GLFW_FALSE);
+    }
+}
+
+inline void glfwWindowHint(int, int) { }
+
+inline GLFWwindow *glfwCreateWindow(int width, int height, char const *, GLFWmonitor *, GLFWwindow *)
+{
+    auto const window = new GLFWwindow;
+
+    window->width = width;
+    window->height = height;
+
+    return window;
+}
+
+inline void glfwDestroyWindow(GLFWwindow *window) { delete window; }
+
+inline void glfwSetWindowUserPointer(GLFWwindow *window, void *pointer) { window->user_pointer = pointer; }
+inline void *glfwGetWindowUserPointer(GLFWwindow *window) { return window->user_pointer; }
+
+inline int glfwWindowShouldClose(GLFWwindow *window) { return window->should_close ? GLFW_TRUE : GLFW_FALSE; }
+inline void glfwSetWindowShouldClose(GLFWwindow *window, int value) { window->should_close = value == GLFW_TRUE; }
+
+inline int glfwGetWindowAttrib(GLFWwindow *window, int attribute)
+{
+    return attribute == GLFW_ICONIFIED && window->iconified ? GLFW_TRUE : GLFW_FALSE;
+}
+
+inline void glfwPollEvents() { }
+
+inline void glfwWaitEvents()
+{
+    stand_in::glfw().wait(std::chrono::milliseconds{10});
+}
+
+inline void glfwWaitEventsTimeout(double seconds)
+{
+    stand_in::glfw().wait(std::chrono::duration<double>{seconds});
+}
+
+inline void glfwPostEmptyEvent()
+{
+    auto &&loop = stand_in::glfw();
+
+    {
+        std::lock_guard lock{loop.mutex};
+        loop.empty_event = true;
+    }
+
+    loop.posted.notify_all();
+}
+
+inline GLFWwindowsizefun glfwSetWindowSizeCallback(GLFWwindow *window, GLFWwindowsizefun callback)
+{
+    return std::exchange(window->size_callback, callback);
+}
+
+inline GLFWkeyfun glfwSetKeyCallback(GLFWwindow *window, GLFWkeyfun callback)
+{
+    return std::exchange(window->key_callback, callback);
+}
+
+inline GLFWcursorposfun glfwSetCursorPosCallback(GLFWwindow *window, GLFWcursorposfun callback)
+{
+    return std::exchange(window->cursor_callback, callback);
+}
+
+inline GLFWmousebuttonfun glfwSetMouseButtonCallback(GLFWwindow *window, GLFWmousebuttonfun callback)
+{
+    return std::exchange(window->mouse_button_callback, callback);
+}
+
+inline GLFWscrollfun glfwSetScrollCallback(GLFWwindow *window, GLFWscrollfun callback)
+{
+    return std::exchange(window->scroll_callback, callback);
+}
+
+inline GLFWwindowfocusfun glfwSetWindowFocusCallback(GLFWwindow *window, GLFWwindowfocusfun callback)
+{
+    return std::exchange(window->focus_callback, callback);
+}
+
+inline GLFWwindowiconifyfun glfwSetWindowIconifyCallback(GLFWwindow *window, GLFWwindowiconifyfun callback)
+{
+    return std::exchange(window->iconify_callback, callback);
+}
@@ -0,0 +1,15 @@
+#pragma once
+
+#include "glfw3.h"
+
+
+// The native handle is the stand-in window itself.
+struct HWND__;
+using HWND = HWND__ *;
+
+inline HWND glfwGetWin32Window(GLFWwindow *window) { return reinterpret_cast<HWND>(window); }
+
+namespace stand_in
+{
+    inline GLFWwindow *window_of(HWND handle) noexcept { return reinterpret_cast<GLFWwindow *>(handle); }
+}
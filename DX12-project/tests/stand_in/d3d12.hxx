@@ -0,0 +1,1796 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <typeinfo>
+#include <utility>
+#include <vector>
+
+#include "win32.hxx"
+
+
+// The part of D3D12 the renderer uses, as an in-process device. Objects keep what was recorded into them, and
+// a simulated GPU executes the submitted work in queue order: copies are performed on host memory, fences complete
+// and command allocators become reusable only when it gets to them. Misuse that the debug layer would catch is
+// reported to stand_in::debug_layer instead.
+// Every interface derives from the previous version only, so a pointer to an object is a valid pointer to any
+// interface it implements, whatever the requested interface ID.
+struct GUID final {
+    std::type_info const *type{nullptr};
+};
+
+struct IUnknown {
+    virtual ~IUnknown() = default;
+
+    ULONG AddRef() noexcept { return ++references_; }
+
+    ULONG Release() noexcept
+    {
+        auto const count = --references_;
+
+        if (count == 0)
+            delete this;
+
+        return count;
+    }
+
+private:
+
+    std::atomic<ULONG> references_{1};
+};
+
+namespace winrt
+{
+    template<class T>
+    GUID guid_of() noexcept { return GUID{&typeid(T)}; }
+
+    template<class T>
+    class com_ptr final {
+    public:
+
+        com_ptr() noexcept = default;
+        com_ptr(std::nullptr_t) noexcept { }
+
+        com_ptr(com_ptr const &other) noexcept : pointer_{other.pointer_} { add_ref(); }
+        com_ptr(com_ptr &&other) noexcept : pointer_{std::exchange(other.pointer_, nullptr)} { }
+
+        ~com_ptr() { release(); }
+
+        com_ptr &operator=(com_ptr const &other) noexcept
+        {
+            copy_from(other.pointer_);
+            return *this;
+        }
+
+        com_ptr &operator=(com_ptr &&other) noexcept
+        {
+            if (this != &other) {
+                release();
+                pointer_ = std::exchange(other.pointer_, nullptr);
+            }
+
+            return *this;
+        }
+
+        com_ptr &operator=(std::nullptr_t) noexcept
+        {
+            release();
+            return *this;
+        }
+
+        T *get() const noexcept { return pointer_; }
+        T *operator->() const noexcept { return pointer_; }
+        T &operator*() const noexcept { return *pointer_; }
+
+        explicit operator bool() const noexcept { return pointer_ != nullptr; }
+
+        T **put() noexcept
+        {
+            release();
+            return &pointer_;
+        }
+
+        void **put_void() noexcept { return reinterpret_cast<void **>(put()); }
+
+        void attach(T *value) noexcept
+        {
+            release();
+            pointer_ = value;
+        }
+
+        T *detach() noexcept { return std::exchange(pointer_, nullptr); }
+
+        void copy_from(T *value) noexcept
+        {
+            if (pointer_ == value)
+                return;
+
+            release();
+
+            pointer_ = value;
+            add_ref();
+        }
+
+        template<class U>
+        com_ptr<U> try_as() const noexcept
+        {
+            com_ptr<U> result;
+            result.copy_from(dynamic_cast<U *>(pointer_));
+
+            return result;
+        }
+
+        friend bool operator==(com_ptr const &lhs, com_ptr const &rhs) noexcept { return lhs.pointer_ == rhs.pointer_; }
+        friend bool operator==(com_ptr const &lhs, std::nullptr_t) noexcept { return lhs.pointer_ == nullptr; }
+
+    private:
+
+        T *pointer_{nullptr};
+
+        void add_ref() noexcept
+        {
+            if (pointer_ != nullptr)
+                pointer_->AddRef();
+        }
+
+        void release() noexcept
+        {
+            if (auto pointer = std::exchange(pointer_, nullptr); pointer != nullptr)
+                pointer->Release();
+        }
+    };
+}
+
+#define D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT ( 256 )
+#define D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT ( 65536 )
+#define D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT ( 4194304 )
+#define D3D12_SMALL_RESOURCE_PLACEMENT_ALIGNMENT ( 4096 )
+#define D3D12_TEXTURE_DATA_PITCH_ALIGNMENT ( 256 )
+#define D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT ( 512 )
+#define D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES ( 0xffffffff )
+
+#define DEFINE_STAND_IN_FLAG_OPERATORS(T) \
+    constexpr T operator| (T lhs, T rhs) noexcept { return static_cast<T>(static_cast<int>(lhs) | static_cast<int>(rhs)); } \
+    constexpr T operator& (T lhs, T rhs) noexcept { return static_cast<T>(static_cast<int>(lhs) & static_cast<int>(rhs)); } \
+    constexpr T operator~ (T value) noexcept { return static_cast<T>(~static_cast<int>(value)); } \
+    constexpr T &operator|= (T &lhs, T rhs) noexcept { return lhs = lhs | rhs; } \
+    constexpr T &operator&= (T &lhs, T rhs) noexcept { return lhs = lhs & rhs; }
+
+using D3D12_GPU_VIRTUAL_ADDRESS = UINT64;
+
+enum DXGI_FORMAT : int {
+    DXGI_FORMAT_UNKNOWN = 0,
+    DXGI_FORMAT_R32G32B32A32_FLOAT = 2,
+    DXGI_FORMAT_R16G16B16A16_FLOAT = 10,
+    DXGI_FORMAT_R8G8B8A8_UNORM = 28,
+    DXGI_FORMAT_D32_FLOAT = 40,
+    DXGI_FORMAT_R32_UINT = 42,
+    DXGI_FORMAT_D24_UNORM_S8_UINT = 45
+};
+
+struct DXGI_SAMPLE_DESC {
+    UINT Count;
+    UINT Quality;
+};
+
+enum D3D12_COMMAND_LIST_TYPE : int {
+    D3D12_COMMAND_LIST_TYPE_DIRECT = 0,
+    D3D12_COMMAND_LIST_TYPE_BUNDLE = 1,
+    D3D12_COMMAND_LIST_TYPE_COMPUTE = 2,
+    D3D12_COMMAND_LIST_TYPE_COPY = 3
+};
+
+enum D3D12_COMMAND_QUEUE_PRIORITY : int {
+    D3D12_COMMAND_QUEUE_PRIORITY_NORMAL = 0,
+    D3D12_COMMAND_QUEUE_PRIORITY_HIGH = 100
+};
+
+enum D3D12_COMMAND_QUEUE_FLAGS : int {
+    D3D12_COMMAND_QUEUE_FLAG_NONE = 0
+};
+
+struct D3D12_COMMAND_QUEUE_DESC {
+    D3D12_COMMAND_LIST_TYPE Type;
+    INT Priority;
+    D3D12_COMMAND_QUEUE_FLAGS Flags;
+    UINT NodeMask;
+};
+
+enum D3D12_FENCE_FLAGS : int {
+    D3D12_FENCE_FLAG_NONE = 0
+};
+
+enum D3D12_DESCRIPTOR_HEAP_TYPE : int {
+    D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV = 0,
+    D3D12_DESCRIPTOR_HEAP_TYPE_SAMPLER,
+    D3D12_DESCRIPTOR_HEAP_TYPE_RTV,
+    D3D12_DESCRIPTOR_HEAP_TYPE_DSV,
+    D3D12_DESCRIPTOR_HEAP_TYPE_NUM_TYPES
+};
+
+enum D3D12_DESCRIPTOR_HEAP_FLAGS : int {
+    D3D12_DESCRIPTOR_HEAP_FLAG_NONE = 0,
+    D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE = 0x1
+};
+
+struct D3D12_DESCRIPTOR_HEAP_DESC {
+    D3D12_DESCRIPTOR_HEAP_TYPE Type;
+    UINT NumDescriptors;
+    D3D12_DESCRIPTOR_HEAP_FLAGS Flags;
+    UINT NodeMask;
+};
+
+struct D3D12_CPU_DESCRIPTOR_HANDLE {
+    SIZE_T ptr;
+};
+
+struct D3D12_GPU_DESCRIPTOR_HANDLE {
+    UINT64 ptr;
+};
+
+enum D3D12_HEAP_TYPE : int {
+    D3D12_HEAP_TYPE_DEFAULT = 1,
+    D3D12_HEAP_TYPE_UPLOAD = 2,
+    D3D12_HEAP_TYPE_READBACK = 3,
+    D3D12_HEAP_TYPE_CUSTOM = 4
+};
+
+enum D3D12_CPU_PAGE_PROPERTY : int {
+    D3D12_CPU_PAGE_PROPERTY_UNKNOWN = 0
+};
+
+enum D3D12_MEMORY_POOL : int {
+    D3D12_MEMORY_POOL_UNKNOWN = 0
+};
+
+struct D3D12_HEAP_PROPERTIES {
+    D3D12_HEAP_TYPE Type;
+    D3D12_CPU_PAGE_PROPERTY CPUPageProperty;
+    D3D12_MEMORY_POOL MemoryPoolPreference;
+    UINT CreationNodeMask;
+    UINT VisibleNodeMask;
+};
+
+struct CD3DX12_HEAP_PROPERTIES : D3D12_HEAP_PROPERTIES {
+    CD3DX12_HEAP_PROPERTIES() = default;
+
+    explicit CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE type, UINT creation_node_mask = 1, UINT node_mask = 1) noexcept
+        : D3D12_HEAP_PROPERTIES{type, D3D12_CPU_PAGE_PROPERTY_UNKNOWN, D3D12_MEMORY_POOL_UNKNOWN, creation_node_mask, node_mask} { }
+};
+
+enum D3D12_HEAP_FLAGS : int {
+    D3D12_HEAP_FLAG_NONE = 0,
+    D3D12_HEAP_FLAG_DENY_BUFFERS = 0x4,
+    D3D12_HEAP_FLAG_DENY_RT_DS_TEXTURES = 0x40,
+    D3D12_HEAP_FLAG_DENY_NON_RT_DS_TEXTURES = 0x80,
+    D3D12_HEAP_FLAG_ALLOW_ALL_BUFFERS_AND_TEXTURES = 0,
+    D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS = 0xc0,
+    D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES = 0x44,
+    D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES = 0x84
+};
+
+DEFINE_STAND_IN_FLAG_OPERATORS(D3D12_HEAP_FLAGS)
+
+struct D3D12_HEAP_DESC {
+    UINT64 SizeInBytes;
+    D3D12_HEAP_PROPERTIES Properties;
+    UINT64 Alignment;
+    D3D12_HEAP_FLAGS Flags;
+};
+
+enum D3D12_RESOURCE_STATES : int {
+    D3D12_RESOURCE_STATE_COMMON = 0,
+    D3D12_RESOURCE_STATE_VERTEX_AND_CONSTANT_BUFFER = 0x1,
+    D3D12_RESOURCE_STATE_INDEX_BUFFER = 0x2,
+    D3D12_RESOURCE_STATE_RENDER_TARGET = 0x4,
+    D3D12_RESOURCE_STATE_UNORDERED_ACCESS = 0x8,
+    D3D12_RESOURCE_STATE_DEPTH_WRITE = 0x10,
+    D3D12_RESOURCE_STATE_DEPTH_READ = 0x20,
+    D3D12_RESOURCE_STATE_NON_PIXEL_SHADER_RESOURCE = 0x40,
+    D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE = 0x80,
+    D3D12_RESOURCE_STATE_STREAM_OUT = 0x100,
+    D3D12_RESOURCE_STATE_INDIRECT_ARGUMENT = 0x200,
+    D3D12_RESOURCE_STATE_COPY_DEST = 0x400,
+    D3D12_RESOURCE_STATE_COPY_SOURCE = 0x800,
+    D3D12_RESOURCE_STATE_GENERIC_READ = 0xac3,
+    D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE = 0xc0,
+    D3D12_RESOURCE_STATE_PRESENT = 0
+};
+
+DEFINE_STAND_IN_FLAG_OPERATORS(D3D12_RESOURCE_STATES)
+
+enum D3D12_RESOURCE_DIMENSION : int {
+    D3D12_RESOURCE_DIMENSION_UNKNOWN = 0,
+    D3D12_RESOURCE_DIMENSION_BUFFER,
+    D3D12_RESOURCE_DIMENSION_TEXTURE1D,
+    D3D12_RESOURCE_DIMENSION_TEXTURE2D,
+    D3D12_RESOURCE_DIMENSION_TEXTURE3D
+};
+
+enum D3D12_TEXTURE_LAYOUT : int {
+    D3D12_TEXTURE_LAYOUT_UNKNOWN = 0,
+    D3D12_TEXTURE_LAYOUT_ROW_MAJOR
+};
+
+enum D3D12_RESOURCE_FLAGS : int {
+    D3D12_RESOURCE_FLAG_NONE = 0,
+    D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET = 0x1,
+    D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL = 0x2,
+    D3D12_RESOURCE_FLAG_ALLOW_UNORDERED_ACCESS = 0x4,
+    D3D12_RESOURCE_FLAG_DENY_SHADER_RESOURCE = 0x8
+};
+
+DEFINE_STAND_IN_FLAG_OPERATORS(D3D12_RESOURCE_FLAGS)
+
+struct D3D12_RESOURCE_DESC {
+    D3D12_RESOURCE_DIMENSION Dimension;
+    UINT64 Alignment;
+    UINT64 Width;
+    UINT Height;
+    UINT16 DepthOrArraySize;
+    UINT16 MipLevels;
+    DXGI_FORMAT Format;
+    DXGI_SAMPLE_DESC SampleDesc;
+    D3D12_TEXTURE_LAYOUT Layout;
+    D3D12_RESOURCE_FLAGS Flags;
+};
+
+struct CD3DX12_RESOURCE_DESC : D3D12_RESOURCE_DESC {
+    CD3DX12_RESOURCE_DESC() = default;
+
+    explicit CD3DX12_RESOURCE_DESC(D3D12_RESOURCE_DESC const &description) noexcept : D3D12_RESOURCE_DESC{description} { }
+
+    static CD3DX12_RESOURCE_DESC Buffer(UINT64 width, D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE, UINT64 alignment = 0) noexcept
+    {
+        return CD3DX12_RESOURCE_DESC{D3D12_RESOURCE_DESC{
+            D3D12_RESOURCE_DIMENSION_BUFFER, alignment, width, 1, 1, 1, DXGI_FORMAT_UNKNOWN, {1, 0}, D3D12_TEXTURE_LAYOUT_ROW_MAJOR, flags
+        }};
+    }
+
+    static CD3DX12_RESOURCE_DESC Tex2D(DXGI_FORMAT format, UINT64 width, UINT height, UINT16 array_size = 1, UINT16 mip_levels = 0,
+                                       UINT sample_count = 1, UINT sample_quality = 0, D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_NONE,
+                                       D3D12_TEXTURE_LAYOUT layout = D3D12_TEXTURE_LAYOUT_UNKNOWN, UINT64 alignment = 0) noexcept
+    {
+        return CD3DX12_RESOURCE_DESC{D3D12_RESOURCE_DESC{
+            D3D12_RESOURCE_DIMENSION_TEXTURE2D, alignment, width, height, array_size, mip_levels, format, {sample_count, sample_quality}, layout, flags
+        }};
+    }
+};
+
+struct D3D12_RESOURCE_ALLOCATION_INFO {
+    UINT64 SizeInBytes;
+    UINT64 Alignment;
+};
+
+struct D3D12_RANGE {
+    SIZE_T Begin;
+    SIZE_T End;
+};
+
+struct D3D12_DEPTH_STENCIL_VALUE {
+    FLOAT Depth;
+    UINT8 Stencil;
+};
+
+struct D3D12_CLEAR_VALUE {
+    DXGI_FORMAT Format;
+
+    union {
+        FLOAT Color[4];
+        D3D12_DEPTH_STENCIL_VALUE DepthStencil;
+    };
+};
+
+enum D3D12_FEATURE : int {
+    D3D12_FEATURE_D3D12_OPTIONS = 0,
+    D3D12_FEATURE_FEATURE_LEVELS = 2,
+    D3D12_FEATURE_MULTISAMPLE_QUALITY_LEVELS = 4
+};
+
+enum D3D12_RESOURCE_HEAP_TIER : int {
+    D3D12_RESOURCE_HEAP_TIER_1 = 1,
+    D3D12_RESOURCE_HEAP_TIER_2 = 2
+};
+
+struct D3D12_FEATURE_DATA_D3D12_OPTIONS {
+    D3D12_RESOURCE_HEAP_TIER ResourceHeapTier;
+};
+
+enum D3D12_RESOURCE_BARRIER_TYPE : int {
+    D3D12_RESOURCE_BARRIER_TYPE_TRANSITION = 0,
+    D3D12_RESOURCE_BARRIER_TYPE_ALIASING,
+    D3D12_RESOURCE_BARRIER_TYPE_UAV
+};
+
+enum D3D12_RESOURCE_BARRIER_FLAGS : int {
+    D3D12_RESOURCE_BARRIER_FLAG_NONE = 0,
+    D3D12_RESOURCE_BARRIER_FLAG_BEGIN_ONLY = 0x1,
+    D3D12_RESOURCE_BARRIER_FLAG_END_ONLY = 0x2
+};
+
+struct ID3D12Resource;
+
+struct D3D12_RESOURCE_TRANSITION_BARRIER {
+    ID3D12Resource *pResource;
+    UINT Subresource;
+    D3D12_RESOURCE_STATES StateBefore;
+    D3D12_RESOURCE_STATES StateAfter;
+};
+
+struct D3D12_RESOURCE_ALIASING_BARRIER {
+    ID3D12Resource *pResourceBefore;
+    ID3D12Resource *pResourceAfter;
+};
+
+struct D3D12_RESOURCE_UAV_BARRIER {
+    ID3D12Resource *pResource;
+};
+
+struct D3D12_RESOURCE_BARRIER {
+    D3D12_RESOURCE_BARRIER_TYPE Type;
+    D3D12_RESOURCE_BARRIER_FLAGS Flags;
+
+    union {
+        D3D12_RESOURCE_TRANSITION_BARRIER Transition;
+        D3D12_RESOURCE_ALIASING_BARRIER Aliasing;
+        D3D12_RESOURCE_UAV_BARRIER UAV;
+    };
+};
+
+struct CD3DX12_RESOURCE_BARRIER : D3D12_RESOURCE_BARRIER {
+    static CD3DX12_RESOURCE_BARRIER
+    Transition(ID3D12Resource *resource, D3D12_RESOURCE_STATES before, D3D12_RESOURCE_STATES after,
+               UINT subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES, D3D12_RESOURCE_BARRIER_FLAGS flags = D3D12_RESOURCE_BARRIER_FLAG_NONE) noexcept
+    {
+        CD3DX12_RESOURCE_BARRIER barrier{ };
+
+        barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION;
+        barrier.Flags = flags;
+        barrier.D3D12_RESOURCE_BARRIER::Transition = D3D12_RESOURCE_TRANSITION_BARRIER{resource, subresource, before, after};
+
+        return barrier;
+    }
+
+    static CD3DX12_RESOURCE_BARRIER Aliasing(ID3D12Resource *before, ID3D12Resource *after) noexcept
+    {
+        CD3DX12_RESOURCE_BARRIER barrier{ };
+
+        barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+        barrier.D3D12_RESOURCE_BARRIER::Aliasing = D3D12_RESOURCE_ALIASING_BARRIER{before, after};
+
+        return barrier;
+    }
+
+    static CD3DX12_RESOURCE_BARRIER UAV(ID3D12Resource *resource) noexcept
+    {
+        CD3DX12_RESOURCE_BARRIER barrier{ };
+
+        barrier.Type = D3D12_RESOURCE_BARRIER_TYPE_UAV;
+        barrier.D3D12_RESOURCE_BARRIER::UAV = D3D12_RESOURCE_UAV_BARRIER{resource};
+
+        return barrier;
+    }
+};
+
+struct D3D12_SUBRESOURCE_FOOTPRINT {
+    DXGI_FORMAT Format;
+    UINT Width;
+    UINT Height;
+    UINT Depth;
+    UINT RowPitch;
+};
+
+struct D3D12_PLACED_SUBRESOURCE_FOOTPRINT {
+    UINT64 Offset;
+    D3D12_SUBRESOURCE_FOOTPRINT Footprint;
+};
+
+enum D3D12_TEXTURE_COPY_TYPE : int {
+    D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX = 0,
+    D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT = 1
+};
+
+struct D3D12_TEXTURE_COPY_LOCATION {
+    ID3D12Resource *pResource;
+    D3D12_TEXTURE_COPY_TYPE Type;
+
+    union {
+        D3D12_PLACED_SUBRESOURCE_FOOTPRINT PlacedFootprint;
+        UINT SubresourceIndex;
+    };
+};
+
+struct CD3DX12_TEXTURE_COPY_LOCATION : D3D12_TEXTURE_COPY_LOCATION {
+    CD3DX12_TEXTURE_COPY_LOCATION(ID3D12Resource *resource, UINT subresource) noexcept : D3D12_TEXTURE_COPY_LOCATION{ }
+    {
+        pResource = resource;
+        Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX;
+        SubresourceIndex = subresource;
+    }
+
+    CD3DX12_TEXTURE_COPY_LOCATION(ID3D12Resource *resource, D3D12_PLACED_SUBRESOURCE_FOOTPRINT const &footprint) noexcept : D3D12_TEXTURE_COPY_LOCATION{ }
+    {
+        pResource = resource;
+        Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT;
+        PlacedFootprint = footprint;
+    }
+};
+
+struct D3D12_BOX {
+    UINT left, top, front;
+    UINT right, bottom, back;
+};
+
+namespace stand_in
+{
+    // What the D3D12 debug layer would have reported.
+    class debug_layer final {
+    public:
+
+        static debug_layer &instance()
+        {
+            static debug_layer layer;
+            return layer;
+        }
+
+        void report(std::string message)
+        {
+            std::lock_guard lock{mutex_};
+
+            messages_.push_back(std::move(message));
+        }
+
+        std::vector<std::string> messages() const
+        {
+            std::lock_guard lock{mutex_};
+
+            return messages_;
+        }
+
+        void clear()
+        {
+            std::lock_guard lock{mutex_};
+
+            messages_.clear();
+        }
+
+    private:
+
+        mutable std::mutex mutex_;
+        std::vector<std::string> messages_;
+    };
+
+    inline void report(std::string message)
+    {
+        debug_layer::instance().report(std::move(message));
+    }
+
+    constexpr UINT64 align(UINT64 value, UINT64 alignment) noexcept
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    constexpr UINT bytes_per_pixel(DXGI_FORMAT format) noexcept
+    {
+        switch (format) {
+            case DXGI_FORMAT_R32G32B32A32_FLOAT:
+                return 16;
+
+            case DXGI_FORMAT_R16G16B16A16_FLOAT:
+                return 8;
+
+            default:
+                return 4;
+        }
+    }
+
+    class gpu;
+}
+
+struct ID3D12RootSignature : IUnknown { };
+
+struct D3D12_SHADER_BYTECODE {
+    void const *pShaderBytecode;
+    SIZE_T BytecodeLength;
+};
+
+struct D3D12_SO_DECLARATION_ENTRY {
+    UINT Stream;
+    char const *SemanticName;
+    UINT SemanticIndex;
+    UINT8 StartComponent;
+    UINT8 ComponentCount;
+    UINT8 OutputSlot;
+};
+
+struct D3D12_STREAM_OUTPUT_DESC {
+    D3D12_SO_DECLARATION_ENTRY const *pSODeclaration;
+    UINT NumEntries;
+    UINT const *pBufferStrides;
+    UINT NumStrides;
+    UINT RasterizedStream;
+};
+
+enum D3D12_BLEND : int {
+    D3D12_BLEND_ZERO = 1,
+    D3D12_BLEND_ONE = 2,
+    D3D12_BLEND_SRC_ALPHA = 5,
+    D3D12_BLEND_INV_SRC_ALPHA = 6
+};
+
+enum D3D12_BLEND_OP : int {
+    D3D12_BLEND_OP_ADD = 1,
+    D3D12_BLEND_OP_SUBTRACT = 2
+};
+
+enum D3D12_LOGIC_OP : int {
+    D3D12_LOGIC_OP_CLEAR = 0,
+    D3D12_LOGIC_OP_NOOP = 4
+};
+
+struct D3D12_RENDER_TARGET_BLEND_DESC {
+    BOOL BlendEnable;
+    BOOL LogicOpEnable;
+    D3D12_BLEND SrcBlend;
+    D3D12_BLEND DestBlend;
+    D3D12_BLEND_OP BlendOp;
+    D3D12_BLEND SrcBlendAlpha;
+    D3D12_BLEND DestBlendAlpha;
+    D3D12_BLEND_OP BlendOpAlpha;
+    D3D12_LOGIC_OP LogicOp;
+    UINT8 RenderTargetWriteMask;
+};
+
+struct D3D12_BLEND_DESC {
+    BOOL AlphaToCoverageEnable;
+    BOOL IndependentBlendEnable;
+    D3D12_RENDER_TARGET_BLEND_DESC RenderTarget[8];
+};
+
+enum D3D12_FILL_MODE : int {
+    D3D12_FILL_MODE_WIREFRAME = 2,
+    D3D12_FILL_MODE_SOLID = 3
+};
+
+enum D3D12_CULL_MODE : int {
+    D3D12_CULL_MODE_NONE = 1,
+    D3D12_CULL_MODE_FRONT = 2,
+    D3D12_CULL_MODE_BACK = 3
+};
+
+enum D3D12_CONSERVATIVE_RASTERIZATION_MODE : int {
+    D3D12_CONSERVATIVE_RASTERIZATION_MODE_OFF = 0,
+    D3D12_CONSERVATIVE_RASTERIZATION_MODE_ON = 1
+};
+
+struct D3D12_RASTERIZER_DESC {
+    D3D12_FILL_MODE FillMode;
+    D3D12_CULL_MODE CullMode;
+    BOOL FrontCounterClockwise;
+    INT DepthBias;
+    FLOAT DepthBiasClamp;
+    FLOAT SlopeScaledDepthBias;
+    BOOL DepthClipEnable;
+    BOOL MultisampleEnable;
+    BOOL AntialiasedLineEnable;
+    UINT ForcedSampleCount;
+    D3D12_CONSERVATIVE_RASTERIZATION_MODE ConservativeRaster;
+};
+
+enum D3D12_DEPTH_WRITE_MASK : int {
+    D3D12_DEPTH_WRITE_MASK_ZERO = 0,
+    D3D12_DEPTH_WRITE_MASK_ALL = 1
+};
+
+enum D3D12_COMPARISON_FUNC : int {
+    D3D12_COMPARISON_FUNC_NEVER = 1,
+    D3D12_COMPARISON_FUNC_LESS = 2,
+    D3D12_COMPARISON_FUNC_GREATER_EQUAL = 7,
+    D3D12_COMPARISON_FUNC_ALWAYS = 8
+};
+
+enum D3D12_STENCIL_OP : int {
+    D3D12_STENCIL_OP_KEEP = 1,
+    D3D12_STENCIL_OP_ZERO = 2,
+    D3D12_STENCIL_OP_REPLACE = 3
+};
+
+struct D3D12_DEPTH_STENCILOP_DESC {
+    D3D12_STENCIL_OP StencilFailOp;
+    D3D12_STENCIL_OP StencilDepthFailOp;
+    D3D12_STENCIL_OP StencilPassOp;
+    D3D12_COMPARISON_FUNC StencilFunc;
+};
+
+struct D3D12_DEPTH_STENCIL_DESC {
+    BOOL DepthEnable;
+    D3D12_DEPTH_WRITE_MASK DepthWriteMask;
+    D3D12_COMPARISON_FUNC DepthFunc;
+    BOOL StencilEnable;
+    UINT8 StencilReadMask;
+    UINT8 StencilWriteMask;
+    D3D12_DEPTH_STENCILOP_DESC FrontFace;
+    D3D12_DEPTH_STENCILOP_DESC BackFace;
+};
+
+enum D3D12_INPUT_CLASSIFICATION : int {
+    D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA = 0,
+    D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA = 1
+};
+
+struct D3D12_INPUT_ELEMENT_DESC {
+    char const *SemanticName;
+    UINT SemanticIndex;
+    DXGI_FORMAT Format;
+    UINT InputSlot;
+    UINT AlignedByteOffset;
+    D3D12_INPUT_CLASSIFICATION InputSlotClass;
+    UINT InstanceDataStepRate;
+};
+
+struct D3D12_INPUT_LAYOUT_DESC {
+    D3D12_INPUT_ELEMENT_DESC const *pInputElementDescs;
+    UINT NumElements;
+};
+
+enum D3D12_INDEX_BUFFER_STRIP_CUT_VALUE : int {
+    D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_DISABLED = 0,
+    D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_0xFFFF = 1,
+    D3D12_INDEX_BUFFER_STRIP_CUT_VALUE_0xFFFFFFFF = 2
+};
+
+enum D3D12_PRIMITIVE_TOPOLOGY_TYPE : int {
+    D3D12_PRIMITIVE_TOPOLOGY_TYPE_UNDEFINED = 0,
+    D3D12_PRIMITIVE_TOPOLOGY_TYPE_POINT = 1,
+    D3D12_PRIMITIVE_TOPOLOGY_TYPE_LINE = 2,
+    D3D12_PRIMITIVE_TOPOLOGY_TYPE_TRIANGLE = 3
+};
+
+struct D3D12_CACHED_PIPELINE_STATE {
+    void const *pCachedBlob;
+    SIZE_T CachedBlobSizeInBytes;
+};
+
+enum D3D12_PIPELINE_STATE_FLAGS : int {
+    D3D12_PIPELINE_STATE_FLAG_NONE = 0,
+    D3D12_PIPELINE_STATE_FLAG_TOOL_DEBUG = 0x1
+};
+
+struct D3D12_GRAPHICS_PIPELINE_STATE_DESC {
+    ID3D12RootSignature *pRootSignature;
+    D3D12_SHADER_BYTECODE VS;
+    D3D12_SHADER_BYTECODE PS;
+    D3D12_SHADER_BYTECODE DS;
+    D3D12_SHADER_BYTECODE HS;
+    D3D12_SHADER_BYTECODE GS;
+    D3D12_STREAM_OUTPUT_DESC StreamOutput;
+    D3D12_BLEND_DESC BlendState;
+    UINT SampleMask;
+    D3D12_RASTERIZER_DESC RasterizerState;
+    D3D12_DEPTH_STENCIL_DESC DepthStencilState;
+    D3D12_INPUT_LAYOUT_DESC InputLayout;
+    D3D12_INDEX_BUFFER_STRIP_CUT_VALUE IBStripCutValue;
+    D3D12_PRIMITIVE_TOPOLOGY_TYPE PrimitiveTopologyType;
+    UINT NumRenderTargets;
+    DXGI_FORMAT RTVFormats[8];
+    DXGI_FORMAT DSVFormat;
+    DXGI_SAMPLE_DESC SampleDesc;
+    UINT NodeMask;
+    D3D12_CACHED_PIPELINE_STATE CachedPSO;
+    D3D12_PIPELINE_STATE_FLAGS Flags;
+};
+
+struct D3D12_COMPUTE_PIPELINE_STATE_DESC {
+    ID3D12RootSignature *pRootSignature;
+    D3D12_SHADER_BYTECODE CS;
+    UINT NodeMask;
+    D3D12_CACHED_PIPELINE_STATE CachedPSO;
+    D3D12_PIPELINE_STATE_FLAGS Flags;
+};
+
+struct ID3D12PipelineState : IUnknown { };
+
+struct ID3D12Heap : IUnknown {
+    explicit ID3D12Heap(D3D12_HEAP_DESC const &description) noexcept : description_{description} { }
+
+    D3D12_HEAP_DESC GetDesc() const noexcept { return description_; }
+
+private:
+
+    D3D12_HEAP_DESC description_;
+};
+
+struct ID3D12Resource : IUnknown {
+    ID3D12Resource(D3D12_RESOURCE_DESC const &description, D3D12_HEAP_TYPE heap_type, ID3D12Heap *heap = nullptr, UINT64 heap_offset = 0)
+        : description_{description}, heap_type_{heap_type}, heap_{heap}, heap_offset_{heap_offset}
+    {
+        static std::atomic<UINT64> next_address{1ull << 40};
+
+        if (description.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+            gpu_address_ = next_address.fetch_add(stand_in::align(description.Width, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT));
+    }
+
+    HRESULT Map(UINT subresource, D3D12_RANGE const *, void **data)
+    {
+        if (subresource != 0 || description_.Dimension != D3D12_RESOURCE_DIMENSION_BUFFER || heap_type_ == D3D12_HEAP_TYPE_DEFAULT) {
+            stand_in::report("only buffers in upload and readback heaps can be mapped");
+            return E_INVALIDARG;
+        }
+
+        ++map_count_;
+
+        if (data != nullptr)
+            *data = memory();
+
+        return S_OK;
+    }
+
+    void Unmap(UINT, D3D12_RANGE const *)
+    {
+        if (map_count_ == 0)
+            stand_in::report("unmapping a resource that isn't mapped");
+
+        else --map_count_;
+    }
+
+    D3D12_GPU_VIRTUAL_ADDRESS GetGPUVirtualAddress() const noexcept { return gpu_address_; }
+
+    D3D12_RESOURCE_DESC GetDesc() const noexcept { return description_; }
+
+    // The contents of a buffer, allocated on first use.
+    std::byte *memory()
+    {
+        std::call_once(memory_flag_, [this] { memory_ = std::make_unique<std::byte[]>(static_cast<std::size_t>(description_.Width)); });
+
+        return memory_.get();
+    }
+
+    ID3D12Heap *heap() const noexcept { return heap_; }
+    UINT64 heap_offset() const noexcept { return heap_offset_; }
+
+    std::uint32_t map_count() const noexcept { return map_count_; }
+
+private:
+
+    D3D12_RESOURCE_DESC description_;
+    D3D12_HEAP_TYPE heap_type_;
+
+    ID3D12Heap *heap_;
+    UINT64 heap_offset_;
+
+    D3D12_GPU_VIRTUAL_ADDRESS gpu_address_{0};
+
+    std::once_flag memory_flag_;
+    std::unique_ptr<std::byte[]> memory_;
+
+    std::uint32_t map_count_{0};
+};
+
+struct ID3D12DescriptorHeap : IUnknown {
+    ID3D12DescriptorHeap(D3D12_DESCRIPTOR_HEAP_DESC const &description, UINT increment_size) noexcept : description_{description}
+    {
+        // Heaps get address ranges that never overlap, with a gap in between to catch handles that run past the end.
+        static std::atomic<UINT64> next_address{1ull << 32};
+
+        auto const size = stand_in::align(static_cast<UINT64>(description.NumDescriptors) * increment_size + 1, 1ull << 20);
+        auto const address = next_address.fetch_add(size + (1ull << 20));
+
+        cpu_start_ = D3D12_CPU_DESCRIPTOR_HANDLE{static_cast<SIZE_T>(address)};
+
+        if ((description.Flags & D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE) != 0)
+            gpu_start_ = D3D12_GPU_DESCRIPTOR_HANDLE{address + (1ull << 44)};
+
+        ++live_number();
+    }
+
+    ~ID3D12DescriptorHeap() override { --live_number(); }
+
+    // The number of heaps that have not been released yet, which the debug layer would report as live objects.
+    static std::atomic<int> &live_number() noexcept
+    {
+        static std::atomic<int> value{0};
+        return value;
+    }
+
+    D3D12_DESCRIPTOR_HEAP_DESC GetDesc() const noexcept { return description_; }
+
+    D3D12_CPU_DESCRIPTOR_HANDLE GetCPUDescriptorHandleForHeapStart() const noexcept { return cpu_start_; }
+    D3D12_GPU_DESCRIPTOR_HANDLE GetGPUDescriptorHandleForHeapStart() const noexcept { return gpu_start_; }
+
+private:
+
+    D3D12_DESCRIPTOR_HEAP_DESC description_;
+
+    D3D12_CPU_DESCRIPTOR_HANDLE cpu_start_{0};
+    D3D12_GPU_DESCRIPTOR_HANDLE gpu_start_{0};
+};
+
+struct ID3D12Fence : IUnknown { };
+
+struct ID3D12Fence1 : ID3D12Fence {
+    explicit ID3D12Fence1(UINT64 initial_value) noexcept : completed_{initial_value} { }
+
+    UINT64 GetCompletedValue() const noexcept { return completed_.load(std::memory_order_acquire); }
+
+    // Without an event the call blocks until the fence reaches the value.
+    HRESULT SetEventOnCompletion(UINT64 value, HANDLE event);
+
+    // Sets the value from the CPU.
+    HRESULT Signal(UINT64 value);
+
+private:
+
+    friend class stand_in::gpu;
+
+    std::atomic<UINT64> completed_;
+
+    // Guarded by the GPU's lock.
+    std::vector<std::pair<UINT64, HANDLE>> events_;
+
+    void complete(UINT64 value);
+};
+
+struct ID3D12CommandAllocator : IUnknown {
+    explicit ID3D12CommandAllocator(D3D12_COMMAND_LIST_TYPE type) noexcept : type_{type} { }
+
+    // Fails if lists that recorded into the allocator are still queued or executing.
+    HRESULT Reset()
+    {
+        if (auto const pending = pending_.load(std::memory_order_acquire); pending != 0) {
+            stand_in::report("a command allocator was reset while its command lists were still executing on the GPU");
+            return E_FAIL;
+        }
+
+        ++reset_count_;
+
+        return S_OK;
+    }
+
+    D3D12_COMMAND_LIST_TYPE type() const noexcept { return type_; }
+
+    // Submissions of lists recorded into the allocator that the GPU hasn't finished.
+    std::uint32_t pending_executions() const noexcept { return pending_.load(std::memory_order_acquire); }
+
+    std::uint64_t reset_count() const noexcept { return reset_count_; }
+
+private:
+
+    friend struct ID3D12CommandQueue;
+    friend class stand_in::gpu;
+
+    D3D12_COMMAND_LIST_TYPE type_;
+
+    std::atomic<std::uint32_t> pending_{0};
+    std::uint64_t reset_count_{0};
+};
+
+namespace stand_in
+{
+    struct queue_wait final {
+        ID3D12Fence *fence;
+        UINT64 value;
+    };
+
+    struct buffer_copy final {
+        ID3D12Resource *destination;
+        UINT64 destination_offset;
+
+        ID3D12Resource *source;
+        UINT64 source_offset;
+
+        UINT64 size;
+    };
+
+    // What a command list recorded since it was last reset.
+    struct recording final {
+        std::vector<D3D12_RESOURCE_BARRIER> barriers;
+        std::size_t barrier_calls{0};
+
+        std::vector<buffer_copy> buffer_copies;
+        std::size_t texture_copies{0};
+
+        std::size_t draws{0};
+        std::size_t dispatches{0};
+        std::size_t descriptor_heap_calls{0};
+    };
+}
+
+struct ID3D12CommandList : IUnknown {
+    explicit ID3D12CommandList(D3D12_COMMAND_LIST_TYPE type) noexcept : type_{type} { }
+
+    D3D12_COMMAND_LIST_TYPE GetType() const noexcept { return type_; }
+
+private:
+
+    D3D12_COMMAND_LIST_TYPE type_;
+};
+
+struct ID3D12GraphicsCommandList : ID3D12CommandList {
+    ID3D12GraphicsCommandList(D3D12_COMMAND_LIST_TYPE type, ID3D12CommandAllocator *allocator) : ID3D12CommandList{type}
+    {
+        allocator_.copy_from(allocator);
+    }
+
+    HRESULT Close()
+    {
+        if (closed_) {
+            stand_in::report("closing a command list that is already closed");
+            return E_FAIL;
+        }
+
+        closed_ = true;
+
+        return S_OK;
+    }
+
+    HRESULT Reset(ID3D12CommandAllocator *allocator, ID3D12PipelineState *)
+    {
+        if (!closed_) {
+            stand_in::report("resetting a command list that is still recording");
+            return E_FAIL;
+        }
+
+        if (allocator == nullptr || allocator->type() != GetType()) {
+            stand_in::report("resetting a command list with an allocator of another type");
+            return E_INVALIDARG;
+        }
+
+        allocator_.copy_from(allocator);
+
+        recording_ = stand_in::recording{ };
+        closed_ = false;
+
+        return S_OK;
+    }
+
+    void ResourceBarrier(UINT count, D3D12_RESOURCE_BARRIER const *barriers)
+    {
+        if (!check_recording())
+            return;
+
+        recording_.barriers.insert(std::end(recording_.barriers), barriers, barriers + count);
+        ++recording_.barrier_calls;
+    }
+
+    void CopyBufferRegion(ID3D12Resource *destination, UINT64 destination_offset, ID3D12Resource *source, UINT64 source_offset, UINT64 size)
+    {
+        if (!check_recording())
+            return;
+
+        if (destination_offset + size > destination->GetDesc().Width || source_offset + size > source->GetDesc().Width)
+            stand_in::report("buffer copy out of bounds");
+
+        else recording_.buffer_copies.push_back(stand_in::buffer_copy{destination, destination_offset, source, source_offset, size});
+    }
+
+    void CopyTextureRegion(D3D12_TEXTURE_COPY_LOCATION const *, UINT, UINT, UINT, D3D12_TEXTURE_COPY_LOCATION const *, D3D12_BOX const *)
+    {
+        if (check_recording())
+            ++recording_.texture_copies;
+    }
+
+    void SetDescriptorHeaps(UINT, ID3D12DescriptorHeap *const *)
+    {
+        if (check_recording())
+            ++recording_.descriptor_heap_calls;
+    }
+
+    void SetPipelineState(ID3D12PipelineState *) { check_recording(); }
+
+    void DrawIndexedInstanced(UINT, UINT, UINT, INT, UINT)
+    {
+        if (check_recording())
+            ++recording_.draws;
+    }
+
+    void Dispatch(UINT, UINT, UINT)
+    {
+        if (check_recording())
+            ++recording_.dispatches;
+    }
+
+    bool closed() const noexcept { return closed_; }
+
+    ID3D12CommandAllocator *allocator() const noexcept { return allocator_.get(); }
+
+    stand_in::recording const &recorded() const noexcept { return recording_; }
+
+private:
+
+    winrt::com_ptr<ID3D12CommandAllocator> allocator_;
+
+    stand_in::recording recording_;
+    bool closed_{false};
+
+    bool check_recording()
+    {
+        if (closed_)
+            stand_in::report("recording into a closed command list");
+
+        return !closed_;
+    }
+};
+
+struct ID3D12GraphicsCommandList5 : ID3D12GraphicsCommandList {
+    using ID3D12GraphicsCommandList::ID3D12GraphicsCommandList;
+};
+
+struct ID3D12CommandQueue : IUnknown {
+    explicit ID3D12CommandQueue(D3D12_COMMAND_QUEUE_DESC const &description);
+    ~ID3D12CommandQueue() override;
+
+    D3D12_COMMAND_QUEUE_DESC GetDesc() const noexcept { return description_; }
+
+    HRESULT Signal(ID3D12Fence *fence, UINT64 value);
+    HRESULT Wait(ID3D12Fence *fence, UINT64 value);
+
+    void ExecuteCommandLists(UINT count, ID3D12CommandList *const *command_lists);
+
+    // Operations submitted that the GPU hasn't executed yet.
+    std::size_t pending_operations() const;
+
+    // Every Wait() call made on the queue so far, in order.
+    std::vector<stand_in::queue_wait> issued_waits() const;
+
+private:
+
+    friend class stand_in::gpu;
+
+    struct operation final {
+        enum class kind {
+            execute, signal, wait
+        } type{kind::execute};
+
+        winrt::com_ptr<ID3D12Fence1> fence;
+        UINT64 value{0};
+
+        std::vector<winrt::com_ptr<ID3D12CommandAllocator>> allocators;
+        std::vector<stand_in::buffer_copy> copies;
+    };
+
+    D3D12_COMMAND_QUEUE_DESC description_;
+
+    // Guarded by the GPU's lock.
+    std::deque<operation> operations_;
+    std::vector<stand_in::queue_wait> issued_waits_;
+
+    void push(operation &&value);
+};
+
+namespace stand_in
+{
+    struct gpu_statistics final {
+        std::uint64_t executed_command_lists{0};
+        std::uint64_t signals{0};
+        std::uint64_t waits{0};
+    };
+
+    // The GPU side of every queue. Nothing executes until execute() is called: by a test, by a thread that plays
+    // the GPU (gpu_thread), or, unless disabled, by a CPU wait that would otherwise block. A queue executes its
+    // operations in order and stalls on a wait until the fence reaches the value.
+    class gpu final {
+    public:
+
+        static gpu &instance()
+        {
+            static gpu value;
+            return value;
+        }
+
+        // Runs every queue as far as it can get; returns the number of operations executed.
+        std::size_t execute()
+        {
+            std::lock_guard executing{execution_mutex_};
+
+            std::size_t executed = 0;
+
+            for (auto progress = true; progress; ) {
+                progress = false;
+
+                std::unique_lock lock{mutex_};
+
+                auto const queues = queues_;
+
+                for (auto queue : queues) {
+                    while (!queue->operations_.empty()) {
+                        auto &&operation = queue->operations_.front();
+
+                        if (operation.type == ID3D12CommandQueue::operation::kind::wait) {
+                            if (operation.fence->GetCompletedValue() < operation.value)
+                                break;
+
+                            ++statistics_.waits;
+                        }
+
+                        else if (operation.type == ID3D12CommandQueue::operation::kind::signal) {
+                            operation.fence->complete(operation.value);
+
+                            ++statistics_.signals;
+                        }
+
+                        else {
+                            auto work = std::move(operation);
+                            queue->operations_.pop_front();
+
+                            lock.unlock();
+
+                            run(work);
+
+                            lock.lock();
+
+                            for (auto &&allocator : work.allocators)
+                                --allocator->pending_;
+
+                            statistics_.executed_command_lists += std::size(work.allocators);
+
+                            ++executed;
+                            progress = true;
+
+                            continue;
+                        }
+
+                        queue->operations_.pop_front();
+
+                        ++executed;
+                        progress = true;
+                    }
+                }
+            }
+
+            return executed;
+        }
+
+        // How long the GPU takes for each command list it executes.
+        void set_command_list_cost(std::chrono::nanoseconds cost) noexcept { command_list_cost_.store(cost.count()); }
+
+        // Whether a CPU wait that would block runs the GPU first.
+        void set_execute_on_wait(bool value) noexcept { execute_on_wait_.store(value); }
+
+        gpu_statistics statistics() const
+        {
+            std::lock_guard lock{mutex_};
+
+            return statistics_;
+        }
+
+        // Blocks until the fence reaches the value.
+        void wait(ID3D12Fence1 *const fence, UINT64 value)
+        {
+            while (fence->GetCompletedValue() < value) {
+                if (execute_on_wait_.load() && execute() != 0)
+                    continue;
+
+                std::unique_lock lock{mutex_};
+
+                completion_condition_.wait_for(lock, std::chrono::milliseconds{1}, [fence, value]
+                {
+                    return fence->GetCompletedValue() >= value;
+                });
+            }
+        }
+
+        // Blocks until new work is submitted or a millisecond has passed.
+        void wait_for_work()
+        {
+            std::unique_lock lock{mutex_};
+
+            auto const generation = generation_;
+
+            work_condition_.wait_for(lock, std::chrono::milliseconds{1}, [this, generation] { return generation_ != generation; });
+        }
+
+        void notify()
+        {
+            {
+                std::lock_guard lock{mutex_};
+                ++generation_;
+            }
+
+            work_condition_.notify_all();
+        }
+
+    private:
+
+        friend struct ::ID3D12Fence1;
+        friend struct ::ID3D12CommandQueue;
+
+        mutable std::mutex mutex_;
+        std::mutex execution_mutex_;
+
+        std::condition_variable completion_condition_;
+        std::condition_variable work_condition_;
+
+        std::vector<ID3D12CommandQueue *> queues_;
+
+        std::atomic<std::chrono::nanoseconds::rep> command_list_cost_{0};
+        std::atomic<bool> execute_on_wait_{true};
+
+        std::uint64_t generation_{0};
+
+        gpu_statistics statistics_;
+
+        gpu()
+        {
+            blocking_wait_hook() = []
+            {
+                if (auto &&value = instance(); value.execute_on_wait_.load())
+                    value.execute();
+            };
+        }
+
+        void run(ID3D12CommandQueue::operation const &work)
+        {
+            for (auto &&copy : work.copies)
+                std::memcpy(copy.destination->memory() + copy.destination_offset, copy.source->memory() + copy.source_offset, copy.size);
+
+            if (auto const cost = std::chrono::nanoseconds{command_list_cost_.load()}; cost.count() != 0)
+                std::this_thread::sleep_for(cost * std::size(work.allocators));
+        }
+
+        void attach(ID3D12CommandQueue *const queue)
+        {
+            std::lock_guard lock{mutex_};
+
+            queues_.push_back(queue);
+        }
+
+        void detach(ID3D12CommandQueue *const queue)
+        {
+            std::lock_guard executing{execution_mutex_};
+            std::lock_guard lock{mutex_};
+
+            queues_.erase(std::remove(std::begin(queues_), std::end(queues_), queue), std::end(queues_));
+
+            for (auto &&operation : queue->operations_) {
+                for (auto &&allocator : operation.allocators)
+                    --allocator->pending_;
+            }
+
+            queue->operations_.clear();
+        }
+    };
+
+    // Plays the GPU on a thread of its own, taking 'command_list_cost' for every command list, so that
+    // CPU waits block for real instead of running the GPU themselves.
+    class gpu_thread final {
+    public:
+
+        explicit gpu_thread(std::chrono::nanoseconds command_list_cost = { })
+        {
+            auto &&device = gpu::instance();
+
+            device.set_command_list_cost(command_list_cost);
+            device.set_execute_on_wait(false);
+
+            thread_ = std::thread{[this, &device]
+            {
+                while (!stop_.load()) {
+                    if (device.execute() == 0)
+                        device.wait_for_work();
+                }
+            }};
+        }
+
+        ~gpu_thread()
+        {
+            auto &&device = gpu::instance();
+
+            stop_.store(true);
+            device.notify();
+
+            thread_.join();
+
+            device.set_command_list_cost({ });
+            device.set_execute_on_wait(true);
+        }
+
+        gpu_thread(gpu_thread const &) = delete;
+        gpu_thread &operator=(gpu_thread const &) = delete;
+
+    private:
+
+        std::atomic<bool> stop_{false};
+        std::thread thread_;
+    };
+}
+
+inline HRESULT ID3D12Fence1::SetEventOnCompletion(UINT64 value, HANDLE event)
+{
+    auto &&gpu = stand_in::gpu::instance();
+
+    if (event == nullptr) {
+        gpu.wait(this, value);
+        return S_OK;
+    }
+
+    std::lock_guard lock{gpu.mutex_};
+
+    if (GetCompletedValue() >= value)
+        SetEvent(event);
+
+    else events_.emplace_back(value, event);
+
+    return S_OK;
+}
+
+inline HRESULT ID3D12Fence1::Signal(UINT64 value)
+{
+    auto &&gpu = stand_in::gpu::instance();
+
+    {
+        std::lock_guard lock{gpu.mutex_};
+
+        complete(value);
+    }
+
+    gpu.notify();
+
+    return S_OK;
+}
+
+// Has to be called with the GPU's lock held.
+inline void ID3D12Fence1::complete(UINT64 value)
+{
+    completed_.store(value, std::memory_order_release);
+
+    auto it = std::remove_if(std::begin(events_), std::end(events_), [value] (auto &&entry)
+    {
+        if (entry.first > value)
+            return false;
+
+        SetEvent(entry.second);
+
+        return true;
+    });
+
+    events_.erase(it, std::end(events_));
+
+    stand_in::gpu::instance().completion_condition_.notify_all();
+}
+
+inline ID3D12CommandQueue::ID3D12CommandQueue(D3D12_COMMAND_QUEUE_DESC const &description) : description_{description}
+{
+    stand_in::gpu::instance().attach(this);
+}
+
+inline ID3D12CommandQueue::~ID3D12CommandQueue()
+{
+    stand_in::gpu::instance().detach(this);
+}
+
+inline HRESULT ID3D12CommandQueue::Signal(ID3D12Fence *fence, UINT64 value)
+{
+    operation signal;
+    signal.type = operation::kind::signal;
+    signal.fence.copy_from(static_cast<ID3D12Fence1 *>(fence));
+    signal.value = value;
+
+    push(std::move(signal));
+
+    return S_OK;
+}
+
+inline HRESULT ID3D12CommandQueue::Wait(ID3D12Fence *fence, UINT64 value)
+{
+    operation wait;
+    wait.type = operation::kind::wait;
+    wait.fence.copy_from(static_cast<ID3D12Fence1 *>(fence));
+    wait.value = value;
+
+    {
+        std::lock_guard lock{stand_in::gpu::instance().mutex_};
+
+        issued_waits_.push_back(stand_in::queue_wait{fence, value});
+    }
+
+    push(std::move(wait));
+
+    return S_OK;
+}
+
+inline void ID3D12CommandQueue::ExecuteCommandLists(UINT count, ID3D12CommandList *const *command_lists)
+{
+    operation execute;
+    execute.type = operation::kind::execute;
+
+    for (auto index = 0u; index < count; ++index) {
+        auto const command_list = static_cast<ID3D12GraphicsCommandList *>(command_lists[index]);
+
+        if (!command_list->closed())
+            stand_in::report("executing a command list that is still recording");
+
+        if (command_list->GetType() != description_.Type)
+            stand_in::report("executing a command list on a queue of another type");
+
+        auto &&allocator = execute.allocators.emplace_back();
+        allocator.copy_from(command_list->allocator());
+
+        ++allocator->pending_;
+
+        auto &&copies = command_list->recorded().buffer_copies;
+        execute.copies.insert(std::end(execute.copies), std::begin(copies), std::end(copies));
+    }
+
+    push(std::move(execute));
+}
+
+inline std::size_t ID3D12CommandQueue::pending_operations() const
+{
+    std::lock_guard lock{stand_in::gpu::instance().mutex_};
+
+    return std::size(operations_);
+}
+
+inline std::vector<stand_in::queue_wait> ID3D12CommandQueue::issued_waits() const
+{
+    std::lock_guard lock{stand_in::gpu::instance().mutex_};
+
+    return issued_waits_;
+}
+
+inline void ID3D12CommandQueue::push(operation &&value)
+{
+    auto &&gpu = stand_in::gpu::instance();
+
+    {
+        std::lock_guard lock{gpu.mutex_};
+
+        operations_.push_back(std::move(value));
+    }
+
+    gpu.notify();
+}
+
+namespace stand_in
+{
+    struct device_statistics final {
+        std::atomic<std::uint64_t> fences{0};
+        std::atomic<std::uint64_t> queues{0};
+        std::atomic<std::uint64_t> command_allocators{0};
+        std::atomic<std::uint64_t> command_lists{0};
+        std::atomic<std::uint64_t> descriptor_heaps{0};
+        std::atomic<std::uint64_t> committed_resources{0};
+        std::atomic<std::uint64_t> placed_resources{0};
+        std::atomic<std::uint64_t> heaps{0};
+
+        std::atomic<std::uint64_t> descriptor_copy_calls{0};
+        std::atomic<std::uint64_t> copied_descriptors{0};
+    };
+}
+
+struct ID3D12Device : IUnknown { };
+
+struct ID3D12Device6 : ID3D12Device {
+    UINT GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE type) const noexcept
+    {
+        return type == D3D12_DESCRIPTOR_HEAP_TYPE_DSV ? 8u : 32u;
+    }
+
+    HRESULT CreateDescriptorHeap(D3D12_DESCRIPTOR_HEAP_DESC const *description, GUID, void **heap)
+    {
+        ++statistics_.descriptor_heaps;
+
+        *heap = new ID3D12DescriptorHeap{*description, GetDescriptorHandleIncrementSize(description->Type)};
+
+        return S_OK;
+    }
+
+    void CopyDescriptors(UINT destination_range_count, D3D12_CPU_DESCRIPTOR_HANDLE const *, UINT const *destination_range_sizes,
+                         UINT source_range_count, D3D12_CPU_DESCRIPTOR_HANDLE const *, UINT const *source_range_sizes, D3D12_DESCRIPTOR_HEAP_TYPE)
+    {
+        auto const count_of = [] (UINT range_count, UINT const *sizes)
+        {
+            UINT64 count = 0;
+
+            for (auto index = 0u; index < range_count; ++index)
+                count += sizes != nullptr ? sizes[index] : 1u;
+
+            return count;
+        };
+
+        auto const count = count_of(destination_range_count, destination_range_sizes);
+
+        if (count != count_of(source_range_count, source_range_sizes))
+            stand_in::report("descriptor copy with different source and destination sizes");
+
+        ++statistics_.descriptor_copy_calls;
+        statistics_.copied_descriptors += count;
+    }
+
+    void CopyDescriptorsSimple(UINT count, D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_CPU_DESCRIPTOR_HANDLE, D3D12_DESCRIPTOR_HEAP_TYPE)
+    {
+        ++statistics_.descriptor_copy_calls;
+        statistics_.copied_descriptors += count;
+    }
+
+    HRESULT CreateFence(UINT64 initial_value, D3D12_FENCE_FLAGS, GUID, void **fence)
+    {
+        ++statistics_.fences;
+
+        *fence = new ID3D12Fence1{initial_value};
+
+        return S_OK;
+    }
+
+    HRESULT CreateCommandQueue(D3D12_COMMAND_QUEUE_DESC const *description, GUID, void **queue)
+    {
+        ++statistics_.queues;
+
+        *queue = new ID3D12CommandQueue{*description};
+
+        return S_OK;
+    }
+
+    HRESULT CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE type, GUID, void **allocator)
+    {
+        ++statistics_.command_allocators;
+
+        *allocator = new ID3D12CommandAllocator{type};
+
+        return S_OK;
+    }
+
+    HRESULT CreateCommandList(UINT, D3D12_COMMAND_LIST_TYPE type, ID3D12CommandAllocator *allocator, ID3D12PipelineState *, GUID, void **command_list)
+    {
+        if (allocator == nullptr || allocator->type() != type) {
+            stand_in::report("creating a command list with an allocator of another type");
+            return E_INVALIDARG;
+        }
+
+        ++statistics_.command_lists;
+
+        *command_list = new ID3D12GraphicsCommandList5{type, allocator};
+
+        return S_OK;
+    }
+
+    HRESULT CreateCommittedResource(D3D12_HEAP_PROPERTIES const *heap_properties, D3D12_HEAP_FLAGS, D3D12_RESOURCE_DESC const *description,
+                                    D3D12_RESOURCE_STATES, D3D12_CLEAR_VALUE const *, GUID, void **resource)
+    {
+        ++statistics_.committed_resources;
+
+        *resource = new ID3D12Resource{*description, heap_properties->Type};
+
+        return S_OK;
+    }
+
+    HRESULT CreateHeap(D3D12_HEAP_DESC const *description, GUID, void **heap)
+    {
+        if (description->SizeInBytes % description->Alignment != 0) {
+            stand_in::report("heap size isn't a multiple of its alignment");
+            return E_INVALIDARG;
+        }
+
+        ++statistics_.heaps;
+
+        *heap = new ID3D12Heap{*description};
+
+        return S_OK;
+    }
+
+    HRESULT CreatePlacedResource(ID3D12Heap *heap, UINT64 offset, D3D12_RESOURCE_DESC const *description, D3D12_RESOURCE_STATES,
+                                 D3D12_CLEAR_VALUE const *, GUID, void **resource)
+    {
+        auto const info = GetResourceAllocationInfo(0, 1, description);
+        auto const heap_description = heap->GetDesc();
+
+        if (offset % info.Alignment != 0 || offset + info.SizeInBytes > heap_description.SizeInBytes) {
+            stand_in::report("placed resource is misaligned or doesn't fit its heap");
+            return E_INVALIDARG;
+        }
+
+        ++statistics_.placed_resources;
+
+        *resource = new ID3D12Resource{*description, heap_description.Properties.Type, heap, offset};
+
+        return S_OK;
+    }
+
+    D3D12_RESOURCE_ALLOCATION_INFO GetResourceAllocationInfo(UINT, UINT count, D3D12_RESOURCE_DESC const *descriptions) const noexcept
+    {
+        D3D12_RESOURCE_ALLOCATION_INFO info{0, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT};
+
+        for (auto index = 0u; index < count; ++index) {
+            auto &&description = descriptions[index];
+
+            UINT64 size = 0;
+
+            if (description.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER)
+                size = description.Width;
+
+            else {
+                auto const mip_levels = (std::max)(description.MipLevels, UINT16{1});
+
+                for (auto mip = 0u; mip < mip_levels; ++mip)
+                    size += (std::max)(description.Width >> mip, UINT64{1}) * (std::max)(description.Height >> mip, 1u) * stand_in::bytes_per_pixel(description.Format);
+
+                size *= static_cast<UINT64>(description.DepthOrArraySize) * (std::max)(description.SampleDesc.Count, 1u);
+            }
+
+            if (description.SampleDesc.Count > 1)
+                info.Alignment = D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT;
+
+            info.SizeInBytes = stand_in::align(info.SizeInBytes, info.Alignment) + stand_in::align(size, info.Alignment);
+        }
+
+        return info;
+    }
+
+    HRESULT CheckFeatureSupport(D3D12_FEATURE feature, void *data, UINT size)
+    {
+        if (feature != D3D12_FEATURE_D3D12_OPTIONS || size != sizeof(D3D12_FEATURE_DATA_D3D12_OPTIONS))
+            return E_INVALIDARG;
+
+        static_cast<D3D12_FEATURE_DATA_D3D12_OPTIONS *>(data)->ResourceHeapTier = resource_heap_tier_;
+
+        return S_OK;
+    }
+
+    // Rows are aligned to D3D12_TEXTURE_DATA_PITCH_ALIGNMENT and subresources to D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT.
+    void GetCopyableFootprints(D3D12_RESOURCE_DESC const *description, UINT first_subresource, UINT count, UINT64 base_offset,
+                               D3D12_PLACED_SUBRESOURCE_FOOTPRINT *layouts, UINT *row_counts, UINT64 *row_sizes, UINT64 *total_size) const noexcept
+    {
+        auto const mip_levels = (std::max)(description->MipLevels, UINT16{1});
+
+        auto offset = base_offset;
+        UINT64 end = base_offset;
+
+        for (auto index = 0u; index < count; ++index) {
+            auto const mip = (first_subresource + index) % mip_levels;
+
+            auto const width = static_cast<UINT>((std::max)(description->Width >> mip, UINT64{1}));
+            auto const height = (std::max)(description->Height >> mip, 1u);
+
+            auto const row_size = static_cast<UINT64>(width) * stand_in::bytes_per_pixel(description->Format);
+            auto const row_pitch = static_cast<UINT>(stand_in::align(row_size, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT));
+
+            offset = stand_in::align(offset, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+
+            if (layouts != nullptr)
+                layouts[index] = D3D12_PLACED_SUBRESOURCE_FOOTPRINT{offset, D3D12_SUBRESOURCE_FOOTPRINT{description->Format, width, height, 1, row_pitch}};
+
+            if (row_counts != nullptr)
+                row_counts[index] = height;
+
+            if (row_sizes != nullptr)
+                row_sizes[index] = row_size;
+
+            end = offset + static_cast<UINT64>(row_pitch) * (height - 1) + row_size;
+            offset += static_cast<UINT64>(row_pitch) * height;
+        }
+
+        if (total_size != nullptr)
+            *total_size = end - base_offset;
+    }
+
+    void set_resource_heap_tier(D3D12_RESOURCE_HEAP_TIER tier) noexcept { resource_heap_tier_ = tier; }
+
+    stand_in::device_statistics const &statistics() const noexcept { return statistics_; }
+
+private:
+
+    D3D12_RESOURCE_HEAP_TIER resource_heap_tier_{D3D12_RESOURCE_HEAP_TIER_2};
+
+    stand_in::device_statistics statistics_;
+};
+
+namespace stand_in
+{
+    inline winrt::com_ptr<ID3D12Device6> create_device()
+    {
+        winrt::com_ptr<ID3D12Device6> device;
+        device.attach(new ID3D12Device6);
+
+        return device;
+    }
+}
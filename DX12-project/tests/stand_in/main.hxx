@@ -0,0 +1,25 @@
+#pragma once
+
+// Takes the place of src/main.hxx in the Linux test and benchmark builds: the same standard headers,
+// with the Windows and D3D12 headers replaced by stand-ins.
+
+#include <algorithm>
+#include <array>
+#include <exception>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <span>
+#include <thread>
+#include <vector>
+
+#include <string>
+using namespace std::string_literals;
+
+#include <string_view>
+using namespace std::string_view_literals;
+
+#include <fmt/format.h>
+
+#include "win32.hxx"
+#include "d3d12.hxx"
@@ -0,0 +1,178 @@
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <climits>
+#include <cstdint>
+#include <functional>
+
+#include <poll.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+
+
+// The part of the Win32 API the renderer uses, over Linux primitives. Events are eventfd objects,
+// so waiting on them costs a real kernel round trip like on Windows.
+using BOOL = int;
+using INT = std::int32_t;
+using LONG = std::int32_t;
+using ULONG = std::uint32_t;
+using HRESULT = std::int32_t;
+using UINT = std::uint32_t;
+using UINT8 = std::uint8_t;
+using UINT16 = std::uint16_t;
+using UINT64 = std::uint64_t;
+using DWORD = std::uint32_t;
+using SIZE_T = std::size_t;
+using FLOAT = float;
+using HANDLE = void *;
+
+#define TRUE 1
+#define FALSE 0
+
+#define FAILED(hr) (static_cast<HRESULT>(hr) < 0)
+#define SUCCEEDED(hr) (static_cast<HRESULT>(hr) >= 0)
+
+auto constexpr S_OK = HRESULT{0};
+auto constexpr E_FAIL = static_cast<HRESULT>(0x80004005);
+auto constexpr E_INVALIDARG = static_cast<HRESULT>(0x80070057);
+auto constexpr E_OUTOFMEMORY = static_cast<HRESULT>(0x8007000E);
+
+auto constexpr INFINITE = DWORD{0xFFFFFFFF};
+auto constexpr WAIT_OBJECT_0 = DWORD{0};
+auto constexpr WAIT_TIMEOUT = DWORD{0x102};
+auto constexpr WAIT_FAILED = DWORD{0xFFFFFFFF};
+
+auto constexpr EVENT_ALL_ACCESS = DWORD{0x1F0003};
+
+namespace stand_in
+{
+    struct win32_statistics final {
+        std::atomic<std::uint64_t> events_created{0};
+        std::atomic<std::uint64_t> events_closed{0};
+
+        std::atomic<std::uint64_t> waits{0};
+
+        // Waits that found the event unsignaled.
+        std::atomic<std::uint64_t> blocking_waits{0};
+    };
+
+    inline win32_statistics &win32() noexcept
+    {
+        static win32_statistics statistics;
+        return statistics;
+    }
+
+    // Called before a wait blocks; the D3D12 stand-in runs the GPU from here.
+    inline std::function<void()> &blocking_wait_hook() noexcept
+    {
+        static std::function<void()> hook;
+        return hook;
+    }
+
+    // Makes the next 'count' waits fail as if the handle were invalid.
+    inline std::atomic<std::uint32_t> &injected_wait_failures() noexcept
+    {
+        static std::atomic<std::uint32_t> count{0};
+        return count;
+    }
+
+    inline int descriptor_of(HANDLE handle) noexcept
+    {
+        return static_cast<int>(reinterpret_cast<std::intptr_t>(handle)) - 1;
+    }
+
+    inline HANDLE handle_of(int descriptor) noexcept
+    {
+        return reinterpret_cast<HANDLE>(static_cast<std::intptr_t>(descriptor) + 1);
+    }
+}
+
+// Only auto-reset events: a successful wait consumes the signal.
+inline HANDLE CreateEventEx(void *, wchar_t const *, DWORD, DWORD)
+{
+    auto const descriptor = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+
+    if (descriptor < 0)
+        return nullptr;
+
+    ++stand_in::win32().events_created;
+
+    return stand_in::handle_of(descriptor);
+}
+
+inline BOOL SetEvent(HANDLE handle)
+{
+    std::uint64_t const value = 1;
+
+    return write(stand_in::descriptor_of(handle), &value, sizeof(value)) == sizeof(value) ? TRUE : FALSE;
+}
+
+inline BOOL CloseHandle(HANDLE handle)
+{
+    ++stand_in::win32().events_closed;
+
+    return close(stand_in::descriptor_of(handle)) == 0 ? TRUE : FALSE;
+}
+
+inline DWORD GetLastError()
+{
+    return static_cast<DWORD>(errno);
+}
+
+inline DWORD WaitForSingleObject(HANDLE handle, DWORD milliseconds)
+{
+    ++stand_in::win32().waits;
+
+    if (auto &&failures = stand_in::injected_wait_failures(); failures.load() != 0) {
+        --failures;
+        errno = EBADF;
+
+        return WAIT_FAILED;
+    }
+
+    auto const descriptor = stand_in::descriptor_of(handle);
+
+    auto const try_consume = [descriptor]
+    {
+        std::uint64_t value = 0;
+
+        return read(descriptor, &value, sizeof(value)) == sizeof(value);
+    };
+
+    if (try_consume())
+        return WAIT_OBJECT_0;
+
+    if (errno != EAGAIN)
+        return WAIT_FAILED;
+
+    if (milliseconds == 0)
+        return WAIT_TIMEOUT;
+
+    ++stand_in::win32().blocking_waits;
+
+    if (auto &&hook = stand_in::blocking_wait_hook(); hook)
+        hook();
+
+    auto const timeout = milliseconds == INFINITE ? -1 : static_cast<int>((std::min)(milliseconds, static_cast<DWORD>(INT_MAX)));
+
+    while (true) {
+        if (try_consume())
+            return WAIT_OBJECT_0;
+
+        if (errno != EAGAIN)
+            return WAIT_FAILED;
+
+        pollfd request{descriptor, POLLIN, 0};
+
+        // A timed wait that gets interrupted starts over; good enough for tests.
+        auto const ready = poll(&request, 1, timeout);
+
+        if (ready == 0)
+            return WAIT_TIMEOUT;
+
+        if (ready < 0 && errno != EINTR)
+            return WAIT_FAILED;
+    }
+}
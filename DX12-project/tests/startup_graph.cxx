@@ -0,0 +1,206 @@
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+#include "test.hxx"
+
+#include "platform/startup_graph.hxx"
+
+
+namespace
+{
+    using namespace std::chrono_literals;
+
+    // Stands in for a step of the real startup that takes 'latency', e.g. reading a file or creating a device.
+    std::function<void()> mock_step(std::chrono::milliseconds latency, std::function<void()> body = { })
+    {
+        return [latency, body = std::move(body)]
+        {
+            std::this_thread::sleep_for(latency);
+
+            if (body)
+                body();
+        };
+    }
+
+    // Records the order in which the steps finished.
+    struct completion_log final {
+        std::mutex mutex;
+        std::vector<std::uint32_t> order;
+
+        std::function<void()> record(std::uint32_t step)
+        {
+            return [this, step]
+            {
+                std::lock_guard lock{mutex};
+                order.push_back(step);
+            };
+        }
+
+        std::size_t position(std::uint32_t step)
+        {
+            return static_cast<std::size_t>(std::find(std::begin(order), std::end(order), step) - std::begin(order));
+        }
+    };
+
+    bool overlap(platform::startup_step_timing const &lhs, platform::startup_step_timing const &rhs)
+    {
+        return lhs.start < rhs.start + rhs.duration && rhs.start < lhs.start + lhs.duration;
+    }
+}
+
+TEST(steps_start_after_their_dependencies)
+{
+    platform::job_system jobs{3};
+    platform::startup_graph startup;
+
+    completion_log log;
+
+    // A diamond with a tail: window -> (device, shaders) -> pipelines -> first frame.
+    auto const window = startup.add_step("window", mock_step(2ms, log.record(0)));
+    auto const device = startup.add_step("device", mock_step(5ms, log.record(1)), {window});
+    auto const shaders = startup.add_step("shaders", mock_step(1ms, log.record(2)), {window});
+    auto const pipelines = startup.add_step("pipelines", mock_step(1ms, log.record(3)), {device, shaders});
+    startup.add_step("first frame", mock_step(0ms, log.record(4)), {pipelines});
+
+    auto const timings = startup.run(jobs);
+
+    CHECK(std::size(timings) == 5);
+    CHECK(std::size(log.order) == 5);
+
+    CHECK(log.position(0) < log.position(1));
+    CHECK(log.position(0) < log.position(2));
+    CHECK(log.position(1) < log.position(3));
+    CHECK(log.position(2) < log.position(3));
+    CHECK(log.position(3) < log.position(4));
+
+    // A step starts no earlier than its dependencies end.
+    CHECK(timings[pipelines].start >= timings[device].start + timings[device].duration);
+    CHECK(timings[pipelines].start >= timings[shaders].start + timings[shaders].duration);
+
+    // Only earlier steps can be named.
+    CHECK_THROWS(std::invalid_argument, startup.add_step("cycle", [] { }, {5}));
+}
+
+TEST(pinned_steps_run_on_the_main_thread)
+{
+    platform::job_system jobs{3};
+    platform::startup_graph startup;
+
+    auto const main_thread = std::this_thread::get_id();
+
+    std::atomic<int> pinned_elsewhere{0};
+    std::atomic<int> pinned_runs{0};
+
+    auto const pinned = [&]
+    {
+        ++pinned_runs;
+
+        if (std::this_thread::get_id() != main_thread)
+            ++pinned_elsewhere;
+    };
+
+    // Pinned steps after steps that run on the workers, so that they become ready on a worker thread.
+    auto const loading = startup.add_step("loading", mock_step(2ms));
+    auto const window = startup.add_step("window", pinned, {loading}, platform::startup_thread::main);
+    auto const compiling = startup.add_step("compiling", mock_step(2ms), {window});
+
+    for (auto index = 0; index < 8; ++index)
+        startup.add_step("message loop", mock_step(1ms, pinned), {compiling}, platform::startup_thread::main);
+
+    auto const timings = startup.run(jobs);
+
+    CHECK(pinned_runs.load() == 9);
+    CHECK(pinned_elsewhere.load() == 0);
+
+    // The main thread is the owner, so it is thread 0 of the job system.
+    CHECK(timings[window].thread_index == 0);
+}
+
+TEST(independent_steps_overlap)
+{
+    platform::job_system jobs{4};
+    platform::startup_graph startup;
+
+    auto constexpr kSTEP_NUMBER = 4u;
+
+    for (auto index = 0u; index < kSTEP_NUMBER; ++index)
+        startup.add_step("independent", mock_step(30ms));
+
+    auto const start = std::chrono::steady_clock::now();
+
+    auto const timings = startup.run(jobs);
+
+    auto const elapsed = std::chrono::steady_clock::now() - start;
+
+    // Four workers and the main thread run them side by side rather than one after another.
+    CHECK(elapsed < kSTEP_NUMBER * 30ms);
+
+    auto overlapping = 0;
+
+    for (auto lhs = 0u; lhs < kSTEP_NUMBER; ++lhs) {
+        for (auto rhs = lhs + 1; rhs < kSTEP_NUMBER; ++rhs)
+            overlapping += overlap(timings[lhs], timings[rhs]) ? 1 : 0;
+    }
+
+    CHECK(overlapping > 0);
+}
+
+TEST(a_failing_step_fails_the_run_and_its_dependents_are_skipped)
+{
+    platform::job_system jobs{2};
+    platform::startup_graph startup;
+
+    std::atomic<int> dependents_run{0};
+    std::atomic<bool> independent_run{false};
+
+    auto const failing = startup.add_step("device", mock_step(1ms, [] { throw std::runtime_error{"no adapter"}; }));
+    auto const dependent = startup.add_step("swapchain", [&] { ++dependents_run; }, {failing});
+    startup.add_step("pipelines", [&] { ++dependents_run; }, {dependent});
+    startup.add_step("pinned", [&] { ++dependents_run; }, {dependent}, platform::startup_thread::main);
+
+    // Already running when the device fails; it finishes.
+    startup.add_step("shader cache", mock_step(20ms, [&] { independent_run = true; }));
+
+    CHECK_THROWS(std::runtime_error, startup.run(jobs));
+
+    CHECK(dependents_run.load() == 0);
+    CHECK(independent_run.load());
+
+    // The job system is still usable afterwards.
+    platform::startup_graph next;
+
+    auto ran = false;
+    next.add_step("retry", [&ran] { ran = true; });
+    next.run(jobs);
+
+    CHECK(ran);
+}
+
+TEST(timings_measure_every_step)
+{
+    platform::job_system jobs{2};
+    platform::startup_graph startup;
+
+    auto const slow = startup.add_step("slow", mock_step(20ms));
+    auto const fast = startup.add_step("fast", mock_step(1ms));
+    auto const last = startup.add_step("last", mock_step(5ms), {slow, fast});
+
+    auto const timings = startup.run(jobs);
+
+    CHECK(timings[slow].name == "slow");
+    CHECK(timings[fast].name == "fast");
+    CHECK(timings[last].name == "last");
+
+    CHECK(timings[slow].duration >= 20ms);
+    CHECK(timings[fast].duration >= 1ms);
+    CHECK(timings[last].duration >= 5ms);
+
+    // The last step waited for the slow one.
+    CHECK(timings[last].start >= timings[slow].start + timings[slow].duration);
+
+    for (auto &&timing : timings)
+        CHECK(timing.thread_index < jobs.thread_count());
+}
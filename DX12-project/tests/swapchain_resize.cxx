@@ -0,0 +1,182 @@
+#include <vector>
+
+#include "test.hxx"
+
+#include "main.hxx"
+#include "graphics/frame.hxx"
+#include "graphics/swapchain_resize.hxx"
+
+
+namespace
+{
+    using namespace std::chrono_literals;
+
+    using time_point = graphics::resize_coalescer::time_point;
+
+    auto constexpr kFRAME_PERIOD = std::chrono::nanoseconds{16'666'667};
+
+    auto constexpr kFRAMES_IN_FLIGHT = 3u;
+
+    struct size_event final {
+        time_point time;
+        graphics::extent size;
+    };
+
+    struct replay_result final {
+        std::vector<graphics::extent> resizes;
+
+        graphics::resize_statistics statistics;
+        graphics::extent final_size;
+
+        // Blocking waits issued by the resizes for the frames in flight.
+        std::uint64_t resize_waits{0};
+    };
+
+    // Feeds the events to the coalescer as the window procedure would and polls it at the start of each frame
+    // until 'end'. A resize waits for the frames in flight as resize_swapchain() does, against stand-in fences.
+    // The GPU is a frame behind: the previous frame is still queued when the next one starts, unless 'gpu_idle'.
+    // Frames are skipped while the window is minimized.
+    replay_result replay(graphics::extent initial, std::vector<size_event> const &events, time_point end, bool gpu_idle = false)
+    {
+        auto device = stand_in::create_device();
+        graphics::queue_scheduler queues{device.get()};
+
+        std::vector<graphics::frame_context> frame_contexts(kFRAMES_IN_FLIGHT);
+
+        graphics::resize_coalescer coalescer{initial};
+
+        replay_result result;
+
+        auto next_event = std::begin(events);
+        auto frame_index = 0u;
+
+        for (auto now = time_point{kFRAME_PERIOD}; now <= end; now += kFRAME_PERIOD) {
+            for (; next_event != std::end(events) && next_event->time <= now; ++next_event)
+                coalescer.on_resize(next_event->size, next_event->time);
+
+            if (coalescer.minimized())
+                continue;
+
+            if (gpu_idle)
+                stand_in::gpu::instance().execute();
+
+            if (auto size = coalescer.poll(now); size) {
+                auto const waits = stand_in::win32().blocking_waits.load();
+
+                wait_for_frames_in_flight(frame_contexts, queues);
+
+                result.resize_waits += stand_in::win32().blocking_waits.load() - waits;
+                result.resizes.push_back(*size);
+
+                // Nothing may reference the old buffers any more.
+                for (auto &&frame : frame_contexts)
+                    CHECK(queues.timeline(graphics::queue_type::graphics).is_complete(frame.fence_value));
+            }
+
+            // The GPU finishes the earlier frames while this one is recorded.
+            stand_in::gpu::instance().execute();
+
+            auto &frame = frame_contexts[frame_index];
+
+            queues.timeline(graphics::queue_type::graphics).wait(frame.fence_value);
+            frame.fence_value = queues.signal(graphics::queue_type::graphics).value;
+
+            frame_index = (frame_index + 1) % kFRAMES_IN_FLIGHT;
+        }
+
+        queues.flush();
+
+        result.statistics = coalescer.statistics();
+        result.final_size = coalescer.current();
+
+        return result;
+    }
+
+    // A drag of just over 900 ms from 800x600 to 1258x829 with a mouse reporting every 4 ms; the first event
+    // still has the old size.
+    std::vector<size_event> drag(time_point start)
+    {
+        std::vector<size_event> events;
+
+        for (auto index = 0u; index < 230; ++index)
+            events.push_back({start + index * 4ms, {800 + 2 * index, 600 + index}});
+
+        return events;
+    }
+}
+
+TEST(a_long_drag_resizes_at_the_max_interval_and_ends_at_the_last_size)
+{
+    auto const events = drag(time_point{1010ms});
+
+    auto const result = replay({800, 600}, events, time_point{3s});
+
+    CHECK(result.statistics.events == 230);
+    CHECK(result.final_size == events.back().size);
+    CHECK(result.resizes.back() == events.back().size);
+
+    // The first new size applies at the next frame and the size follows the drag every 6 frames (100 ms)
+    // until 1917 ms; the last event comes at 1926 ms and settles 3 frames later: 230 events, 11 resizes.
+    CHECK(result.statistics.resizes == 11);
+    CHECK(std::size(result.resizes) == 11);
+
+    // The previous frame is always still in flight, so each resize blocks once, rather than once per event.
+    CHECK(result.resize_waits == 11);
+    CHECK(result.resizes[9] != events.back().size);
+
+    for (auto index = 1u; index < std::size(result.resizes); ++index)
+        CHECK(result.resizes[index].width > result.resizes[index - 1].width);
+}
+
+TEST(a_burst_shorter_than_the_settle_time_resizes_once)
+{
+    std::vector<size_event> events;
+
+    // Maximizing: a few events within a frame, the last one is the size that counts.
+    for (auto index = 0u; index < 5; ++index)
+        events.push_back({time_point{1s + index * 1ms}, {1024 + 100 * index, 768 + 50 * index}});
+
+    auto const result = replay({1024, 768}, events, time_point{2s});
+
+    CHECK(result.statistics.resizes == 1);
+    CHECK(result.resize_waits == 1);
+    CHECK(result.final_size == (graphics::extent{1424, 968}));
+}
+
+TEST(minimizing_and_restoring_to_the_same_size_does_not_resize)
+{
+    auto const events = std::vector<size_event>{
+        {time_point{1s}, {0, 0}},
+        {time_point{2s}, {1280, 720}}
+    };
+
+    auto const result = replay({1280, 720}, events, time_point{3s});
+
+    CHECK(result.statistics.events == 2);
+    CHECK(result.statistics.resizes == 0);
+    CHECK(result.resize_waits == 0);
+    CHECK(result.final_size == (graphics::extent{1280, 720}));
+}
+
+TEST(a_drag_back_to_the_start_size_ends_at_the_start_size)
+{
+    auto events = drag(time_point{1s});
+
+    events.push_back({events.back().time + 4ms, {800, 600}});
+
+    auto const result = replay({800, 600}, events, time_point{3s});
+
+    CHECK(result.final_size == (graphics::extent{800, 600}));
+    CHECK(result.resizes.back() == (graphics::extent{800, 600}));
+}
+
+TEST(resizes_dont_block_once_the_gpu_has_caught_up)
+{
+    auto const events = drag(time_point{1010ms});
+
+    auto const result = replay({800, 600}, events, time_point{3s}, true);
+
+    CHECK(result.statistics.resizes == 11);
+    CHECK(result.resize_waits == 0);
+    CHECK(result.final_size == events.back().size);
+}
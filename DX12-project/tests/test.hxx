@@ -0,0 +1,81 @@
+#pragma once
+
+#include <cstdlib>
+#include <functional>
+#include <iostream>
+#include <string_view>
+#include <vector>
+
+
+// A test file registers its cases with TEST and the main() below runs all of them; a failed CHECK
+// reports the expression and the case carries on, so one run lists every failure.
+namespace test
+{
+    struct test_case final {
+        std::string_view name;
+        std::function<void()> body;
+    };
+
+    inline std::vector<test_case> &cases()
+    {
+        static std::vector<test_case> value;
+        return value;
+    }
+
+    inline int &failures()
+    {
+        static int value = 0;
+        return value;
+    }
+
+    struct registrar final {
+        registrar(std::string_view name, std::function<void()> body)
+        {
+            cases().push_back(test_case{name, std::move(body)});
+        }
+    };
+
+    inline void fail(std::string_view expression, char const *file, int line)
+    {
+        std::cerr << file << ':' << line << ": check failed: " << expression << '\n';
+        ++failures();
+    }
+}
+
+#define TEST_CONCATENATE_(a, b) a##b
+#define TEST_CONCATENATE(a, b) TEST_CONCATENATE_(a, b)
+
+#define TEST(name) \
+    static void name(); \
+    static test::registrar TEST_CONCATENATE(name, _registrar){#name, name}; \
+    static void name()
+
+#define CHECK(expression) \
+    do { if (!(expression)) test::fail(#expression, __FILE__, __LINE__); } while (false)
+
+#define CHECK_THROWS(exception_type, expression) \
+    do { \
+        auto thrown = false; \
+        try { (void)(expression); } catch (exception_type const &) { thrown = true; } \
+        if (!thrown) test::fail("throws " #exception_type ": " #expression, __FILE__, __LINE__); \
+    } while (false)
+
+int main()
+{
+    for (auto &&test_case : test::cases()) {
+        auto const failures = test::failures();
+
+        try {
+            test_case.body();
+        }
+
+        catch (std::exception const &exception) {
+            std::cerr << test_case.name << ": unexpected exception: " << exception.what() << '\n';
+            ++test::failures();
+        }
+
+        std::cout << (test::failures() == failures ? "passed: " : "FAILED: ") << test_case.name << '\n';
+    }
+
+    return test::failures() == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
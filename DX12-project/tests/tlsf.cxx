@@ -0,0 +1,135 @@
+#include <random>
+
+#include "test.hxx"
+
+#include "graphics/tlsf.hxx"
+
+
+namespace
+{
+    bool overlaps(graphics::tlsf_allocator::allocation const &lhs, graphics::tlsf_allocator::allocation const &rhs)
+    {
+        return lhs.offset < rhs.offset + rhs.size && rhs.offset < lhs.offset + lhs.size;
+    }
+}
+
+TEST(allocations_fill_the_range_and_coalesce)
+{
+    graphics::tlsf_allocator allocator{1 << 20, 256};
+
+    std::vector<graphics::tlsf_allocator::allocation> allocations;
+
+    for (auto index = 0; index < 16; ++index) {
+        auto const allocation = allocator.allocate(1 << 16, 256);
+
+        CHECK(allocation.valid());
+        allocations.push_back(allocation);
+    }
+
+    // Full.
+    CHECK(!allocator.allocate(1, 1).valid());
+    CHECK(allocator.statistics().used == allocator.size());
+
+    // Free every other block: half the space is free, but in 64K pieces.
+    for (auto index = 0u; index < std::size(allocations); index += 2)
+        allocator.free(allocations[index]);
+
+    auto statistics = allocator.statistics();
+
+    CHECK(statistics.largest_free_block == 1 << 16);
+    CHECK(statistics.free_block_count == 8);
+    CHECK(statistics.fragmentation() > .8f);
+    CHECK(!allocator.allocate(1 << 17, 256).valid());
+
+    for (auto index = 1u; index < std::size(allocations); index += 2)
+        allocator.free(allocations[index]);
+
+    statistics = allocator.statistics();
+
+    CHECK(statistics.free_block_count == 1);
+    CHECK(statistics.largest_free_block == allocator.size());
+    CHECK(statistics.fragmentation() == 0.f);
+}
+
+TEST(sizes_and_offsets_follow_the_granularity_and_alignment)
+{
+    graphics::tlsf_allocator allocator{(1 << 20) + 50, 64};
+
+    CHECK(allocator.size() == 1 << 20);
+    CHECK(!allocator.allocate(0, 64).valid());
+
+    auto const small = allocator.allocate(1, 1);
+    auto const aligned = allocator.allocate(1000, 4096);
+
+    CHECK(small.size == 64);
+    CHECK(aligned.offset % 4096 == 0);
+    CHECK(aligned.size >= 1000);
+    CHECK(!overlaps(small, aligned));
+
+    CHECK(!allocator.allocate((1 << 20) + 1, 64).valid());
+}
+
+// Random allocations and frees over allocators of random size and granularity. Every allocation has to be aligned,
+// large enough, inside the range and disjoint from every live one; the used size has to match the live allocations,
+// and freeing everything has to coalesce back into a single block.
+TEST(randomized_allocations_and_frees)
+{
+    std::mt19937_64 generator{1};
+
+    for (auto round = 0; round < 200; ++round) {
+        auto const size = generator() % (1 << 20) + 4096;
+        auto const granularity = std::uint64_t{1} << (generator() % 8);
+
+        graphics::tlsf_allocator allocator{size, granularity};
+
+        std::vector<graphics::tlsf_allocator::allocation> live;
+
+        auto failures = 0;
+
+        for (auto operation = 0; operation < 2000; ++operation) {
+            if (live.empty() || generator() % 2 == 0) {
+                auto const requested = generator() % (size / 8) + 1;
+                auto const alignment = std::uint64_t{1} << (generator() % 12);
+
+                auto const allocation = allocator.allocate(requested, alignment);
+
+                if (!allocation.valid())
+                    continue;
+
+                if (allocation.offset % alignment != 0 || allocation.size < requested || allocation.offset + allocation.size > allocator.size())
+                    ++failures;
+
+                for (auto &&other : live) {
+                    if (overlaps(allocation, other))
+                        ++failures;
+                }
+
+                live.push_back(allocation);
+            }
+
+            else {
+                auto const index = generator() % std::size(live);
+
+                allocator.free(live[index]);
+                live.erase(std::begin(live) + static_cast<std::ptrdiff_t>(index));
+            }
+
+            std::uint64_t used = 0;
+
+            for (auto &&allocation : live)
+                used += allocation.size;
+
+            if (allocator.statistics().used != used || allocator.statistics().allocation_count != std::size(live))
+                ++failures;
+        }
+
+        for (auto &&allocation : live)
+            allocator.free(allocation);
+
+        auto const statistics = allocator.statistics();
+
+        CHECK(failures == 0);
+        CHECK(statistics.free_block_count == 1);
+        CHECK(statistics.largest_free_block == allocator.size());
+    }
+}
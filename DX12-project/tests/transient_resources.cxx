@@ -0,0 +1,395 @@
+#include <random>
+
+#include "test.hxx"
+
+#include "main.hxx"
+#include "graphics/aliasing.hxx"
+#include "graphics/command_pool.hxx"
+#include "graphics/frame.hxx"
+#include "graphics/memory.hxx"
+#include "graphics/render_graph.hxx"
+#include "graphics/render_graph_executor.hxx"
+#include "graphics/transient.hxx"
+
+
+namespace
+{
+    bool lifetimes_intersect(graphics::aliasing_request const &lhs, graphics::aliasing_request const &rhs)
+    {
+        return lhs.first_pass <= rhs.last_pass && rhs.first_pass <= lhs.last_pass;
+    }
+
+    bool ranges_overlap(std::uint64_t lhs_offset, std::uint64_t lhs_size, std::uint64_t rhs_offset, std::uint64_t rhs_size)
+    {
+        return lhs_offset < rhs_offset + rhs_size && rhs_offset < lhs_offset + lhs_size;
+    }
+
+    auto render_target(DXGI_FORMAT format, D3D12_RESOURCE_FLAGS flags = D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET)
+    {
+        return CD3DX12_RESOURCE_DESC::Tex2D(format, 1920, 1080, 1, 1, 1, 0, flags);
+    }
+}
+
+TEST(disjoint_lifetimes_share_memory)
+{
+    auto constexpr kSIZE = 8ull << 20;
+
+    // G-buffer [0, 1], lighting target [1, 4], two bloom targets [2, 3] and [3, 4].
+    auto const requests = std::array{
+        graphics::aliasing_request{kSIZE, 65536, 0, 1},
+        graphics::aliasing_request{kSIZE, 65536, 0, 1},
+        graphics::aliasing_request{kSIZE, 65536, 1, 4},
+        graphics::aliasing_request{kSIZE, 65536, 2, 3},
+        graphics::aliasing_request{kSIZE, 65536, 3, 4}
+    };
+
+    auto const layout = graphics::pack_aliased_resources(requests);
+
+    CHECK(layout.unaliased_size == 5 * kSIZE);
+    CHECK(layout.size == 3 * kSIZE);
+    CHECK(layout.bytes_saved() == 2 * kSIZE);
+
+    // Both bloom targets take over G-buffer memory.
+    CHECK(layout.placements[3].predecessor == 0 || layout.placements[3].predecessor == 1);
+    CHECK(layout.placements[4].predecessor == 0 || layout.placements[4].predecessor == 1);
+
+    // The G-buffer takes its memory back from the bloom targets of the previous frame.
+    CHECK(layout.placements[0].predecessor == 3 || layout.placements[0].predecessor == 4);
+    CHECK(layout.placements[1].predecessor == 3 || layout.placements[1].predecessor == 4);
+    CHECK(layout.placements[0].predecessor != layout.placements[1].predecessor);
+
+    // The lighting target shares its memory with nothing.
+    CHECK(layout.placements[2].predecessor == graphics::kNO_ALIASED_PREDECESSOR);
+}
+
+TEST(randomized_pass_lists_never_overlap_live_resources)
+{
+    std::mt19937 generator{11};
+
+    for (auto round = 0; round < 500; ++round) {
+        auto const pass_count = std::uniform_int_distribution<std::uint32_t>{1, 12}(generator);
+        auto const resource_count = std::uniform_int_distribution<std::uint32_t>{1, 24}(generator);
+
+        std::vector<graphics::aliasing_request> requests;
+
+        for (auto index = 0u; index < resource_count; ++index) {
+            auto first = std::uniform_int_distribution<std::uint32_t>{0, pass_count - 1}(generator);
+            auto last = std::uniform_int_distribution<std::uint32_t>{0, pass_count - 1}(generator);
+
+            if (first > last)
+                std::swap(first, last);
+
+            auto const size = std::uniform_int_distribution<std::uint64_t>{1, 64}(generator) << 16;
+            auto const alignment = std::uniform_int_distribution<int>{0, 3}(generator) == 0 ? 4ull << 20 : 65536ull;
+
+            requests.push_back(graphics::aliasing_request{size, alignment, first, last});
+        }
+
+        auto const layout = graphics::pack_aliased_resources(requests);
+
+        auto failures = 0;
+        std::uint64_t total = 0;
+
+        for (auto i = 0u; i < resource_count; ++i) {
+            auto &&placement = layout.placements[i];
+
+            total += requests[i].size;
+
+            if (placement.offset % requests[i].alignment != 0 || placement.offset + requests[i].size > layout.size)
+                ++failures;
+
+            for (auto j = i + 1; j < resource_count; ++j) {
+                if (lifetimes_intersect(requests[i], requests[j]) &&
+                    ranges_overlap(placement.offset, requests[i].size, layout.placements[j].offset, requests[j].size))
+                    ++failures;
+            }
+
+            // The predecessor overlaps in memory and was done before the resource started, in this frame or,
+            // if nothing in this frame was, in the previous one. Every resource that overlaps has one.
+            auto overlapping = false;
+            auto earlier = false;
+
+            for (auto j = 0u; j < resource_count; ++j) {
+                if (j != i && ranges_overlap(placement.offset, requests[i].size, layout.placements[j].offset, requests[j].size)) {
+                    overlapping = true;
+                    earlier = earlier || requests[j].last_pass < requests[i].first_pass;
+                }
+            }
+
+            if (auto const predecessor = placement.predecessor; predecessor != graphics::kNO_ALIASED_PREDECESSOR) {
+                if (predecessor == i || (requests[predecessor].last_pass >= requests[i].first_pass) == earlier ||
+                    !ranges_overlap(placement.offset, requests[i].size, layout.placements[predecessor].offset, requests[predecessor].size))
+                    ++failures;
+            }
+
+            else if (overlapping)
+                ++failures;
+        }
+
+        CHECK(failures == 0);
+        CHECK(layout.unaliased_size >= total);
+        CHECK(layout.size <= layout.unaliased_size);
+    }
+}
+
+// A deferred frame through the render graph: the compiled lifetimes lay the transient targets out, and executing
+// the graph records each aliasing barrier right before the pass that first uses the memory.
+TEST(compiled_frame_records_aliasing_barriers)
+{
+    using graphics::resource_access;
+
+    auto device = stand_in::create_device();
+
+    graphics::resource_state_registry resource_states;
+    graphics::queue_scheduler queues{device.get()};
+    graphics::command_pool command_pool{device.get()};
+    graphics::memory_allocator memory_allocator{device.get()};
+    graphics::transient_resource_pool transient_resources{device.get(), memory_allocator};
+
+    auto frame_contexts = create_frame_contexts(1, resource_states);
+    auto &&frame = frame_contexts.front();
+
+    begin_command_lists(frame, command_pool, D3D12_COMMAND_LIST_TYPE_DIRECT);
+
+    // Aliasing barriers recorded by the time each pass runs.
+    std::vector<std::size_t> recorded_aliasing_barriers;
+
+    auto const record = [&frame, &recorded_aliasing_barriers]
+    {
+        auto &&barriers = static_cast<ID3D12GraphicsCommandList *>(frame.current_command_list)->recorded().barriers;
+
+        recorded_aliasing_barriers.push_back(static_cast<std::size_t>(std::count_if(std::begin(barriers), std::end(barriers), [] (auto &&barrier)
+        {
+            return barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_ALIASING;
+        })));
+    };
+
+    graphics::render_graph graph;
+
+    auto const back_buffer = graph.import_resource("back buffer"sv, resource_access::present, resource_access::present);
+
+    auto const albedo = graph.create_resource("albedo"sv);
+    auto const normals = graph.create_resource("normals"sv);
+    auto const depth = graph.create_resource("depth"sv);
+    auto const lit = graph.create_resource("lit"sv);
+    auto const bloom_down = graph.create_resource("bloom down"sv);
+    auto const bloom_up = graph.create_resource("bloom up"sv);
+
+    auto const gbuffer_pass = graph.add_pass("g-buffer"sv, graphics::queue_type::graphics, record);
+    graph.write(gbuffer_pass, albedo, resource_access::render_target);
+    graph.write(gbuffer_pass, normals, resource_access::render_target);
+    graph.write(gbuffer_pass, depth, resource_access::depth_write);
+
+    auto const lighting_pass = graph.add_pass("lighting"sv, graphics::queue_type::graphics, record);
+    graph.read(lighting_pass, albedo, resource_access::shader_read);
+    graph.read(lighting_pass, normals, resource_access::shader_read);
+    graph.read(lighting_pass, depth, resource_access::shader_read);
+    graph.write(lighting_pass, lit, resource_access::render_target);
+
+    auto const bloom_down_pass = graph.add_pass("bloom down"sv, graphics::queue_type::graphics, record);
+    graph.read(bloom_down_pass, lit, resource_access::shader_read);
+    graph.write(bloom_down_pass, bloom_down, resource_access::render_target);
+
+    auto const bloom_up_pass = graph.add_pass("bloom up"sv, graphics::queue_type::graphics, record);
+    graph.read(bloom_up_pass, bloom_down, resource_access::shader_read);
+    graph.write(bloom_up_pass, bloom_up, resource_access::render_target);
+
+    auto const tonemap_pass = graph.add_pass("tonemap"sv, graphics::queue_type::graphics, record);
+    graph.read(tonemap_pass, lit, resource_access::shader_read);
+    graph.read(tonemap_pass, bloom_up, resource_access::shader_read);
+    graph.write(tonemap_pass, back_buffer, resource_access::render_target);
+
+    graphics::render_graph_compiler compiler;
+    auto &&compiled = compiler.compile(graph);
+
+    CHECK(std::size(compiled.order) == 5);
+
+    auto const declare = [&] (std::uint32_t resource, D3D12_RESOURCE_DESC const &description, D3D12_RESOURCE_STATES state)
+    {
+        auto const lifetime = compiled.lifetimes.at(resource);
+
+        return transient_resources.declare(description, lifetime.first, lifetime.last, state);
+    };
+
+    auto const targets = std::array{
+        std::pair{albedo, declare(albedo, render_target(DXGI_FORMAT_R8G8B8A8_UNORM), D3D12_RESOURCE_STATE_RENDER_TARGET)},
+        std::pair{normals, declare(normals, render_target(DXGI_FORMAT_R8G8B8A8_UNORM), D3D12_RESOURCE_STATE_RENDER_TARGET)},
+        std::pair{depth, declare(depth, render_target(DXGI_FORMAT_D32_FLOAT, D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL), D3D12_RESOURCE_STATE_DEPTH_WRITE)},
+        std::pair{lit, declare(lit, render_target(DXGI_FORMAT_R16G16B16A16_FLOAT), D3D12_RESOURCE_STATE_RENDER_TARGET)},
+        std::pair{bloom_down, declare(bloom_down, render_target(DXGI_FORMAT_R8G8B8A8_UNORM), D3D12_RESOURCE_STATE_RENDER_TARGET)},
+        std::pair{bloom_up, declare(bloom_up, render_target(DXGI_FORMAT_R8G8B8A8_UNORM), D3D12_RESOURCE_STATE_RENDER_TARGET)}
+    };
+
+    transient_resources.build();
+
+    // The bloom targets fit into G-buffer memory.
+    auto const target_size = device->GetResourceAllocationInfo(0, 1, &static_cast<D3D12_RESOURCE_DESC const &>(render_target(DXGI_FORMAT_R8G8B8A8_UNORM))).SizeInBytes;
+
+    CHECK(transient_resources.bytes_saved() >= 2 * target_size);
+    CHECK(transient_resources.heap_size() + transient_resources.bytes_saved() > transient_resources.heap_size());
+
+    std::vector<ID3D12Resource *> resources(std::size(graph.resources()), nullptr);
+
+    auto back_buffer_resource = winrt::com_ptr<ID3D12Resource>{ };
+    back_buffer_resource.attach(new ID3D12Resource{render_target(DXGI_FORMAT_R8G8B8A8_UNORM), D3D12_HEAP_TYPE_DEFAULT});
+
+    resources[back_buffer] = back_buffer_resource.get();
+    resource_states.register_resource(back_buffer_resource.get(), 1, D3D12_RESOURCE_STATE_PRESENT);
+
+    for (auto [resource, id] : targets) {
+        resources[resource] = transient_resources.resource(id);
+        resource_states.register_resource(resources[resource], 1, resource == depth ? D3D12_RESOURCE_STATE_DEPTH_WRITE : D3D12_RESOURCE_STATE_RENDER_TARGET);
+    }
+
+    execute_render_graph(graph, compiled, frame, resources, transient_resources);
+
+    CHECK(std::size(recorded_aliasing_barriers) == 5);
+
+    std::size_t expected = 0;
+    std::size_t total = 0;
+
+    for (auto position = 0u; position < std::size(compiled.order); ++position) {
+        auto const barriers = transient_resources.aliasing_barriers(position);
+
+        expected += std::size(barriers);
+
+        // Every barrier hands memory over to a resource whose lifetime starts at this pass.
+        for (auto &&barrier : barriers) {
+            auto const after = std::find(std::begin(resources), std::end(resources), barrier.Aliasing.pResourceAfter);
+
+            CHECK(after != std::end(resources));
+            CHECK(compiled.lifetimes[static_cast<std::uint32_t>(after - std::begin(resources))].first == position);
+        }
+
+        if (position < std::size(recorded_aliasing_barriers))
+            CHECK(recorded_aliasing_barriers[position] == expected);
+
+        total += std::size(barriers);
+    }
+
+    CHECK(total >= 2);
+
+    CHECK(stand_in::debug_layer::instance().messages().empty());
+}
+
+// The placed resources are reused every frame, so the first resource in a range takes it back from the last one
+// of the previous frame: A at pass 0 of the second frame follows B, which used the memory at passes 2-3 of the first.
+TEST(consecutive_frames_hand_memory_back_to_the_first_resource)
+{
+    using graphics::resource_access;
+
+    auto device = stand_in::create_device();
+
+    graphics::resource_state_registry resource_states;
+    graphics::queue_scheduler queues{device.get()};
+    graphics::command_pool command_pool{device.get()};
+    graphics::memory_allocator memory_allocator{device.get()};
+    graphics::transient_resource_pool transient_resources{device.get(), memory_allocator};
+
+    auto frame_contexts = create_frame_contexts(2, resource_states);
+
+    graphics::frame_context *frame = nullptr;
+
+    // Aliasing barriers recorded by the time pass 0 runs, per frame.
+    std::vector<std::vector<D3D12_RESOURCE_ALIASING_BARRIER>> first_pass_barriers;
+
+    auto const record_first_pass = [&frame, &first_pass_barriers]
+    {
+        auto &&barriers = static_cast<ID3D12GraphicsCommandList *>(frame->current_command_list)->recorded().barriers;
+
+        auto &&aliasing = first_pass_barriers.emplace_back();
+
+        for (auto &&barrier : barriers) {
+            if (barrier.Type == D3D12_RESOURCE_BARRIER_TYPE_ALIASING)
+                aliasing.push_back(barrier.Aliasing);
+        }
+    };
+
+    graphics::render_graph graph;
+
+    auto const back_buffer = graph.import_resource("back buffer"sv, resource_access::present, resource_access::present);
+    auto const history = graph.import_resource("history"sv, resource_access::shader_read, resource_access::shader_read);
+
+    auto const a = graph.create_resource("a"sv);
+    auto const b = graph.create_resource("b"sv);
+
+    auto const write_a = graph.add_pass("write a"sv, graphics::queue_type::graphics, record_first_pass);
+    graph.write(write_a, a, resource_access::render_target);
+
+    auto const read_a = graph.add_pass("read a"sv, graphics::queue_type::graphics);
+    graph.read(read_a, a, resource_access::shader_read);
+    graph.write(read_a, history, resource_access::render_target);
+
+    auto const write_b = graph.add_pass("write b"sv, graphics::queue_type::graphics);
+    graph.read(write_b, history, resource_access::shader_read);
+    graph.write(write_b, b, resource_access::render_target);
+
+    auto const read_b = graph.add_pass("read b"sv, graphics::queue_type::graphics);
+    graph.read(read_b, b, resource_access::shader_read);
+    graph.write(read_b, back_buffer, resource_access::render_target);
+
+    graphics::render_graph_compiler compiler;
+    auto &&compiled = compiler.compile(graph);
+
+    CHECK(std::size(compiled.order) == 4);
+    CHECK(compiled.lifetimes.at(a).first == 0 && compiled.lifetimes.at(a).last == 1);
+    CHECK(compiled.lifetimes.at(b).first == 2 && compiled.lifetimes.at(b).last == 3);
+
+    auto const description = render_target(DXGI_FORMAT_R8G8B8A8_UNORM);
+
+    auto const a_id = transient_resources.declare(description, 0, 1, D3D12_RESOURCE_STATE_RENDER_TARGET);
+    auto const b_id = transient_resources.declare(description, 2, 3, D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+    transient_resources.build();
+
+    CHECK(transient_resources.bytes_saved() > 0);
+
+    std::vector<winrt::com_ptr<ID3D12Resource>> imported;
+
+    std::vector<ID3D12Resource *> resources(std::size(graph.resources()), nullptr);
+
+    for (auto [resource, state] : {std::pair{back_buffer, D3D12_RESOURCE_STATE_PRESENT}, std::pair{history, D3D12_RESOURCE_STATE_ALL_SHADER_RESOURCE}}) {
+        imported.emplace_back().attach(new ID3D12Resource{description, D3D12_HEAP_TYPE_DEFAULT});
+
+        resources[resource] = imported.back().get();
+        resource_states.register_resource(resources[resource], 1, state);
+    }
+
+    resources[a] = transient_resources.resource(a_id);
+    resources[b] = transient_resources.resource(b_id);
+
+    for (auto resource : {resources[a], resources[b]})
+        resource_states.register_resource(resource, 1, D3D12_RESOURCE_STATE_RENDER_TARGET);
+
+    for (auto &&context : frame_contexts) {
+        frame = &context;
+
+        begin_command_lists(context, command_pool, D3D12_COMMAND_LIST_TYPE_DIRECT);
+
+        execute_render_graph(graph, compiled, context, resources, transient_resources);
+
+        context.fence_value = submit_command_lists(context, command_pool, queues, graphics::queue_type::graphics);
+    }
+
+    queues.flush();
+
+    CHECK(std::size(first_pass_barriers) == 2);
+
+    // B takes the memory over from A within the frame; A takes it back at pass 0 of the next one.
+    auto const a_after_b = [&resources, a, b] (auto &&barriers)
+    {
+        return std::any_of(std::begin(barriers), std::end(barriers), [&resources, a, b] (auto &&barrier)
+        {
+            return barrier.pResourceBefore == resources[b] && barrier.pResourceAfter == resources[a];
+        });
+    };
+
+    CHECK(a_after_b(first_pass_barriers[1]));
+
+    auto const b_barriers = transient_resources.aliasing_barriers(2);
+
+    CHECK(std::size(b_barriers) == 1);
+    CHECK(b_barriers[0].Aliasing.pResourceBefore == resources[a] && b_barriers[0].Aliasing.pResourceAfter == resources[b]);
+
+    CHECK(stand_in::debug_layer::instance().messages().empty());
+}
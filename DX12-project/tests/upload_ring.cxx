@@ -0,0 +1,193 @@
+#include <random>
+
+#include "test.hxx"
+
+#include "main.hxx"
+#include "graphics/queue.hxx"
+#include "graphics/upload.hxx"
+
+
+namespace
+{
+    struct fixture final {
+        winrt::com_ptr<ID3D12Device6> device{stand_in::create_device()};
+        graphics::queue_scheduler queues{device.get()};
+
+        auto &timeline() { return queues.timeline(graphics::queue_type::graphics); }
+
+        UINT64 submit_frame() { return queues.submit(graphics::queue_type::graphics, { }).value; }
+
+        ~fixture() { queues.flush(); }
+    };
+
+    struct stalled_gpu final {
+        stalled_gpu() { stand_in::gpu::instance().set_execute_on_wait(false); }
+        ~stalled_gpu() { stand_in::gpu::instance().set_execute_on_wait(true); }
+    };
+
+    struct live_allocation final {
+        ID3D12Resource *resource{nullptr};
+
+        UINT64 offset{0};
+        UINT64 size{0};
+
+        UINT64 fence_value{0};
+    };
+}
+
+TEST(allocations_are_aligned_bumps)
+{
+    fixture fixture;
+    graphics::upload_ring ring{fixture.device.get(), fixture.timeline(), 1 << 16};
+
+    auto const first = ring.allocate(100);
+    auto const second = ring.allocate(100);
+    auto const third = ring.allocate(16, 16);
+    auto const fourth = ring.allocate(4096, 512);
+
+    CHECK(first.offset == 0);
+    CHECK(second.offset == 256);
+    CHECK(third.offset == 368);
+    CHECK(fourth.offset == 512);
+
+    for (auto &&allocation : {first, second, third, fourth}) {
+        CHECK(allocation.cpu_address - first.cpu_address == static_cast<std::ptrdiff_t>(allocation.offset));
+        CHECK(allocation.gpu_address - first.gpu_address == allocation.offset);
+        CHECK(allocation.resource == first.resource);
+    }
+
+    // The ring is persistently mapped, so the memory can be written without any further calls.
+    std::memset(fourth.cpu_address, 0xab, fourth.size);
+
+    CHECK(ring.occupancy() == 512 + 4096);
+}
+
+TEST(space_is_retired_by_fence_value)
+{
+    fixture fixture;
+    stalled_gpu stalled;
+
+    graphics::upload_ring ring{fixture.device.get(), fixture.timeline(), 1 << 16, false};
+
+    (void)ring.allocate(40'000);
+    ring.end_frame(fixture.submit_frame());
+
+    CHECK(ring.occupancy() == 40'000);
+
+    // The GPU hasn't finished the frame, so the rest of the lap is free but the start of the buffer isn't.
+    (void)ring.allocate(20'000);
+    CHECK(ring.occupancy() == 60'192);
+
+    stand_in::gpu::instance().execute();
+
+    // The next allocation doesn't fit the lap; it wraps to the start of the buffer, which the first frame released.
+    auto const wrapped = ring.allocate(20'000);
+
+    CHECK(wrapped.offset == 0);
+    CHECK(ring.overflow_page_number() == 0);
+}
+
+TEST(overflow_pages_live_until_the_frame_completes)
+{
+    fixture fixture;
+    stalled_gpu stalled;
+
+    graphics::upload_ring ring{fixture.device.get(), fixture.timeline(), 1 << 16};
+
+    (void)ring.allocate(60'000);
+    ring.end_frame(fixture.submit_frame());
+
+    // The ring is full and the frame is still in flight.
+    auto const spilled = ring.allocate(10'000);
+
+    CHECK(ring.overflow_page_number() == 1);
+    CHECK(spilled.resource != nullptr);
+    CHECK(spilled.offset % D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT == 0);
+
+    // Larger than the whole ring.
+    auto const oversized = ring.allocate(1 << 17);
+
+    CHECK(oversized.size == 1 << 17);
+    CHECK(oversized.resource->GetDesc().Width >= 1 << 17);
+
+    ring.end_frame(fixture.submit_frame());
+
+    stand_in::gpu::instance().execute();
+
+    // Both frames are complete: the pages are released and the ring has room again.
+    auto const reused = ring.allocate(1 << 15);
+
+    CHECK(ring.overflow_page_number() == 0);
+    CHECK(reused.offset == 0);
+    CHECK(stand_in::debug_layer::instance().messages().empty());
+}
+
+TEST(randomized_frames_never_reuse_live_memory)
+{
+    fixture fixture;
+
+    auto constexpr kFRAMES_IN_FLIGHT = 3u;
+
+    for (auto allow_overflow : {false, true}) {
+        graphics::upload_ring ring{fixture.device.get(), fixture.timeline(), 1 << 18, allow_overflow};
+
+        std::mt19937 generator{7};
+        std::uniform_int_distribution<UINT64> size{1, 8192};
+        std::uniform_int_distribution<int> alignment_shift{4, 9};
+        std::uniform_int_distribution<int> allocation_number{1, 60};
+
+        std::array<UINT64, kFRAMES_IN_FLIGHT> frame_fences{ };
+        std::vector<live_allocation> live;
+
+        auto overlaps = 0;
+        auto misaligned = 0;
+        auto straddles = 0;
+
+        for (auto frame = 0u; frame < 500; ++frame) {
+            fixture.timeline().wait(frame_fences[frame % kFRAMES_IN_FLIGHT]);
+
+            std::erase_if(live, [&fixture] (auto &&allocation)
+            {
+                return allocation.fence_value != 0 && fixture.timeline().is_complete(allocation.fence_value);
+            });
+
+            auto const first_of_frame = std::size(live);
+
+            for (auto count = allocation_number(generator); count > 0; --count) {
+                auto const alignment = UINT64{1} << alignment_shift(generator);
+                auto const allocation = ring.allocate(size(generator), alignment);
+
+                if (allocation.offset % alignment != 0)
+                    ++misaligned;
+
+                if (allocation.offset + allocation.size > allocation.resource->GetDesc().Width)
+                    ++straddles;
+
+                for (auto &&other : live) {
+                    auto const in_flight = other.fence_value == 0 || !fixture.timeline().is_complete(other.fence_value);
+
+                    if (in_flight && other.resource == allocation.resource &&
+                        allocation.offset < other.offset + other.size && other.offset < allocation.offset + allocation.size)
+                        ++overlaps;
+                }
+
+                live.push_back(live_allocation{allocation.resource, allocation.offset, allocation.size, 0});
+            }
+
+            auto const fence_value = fixture.submit_frame();
+
+            for (auto index = first_of_frame; index < std::size(live); ++index)
+                live[index].fence_value = fence_value;
+
+            ring.end_frame(fence_value);
+
+            frame_fences[frame % kFRAMES_IN_FLIGHT] = fence_value;
+
+            CHECK(ring.occupancy() <= ring.capacity());
+        }
+
+        CHECK(overlaps == 0);
+        CHECK(misaligned == 0);
+        CHECK(straddles == 0);
+    }
+}
@@ -0,0 +1,146 @@
+#include <random>
+
+#include "test.hxx"
+
+#include "main.hxx"
+#include "graphics/command_pool.hxx"
+#include "graphics/queue.hxx"
+#include "graphics/streaming.hxx"
+
+
+namespace
+{
+    winrt::com_ptr<ID3D12Resource> create_destination(UINT64 size)
+    {
+        winrt::com_ptr<ID3D12Resource> resource;
+        resource.attach(new ID3D12Resource{CD3DX12_RESOURCE_DESC::Buffer(size), D3D12_HEAP_TYPE_DEFAULT});
+
+        return resource;
+    }
+
+    struct streaming final {
+        winrt::com_ptr<ID3D12Device6> device{stand_in::create_device()};
+
+        graphics::queue_scheduler queues{device.get()};
+        graphics::command_pool command_pool{device.get()};
+    };
+}
+
+TEST(uploads_arrive_in_request_order)
+{
+    auto constexpr kDESTINATION_SIZE = 16ull << 20;
+
+    stand_in::debug_layer::instance().clear();
+
+    streaming streaming;
+
+    auto const destination = create_destination(kDESTINATION_SIZE);
+
+    // The contents the destination should end up with; later requests overwrite earlier ones.
+    std::vector<std::byte> expected(kDESTINATION_SIZE);
+    std::vector<graphics::upload_token> tokens;
+
+    {
+        // Small pages, so that batches wrap the ring and requests larger than a page get dedicated ones.
+        graphics::upload_service uploads{streaming.device.get(), streaming.command_pool, streaming.queues, 1ull << 20, 3, 256ull << 10};
+
+        std::mt19937 generator{3};
+
+        for (auto index = 0; index < 400; ++index) {
+            auto const size = index % 97 == 0 ? (3ull << 20) : std::uniform_int_distribution<UINT64>{1, 70'000}(generator);
+            auto const offset = std::uniform_int_distribution<UINT64>{0, kDESTINATION_SIZE - size}(generator);
+
+            std::vector<std::byte> data(size);
+
+            for (auto &&value : data)
+                value = static_cast<std::byte>(generator());
+
+            std::copy(std::begin(data), std::end(data), std::begin(expected) + static_cast<std::ptrdiff_t>(offset));
+
+            tokens.push_back(uploads.upload_buffer(destination.get(), offset, std::move(data)));
+        }
+
+        uploads.flush();
+
+        CHECK(std::all_of(std::begin(tokens), std::end(tokens), [&uploads] (auto token) { return uploads.is_complete(token); }));
+
+        auto const statistics = uploads.statistics();
+
+        CHECK(statistics.requests == std::size(tokens));
+        CHECK(statistics.batches < statistics.requests);
+        CHECK(statistics.batches > 1);
+    }
+
+    CHECK(std::equal(std::begin(expected), std::end(expected), destination->memory()));
+
+    // Every batch went out on a copy list of its own from the pool.
+    CHECK(streaming.command_pool.statistics(D3D12_COMMAND_LIST_TYPE_COPY).in_use == 0);
+
+    CHECK(stand_in::debug_layer::instance().messages().empty());
+}
+
+TEST(tokens_complete_with_the_copy_queue)
+{
+    streaming streaming;
+
+    auto const destination = create_destination(1ull << 20);
+
+    // The GPU only runs when the test says so.
+    stand_in::gpu::instance().set_execute_on_wait(false);
+
+    {
+        graphics::upload_service uploads{streaming.device.get(), streaming.command_pool, streaming.queues, 1ull << 20, 2, 64ull << 10};
+
+        auto const token = uploads.upload_buffer(destination.get(), 0, std::vector<std::byte>(1000, std::byte{7}));
+
+        // The render thread polls; the worker submits the batch on its own.
+        auto fence = uploads.fence(token);
+
+        while (!fence) {
+            std::this_thread::yield();
+            fence = uploads.fence(token);
+        }
+
+        CHECK(fence->queue == graphics::queue_type::copy);
+        CHECK(fence->value != 0);
+        CHECK(!uploads.is_complete(token));
+
+        stand_in::gpu::instance().execute();
+
+        CHECK(uploads.is_complete(token));
+        CHECK(destination->memory()[999] == std::byte{7});
+
+        // A completed request needs no wait.
+        CHECK(uploads.fence(token)->value == 0);
+    }
+
+    stand_in::gpu::instance().set_execute_on_wait(true);
+}
+
+TEST(texture_rows_are_staged_at_the_pitch_alignment)
+{
+    streaming streaming;
+
+    winrt::com_ptr<ID3D12Resource> texture;
+    texture.attach(new ID3D12Resource{CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, 100, 64, 1, 2), D3D12_HEAP_TYPE_DEFAULT});
+
+    graphics::upload_service uploads{streaming.device.get(), streaming.command_pool, streaming.queues};
+
+    // Rows of 400 and 200 bytes are padded to 512 and 256 bytes in the staging page.
+    std::vector<graphics::texture_subresource_data> subresources(2);
+
+    subresources[0].data.resize(400 * 64);
+    subresources[0].row_pitch = 400;
+    subresources[0].slice_pitch = 400 * 64;
+
+    subresources[1].data.resize(200 * 32);
+    subresources[1].row_pitch = 200;
+    subresources[1].slice_pitch = 200 * 32;
+
+    auto const token = uploads.upload_texture(texture.get(), 0, std::move(subresources));
+
+    uploads.flush();
+
+    CHECK(uploads.is_complete(token));
+    CHECK(uploads.statistics().bytes == 512 * 64 + 256 * 31 + 200);
+}